@@ -27,9 +27,15 @@
 #include "algorithms/hungarian.h"
 #include "cpp/parse_dimacs_assignment.h"
 #include "cpp/print_dimacs_assignment.h"
+#include "graph/auction_assignment.h"
 #include "graph/ebert_graph.h"
+#include "graph/graph.h"
 #include "graph/linear_assignment.h"
 
+DEFINE_int32(assignment_auction_threads, 0,
+              "If positive, also solve the problem with the auction algorithm "
+              "with 1, 2, 4, ... up to this number of threads, and compare "
+              "the results.");
 DEFINE_bool(assignment_compare_hungarian, false,
             "Compare result and speed against Hungarian method.");
 DEFINE_string(assignment_problem_output_file, "",
@@ -107,6 +113,59 @@ CostValue BuildAndSolveHungarianInstance(
   return static_cast<CostValue>(result_cost);
 }
 
+// Solves the problem with ParallelAuctionAssignment on a copy of the graph,
+// and re-solves it from the final prices to measure the warm start.
+template <typename GraphType>
+void BenchmarkAuctionAssignment(
+    const LinearSumAssignment<GraphType>& assignment, int max_num_threads,
+    bool check_cost, CostValue expected_cost) {
+  typedef StaticGraph<> AuctionGraph;
+  const GraphType& graph = assignment.Graph();
+  const NodeIndex num_left_nodes = assignment.NumLeftNodes();
+  AuctionGraph auction_graph(assignment.NumNodes(), graph.num_arcs());
+  std::vector<CostValue> costs;
+  costs.reserve(graph.num_arcs());
+  for (typename LinearSumAssignment<GraphType>::BipartiteLeftNodeIterator
+           node_it(assignment);
+       node_it.Ok(); node_it.Next()) {
+    const NodeIndex left_node = node_it.Index();
+    for (typename GraphType::OutgoingArcIterator arc_it(graph, left_node);
+         arc_it.Ok(); arc_it.Next()) {
+      auction_graph.AddArc(left_node - GraphType::kFirstNode,
+                           graph.Head(arc_it.Index()) - GraphType::kFirstNode);
+      costs.push_back(assignment.ArcCost(arc_it.Index()));
+    }
+  }
+  std::vector<AuctionGraph::ArcIndex> permutation;
+  auction_graph.Build(&permutation);
+  for (int num_threads = 1; num_threads <= max_num_threads; num_threads *= 2) {
+    ParallelAuctionAssignment<AuctionGraph> auction(&auction_graph,
+                                                    num_left_nodes);
+    auction.set_num_threads(num_threads);
+    for (int i = 0; i < costs.size(); ++i) {
+      auction.SetArcCost(permutation.empty() ? i : permutation[i], costs[i]);
+    }
+    for (int solve = 0; solve < 2; ++solve) {
+      WallTimer timer;
+      timer.Start();
+      const bool success = auction.ComputeAssignment();
+      const double elapsed = timer.GetInMs() / 1000.0;
+      if (!success) {
+        LOG(WARNING) << "Auction: given problem is infeasible.";
+        return;
+      }
+      LOG(INFO) << "Auction with " << num_threads << " thread(s)"
+                << (solve == 0 ? "" : ", warm start") << ": cost "
+                << auction.GetCost() << " computed in " << elapsed
+                << " seconds (" << auction.StatsString() << ").";
+      if (check_cost && auction.GetCost() != expected_cost) {
+        LOG(ERROR) << "Optimum cost mismatch: " << auction.GetCost() << " vs. "
+                   << expected_cost << ".";
+      }
+    }
+  }
+}
+
 template <typename GraphType>
 void DisplayAssignment(const LinearSumAssignment<GraphType>& assignment) {
   for (typename LinearSumAssignment<GraphType>::BipartiteLeftNodeIterator
@@ -167,6 +226,10 @@ int SolveDimacsAssignment(int argc, char* argv[]) {
   } else {
     LOG(WARNING) << "Given problem is infeasible.";
   }
+  if (FLAGS_assignment_auction_threads > 0) {
+    BenchmarkAuctionAssignment(*assignment, FLAGS_assignment_auction_threads,
+                               success, success ? assignment->GetCost() : 0);
+  }
   delete assignment;
   delete graph;
   return 0;
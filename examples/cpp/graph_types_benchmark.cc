@@ -0,0 +1,216 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compares the flow and assignment algorithms on the graph classes of
+// ebert_graph.h and on the compressed (CSR) graph classes of graph.h, on the
+// same random instances:
+// - GenericMaxFlow on StarGraph and ReverseArcStaticGraph<>,
+// - GenericMinCostFlow on StarGraph and ReverseArcStaticGraph<>,
+// - LinearSumAssignment on ForwardStarGraph and StaticGraph<>.
+// The results are checked to be the same for both graph types.
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "base/timer.h"
+#include "graph/ebert_graph.h"
+#include "graph/graph.h"
+#include "graph/graphs.h"
+#include "graph/linear_assignment.h"
+#include "graph/max_flow.h"
+#include "graph/min_cost_flow.h"
+
+DEFINE_int32(num_nodes, 100000, "Number of nodes of the flow instances.");
+DEFINE_int32(num_left_nodes, 20000,
+             "Number of left nodes of the assignment instance.");
+DEFINE_int32(degree, 10, "Number of outgoing arcs per node.");
+DEFINE_int32(max_capacity, 100, "Arc capacities are in [1, max_capacity].");
+DEFINE_int32(max_cost, 1000, "Arc costs are in [0, max_cost].");
+DEFINE_int32(seed, 0, "Random seed.");
+
+namespace operations_research {
+
+struct RandomArcs {
+  std::vector<NodeIndex> tails;
+  std::vector<NodeIndex> heads;
+  std::vector<FlowQuantity> capacities;
+  std::vector<CostValue> costs;
+
+  ArcIndex num_arcs() const { return tails.size(); }
+  void Add(NodeIndex tail, NodeIndex head, FlowQuantity capacity,
+           CostValue cost) {
+    tails.push_back(tail);
+    heads.push_back(head);
+    capacities.push_back(capacity);
+    costs.push_back(cost);
+  }
+};
+
+// A flow network on num_nodes nodes where each node has a path to the next
+// one, plus random arcs. The source is 0 and the sink num_nodes - 1.
+void GenerateFlowInstance(NodeIndex num_nodes, ACMRandom* random,
+                          RandomArcs* arcs) {
+  for (NodeIndex node = 0; node < num_nodes; ++node) {
+    for (int i = 0; i < FLAGS_degree; ++i) {
+      const NodeIndex head = i == 0 && node + 1 < num_nodes
+                                 ? node + 1
+                                 : random->Uniform(num_nodes);
+      if (head == node) continue;
+      arcs->Add(node, head, 1 + random->Uniform(FLAGS_max_capacity),
+                random->Uniform(FLAGS_max_cost + 1));
+    }
+  }
+}
+
+// An assignment instance where left node i can always be assigned to the
+// right node num_left_nodes + i, so that it is feasible.
+void GenerateAssignmentInstance(NodeIndex num_left_nodes, ACMRandom* random,
+                                RandomArcs* arcs) {
+  for (NodeIndex node = 0; node < num_left_nodes; ++node) {
+    arcs->Add(node, num_left_nodes + node, 1,
+              random->Uniform(FLAGS_max_cost + 1));
+    for (int i = 1; i < FLAGS_degree; ++i) {
+      arcs->Add(node, num_left_nodes + random->Uniform(num_left_nodes), 1,
+                random->Uniform(FLAGS_max_cost + 1));
+    }
+  }
+}
+
+// Adds the arcs to the graph and builds it. graph_arc[i] is set to the index
+// in the graph of the i-th arc.
+template <typename Graph>
+void BuildGraph(const RandomArcs& arcs, Graph* graph,
+                std::vector<ArcIndex>* graph_arc) {
+  graph_arc->resize(arcs.num_arcs());
+  for (ArcIndex i = 0; i < arcs.num_arcs(); ++i) {
+    (*graph_arc)[i] = graph->AddArc(arcs.tails[i], arcs.heads[i]);
+  }
+  std::vector<ArcIndex> permutation;
+  Graphs<Graph>::Build(graph, &permutation);
+  if (!permutation.empty()) {
+    for (ArcIndex i = 0; i < arcs.num_arcs(); ++i) {
+      (*graph_arc)[i] = permutation[(*graph_arc)[i]];
+    }
+  }
+}
+
+template <typename Graph>
+FlowQuantity RunMaxFlow(const std::string& name, NodeIndex num_nodes,
+                        const RandomArcs& arcs) {
+  WallTimer timer;
+  timer.Start();
+  Graph graph(num_nodes, arcs.num_arcs());
+  std::vector<ArcIndex> graph_arc;
+  BuildGraph(arcs, &graph, &graph_arc);
+  GenericMaxFlow<Graph> max_flow(&graph, 0, num_nodes - 1);
+  for (ArcIndex i = 0; i < arcs.num_arcs(); ++i) {
+    max_flow.SetArcCapacity(graph_arc[i], arcs.capacities[i]);
+  }
+  const double build_time = timer.Get();
+  CHECK(max_flow.Solve());
+  timer.Stop();
+  printf("%-46s flow = %lld, build = %.3fs, total = %.3fs\n", name.c_str(),
+         static_cast<long long>(max_flow.GetOptimalFlow()),  // NOLINT
+         build_time, timer.Get());
+  return max_flow.GetOptimalFlow();
+}
+
+template <typename Graph>
+CostValue RunMinCostFlow(const std::string& name, NodeIndex num_nodes,
+                         const RandomArcs& arcs, FlowQuantity supply) {
+  WallTimer timer;
+  timer.Start();
+  Graph graph(num_nodes, arcs.num_arcs());
+  std::vector<ArcIndex> graph_arc;
+  BuildGraph(arcs, &graph, &graph_arc);
+  GenericMinCostFlow<Graph> min_cost_flow(&graph);
+  for (ArcIndex i = 0; i < arcs.num_arcs(); ++i) {
+    min_cost_flow.SetArcCapacity(graph_arc[i], arcs.capacities[i]);
+    min_cost_flow.SetArcUnitCost(graph_arc[i], arcs.costs[i]);
+  }
+  min_cost_flow.SetNodeSupply(0, supply);
+  min_cost_flow.SetNodeSupply(num_nodes - 1, -supply);
+  const double build_time = timer.Get();
+  CHECK(min_cost_flow.Solve());
+  timer.Stop();
+  printf("%-46s cost = %lld, build = %.3fs, total = %.3fs\n", name.c_str(),
+         static_cast<long long>(min_cost_flow.GetOptimalCost()),  // NOLINT
+         build_time, timer.Get());
+  return min_cost_flow.GetOptimalCost();
+}
+
+template <typename Graph>
+CostValue RunAssignment(const std::string& name, NodeIndex num_left_nodes,
+                        const RandomArcs& arcs) {
+  WallTimer timer;
+  timer.Start();
+  Graph graph(2 * num_left_nodes, arcs.num_arcs());
+  std::vector<ArcIndex> graph_arc;
+  BuildGraph(arcs, &graph, &graph_arc);
+  LinearSumAssignment<Graph> assignment(graph, num_left_nodes);
+  for (ArcIndex i = 0; i < arcs.num_arcs(); ++i) {
+    assignment.SetArcCost(graph_arc[i], arcs.costs[i]);
+  }
+  const double build_time = timer.Get();
+  CHECK(assignment.ComputeAssignment());
+  timer.Stop();
+  printf("%-46s cost = %lld, build = %.3fs, total = %.3fs\n", name.c_str(),
+         static_cast<long long>(assignment.GetCost()),  // NOLINT
+         build_time, timer.Get());
+  return assignment.GetCost();
+}
+
+void RunGraphTypesBenchmark() {
+  ACMRandom random(FLAGS_seed);
+  const NodeIndex num_nodes = FLAGS_num_nodes;
+  RandomArcs flow_arcs;
+  GenerateFlowInstance(num_nodes, &random, &flow_arcs);
+  printf("Flow instance: %d nodes, %d arcs\n", num_nodes,
+         flow_arcs.num_arcs());
+  const FlowQuantity flow = RunMaxFlow<StarGraph>(
+      "GenericMaxFlow<StarGraph>", num_nodes, flow_arcs);
+  CHECK_EQ(flow, RunMaxFlow<ReverseArcStaticGraph<> >(
+                     "GenericMaxFlow<ReverseArcStaticGraph<> >", num_nodes,
+                     flow_arcs));
+  const CostValue cost = RunMinCostFlow<StarGraph>(
+      "GenericMinCostFlow<StarGraph>", num_nodes, flow_arcs, flow);
+  CHECK_EQ(cost, RunMinCostFlow<ReverseArcStaticGraph<> >(
+                     "GenericMinCostFlow<ReverseArcStaticGraph<> >", num_nodes,
+                     flow_arcs, flow));
+
+  const NodeIndex num_left_nodes = FLAGS_num_left_nodes;
+  RandomArcs assignment_arcs;
+  GenerateAssignmentInstance(num_left_nodes, &random, &assignment_arcs);
+  printf("Assignment instance: %d left nodes, %d arcs\n", num_left_nodes,
+         assignment_arcs.num_arcs());
+  const CostValue assignment_cost = RunAssignment<ForwardStarGraph>(
+      "LinearSumAssignment<ForwardStarGraph>", num_left_nodes,
+      assignment_arcs);
+  CHECK_EQ(assignment_cost, RunAssignment<StaticGraph<> >(
+                                "LinearSumAssignment<StaticGraph<> >",
+                                num_left_nodes, assignment_arcs));
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::RunGraphTypesBenchmark();
+  return EXIT_SUCCESS;
+}
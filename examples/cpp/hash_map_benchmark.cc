@@ -0,0 +1,202 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Microbenchmarks of FlatHashMap (base/flat_hash_map.h) against hash_map
+// (base/hash.h) and std::unordered_map, on the operations of the solvers:
+// insertions, successful and unsuccessful lookups, erasures and iteration.
+// The keys are random int64, pointers (as in the callback caches of the
+// routing library), pairs of int64 (as in the penalties of the guided local
+// search) and strings (as in the name tables of the MPS reader). The results
+// of all the containers are checked to be the same.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/flat_hash_map.h"
+#include "base/hash.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "base/stringprintf.h"
+#include "base/timer.h"
+
+DEFINE_int32(num_keys, 1000000, "Number of keys inserted in each map.");
+DEFINE_int32(num_lookups, 10000000, "Number of lookups of each kind.");
+DEFINE_int32(num_small_maps, 100000,
+             "Number of maps of 8 keys in the small maps benchmark.");
+DEFINE_int32(seed, 0, "Random seed.");
+
+namespace operations_research {
+
+// The keys of each type, generated from random 64-bit numbers.
+template <class Key>
+Key MakeKey(uint64 random);
+
+template <>
+int64 MakeKey<int64>(uint64 random) {
+  return static_cast<int64>(random);
+}
+
+template <>
+const int* MakeKey<const int*>(uint64 random) {
+  // Aligned addresses, as the ones returned by new.
+  return reinterpret_cast<const int*>((random & 0xffffffffffffULL) << 4);
+}
+
+template <>
+std::pair<int64, int64> MakeKey<std::pair<int64, int64> >(uint64 random) {
+  return std::make_pair(static_cast<int64>(random >> 40),
+                        static_cast<int64>(random & 0xffffff));
+}
+
+template <>
+std::string MakeKey<std::string>(uint64 random) {
+  return StringPrintf("X%llx",
+                      static_cast<unsigned long long>(random));  // NOLINT
+}
+
+// The time of one operation in nanoseconds.
+double NanosecondsPerOperation(const WallTimer& timer, int num_operations) {
+  return 1e9 * timer.Get() / std::max(1, num_operations);
+}
+
+// Runs all the operations on a map of the given type, prints their times and
+// returns a checksum of the results.
+template <class Map, class Key>
+int64 RunMapBenchmark(const std::string& name, const std::vector<Key>& keys,
+                      const std::vector<Key>& missing_keys,
+                      const std::vector<int>& lookups) {
+  int64 checksum = 0;
+  WallTimer timer;
+  Map map;
+
+  timer.Start();
+  for (int i = 0; i < keys.size(); ++i) map[keys[i]] = i;
+  timer.Stop();
+  const double insert_time = NanosecondsPerOperation(timer, keys.size());
+  checksum += map.size();
+
+  timer.Restart();
+  for (const int i : lookups) {
+    const typename Map::const_iterator it = map.find(keys[i]);
+    if (it != map.end()) checksum += it->second;
+  }
+  timer.Stop();
+  const double hit_time = NanosecondsPerOperation(timer, lookups.size());
+
+  timer.Restart();
+  for (const int i : lookups) {
+    checksum += map.count(missing_keys[i]);
+  }
+  timer.Stop();
+  const double miss_time = NanosecondsPerOperation(timer, lookups.size());
+
+  timer.Restart();
+  for (typename Map::const_iterator it = map.begin(); it != map.end(); ++it) {
+    checksum += it->second;
+  }
+  timer.Stop();
+  const double iteration_time = NanosecondsPerOperation(timer, map.size());
+
+  timer.Restart();
+  for (int i = 0; i < keys.size(); i += 2) checksum += map.erase(keys[i]);
+  timer.Stop();
+  const double erase_time = NanosecondsPerOperation(timer, keys.size() / 2);
+  checksum += map.size();
+
+  printf("  %-26s insert %6.1f  hit %6.1f  miss %6.1f  iterate %5.1f  "
+         "erase %6.1f ns\n",
+         name.c_str(), insert_time, hit_time, miss_time, iteration_time,
+         erase_time);
+  return checksum;
+}
+
+// Many small maps, created and destroyed, as in the solvers that keep a map
+// per constraint or per search node.
+template <class Map, class Key>
+int64 RunSmallMapsBenchmark(const std::string& name,
+                            const std::vector<Key>& keys) {
+  const int kNumKeysPerMap = 8;
+  int64 checksum = 0;
+  WallTimer timer;
+  timer.Start();
+  for (int m = 0; m < FLAGS_num_small_maps; ++m) {
+    Map map;
+    const int first = m % (keys.size() - kNumKeysPerMap);
+    for (int i = 0; i < kNumKeysPerMap; ++i) map[keys[first + i]] = i;
+    for (int i = 0; i < kNumKeysPerMap; ++i) {
+      checksum += map.find(keys[first + i])->second;
+    }
+  }
+  timer.Stop();
+  printf("  %-26s small maps %6.1f ns per map\n", name.c_str(),
+         NanosecondsPerOperation(timer, FLAGS_num_small_maps));
+  return checksum;
+}
+
+template <class Key>
+void RunKeyTypeBenchmark(const std::string& key_name, ACMRandom* random) {
+  std::vector<Key> keys;
+  std::vector<Key> missing_keys;
+  for (int i = 0; i < FLAGS_num_keys; ++i) {
+    // The keys and the missing keys differ by their lowest bit.
+    const uint64 r = static_cast<uint64>(random->Next64()) & ~1ULL;
+    keys.push_back(MakeKey<Key>(r));
+    missing_keys.push_back(MakeKey<Key>(r | 1));
+  }
+  std::vector<int> lookups(FLAGS_num_lookups);
+  for (int& i : lookups) i = random->Uniform(FLAGS_num_keys);
+  printf("%s keys:\n", key_name.c_str());
+
+  const int64 checksum =
+      RunMapBenchmark<FlatHashMap<Key, int64> >("FlatHashMap", keys,
+                                                missing_keys, lookups);
+  CHECK_EQ(checksum, (RunMapBenchmark<hash_map<Key, int64> >(
+                         "hash_map", keys, missing_keys, lookups)));
+  CHECK_EQ(checksum,
+           (RunMapBenchmark<std::unordered_map<Key, int64, FlatHash<Key> > >(
+               "std::unordered_map", keys, missing_keys, lookups)));
+
+  const int64 small_checksum =
+      RunSmallMapsBenchmark<FlatHashMap<Key, int64> >("FlatHashMap", keys);
+  CHECK_EQ(small_checksum, (RunSmallMapsBenchmark<hash_map<Key, int64> >(
+                               "hash_map", keys)));
+  CHECK_EQ(small_checksum,
+           (RunSmallMapsBenchmark<
+               std::unordered_map<Key, int64, FlatHash<Key> > >(
+               "std::unordered_map", keys)));
+}
+
+void RunHashMapBenchmark() {
+  CHECK_GT(FLAGS_num_keys, 8);
+  ACMRandom random(FLAGS_seed);
+  printf("%d keys, %d lookups\n", FLAGS_num_keys, FLAGS_num_lookups);
+  RunKeyTypeBenchmark<int64>("int64", &random);
+  RunKeyTypeBenchmark<const int*>("Pointer", &random);
+  RunKeyTypeBenchmark<std::pair<int64, int64> >("Pair of int64", &random);
+  RunKeyTypeBenchmark<std::string>("String", &random);
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::RunHashMapBenchmark();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,186 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compares the sequential GenericMaxFlow and the multi-threaded
+// ParallelMaxFlow on a max flow problem in DIMACS format:
+// http://lpsolve.sourceforge.net/5.5/DIMACS_maxf.htm
+//
+// The parallel algorithm is run with 1, 2, 4, ... up to --max_flow_threads
+// threads, and the flow values are checked against the sequential one.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/stringprintf.h"
+#include "base/timer.h"
+#include "graph/graph.h"
+#include "graph/max_flow.h"
+#include "graph/parallel_max_flow.h"
+
+DEFINE_int32(max_flow_threads, 8,
+             "Maximum number of threads used by the parallel algorithm.");
+DEFINE_bool(max_flow_run_sequential, true,
+            "Also run the sequential GenericMaxFlow.");
+
+namespace operations_research {
+
+typedef ReverseArcStaticGraph<> Graph;
+
+struct DimacsMaxFlowProblem {
+  DimacsMaxFlowProblem() : source(-1), sink(-1) {}
+  Graph graph;
+  std::vector<FlowQuantity> capacities;  // Indexed by arc after Build().
+  Graph::NodeIndex source;
+  Graph::NodeIndex sink;
+};
+
+// Reads the file and builds the graph. The DIMACS nodes are numbered from 1.
+// Returns false and logs an error if the file cannot be parsed.
+bool ReadDimacsMaxFlowProblem(const std::string& filename,
+                              DimacsMaxFlowProblem* problem) {
+  FILE* const file = fopen(filename.c_str(), "r");
+  if (file == NULL) {
+    LOG(ERROR) << "Cannot open " << filename;
+    return false;
+  }
+  char line[1024];
+  int line_number = 0;
+  bool ok = true;
+  std::vector<FlowQuantity> capacities;
+  while (ok && fgets(line, sizeof(line), file) != NULL) {
+    ++line_number;
+    char* p = line + 1;
+    switch (line[0]) {
+      case 'p': {
+        char format[16];
+        long long num_nodes = 0;  // NOLINT
+        long long num_arcs = 0;   // NOLINT
+        ok = sscanf(line, "p %15s %lld %lld", format, &num_nodes,
+                    &num_arcs) == 3 &&
+             strcmp(format, "max") == 0;
+        if (ok) {
+          problem->graph.Reserve(num_nodes, num_arcs);
+          problem->graph.AddNode(num_nodes - 1);
+          capacities.reserve(num_arcs);
+        }
+        break;
+      }
+      case 'n': {
+        const long node = strtol(p, &p, 10) - 1;  // NOLINT
+        const char type = *(p + strspn(p, " \t"));
+        if (type == 's') {
+          problem->source = node;
+        } else if (type == 't') {
+          problem->sink = node;
+        } else {
+          ok = false;
+        }
+        break;
+      }
+      case 'a': {
+        const long tail = strtol(p, &p, 10) - 1;  // NOLINT
+        const long head = strtol(p, &p, 10) - 1;  // NOLINT
+        const FlowQuantity capacity = strtoll(p, &p, 10);
+        ok = tail >= 0 && head >= 0 && tail < problem->graph.num_nodes() &&
+             head < problem->graph.num_nodes() && capacity >= 0;
+        if (ok) {
+          problem->graph.AddArc(tail, head);
+          capacities.push_back(capacity);
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  }
+  fclose(file);
+  if (!ok || problem->source < 0 || problem->sink < 0) {
+    LOG(ERROR) << filename << ": parse error at line " << line_number;
+    return false;
+  }
+  std::vector<Graph::ArcIndex> permutation;
+  problem->graph.Build(&permutation);
+  problem->capacities.resize(capacities.size());
+  for (int i = 0; i < capacities.size(); ++i) {
+    const Graph::ArcIndex arc = permutation.empty() ? i : permutation[i];
+    problem->capacities[arc] = capacities[i];
+  }
+  return true;
+}
+
+template <class MaxFlowType>
+FlowQuantity SolveAndReport(const DimacsMaxFlowProblem& problem,
+                            const std::string& name, MaxFlowType* max_flow) {
+  for (Graph::ArcIndex arc = 0; arc < problem.graph.num_arcs(); ++arc) {
+    max_flow->SetArcCapacity(arc, problem.capacities[arc]);
+  }
+  WallTimer timer;
+  timer.Start();
+  CHECK(max_flow->Solve());
+  timer.Stop();
+  CHECK_EQ(MaxFlowStatusClass::OPTIMAL, max_flow->status());
+  printf("%-24s flow = %lld, time = %.3fs\n", name.c_str(),
+         static_cast<long long>(max_flow->GetOptimalFlow()),  // NOLINT
+         timer.Get());
+  return max_flow->GetOptimalFlow();
+}
+
+int RunMaxFlowBenchmark(const std::string& filename) {
+  DimacsMaxFlowProblem problem;
+  WallTimer timer;
+  timer.Start();
+  if (!ReadDimacsMaxFlowProblem(filename, &problem)) return EXIT_FAILURE;
+  timer.Stop();
+  printf("%s: %d nodes, %d arcs, read in %.3fs\n", filename.c_str(),
+         problem.graph.num_nodes(), problem.graph.num_arcs(), timer.Get());
+
+  FlowQuantity reference = -1;
+  if (FLAGS_max_flow_run_sequential) {
+    GenericMaxFlow<Graph> max_flow(&problem.graph, problem.source,
+                                   problem.sink);
+    max_flow.SetCheckResult(false);
+    reference = SolveAndReport(problem, "GenericMaxFlow", &max_flow);
+  }
+  for (int num_threads = 1; num_threads <= FLAGS_max_flow_threads;
+       num_threads *= 2) {
+    ParallelMaxFlow<Graph> max_flow(&problem.graph, problem.source,
+                                    problem.sink);
+    max_flow.set_num_threads(num_threads);
+    const FlowQuantity flow = SolveAndReport(
+        problem, StringPrintf("ParallelMaxFlow(%d)", num_threads), &max_flow);
+    if (reference < 0) reference = flow;
+    CHECK_EQ(reference, flow);
+  }
+  return EXIT_SUCCESS;
+}
+
+}  // namespace operations_research
+
+static const char* const kUsageTemplate = "usage: %s <filename>";
+
+int main(int argc, char* argv[]) {
+  const std::string usage = operations_research::StringPrintf(
+      kUsageTemplate, argc < 1 ? "max_flow_benchmark" : argv[0]);
+  google::SetUsageMessage(usage);
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  if (argc < 2) {
+    LOG(FATAL) << usage;
+  }
+  return operations_research::RunMaxFlowBenchmark(argv[1]);
+}
@@ -230,7 +230,9 @@ int Run() {
   if (FLAGS_use_symmetry) {
     LOG(INFO) << "Finding symmetries of the problem.";
     std::vector<std::unique_ptr<SparsePermutation>> generators;
-    FindLinearBooleanProblemSymmetries(problem, &generators);
+    TimeLimit time_limit(parameters.max_time_in_seconds(),
+                         parameters.max_deterministic_time());
+    FindLinearBooleanProblemSymmetries(problem, &time_limit, &generators);
     solver->AddSymmetries(&generators);
   }
 
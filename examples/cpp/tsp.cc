@@ -24,7 +24,11 @@
 // solutions being generated using a cheapest addition heuristic.
 // Optionally one can randomly forbid a set of random connections between nodes
 // (forbidden arcs).
+// With --tsp_lower_bound, the solution is compared to the Held-Karp lower bound
+// of the instance (cf graph/one_tree_lower_bound.h), to bound its distance to
+// the optimum.
 
+#include <algorithm>
 #include "base/unique_ptr.h"
 
 #include "base/callback.h"
@@ -33,6 +37,7 @@
 #include "base/integral_types.h"
 #include "base/join.h"
 #include "constraint_solver/routing.h"
+#include "graph/one_tree_lower_bound.h"
 #include "base/random.h"
 
 using operations_research::Assignment;
@@ -46,6 +51,9 @@ DEFINE_int32(tsp_random_forbidden_connections, 0,
              "Number of random forbidden connections.");
 DEFINE_bool(tsp_use_deterministic_random_seed, false,
             "Use deterministic random seeds.");
+DEFINE_bool(tsp_lower_bound, false,
+            "Compute a Held-Karp lower bound of the random matrix instance, "
+            "and the optimality gap of the solution.");
 DECLARE_string(routing_first_solution);
 DECLARE_bool(routing_no_lns);
 
@@ -100,6 +108,23 @@ class RandomMatrix {
   const int size_;
 };
 
+// The random matrix is not symmetric, but a tour that uses the arc from i to j
+// costs at least min(Distance(i, j), Distance(j, i)), so the lower bound of the
+// symmetric instance with these costs is a lower bound of the instance.
+class SymmetricMatrixCost {
+ public:
+  explicit SymmetricMatrixCost(const RandomMatrix* matrix) : matrix_(matrix) {}
+  double operator()(int i, int j) const {
+    return std::min(matrix_->Distance(RoutingModel::NodeIndex(i),
+                                      RoutingModel::NodeIndex(j)),
+                    matrix_->Distance(RoutingModel::NodeIndex(j),
+                                      RoutingModel::NodeIndex(i)));
+  }
+
+ private:
+  const RandomMatrix* const matrix_;
+};
+
 int main(int argc, char** argv) {
   google::ParseCommandLineFlags( &argc, &argv, true);
   if (FLAGS_tsp_size > 0) {
@@ -143,6 +168,15 @@ int main(int argc, char** argv) {
     if (solution != NULL) {
       // Solution cost.
       LOG(INFO) << "Cost " << solution->ObjectiveValue();
+      if (FLAGS_tsp_lower_bound && FLAGS_tsp_use_random_matrix) {
+        const double lower_bound =
+            operations_research::ComputeOneTreeLowerBound(
+                FLAGS_tsp_size, SymmetricMatrixCost(&matrix));
+        LOG(INFO) << "Lower bound " << lower_bound << ", gap "
+                  << 100.0 * (solution->ObjectiveValue() - lower_bound) /
+                         std::max(1.0, lower_bound)
+                  << "%";
+      }
       // Inspect solution.
       // Only one route here; otherwise iterate from 0 to routing.vehicles() - 1
       const int route_number = 0;
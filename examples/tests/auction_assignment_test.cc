@@ -0,0 +1,141 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests the warm starts of ParallelAuctionAssignment: repeated re-solves with
+// changing costs must stay optimal with bounded prices, and a failed solve
+// must not poison the next one.
+
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "graph/auction_assignment.h"
+#include "graph/graph.h"
+#include "graph/linear_assignment.h"
+
+namespace operations_research {
+typedef StaticGraph<> Graph;
+
+const int kNumLeftNodes = 1000;
+const int kDegree = 8;
+const CostValue kMaxCost = 1000;
+
+// Builds a random bipartite graph where left node i has an arc to right node
+// i, so that it has a perfect matching, and kDegree - 1 other random arcs.
+void BuildRandomGraph(int num_left_nodes, Graph* graph) {
+  ACMRandom random(12345);
+  for (int left = 0; left < num_left_nodes; ++left) {
+    graph->AddArc(left, num_left_nodes + left);
+    for (int i = 1; i < kDegree; ++i) {
+      graph->AddArc(left, num_left_nodes + random.Uniform(num_left_nodes));
+    }
+  }
+  std::vector<Graph::ArcIndex> permutation;
+  graph->Build(&permutation);
+}
+
+// Returns a pseudo-random cost in [0, kMaxCost] for the arc and the round.
+CostValue ArcCost(const Graph& graph, Graph::ArcIndex arc, int round) {
+  const uint64 hash = (static_cast<uint64>(graph.Tail(arc)) * 1000003 +
+                       graph.Head(arc)) * 7919 + round * 104729;
+  return (hash ^ (hash >> 13)) % (kMaxCost + 1);
+}
+
+CostValue OptimalCost(const Graph& graph, int num_left_nodes, int round) {
+  LinearSumAssignment<Graph> assignment(graph, num_left_nodes);
+  for (Graph::ArcIndex arc = 0; arc < graph.num_arcs(); ++arc) {
+    assignment.SetArcCost(arc, ArcCost(graph, arc, round));
+  }
+  CHECK(assignment.ComputeAssignment());
+  return assignment.GetCost();
+}
+
+// Re-solves with new costs: the warm starts must find the optimum, and the
+// prices must not grow from one solve to the next.
+void TestWarmStartedResolves() {
+  Graph graph;
+  BuildRandomGraph(kNumLeftNodes, &graph);
+  ParallelAuctionAssignment<Graph> auction(&graph, kNumLeftNodes);
+  // With the prices kept within n * C of zero at the beginning of the phases,
+  // they stay within a small multiple of it.
+  const CostValue price_bound = 8 * kNumLeftNodes * (kMaxCost + 1);
+  for (int round = 0; round < 10; ++round) {
+    for (Graph::ArcIndex arc = 0; arc < graph.num_arcs(); ++arc) {
+      auction.SetArcCost(arc, ArcCost(graph, arc, round));
+    }
+    CHECK(auction.ComputeAssignment());
+    CHECK_EQ(round > 0, auction.was_warm_started());
+    CHECK_EQ(OptimalCost(graph, kNumLeftNodes, round), auction.GetCost());
+    for (int right = kNumLeftNodes; right < 2 * kNumLeftNodes; ++right) {
+      CHECK_LE(auction.Price(right), 0);
+      CHECK_GE(auction.Price(right), -price_bound);
+    }
+  }
+}
+
+// Two left nodes share a single right node: the problem is infeasible, and
+// each re-solve must fail from scratch.
+void TestResolvesAfterInfeasible() {
+  const int num_left_nodes = 100;
+  Graph graph;
+  for (int left = 0; left < num_left_nodes; ++left) {
+    graph.AddArc(left, num_left_nodes + (left == 1 ? 0 : left));
+    if (left > 1) graph.AddArc(left, num_left_nodes + left - 1);
+  }
+  std::vector<Graph::ArcIndex> permutation;
+  graph.Build(&permutation);
+  ParallelAuctionAssignment<Graph> auction(&graph, num_left_nodes);
+  for (Graph::ArcIndex arc = 0; arc < graph.num_arcs(); ++arc) {
+    auction.SetArcCost(arc, ArcCost(graph, arc, 0));
+  }
+  for (int round = 0; round < 10; ++round) {
+    CHECK(!auction.ComputeAssignment());
+    CHECK(!auction.was_warm_started());
+    for (int right = num_left_nodes; right < 2 * num_left_nodes; ++right) {
+      CHECK_EQ(0, auction.Price(right));
+    }
+  }
+}
+
+// A solve aborted because the costs are too large must leave a cold start
+// for the next one.
+void TestResolveAfterAbortedSolve() {
+  Graph graph;
+  BuildRandomGraph(kNumLeftNodes, &graph);
+  ParallelAuctionAssignment<Graph> auction(&graph, kNumLeftNodes);
+  for (Graph::ArcIndex arc = 0; arc < graph.num_arcs(); ++arc) {
+    auction.SetArcCost(arc, ArcCost(graph, arc, 0));
+  }
+  CHECK(auction.ComputeAssignment());
+  auction.SetArcCost(0, kint64max / (4 * (kNumLeftNodes + 1)));
+  CHECK(!auction.ComputeAssignment());
+  auction.SetArcCost(0, ArcCost(graph, 0, 1));
+  for (Graph::ArcIndex arc = 1; arc < graph.num_arcs(); ++arc) {
+    auction.SetArcCost(arc, ArcCost(graph, arc, 1));
+  }
+  CHECK(auction.ComputeAssignment());
+  CHECK(!auction.was_warm_started());
+  CHECK_EQ(OptimalCost(graph, kNumLeftNodes, 1), auction.GetCost());
+}
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::TestWarmStartedResolves();
+  operations_research::TestResolvesAfterInfeasible();
+  operations_research::TestResolveAfterAbortedSolve();
+  LOG(INFO) << "All tests passed.";
+  return 0;
+}
@@ -0,0 +1,98 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests BitsetCliqueFinder::CoverEdgesByCliques(): each reported clique must
+// be a clique of the graph and cover at least one edge that the previous
+// cliques did not cover.
+
+#include <algorithm>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "graph/cliques.h"
+
+namespace operations_research {
+// Checks the cliques reported by CoverEdgesByCliques() against a copy of the
+// adjacency matrix of the graph.
+class CoverChecker {
+ public:
+  explicit CoverChecker(int num_nodes)
+      : num_nodes_(num_nodes),
+        edge_(num_nodes * num_nodes, false),
+        covered_(num_nodes * num_nodes, false),
+        num_cliques_(0) {}
+
+  void AddEdge(int node1, int node2) {
+    edge_[node1 * num_nodes_ + node2] = true;
+    edge_[node2 * num_nodes_ + node1] = true;
+  }
+
+  bool CheckClique(const std::vector<int>& clique) {
+    CHECK_GE(clique.size(), 2);
+    CHECK(std::is_sorted(clique.begin(), clique.end()));
+    bool covers_new_edge = false;
+    for (int i = 0; i < clique.size(); ++i) {
+      for (int j = i + 1; j < clique.size(); ++j) {
+        const int index = clique[i] * num_nodes_ + clique[j];
+        CHECK(edge_[index]) << clique[i] << " " << clique[j];
+        covers_new_edge |= !covered_[index];
+        covered_[index] = true;
+      }
+    }
+    CHECK(covers_new_edge) << "Clique " << num_cliques_
+                           << " covers no new edge.";
+    ++num_cliques_;
+    return false;
+  }
+
+  int num_cliques() const { return num_cliques_; }
+
+ private:
+  const int num_nodes_;
+  std::vector<bool> edge_;
+  std::vector<bool> covered_;
+  int num_cliques_;
+};
+
+void TestCoverEdgesByCliques(int num_nodes, int density_percent, int seed) {
+  ACMRandom random(seed);
+  BitsetCliqueFinder finder(num_nodes);
+  CoverChecker checker(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    for (int j = i + 1; j < num_nodes; ++j) {
+      if (random.Uniform(100) < density_percent) {
+        finder.AddEdge(i, j);
+        checker.AddEdge(i, j);
+      }
+    }
+  }
+  finder.CoverEdgesByCliques(
+      NewPermanentCallback(&checker, &CoverChecker::CheckClique));
+  LOG(INFO) << num_nodes << " nodes, density " << density_percent << "%: "
+            << checker.num_cliques() << " cliques";
+}
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::TestCoverEdgesByCliques(50, 50, 1);
+  operations_research::TestCoverEdgesByCliques(200, 10, 2);
+  operations_research::TestCoverEdgesByCliques(200, 30, 3);
+  operations_research::TestCoverEdgesByCliques(150, 70, 4);
+  LOG(INFO) << "All tests passed.";
+  return 0;
+}
@@ -301,11 +301,14 @@ CPBINARIES = \
 	$(BIN_DIR)/dobble_ls$E \
 	$(BIN_DIR)/flow_api$E \
 	$(BIN_DIR)/golomb$E \
+	$(BIN_DIR)/graph_types_benchmark$E \
+	$(BIN_DIR)/hash_map_benchmark$E \
 	$(BIN_DIR)/jobshop$E \
 	$(BIN_DIR)/jobshop_ls$E \
 	$(BIN_DIR)/linear_assignment_api$E \
 	$(BIN_DIR)/ls_api$E \
 	$(BIN_DIR)/magic_square$E \
+	$(BIN_DIR)/max_flow_benchmark$E \
 	$(BIN_DIR)/model_util$E \
 	$(BIN_DIR)/multidim_knapsack$E \
 	$(BIN_DIR)/network_routing$E \
@@ -381,6 +384,8 @@ clean_cc:
 	-$(DEL) $(BIN_DIR)$Sfz$E
 	-$(DEL) $(BIN_DIR)$Sfz2$E
 	-$(DEL) $(BIN_DIR)$Sparser_main$E
+	-$(DEL) $(BIN_DIR)$Sparser_benchmark$E
+	-$(DEL) $(BIN_DIR)$Sfz_benchmark$E
 	-$(DEL) $(BIN_DIR)$Ssat_runner$E
 	-$(DEL) $(CPBINARIES)
 	-$(DEL) $(LPBINARIES)
@@ -705,10 +710,12 @@ UTIL_LIB_OBJS=\
 	$(OBJ_DIR)/util/cached_log.$O \
 	$(OBJ_DIR)/util/fp_utils.$O \
 	$(OBJ_DIR)/util/graph_export.$O \
+	$(OBJ_DIR)/util/memory_mapped_file.$O \
 	$(OBJ_DIR)/util/piecewise_linear_function.$O \
 	$(OBJ_DIR)/util/proto_tools.$O \
 	$(OBJ_DIR)/util/rational_approximation.$O \
 	$(OBJ_DIR)/util/stats.$O \
+	$(OBJ_DIR)/util/stats_registry.$O \
 	$(OBJ_DIR)/util/time_limit.$O \
 	$(OBJ_DIR)/util/xml_helper.$O
 
@@ -724,6 +731,9 @@ $(OBJ_DIR)/util/fp_utils.$O:$(SRC_DIR)/util/fp_utils.cc
 $(OBJ_DIR)/util/graph_export.$O:$(SRC_DIR)/util/graph_export.cc
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/util/graph_export.cc $(OBJ_OUT)$(OBJ_DIR)$Sutil$Sgraph_export.$O
 
+$(OBJ_DIR)/util/memory_mapped_file.$O:$(SRC_DIR)/util/memory_mapped_file.cc
+	$(CCC) $(CFLAGS) -c $(SRC_DIR)/util/memory_mapped_file.cc $(OBJ_OUT)$(OBJ_DIR)$Sutil$Smemory_mapped_file.$O
+
 $(OBJ_DIR)/util/piecewise_linear_function.$O:$(SRC_DIR)/util/piecewise_linear_function.cc
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/util/piecewise_linear_function.cc $(OBJ_OUT)$(OBJ_DIR)$Sutil$Spiecewise_linear_function.$O
 
@@ -736,6 +746,9 @@ $(OBJ_DIR)/util/rational_approximation.$O:$(SRC_DIR)/util/rational_approximation
 $(OBJ_DIR)/util/stats.$O:$(SRC_DIR)/util/stats.cc
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/util/stats.cc $(OBJ_OUT)$(OBJ_DIR)$Sutil$Sstats.$O
 
+$(OBJ_DIR)/util/stats_registry.$O:$(SRC_DIR)/util/stats_registry.cc $(SRC_DIR)/util/stats_registry.h
+	$(CCC) $(CFLAGS) -c $(SRC_DIR)/util/stats_registry.cc $(OBJ_OUT)$(OBJ_DIR)$Sutil$Sstats_registry.$O
+
 $(OBJ_DIR)/util/time_limit.$O:$(SRC_DIR)/util/time_limit.cc
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/util/time_limit.cc $(OBJ_OUT)$(OBJ_DIR)$Sutil$Stime_limit.$O
 
@@ -755,15 +768,22 @@ endif
 GRAPH_LIB_OBJS=\
 	$(OBJ_DIR)/graph/simple_assignment.$O \
 	$(OBJ_DIR)/graph/linear_assignment.$O \
+	$(OBJ_DIR)/graph/auction_assignment.$O \
 	$(OBJ_DIR)/graph/cliques.$O \
 	$(OBJ_DIR)/graph/connectivity.$O \
 	$(OBJ_DIR)/graph/flow_problem.pb.$O \
+	$(OBJ_DIR)/graph/mapped_graph.$O \
 	$(OBJ_DIR)/graph/max_flow.$O \
-	$(OBJ_DIR)/graph/min_cost_flow.$O
+	$(OBJ_DIR)/graph/min_cost_flow.$O \
+	$(OBJ_DIR)/graph/network_simplex.$O \
+	$(OBJ_DIR)/graph/parallel_max_flow.$O
 
 $(OBJ_DIR)/graph/linear_assignment.$O:$(SRC_DIR)/graph/linear_assignment.cc
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/graph/linear_assignment.cc $(OBJ_OUT)$(OBJ_DIR)$Sgraph$Slinear_assignment.$O
 
+$(OBJ_DIR)/graph/auction_assignment.$O:$(SRC_DIR)/graph/auction_assignment.cc $(SRC_DIR)/graph/auction_assignment.h
+	$(CCC) $(CFLAGS) -c $(SRC_DIR)/graph/auction_assignment.cc $(OBJ_OUT)$(OBJ_DIR)$Sgraph$Sauction_assignment.$O
+
 $(OBJ_DIR)/graph/simple_assignment.$O:$(SRC_DIR)/graph/assignment.cc
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/graph/assignment.cc $(OBJ_OUT)$(OBJ_DIR)$Sgraph$Ssimple_assignment.$O
 
@@ -781,14 +801,23 @@ $(GEN_DIR)/graph/flow_problem.pb.h:$(GEN_DIR)/graph/flow_problem.pb.cc
 $(OBJ_DIR)/graph/flow_problem.pb.$O:$(GEN_DIR)/graph/flow_problem.pb.cc
 	 $(CCC) $(CFLAGS) -c $(GEN_DIR)$Sgraph$Sflow_problem.pb.cc $(OBJ_OUT)$(OBJ_DIR)$Sgraph$Sflow_problem.pb.$O
 
-$(OBJ_DIR)/graph/max_flow.$O:$(SRC_DIR)/graph/max_flow.cc $(SRC_DIR)/util/stats.h $(GEN_DIR)/graph/flow_problem.pb.h
+$(OBJ_DIR)/graph/mapped_graph.$O:$(SRC_DIR)/graph/mapped_graph.cc $(SRC_DIR)/graph/mapped_graph.h
+	$(CCC) $(CFLAGS) -c $(SRC_DIR)/graph/mapped_graph.cc $(OBJ_OUT)$(OBJ_DIR)$Sgraph$Smapped_graph.$O
+
+$(OBJ_DIR)/graph/max_flow.$O:$(SRC_DIR)/graph/max_flow.cc $(SRC_DIR)/graph/mapped_graph.h $(SRC_DIR)/util/stats.h $(GEN_DIR)/graph/flow_problem.pb.h
 	 $(PROTOBUF_DIR)$Sbin$Sprotoc --proto_path=$(INC_DIR) --cpp_out=$(GEN_DIR) $(SRC_DIR)$Sgraph$Sflow_problem.proto
 	 $(PROTOBUF_DIR)$Sbin$Sprotoc --proto_path=$(INC_DIR) --cpp_out=$(GEN_DIR) $(SRC_DIR)$Sgraph$Sflow_problem.proto
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/graph/max_flow.cc $(OBJ_OUT)$(OBJ_DIR)$Sgraph$Smax_flow.$O
 
-$(OBJ_DIR)/graph/min_cost_flow.$O:$(SRC_DIR)/graph/min_cost_flow.cc $(GEN_DIR)/graph/flow_problem.pb.h
+$(OBJ_DIR)/graph/min_cost_flow.$O:$(SRC_DIR)/graph/min_cost_flow.cc $(SRC_DIR)/graph/mapped_graph.h $(SRC_DIR)/graph/network_simplex.h $(GEN_DIR)/graph/flow_problem.pb.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/graph/min_cost_flow.cc $(OBJ_OUT)$(OBJ_DIR)$Sgraph$Smin_cost_flow.$O
 
+$(OBJ_DIR)/graph/network_simplex.$O:$(SRC_DIR)/graph/network_simplex.cc $(SRC_DIR)/graph/network_simplex.h $(GEN_DIR)/graph/flow_problem.pb.h
+	$(CCC) $(CFLAGS) -c $(SRC_DIR)/graph/network_simplex.cc $(OBJ_OUT)$(OBJ_DIR)$Sgraph$Snetwork_simplex.$O
+
+$(OBJ_DIR)/graph/parallel_max_flow.$O:$(SRC_DIR)/graph/parallel_max_flow.cc $(SRC_DIR)/graph/parallel_max_flow.h $(GEN_DIR)/graph/flow_problem.pb.h
+	$(CCC) $(CFLAGS) -c $(SRC_DIR)/graph/parallel_max_flow.cc $(OBJ_OUT)$(OBJ_DIR)$Sgraph$Sparallel_max_flow.$O
+
 $(LIB_DIR)/$(LIBPREFIX)graph.$(DYNAMIC_LIB_SUFFIX): $(GRAPH_LIB_OBJS)
 	$(DYNAMIC_LINK_CMD) $(DYNAMIC_LINK_PREFIX)$(LIB_DIR)$S$(LIBPREFIX)graph.$(DYNAMIC_LIB_SUFFIX) $(GRAPH_LIB_OBJS)
 
@@ -1195,6 +1224,7 @@ endif
 
 FLATZINC_LIB_OBJS=\
 	$(OBJ_DIR)/flatzinc/constraints.$O\
+	$(OBJ_DIR)/flatzinc/fast_parser.$O\
 	$(OBJ_DIR)/flatzinc/flatzinc_constraints.$O\
 	$(OBJ_DIR)/flatzinc/model.$O\
 	$(OBJ_DIR)/flatzinc/parallel_support.$O\
@@ -1202,6 +1232,7 @@ FLATZINC_LIB_OBJS=\
 	$(OBJ_DIR)/flatzinc/parser.tab.$O\
 	$(OBJ_DIR)/flatzinc/parser.yy.$O\
 	$(OBJ_DIR)/flatzinc/presolve.$O\
+	$(OBJ_DIR)/flatzinc/sat_backend.$O\
 	$(OBJ_DIR)/flatzinc/sat_constraint.$O\
 	$(OBJ_DIR)/flatzinc/search.$O\
 	$(OBJ_DIR)/flatzinc/sequential_support.$O\
@@ -1218,6 +1249,9 @@ $(GEN_DIR)/flatzinc/parser.tab.hh: $(GEN_DIR)/flatzinc/parser.tab.cc
 $(OBJ_DIR)/flatzinc/constraints.$O:$(SRC_DIR)/flatzinc/constraints.cc $(SRC_DIR)/flatzinc/model.h $(SRC_DIR)/flatzinc/solver.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)$Sflatzinc$Sconstraints.cc $(OBJ_OUT)$(OBJ_DIR)$Sflatzinc$Sconstraints.$O
 
+$(OBJ_DIR)/flatzinc/fast_parser.$O:$(SRC_DIR)/flatzinc/fast_parser.cc $(SRC_DIR)/flatzinc/fast_parser.h $(SRC_DIR)/flatzinc/model.h
+	$(CCC) $(CFLAGS) -c $(SRC_DIR)$Sflatzinc$Sfast_parser.cc $(OBJ_OUT)$(OBJ_DIR)$Sflatzinc$Sfast_parser.$O
+
 $(OBJ_DIR)/flatzinc/flatzinc_constraints.$O:$(SRC_DIR)/flatzinc/flatzinc_constraints.cc $(SRC_DIR)/flatzinc/model.h $(SRC_DIR)/flatzinc/solver.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)$Sflatzinc$Sflatzinc_constraints.cc $(OBJ_OUT)$(OBJ_DIR)$Sflatzinc$Sflatzinc_constraints.$O
 
@@ -1239,6 +1273,9 @@ $(OBJ_DIR)/flatzinc/parser.yy.$O:$(GEN_DIR)/flatzinc/parser.yy.cc $(SRC_DIR)/fla
 $(OBJ_DIR)/flatzinc/presolve.$O:$(SRC_DIR)/flatzinc/presolve.cc $(SRC_DIR)/flatzinc/model.h $(SRC_DIR)/flatzinc/presolve.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)$Sflatzinc$Spresolve.cc $(OBJ_OUT)$(OBJ_DIR)$Sflatzinc$Spresolve.$O
 
+$(OBJ_DIR)/flatzinc/sat_backend.$O:$(SRC_DIR)/flatzinc/sat_backend.cc $(SRC_DIR)/flatzinc/model.h $(SRC_DIR)/flatzinc/sat_backend.h $(SRC_DIR)/flatzinc/search.h $(GEN_DIR)/sat/sat_parameters.pb.h
+	$(CCC) $(CFLAGS) -c $(SRC_DIR)$Sflatzinc$Ssat_backend.cc $(OBJ_OUT)$(OBJ_DIR)$Sflatzinc$Ssat_backend.$O
+
 $(OBJ_DIR)/flatzinc/sat_constraint.$O:$(SRC_DIR)/flatzinc/sat_constraint.cc $(SRC_DIR)/flatzinc/model.h $(SRC_DIR)/flatzinc/solver.h  $(GEN_DIR)/sat/sat_parameters.pb.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)$Sflatzinc$Ssat_constraint.cc $(OBJ_OUT)$(OBJ_DIR)$Sflatzinc$Ssat_constraint.$O
 
@@ -1260,7 +1297,13 @@ $(OBJ_DIR)/flatzinc/fz.$O:$(SRC_DIR)/flatzinc/fz.cc $(SRC_DIR)/flatzinc/model.h
 $(OBJ_DIR)/flatzinc/parser_main.$O:$(SRC_DIR)/flatzinc/parser_main.cc $(SRC_DIR)/flatzinc/model.h $(SRC_DIR)/flatzinc/solver.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)$Sflatzinc$Sparser_main.cc $(OBJ_OUT)$(OBJ_DIR)$Sflatzinc$Sparser_main.$O
 
-fz : $(BIN_DIR)/fz$E $(BIN_DIR)/parser_main$E
+$(OBJ_DIR)/flatzinc/parser_benchmark.$O:$(SRC_DIR)/flatzinc/parser_benchmark.cc $(SRC_DIR)/flatzinc/model.h $(SRC_DIR)/flatzinc/parser.h $(SRC_DIR)/flatzinc/fast_parser.h
+	$(CCC) $(CFLAGS) -c $(SRC_DIR)$Sflatzinc$Sparser_benchmark.cc $(OBJ_OUT)$(OBJ_DIR)$Sflatzinc$Sparser_benchmark.$O
+
+$(OBJ_DIR)/flatzinc/fz_benchmark.$O:$(SRC_DIR)/flatzinc/fz_benchmark.cc
+	$(CCC) $(CFLAGS) -c $(SRC_DIR)$Sflatzinc$Sfz_benchmark.cc $(OBJ_OUT)$(OBJ_DIR)$Sflatzinc$Sfz_benchmark.$O
+
+fz : $(BIN_DIR)/fz$E $(BIN_DIR)/parser_main$E $(BIN_DIR)/parser_benchmark$E $(BIN_DIR)/fz_benchmark$E
 
 $(BIN_DIR)/fz$E: $(OBJ_DIR)/flatzinc/fz.$O $(STATIC_FLATZINC_DEPS)
 	$(CCC) $(CFLAGS) $(OBJ_DIR)$Sflatzinc$Sfz.$O $(STATIC_FZ) $(STATIC_FLATZINC_LNK) $(STATIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sfz$E
@@ -1268,6 +1311,17 @@ $(BIN_DIR)/fz$E: $(OBJ_DIR)/flatzinc/fz.$O $(STATIC_FLATZINC_DEPS)
 $(BIN_DIR)/parser_main$E: $(OBJ_DIR)/flatzinc/parser_main.$O $(STATIC_FLATZINC_DEPS)
 	$(CCC) $(CFLAGS) $(OBJ_DIR)$Sflatzinc$Sparser_main.$O $(STATIC_FZ) $(STATIC_FLATZINC_LNK) $(STATIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sparser_main$E
 
+$(BIN_DIR)/parser_benchmark$E: $(OBJ_DIR)/flatzinc/parser_benchmark.$O $(STATIC_FLATZINC_DEPS)
+	$(CCC) $(CFLAGS) $(OBJ_DIR)$Sflatzinc$Sparser_benchmark.$O $(STATIC_FZ) $(STATIC_FLATZINC_LNK) $(STATIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sparser_benchmark$E
+
+$(BIN_DIR)/fz_benchmark$E: $(OBJ_DIR)/flatzinc/fz_benchmark.$O $(STATIC_FLATZINC_DEPS)
+	$(CCC) $(CFLAGS) $(OBJ_DIR)$Sflatzinc$Sfz_benchmark.$O $(STATIC_FZ) $(STATIC_FLATZINC_LNK) $(STATIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sfz_benchmark$E
+
+# Runs the flatzinc benchmark. Pass FZ_BENCHMARK_FLAGS=--baseline=<file.json>
+# to compare with the results of a previous run.
+run_fz_benchmark: $(BIN_DIR)/fz$E $(BIN_DIR)/fz_benchmark$E
+	$(BIN_DIR)$Sfz_benchmark$E --fz_binary=$(BIN_DIR)$Sfz$E --instances=$(EX_DIR)$Sflatzinc$Sbenchmark_instances.txt --output=fz_benchmark.json $(FZ_BENCHMARK_FLAGS)
+
 # Flow and linear assignment cpp
 
 $(OBJ_DIR)/linear_assignment_api.$O:$(EX_DIR)/cpp/linear_assignment_api.cc
@@ -1282,12 +1336,44 @@ $(OBJ_DIR)/flow_api.$O:$(EX_DIR)/cpp/flow_api.cc
 $(BIN_DIR)/flow_api$E: $(DYNAMIC_GRAPH_DEPS) $(OBJ_DIR)/flow_api.$O
 	$(CCC) $(CFLAGS) $(OBJ_DIR)/flow_api.$O $(DYNAMIC_GRAPH_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sflow_api$E
 
+$(OBJ_DIR)/auction_assignment_test.$O:$(EX_DIR)/tests/auction_assignment_test.cc $(SRC_DIR)/graph/auction_assignment.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/auction_assignment_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sauction_assignment_test.$O
+
+$(BIN_DIR)/auction_assignment_test$E: $(DYNAMIC_GRAPH_DEPS) $(OBJ_DIR)/auction_assignment_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/auction_assignment_test.$O $(DYNAMIC_GRAPH_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sauction_assignment_test$E
+
+$(OBJ_DIR)/cliques_test.$O:$(EX_DIR)/tests/cliques_test.cc $(SRC_DIR)/graph/cliques.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/cliques_test.cc $(OBJ_OUT)$(OBJ_DIR)$Scliques_test.$O
+
+$(BIN_DIR)/cliques_test$E: $(DYNAMIC_GRAPH_DEPS) $(OBJ_DIR)/cliques_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/cliques_test.$O $(DYNAMIC_GRAPH_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Scliques_test$E
+
+$(OBJ_DIR)/max_flow_benchmark.$O:$(EX_DIR)/cpp/max_flow_benchmark.cc
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Scpp/max_flow_benchmark.cc $(OBJ_OUT)$(OBJ_DIR)$Smax_flow_benchmark.$O
+
+$(BIN_DIR)/max_flow_benchmark$E: $(DYNAMIC_GRAPH_DEPS) $(OBJ_DIR)/max_flow_benchmark.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/max_flow_benchmark.$O $(DYNAMIC_GRAPH_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Smax_flow_benchmark$E
+
+$(OBJ_DIR)/graph_types_benchmark.$O:$(EX_DIR)/cpp/graph_types_benchmark.cc
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Scpp/graph_types_benchmark.cc $(OBJ_OUT)$(OBJ_DIR)$Sgraph_types_benchmark.$O
+
+$(BIN_DIR)/graph_types_benchmark$E: $(DYNAMIC_GRAPH_DEPS) $(OBJ_DIR)/graph_types_benchmark.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/graph_types_benchmark.$O $(DYNAMIC_GRAPH_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sgraph_types_benchmark$E
+
 $(OBJ_DIR)/dimacs_assignment.$O:$(EX_DIR)/cpp/dimacs_assignment.cc
 	$(CCC) $(CFLAGS) -c $(EX_DIR)$Scpp/dimacs_assignment.cc $(OBJ_OUT)$(OBJ_DIR)$Sdimacs_assignment.$O
 
 $(BIN_DIR)/dimacs_assignment$E: $(DYNAMIC_DIMACS_DEPS) $(OBJ_DIR)/dimacs_assignment.$O
 	$(CCC) $(CFLAGS) $(OBJ_DIR)/dimacs_assignment.$O $(DYNAMIC_DIMACS_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sdimacs_assignment$E
 
+# Utilities
+
+$(OBJ_DIR)/hash_map_benchmark.$O:$(EX_DIR)/cpp/hash_map_benchmark.cc $(SRC_DIR)/base/flat_hash_map.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Scpp/hash_map_benchmark.cc $(OBJ_OUT)$(OBJ_DIR)$Shash_map_benchmark.$O
+
+$(BIN_DIR)/hash_map_benchmark$E: $(DYNAMIC_BASE_DEPS) $(OBJ_DIR)/hash_map_benchmark.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/hash_map_benchmark.$O $(DYNAMIC_BASE_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Shash_map_benchmark$E
+
 # Pure CP and Routing Examples
 
 $(OBJ_DIR)/acp_challenge.$O:$(EX_DIR)/cpp/acp_challenge.cc $(SRC_DIR)/constraint_solver/constraint_solver.h
@@ -1422,7 +1508,7 @@ $(OBJ_DIR)/sports_scheduling.$O:$(EX_DIR)/cpp/sports_scheduling.cc $(SRC_DIR)/co
 $(BIN_DIR)/sports_scheduling$E: $(DYNAMIC_CP_DEPS) $(OBJ_DIR)/sports_scheduling.$O
 	$(CCC) $(CFLAGS) $(OBJ_DIR)/sports_scheduling.$O $(DYNAMIC_CP_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Ssports_scheduling$E
 
-$(OBJ_DIR)/tsp.$O: $(EX_DIR)/cpp/tsp.cc $(SRC_DIR)/constraint_solver/constraint_solver.h $(SRC_DIR)/constraint_solver/routing.h
+$(OBJ_DIR)/tsp.$O: $(EX_DIR)/cpp/tsp.cc $(SRC_DIR)/constraint_solver/constraint_solver.h $(SRC_DIR)/constraint_solver/routing.h $(SRC_DIR)/graph/minimum_spanning_tree.h $(SRC_DIR)/graph/one_tree_lower_bound.h
 	$(CCC) $(CFLAGS) -c $(EX_DIR)$Scpp/tsp.cc $(OBJ_OUT)$(OBJ_DIR)$Stsp.$O
 
 $(BIN_DIR)/tsp$E: $(DYNAMIC_ROUTING_DEPS) $(OBJ_DIR)/tsp.$O
@@ -1547,7 +1633,7 @@ satlibs: $(DYNAMIC_SAT_DEPS) $(STATIC_SAT_DEPS)
 $(OBJ_DIR)/sat/sat_solver.$O: $(SRC_DIR)/sat/sat_solver.cc $(SRC_DIR)/sat/sat_solver.h $(SRC_DIR)/sat/sat_base.h $(SRC_DIR)/sat/clause.h $(SRC_DIR)/sat/encoding.h $(SRC_DIR)/sat/unsat_proof.h $(GEN_DIR)/sat/sat_parameters.pb.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/sat/sat_solver.cc $(OBJ_OUT)$(OBJ_DIR)$Ssat$Ssat_solver.$O
 
-$(OBJ_DIR)/sat/lp_utils.$O: $(SRC_DIR)/sat/lp_utils.cc $(SRC_DIR)/sat/lp_utils.h $(SRC_DIR)/sat/sat_solver.h $(GEN_DIR)/sat/sat_parameters.pb.h $(GEN_DIR)/glop/parameters.pb.h
+$(OBJ_DIR)/sat/lp_utils.$O: $(SRC_DIR)/sat/lp_utils.cc $(SRC_DIR)/sat/lp_utils.h $(SRC_DIR)/sat/sat_solver.h $(SRC_DIR)/algorithms/find_graph_symmetries.h $(SRC_DIR)/algorithms/dynamic_partition.h $(GEN_DIR)/sat/sat_parameters.pb.h $(GEN_DIR)/glop/parameters.pb.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/sat/lp_utils.cc $(OBJ_OUT)$(OBJ_DIR)$Ssat$Slp_utils.$O
 
 $(OBJ_DIR)/sat/simplification.$O: $(SRC_DIR)/sat/simplification.cc  $(SRC_DIR)/sat/simplification.h $(SRC_DIR)/sat/sat_base.h $(GEN_DIR)/sat/sat_parameters.pb.h
@@ -1655,7 +1741,7 @@ $(OBJ_DIR)/bop/bop_util.$O: $(SRC_DIR)/bop/bop_util.cc $(SRC_DIR)/bop/bop_util.h
 $(OBJ_DIR)/bop/complete_optimizer.$O: $(SRC_DIR)/bop/complete_optimizer.cc $(SRC_DIR)/bop/complete_optimizer.h $(SRC_DIR)/bop/bop_util.h $(SRC_DIR)/bop/bop_types.h $(SRC_DIR)/bop/bop_base.h $(SRC_DIR)/bop/bop_solution.h $(GEN_DIR)/bop/bop_parameters.pb.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/bop/complete_optimizer.cc $(OBJ_OUT)$(OBJ_DIR)$Sbop$Scomplete_optimizer.$O
 
-$(OBJ_DIR)/bop/integral_solver.$O: $(SRC_DIR)/bop/integral_solver.cc $(SRC_DIR)/bop/integral_solver.h $(SRC_DIR)/bop/bop_solver.h $(SRC_DIR)/bop/bop_util.h $(SRC_DIR)/bop/bop_types.h $(SRC_DIR)/bop/bop_base.h $(SRC_DIR)/bop/bop_fs.h $(SRC_DIR)/bop/bop_ls.h $(SRC_DIR)/bop/bop_lns.h $(SRC_DIR)/bop/bop_portfolio.h $(SRC_DIR)/bop/bop_solution.h $(GEN_DIR)/bop/bop_parameters.pb.h
+$(OBJ_DIR)/bop/integral_solver.$O: $(SRC_DIR)/bop/integral_solver.cc $(SRC_DIR)/bop/integral_solver.h $(SRC_DIR)/bop/bop_solver.h $(SRC_DIR)/sat/lp_utils.h $(SRC_DIR)/bop/bop_util.h $(SRC_DIR)/bop/bop_types.h $(SRC_DIR)/bop/bop_base.h $(SRC_DIR)/bop/bop_fs.h $(SRC_DIR)/bop/bop_ls.h $(SRC_DIR)/bop/bop_lns.h $(SRC_DIR)/bop/bop_portfolio.h $(SRC_DIR)/bop/bop_solution.h $(GEN_DIR)/bop/bop_parameters.pb.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/bop/integral_solver.cc $(OBJ_OUT)$(OBJ_DIR)$Sbop$Sintegral_solver.$O
 
 $(LIB_DIR)/$(LIBPREFIX)bop.$(DYNAMIC_LIB_SUFFIX): $(BOP_LIB_OBJS)
@@ -18,6 +18,7 @@
 #include "base/stringprintf.h"
 #include "base/join.h"
 #include "base/murmur.h"
+#include "util/bitset.h"
 
 namespace operations_research {
 
@@ -97,6 +98,8 @@ void DynamicPartition::Refine(const std::vector<int>& distinguished_subset) {
   tmp_counter_of_part_.resize(NumParts(), 0);
   // We remember the Parts that were actually affected.
   tmp_affected_parts_.clear();
+  int min_affected_part = NumParts();
+  int max_affected_part = -1;
   for (const int element : distinguished_subset) {
     DCHECK_GE(element, 0);
     DCHECK_LT(element, NumElements());
@@ -106,6 +109,8 @@ void DynamicPartition::Refine(const std::vector<int>& distinguished_subset) {
     if (num_distinguished_elements_in_part == 1) {
       // TODO(user): optimize the common singleton case.
       tmp_affected_parts_.push_back(part);
+      min_affected_part = std::min(min_affected_part, part);
+      max_affected_part = std::max(max_affected_part, part);
     }
     // Move the element to the end of its current Part.
     const int old_index = index_of_[element];
@@ -120,9 +125,21 @@ void DynamicPartition::Refine(const std::vector<int>& distinguished_subset) {
   }
 
   // Sort affected parts. This is important to behave as advertised in the .h.
-  // TODO(user, fdid): automatically switch to an O(N) sort when it's faster
-  // than this one, which is O(K log K) with K = tmp_affected_parts_.size().
-  std::sort(tmp_affected_parts_.begin(), tmp_affected_parts_.end());
+  // This is O(K log K) with K = tmp_affected_parts_.size(), or O(R) with a
+  // scan of the range R of the affected part indices, which is faster when
+  // many parts are affected, e.g. when refining a graph by degree.
+  const int num_affected_parts = tmp_affected_parts_.size();
+  const int affected_part_range = max_affected_part - min_affected_part + 1;
+  if (num_affected_parts > 1 &&
+      num_affected_parts * MostSignificantBitPosition32(num_affected_parts) >
+          affected_part_range) {
+    tmp_affected_parts_.clear();
+    for (int part = min_affected_part; part <= max_affected_part; ++part) {
+      if (tmp_counter_of_part_[part] > 0) tmp_affected_parts_.push_back(part);
+    }
+  } else {
+    std::sort(tmp_affected_parts_.begin(), tmp_affected_parts_.end());
+  }
 
   // Iterate on each affected part and split it, or keep it intact if all
   // of its elements were distinguished.
@@ -16,8 +16,10 @@
 #include <algorithm>
 #include <limits>
 #include <numeric>
+#include <thread>
 
 #include "base/commandlineflags.h"
+#include "base/fingerprint2011.h"
 #include "base/stringprintf.h"
 #include "base/join.h"
 #include "algorithms/dense_doubly_linked_list.h"
@@ -36,6 +38,9 @@ DEFINE_bool(minimize_permutation_support_size, false,
 namespace operations_research {
 
 namespace {
+// The deterministic time of scanning one arc during a refinement.
+const double kDeterministicTimePerArc = 1e-8;
+
 // Some routines used below.
 void SwapFrontAndBack(std::vector<int>* v) {
   DCHECK(!v->empty());
@@ -94,12 +99,16 @@ bool ListMapsToList(const List& l1, const List& l2,
 
 GraphSymmetryFinder::GraphSymmetryFinder(const Graph& graph, bool is_undirected)
     : graph_(graph),
+      // Set up an "unlimited" time limit by default.
+      default_time_limit_(
+          new TimeLimit(std::numeric_limits<double>::infinity())),
+      time_limit_(default_time_limit_.get()),
+      num_threads_(1),
+      refinement_fprint_(0),
       tmp_dynamic_permutation_(NumNodes()),
       tmp_node_mask_(NumNodes(), false),
       tmp_degree_(NumNodes(), 0),
       tmp_nodes_with_degree_(NumNodes() + 1) {
-  // Set up an "unlimited" time limit by default.
-  time_limit_.reset(new TimeLimit(std::numeric_limits<double>::infinity()));
   tmp_partition_.Reset(NumNodes());
   if (is_undirected) {
     DCHECK(GraphIsSymmetric(graph));
@@ -166,17 +175,20 @@ bool GraphSymmetryFinder::IsGraphAutomorphism(
 
 namespace {
 // Specialized subroutine, to avoid code duplication: see its call site
-// and its self-explanatory code.
+// and its self-explanatory code. Returns the number of nodes scanned.
 template <class T>
-inline void IncrementCounterForNonSingletons(const T& nodes,
-                                             const DynamicPartition& partition,
-                                             std::vector<int>* node_count,
-                                             std::vector<int>* nodes_seen) {
+inline int IncrementCounterForNonSingletons(const T& nodes,
+                                            const DynamicPartition& partition,
+                                            std::vector<int>* node_count,
+                                            std::vector<int>* nodes_seen) {
+  int num_nodes = 0;
   for (const int node : nodes) {
+    ++num_nodes;
     if (partition.ElementsInSamePartAs(node).size() == 1) continue;
     const int count = ++(*node_count)[node];
     if (count == 1) nodes_seen->push_back(node);
   }
+  return num_nodes;
 }
 }  // namespace
 
@@ -200,6 +212,7 @@ void GraphSymmetryFinder::RecursivelyRefinePartitionByAdjacency(
   if (!reverse_adj_list_index_.empty()) {
     adjacency_directions.push_back(false);  // Also look at incoming arcs.
   }
+  int64 num_scanned_arcs = 0;
   for (int part_index = first_unrefined_part_index;
        part_index < partition->NumParts();  // Moving target!
        ++part_index) {
@@ -208,39 +221,58 @@ void GraphSymmetryFinder::RecursivelyRefinePartitionByAdjacency(
       // come from/to the current part.
       if (outgoing_adjacency) {
         for (const int node : partition->ElementsInPart(part_index)) {
-          IncrementCounterForNonSingletons(graph_[node], *partition,
-                                           &tmp_degree_,
-                                           &tmp_nodes_with_nonzero_degree);
+          num_scanned_arcs += IncrementCounterForNonSingletons(
+              graph_[node], *partition, &tmp_degree_,
+              &tmp_nodes_with_nonzero_degree);
         }
       } else {
         for (const int node : partition->ElementsInPart(part_index)) {
-          IncrementCounterForNonSingletons(TailsOfIncomingArcsTo(node),
-                                           *partition, &tmp_degree_,
-                                           &tmp_nodes_with_nonzero_degree);
+          num_scanned_arcs += IncrementCounterForNonSingletons(
+              TailsOfIncomingArcsTo(node), *partition, &tmp_degree_,
+              &tmp_nodes_with_nonzero_degree);
         }
       }
-      // Group the nodes by (nonzero) degree. Remember the maximum degree.
-      int max_degree = 0;
+      // Group the nodes by (nonzero) degree, as in a counting sort, and
+      // collect the distinct degrees: there are at most as many of them as
+      // nodes, which may be much less than the maximum degree.
       for (const int node : tmp_nodes_with_nonzero_degree) {
         const int degree = tmp_degree_[node];
         tmp_degree_[node] = 0;  // To clean up after us.
-        max_degree = std::max(max_degree, degree);
+        if (tmp_nodes_with_degree_[degree].empty()) {
+          tmp_degrees_.push_back(degree);
+        }
         tmp_nodes_with_degree_[degree].push_back(node);
       }
       tmp_nodes_with_nonzero_degree.clear();  // To clean up after us.
-      // For each degree, refine the partition by the set of nodes with that
-      // degree.
-      for (int degree = 1; degree <= max_degree; ++degree) {
+      // For each degree, by increasing degree, refine the partition by the set
+      // of nodes with that degree.
+      std::sort(tmp_degrees_.begin(), tmp_degrees_.end());
+      for (const int degree : tmp_degrees_) {
+        const int num_parts_before_refinement = partition->NumParts();
         partition->Refine(tmp_nodes_with_degree_[degree]);
         tmp_nodes_with_degree_[degree].clear();  // To clean up after us.
+        if (partition->NumParts() != num_parts_before_refinement) {
+          refinement_fprint_ = FingerprintCat2011(
+              refinement_fprint_,
+              (static_cast<uint64>(part_index) << 32) + 2 * degree +
+                  outgoing_adjacency);
+          refinement_fprint_ =
+              FingerprintCat2011(refinement_fprint_, partition->NumParts());
+        }
       }
+      tmp_degrees_.clear();  // To clean up after us.
     }
   }
+  time_limit_->AdvanceDeterministicTime(kDeterministicTimePerArc *
+                                        num_scanned_arcs);
 }
 
-void GraphSymmetryFinder::DistinguishNodeInPartition(
+uint64 GraphSymmetryFinder::DistinguishNodeInPartition(
     int node, DynamicPartition* partition, std::vector<int>* new_singletons) {
   const int original_num_parts = partition->NumParts();
+  refinement_fprint_ = FingerprintCat2011(partition->PartOf(node),
+                                          partition->SizeOfPart(
+                                              partition->PartOf(node)));
   partition->Refine(std::vector<int>(1, node));
   RecursivelyRefinePartitionByAdjacency(partition->PartOf(node), partition);
 
@@ -265,6 +297,7 @@ void GraphSymmetryFinder::DistinguishNodeInPartition(
       tmp_node_mask_[partition->ParentOfPart(p)] = false;
     }
   }
+  return refinement_fprint_;
 }
 
 namespace {
@@ -345,12 +378,38 @@ void GetAllOtherRepresentativesInSamePartAs(
 }
 }  // namespace
 
+GraphSymmetryFinder::SearchThread::SearchThread(
+    const Graph& graph, bool is_undirected, const DynamicPartition& partition)
+    : finder(new GraphSymmetryFinder(graph, is_undirected)),
+      base_partition(partition),
+      image_partition(partition) {}
+
 util::Status GraphSymmetryFinder::FindSymmetries(
     double time_limit_seconds, std::vector<int>* node_equivalence_classes_io,
     std::vector<std::unique_ptr<SparsePermutation>>* generators,
     std::vector<int>* factorized_automorphism_group_size) {
+  TimeLimit time_limit(time_limit_seconds);
+  return FindSymmetries(&time_limit, node_equivalence_classes_io, generators,
+                        factorized_automorphism_group_size);
+}
+
+util::Status GraphSymmetryFinder::FindSymmetries(
+    TimeLimit* time_limit, std::vector<int>* node_equivalence_classes_io,
+    std::vector<std::unique_ptr<SparsePermutation>>* generators,
+    std::vector<int>* factorized_automorphism_group_size) {
+  time_limit_ = time_limit;
+  const util::Status status =
+      DoFindSymmetries(node_equivalence_classes_io, generators,
+                       factorized_automorphism_group_size);
+  time_limit_ = default_time_limit_.get();
+  return status;
+}
+
+util::Status GraphSymmetryFinder::DoFindSymmetries(
+    std::vector<int>* node_equivalence_classes_io,
+    std::vector<std::unique_ptr<SparsePermutation>>* generators,
+    std::vector<int>* factorized_automorphism_group_size) {
   // Initialization.
-  time_limit_.reset(new TimeLimit(time_limit_seconds));
   IF_STATS_ENABLED(stats_.initialization_time.StartTimer());
   generators->clear();
   factorized_automorphism_group_size->clear();
@@ -434,6 +493,18 @@ util::Status GraphSymmetryFinder::FindSymmetries(
   // Now we've dived to the bottom: we're left with the identity permutation,
   // which we don't need as a generator. We move on to phase 2).
 
+  // With several threads, each of the other threads gets its own copy of the
+  // partitions, which it keeps in the same state as ours.
+  std::vector<std::unique_ptr<SearchThread>> threads;
+  for (int i = 1; i < num_threads_; ++i) {
+    threads.emplace_back(new SearchThread(
+        graph_, /*is_undirected=*/reverse_adj_list_index_.empty(),
+        base_partition));
+  }
+  std::vector<std::unique_ptr<SparsePermutation>> parallel_permutations;
+  std::vector<int> parallel_index_of_node(threads.empty() ? 0 : NumNodes());
+  bool parallel_search_interrupted = false;
+
   IF_STATS_ENABLED(stats_.main_search_time.StartTimer());
   while (!invariant_dive_stack.empty()) {
     if (time_limit_->LimitReached()) break;
@@ -445,6 +516,10 @@ util::Status GraphSymmetryFinder::FindSymmetries(
     invariant_dive_stack.pop_back();
     base_partition.UndoRefineUntilNumPartsEqual(base_num_parts);
     image_partition.UndoRefineUntilNumPartsEqual(base_num_parts);
+    for (const std::unique_ptr<SearchThread>& thread : threads) {
+      thread->base_partition.UndoRefineUntilNumPartsEqual(base_num_parts);
+      thread->image_partition.UndoRefineUntilNumPartsEqual(base_num_parts);
+    }
     VLOG(4) << "Backtracking invariant dive: root node = " << root_node
             << "; partition: "
             << base_partition.DebugString(DynamicPartition::SORT_BY_PART);
@@ -476,10 +551,30 @@ util::Status GraphSymmetryFinder::FindSymmetries(
     DCHECK(!potential_root_image_nodes.empty());
     IF_STATS_ENABLED(stats_.invariant_unroll_time.StopTimerAndAddElapsedTime());
 
+    // With several threads, we search a permutation for all the potential
+    // images at once, and then process them as in the sequential search
+    // below. The permutations of the images that the sequential search would
+    // have pruned are ignored, and those of the other images are valid
+    // answers, even though they were found without the pruning by the
+    // permutations found for the same root node.
+    const bool parallel =
+        !threads.empty() && potential_root_image_nodes.size() > 1;
+    if (parallel) {
+      if (!FindSuitablePermutationsInParallel(
+              root_node, potential_root_image_nodes, &base_partition,
+              &image_partition, *generators, permutations_displacing_node,
+              threads, &parallel_permutations)) {
+        parallel_search_interrupted = true;
+      }
+      for (int i = 0; i < potential_root_image_nodes.size(); ++i) {
+        parallel_index_of_node[potential_root_image_nodes[i]] = i;
+      }
+    }
+
     // Try to map "root_node" to all of its potential images. For each image,
     // we only care about finding a single compatible permutation, if it exists.
     while (!potential_root_image_nodes.empty()) {
-      if (time_limit_->LimitReached()) break;
+      if (!parallel && time_limit_->LimitReached()) break;
       VLOG(4) << "Potential (pruned) images of root node " << root_node
               << " left: [" << strings::Join(potential_root_image_nodes, " ")
               << "].";
@@ -487,9 +582,12 @@ util::Status GraphSymmetryFinder::FindSymmetries(
       VLOG(4) << "Trying image of root node: " << root_image_node;
 
       std::unique_ptr<SparsePermutation> permutation =
-          FindOneSuitablePermutation(root_node, root_image_node,
-                                     &base_partition, &image_partition,
-                                     *generators, permutations_displacing_node);
+          parallel ? std::move(parallel_permutations
+                                   [parallel_index_of_node[root_image_node]])
+                   : FindOneSuitablePermutation(
+                         root_node, root_image_node, &base_partition,
+                         &image_partition, *generators,
+                         permutations_displacing_node);
 
       if (permutation.get() != nullptr) {
         ScopedTimeDistributionUpdater u(&stats_.permutation_output_time);
@@ -527,17 +625,75 @@ util::Status GraphSymmetryFinder::FindSymmetries(
     // TODO(user): better, more complete explanation.
     factorized_automorphism_group_size->push_back(
         node_equivalence_classes.NumNodesInSamePartAs(root_node));
+    if (parallel_search_interrupted) break;
   }
   node_equivalence_classes.FillEquivalenceClasses(node_equivalence_classes_io);
   IF_STATS_ENABLED(stats_.main_search_time.StopTimerAndAddElapsedTime());
   IF_STATS_ENABLED(LOG(INFO) << "Statistics: " << stats_.StatString());
-  if (time_limit_->LimitReached()) {
+  if (parallel_search_interrupted || time_limit_->LimitReached()) {
     return util::Status(util::error::DEADLINE_EXCEEDED,
                         "Some automorphisms were found, but probably not all.");
   }
   return util::Status::OK;
 }
 
+bool GraphSymmetryFinder::FindSuitablePermutationsInParallel(
+    int root_node, const std::vector<int>& root_image_nodes,
+    DynamicPartition* base_partition, DynamicPartition* image_partition,
+    const std::vector<std::unique_ptr<SparsePermutation>>& generators_found_so_far,
+    const std::vector<std::vector<int>>& permutations_displacing_node,
+    const std::vector<std::unique_ptr<SearchThread>>& threads,
+    std::vector<std::unique_ptr<SparsePermutation>>* permutations) {
+  permutations->clear();
+  permutations->resize(root_image_nodes.size());
+  std::atomic<int> next_index(0);
+  std::vector<std::thread> workers;
+  for (const std::unique_ptr<SearchThread>& thread : threads) {
+    // Each thread gets the time left, and its deterministic time is added to
+    // ours once it is done.
+    thread->time_limit.reset(new TimeLimit(
+        time_limit_->GetTimeLeft(), time_limit_->GetDeterministicTimeLeft()));
+    thread->finder->time_limit_ = thread->time_limit.get();
+    workers.push_back(std::thread(
+        &GraphSymmetryFinder::FindSuitablePermutations, thread->finder.get(),
+        root_node, &root_image_nodes, &thread->base_partition,
+        &thread->image_partition, &generators_found_so_far,
+        &permutations_displacing_node, &next_index, permutations));
+  }
+  FindSuitablePermutations(root_node, &root_image_nodes, base_partition,
+                           image_partition, &generators_found_so_far,
+                           &permutations_displacing_node, &next_index,
+                           permutations);
+  bool limit_reached = time_limit_->LimitReached();
+  for (int i = 0; i < threads.size(); ++i) {
+    workers[i].join();
+    SearchThread* const thread = threads[i].get();
+    time_limit_->AdvanceDeterministicTime(
+        thread->time_limit->GetElapsedDeterministicTime());
+    if (thread->time_limit->LimitReached()) limit_reached = true;
+    thread->finder->time_limit_ = thread->finder->default_time_limit_.get();
+  }
+  return !limit_reached;
+}
+
+void GraphSymmetryFinder::FindSuitablePermutations(
+    int root_node, const std::vector<int>* root_image_nodes,
+    DynamicPartition* base_partition, DynamicPartition* image_partition,
+    const std::vector<std::unique_ptr<SparsePermutation>>* generators_found_so_far,
+    const std::vector<std::vector<int>>* permutations_displacing_node,
+    std::atomic<int>* next_index,
+    std::vector<std::unique_ptr<SparsePermutation>>* permutations) {
+  for (;;) {
+    const int index = (*next_index)++;
+    if (index >= root_image_nodes->size() || time_limit_->LimitReached()) {
+      return;
+    }
+    (*permutations)[index] = FindOneSuitablePermutation(
+        root_node, (*root_image_nodes)[index], base_partition, image_partition,
+        *generators_found_so_far, *permutations_displacing_node);
+  }
+}
+
 namespace {
 // This method can be easily understood in the context of
 // ConfirmFullMatchOrFindNextMappingDecision(): see its call sites.
@@ -617,10 +773,21 @@ GraphSymmetryFinder::FindOneSuitablePermutation(
   search_states_.back().remaining_pruned_image_nodes.assign(1, root_image_node);
   {
     ScopedTimeDistributionUpdater u(&stats_.initial_search_refine_time);
-    DistinguishNodeInPartition(root_node, base_partition, &base_singletons);
+    search_states_.back().base_refinement_fprint =
+        DistinguishNodeInPartition(root_node, base_partition, &base_singletons);
   }
   while (!search_states_.empty()) {
-    if (time_limit_->LimitReached()) return nullptr;
+    if (time_limit_->LimitReached()) {
+      // Restore the partitions and the temporary objects to their original
+      // state, as when a permutation is found.
+      const int base_num_parts =
+          search_states_[0].num_parts_before_trying_to_map_base_node;
+      base_partition->UndoRefineUntilNumPartsEqual(base_num_parts);
+      image_partition->UndoRefineUntilNumPartsEqual(base_num_parts);
+      tmp_dynamic_permutation_.Reset();
+      search_states_.clear();
+      return nullptr;
+    }
     // When exploring a SearchState "ss", we're supposed to have:
     // - A base_partition that has already been refined on ss->base_node.
     //   (base_singleton is the list of singletons created on the base
@@ -643,10 +810,11 @@ GraphSymmetryFinder::FindOneSuitablePermutation(
 
     // Apply the decision: map base_node to image_node. Since base_partition
     // was already refined on base_node, we just need to refine image_partition.
+    uint64 image_refinement_fprint = 0;
     {
       ScopedTimeDistributionUpdater u(&stats_.search_refine_time);
-      DistinguishNodeInPartition(image_node, image_partition,
-                                 &image_singletons);
+      image_refinement_fprint = DistinguishNodeInPartition(
+          image_node, image_partition, &image_singletons);
     }
     VLOG(4) << ss.DebugString();
     VLOG(4) << base_partition->DebugString(DynamicPartition::SORT_BY_PART);
@@ -655,7 +823,8 @@ GraphSymmetryFinder::FindOneSuitablePermutation(
     // Run some diagnoses on the two partitions. There are many outcomes, so
     // it's a bit complicated:
     // 1) The partitions are incompatible
-    //   - Because of a straightfoward criterion (size mismatch).
+    //   - Because of a straightfoward criterion (size mismatch, or different
+    //     refinements, as seen with their fingerprints).
     //   - Because they are both fully refined (i.e. singletons only), yet the
     //     permutation induced by them is not a graph automorpshim.
     // 2) The partitions induce a permutation (all their non-singleton parts are
@@ -668,9 +837,10 @@ GraphSymmetryFinder::FindOneSuitablePermutation(
     bool compatible = true;
     {
       ScopedTimeDistributionUpdater u(&stats_.quick_compatibility_time);
-      compatible = PartitionsAreCompatibleAfterPartIndex(
-          *base_partition, *image_partition,
-          ss.num_parts_before_trying_to_map_base_node);
+      compatible = image_refinement_fprint == ss.base_refinement_fprint &&
+                   PartitionsAreCompatibleAfterPartIndex(
+                       *base_partition, *image_partition,
+                       ss.num_parts_before_trying_to_map_base_node);
       u.AlsoUpdate(compatible ? &stats_.quick_compatibility_success_time
                               : &stats_.quick_compatibility_fail_time);
     }
@@ -829,8 +999,9 @@ GraphSymmetryFinder::FindOneSuitablePermutation(
         min_potential_mismatching_part_index);
     {
       ScopedTimeDistributionUpdater u(&stats_.search_refine_time);
-      DistinguishNodeInPartition(next_base_node, base_partition,
-                                 &base_singletons);
+      search_states_.back().base_refinement_fprint =
+          DistinguishNodeInPartition(next_base_node, base_partition,
+                                     &base_singletons);
     }
   }
   // We exhausted the search; we didn't find any permutation.
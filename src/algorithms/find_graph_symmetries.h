@@ -16,6 +16,7 @@
 #ifndef OR_TOOLS_ALGORITHMS_FIND_GRAPH_SYMMETRIES_H_
 #define OR_TOOLS_ALGORITHMS_FIND_GRAPH_SYMMETRIES_H_
 
+#include <atomic>
 #include "base/unique_ptr.h"
 #include <vector>
 
@@ -84,7 +85,8 @@ class GraphSymmetryFinder {
   //
   // DEADLINE AND PARTIAL COMPLETION:
   // If the deadline passed as argument is reached, this method will return
-  // quickly (within a few milliseconds). The outputs may be partially filled:
+  // quickly (within a few milliseconds) with a DEADLINE_EXCEEDED status. The
+  // outputs may be partially filled:
   // - Each element of "generators", if non-empty, will be a valid permutation.
   // - "node_equivalence_classes_io" will contain the equivalence classes
   //   corresponding to the orbits under all the generators in "generators".
@@ -100,6 +102,24 @@ class GraphSymmetryFinder {
       std::vector<std::unique_ptr<SparsePermutation>>* generators,
       std::vector<int>* factorized_automorphism_group_size);
 
+  // Same as above, with a TimeLimit, which may also have a deterministic time
+  // limit: the search advances its deterministic time by 1e-8 per arc scanned
+  // during the refinements of the partitions.
+  util::Status FindSymmetries(
+      TimeLimit* time_limit, std::vector<int>* node_equivalence_classes_io,
+      std::vector<std::unique_ptr<SparsePermutation>>* generators,
+      std::vector<int>* factorized_automorphism_group_size);
+
+  // Sets the number of threads used by FindSymmetries(), including the calling
+  // thread. Defaults to 1. With several threads, the potential images of each
+  // node of the invariant dive are tried in parallel, each thread with its own
+  // copy of the partitions. This finds the same equivalence classes and group
+  // size, but may find other generators.
+  void set_num_threads(int num_threads) {
+    CHECK_GE(num_threads, 1);
+    num_threads_ = num_threads;
+  }
+
   // **** Methods below are public FOR TESTING ONLY. ****
 
   // Fully refine the partition of nodes, using the graph as symmetry breaker.
@@ -120,8 +140,14 @@ class GraphSymmetryFinder {
   // fully refined, further refine it by {node}, and propagate by adjacency.
   // Also, optionally collect all the new singletons of the partition in
   // "new_singletons", sorted by their part number in the partition.
-  void DistinguishNodeInPartition(int node, DynamicPartition* partition,
-                                  std::vector<int>* new_singletons_or_null);
+  //
+  // Returns a fingerprint of the refinement, i.e. of the sequence of the
+  // parts that were split and of the degrees used to split them. If a graph
+  // automorphism maps a partition onto another one, part by part, and maps a
+  // node onto another one, then distinguishing these nodes in these partitions
+  // gives the same fingerprint. The search uses it to prune mappings early.
+  uint64 DistinguishNodeInPartition(int node, DynamicPartition* partition,
+                                    std::vector<int>* new_singletons_or_null);
 
  private:
   const Graph& graph_;
@@ -143,8 +169,61 @@ class GraphSymmetryFinder {
   BeginEndWrapper<std::vector<int>::const_iterator> TailsOfIncomingArcsTo(
       int node) const;
 
-  // Deadline management. Populated upon FindSymmetries().
-  mutable std::unique_ptr<TimeLimit> time_limit_;
+  // Deadline management. time_limit_ points to the TimeLimit given to
+  // FindSymmetries(), or to default_time_limit_ (unlimited) outside of it.
+  std::unique_ptr<TimeLimit> default_time_limit_;
+  TimeLimit* time_limit_;
+
+  int num_threads_;
+
+  // The fingerprint of the refinements since the last call to
+  // DistinguishNodeInPartition(), updated by
+  // RecursivelyRefinePartitionByAdjacency().
+  uint64 refinement_fprint_;
+
+  // The implementation of FindSymmetries(), with the time limit in
+  // time_limit_.
+  util::Status DoFindSymmetries(
+      std::vector<int>* node_equivalence_classes_io,
+      std::vector<std::unique_ptr<SparsePermutation>>* generators,
+      std::vector<int>* factorized_automorphism_group_size);
+
+  // The state of one of the other threads of the parallel search: its own
+  // finder, with its own temporary objects and time limit, and its own copy
+  // of the partitions.
+  struct SearchThread {
+    SearchThread(const Graph& graph, bool is_undirected,
+                 const DynamicPartition& partition);
+    std::unique_ptr<GraphSymmetryFinder> finder;
+    DynamicPartition base_partition;
+    DynamicPartition image_partition;
+    std::unique_ptr<TimeLimit> time_limit;
+  };
+
+  // Tries to map "root_node" to each node of "root_image_nodes", in parallel
+  // with the given threads and the calling thread: (*permutations)[i] is set
+  // to the permutation found by FindOneSuitablePermutation() for
+  // root_image_nodes[i], or to nullptr. The partitions of all threads must be
+  // in the same state. Returns false if the time limit of one of the threads
+  // was reached.
+  bool FindSuitablePermutationsInParallel(
+      int root_node, const std::vector<int>& root_image_nodes,
+      DynamicPartition* base_partition, DynamicPartition* image_partition,
+      const std::vector<std::unique_ptr<SparsePermutation>>& generators_found_so_far,
+      const std::vector<std::vector<int>>& permutations_displacing_node,
+      const std::vector<std::unique_ptr<SearchThread>>& threads,
+      std::vector<std::unique_ptr<SparsePermutation>>* permutations);
+
+  // The function run by each thread of FindSuitablePermutationsInParallel():
+  // it calls FindOneSuitablePermutation() on the root image nodes whose index
+  // it gets from "next_index", until there is none left.
+  void FindSuitablePermutations(
+      int root_node, const std::vector<int>* root_image_nodes,
+      DynamicPartition* base_partition, DynamicPartition* image_partition,
+      const std::vector<std::unique_ptr<SparsePermutation>>* generators_found_so_far,
+      const std::vector<std::vector<int>>* permutations_displacing_node,
+      std::atomic<int>* next_index,
+      std::vector<std::unique_ptr<SparsePermutation>>* permutations);
 
   // Internal search code used in FindSymmetries(), split out for readability:
   // find one permutation (if it exists) that maps root_node to root_image_node
@@ -176,6 +255,11 @@ class GraphSymmetryFinder {
 
     int num_parts_before_trying_to_map_base_node;
 
+    // The fingerprint of the refinement of the base partition by base_node,
+    // which the refinement of the image partition by the image node must
+    // match.
+    uint64 base_refinement_fprint;
+
     // Only parts that are at or beyond this index, or their parent parts, may
     // be mismatching between the base and the image partitions.
     int min_potential_mismatching_part_index;
@@ -184,6 +268,7 @@ class GraphSymmetryFinder {
         : base_node(bn),
           first_image_node(in),
           num_parts_before_trying_to_map_base_node(np),
+          base_refinement_fprint(0),
           min_potential_mismatching_part_index(mi) {}
 
     std::string DebugString() const;
@@ -229,6 +314,7 @@ class GraphSymmetryFinder {
   std::vector<int> tmp_degree_;                       // [0..N-1] = 0.
   std::vector<int> tmp_stack_;                        // Empty.
   std::vector<std::vector<int>> tmp_nodes_with_degree_;    // [0..N-1] = [].
+  std::vector<int> tmp_degrees_;                      // Empty.
   MergingPartition tmp_partition_;               // Reset(N).
   std::vector<const SparsePermutation*> tmp_compatible_permutations_;  // Empty.
 
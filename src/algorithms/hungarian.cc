@@ -11,30 +11,24 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-// See: //depot/google3/java/com/google/wireless/genie/frontend
-//       /mixer/matching/HungarianOptimizer.java
-
 #include "algorithms/hungarian.h"
 
 #include <algorithm>
-#include <cstdio>
 #include <limits>
 
+#include "base/logging.h"
+
 namespace operations_research {
 
 class HungarianOptimizer {
-  static const int kHungarianOptimizerRowNotFound = -1;
-  static const int kHungarianOptimizerColNotFound = -2;
-
  public:
   // Setup the initial conditions for the algorithm.
 
   // Parameters: costs is a matrix of the cost of assigning each agent to
   // each task. costs[i][j] is the cost of assigning agent i to task j.
-  // All the costs must be non-negative.  This matrix does not have to
-  // be square (i.e. we can have different numbers of agents and tasks), but it
-  // must be regular (i.e. there must be the same number of entries in each row
-  // of the matrix).
+  // This matrix does not have to be square (i.e. we can have different
+  // numbers of agents and tasks), but it must be regular (i.e. there must be
+  // the same number of entries in each row of the matrix).
   explicit HungarianOptimizer(const std::vector<std::vector<double> >& costs);
 
   // Find an assignment which maximizes the total cost.
@@ -48,242 +42,124 @@ class HungarianOptimizer {
   void Minimize(std::vector<int>* agent, std::vector<int>* task);
 
  private:
-  typedef void (HungarianOptimizer::*Step)();
-
-  typedef enum {
-    NONE,
-    PRIME,
-    STAR
-  } Mark;
-
-  // Convert the final cost matrix into a set of assignments of agents -> tasks.
+  // Column reduction and reduction transfer of Jonker and Volgenant: assigns
+  // each column to the row where its cost is the smallest, if this row is not
+  // assigned yet, and computes the initial dual values of the rows and
+  // columns. Only valid for square problems.
+  void ReduceColumns();
+
+  // Finds a shortest augmenting path from the free row 'start_row' to a free
+  // column, with the reduced costs as lengths, and returns this column. Fills
+  // path_ with the predecessor row of each column and shortest_path_costs_
+  // with the distance to each column, and sets *path_cost to the length of the
+  // path. The scanned rows and columns are marked in scanned_rows_ and
+  // scanned_cols_. Returns -1 if no column can be reached with a finite
+  // cost.
+  int FindShortestAugmentingPath(int start_row, double* path_cost);
+
+  // Assigns 'start_row', by augmenting along the shortest augmenting path from
+  // it, and updates the dual values so that the reduced costs stay
+  // non-negative and are zero on the assigned cells.
+  void Augment(int start_row);
+
+  // Runs the algorithm: column reduction on square problems, then one
+  // augmentation per free row.
+  void Solve();
+
+  // Convert the final assignment of the rows into a set of assignments of
+  // agents -> tasks.
   // Returns the assignment in the two vectors passed as argument, the same as
   // Minimize and Maximize
   void FindAssignments(std::vector<int>* agent, std::vector<int>* task);
 
-  // Is the cell (row, col) starred?
-  bool IsStarred(int row, int col) const { return marks_[row][col] == STAR; }
-
-  // Mark cell (row, col) with a star
-  void Star(int row, int col) {
-    marks_[row][col] = STAR;
-    stars_in_col_[col]++;
-  }
-
-  // Remove a star from cell (row, col)
-  void UnStar(int row, int col) {
-    marks_[row][col] = NONE;
-    stars_in_col_[col]--;
+  // The costs of the cells of row 'row'.
+  const double* RowCosts(int row) const {
+    return &costs_[static_cast<size_t>(row) * num_cols_];
   }
 
-  // Find a column in row 'row' containing a star, or return
-  // kHungarianOptimizerColNotFound if no such column exists.
-  int FindStarInRow(int row) const;
-
-  // Find a row in column 'col' containing a star, or return
-  // kHungarianOptimizerRowNotFound if no such row exists.
-  int FindStarInCol(int col) const;
-
-  // Is cell (row, col) marked with a prime?
-  bool IsPrimed(int row, int col) const { return marks_[row][col] == PRIME; }
-
-  // Mark cell (row, col) with a prime.
-  void Prime(int row, int col) { marks_[row][col] = PRIME; }
-
-  // Find a column in row containing a prime, or return
-  // kHungarianOptimizerColNotFound if no such column exists.
-  int FindPrimeInRow(int row) const;
-
-  // Remove the prime marks_ from every cell in the matrix.
-  void ClearPrimes();
-
-  // Does column col contain a star?
-  bool ColContainsStar(int col) const { return stars_in_col_[col] > 0; }
-
-  // Is row 'row' covered?
-  bool RowCovered(int row) const { return rows_covered_[row]; }
-
-  // Cover row 'row'.
-  void CoverRow(int row) { rows_covered_[row] = true; }
-
-  // Uncover row 'row'.
-  void UncoverRow(int row) { rows_covered_[row] = false; }
-
-  // Is column col covered?
-  bool ColCovered(int col) const { return cols_covered_[col]; }
-
-  // Cover column col.
-  void CoverCol(int col) { cols_covered_[col] = true; }
-
-  // Uncover column col.
-  void UncoverCol(int col) { cols_covered_[col] = false; }
-
-  // Uncover ever row and column in the matrix.
-  void ClearCovers();
-
-  // Find the smallest uncovered cell in the matrix.
-  double FindSmallestUncovered() const;
-
-  // Find an uncovered zero and store its coordinates in (zeroRow_, zeroCol_)
-  // and return true, or return false if no such cell exists.
-  bool FindZero(int* zero_row, int* zero_col) const;
-
-  // Print the matrix to stdout (for debugging.)
-  void PrintMatrix();
-
-  // Run the Munkres algorithm!
-  void DoMunkres();
-
-  // Step 1.
-  // For each row of the matrix, find the smallest element and subtract it
-  // from every element in its row.  Go to Step 2.
-  void ReduceRows();
-
-  // Step 2.
-  // Find a zero (Z) in the matrix.  If there is no starred zero in its row
-  // or column, star Z.  Repeat for every element in the matrix.  Go to step 3.
-  // Note: profiling shows this method to use 9.2% of the CPU - the next
-  // slowest step takes 0.6%.  I can't think of a way of speeding it up though.
-  void StarZeroes();
-
-  // Step 3.
-  // Cover each column containing a starred zero.  If all columns are
-  // covered, the starred zeros describe a complete set of unique assignments.
-  // In this case, terminate the algorithm.  Otherwise, go to step 4.
-  void CoverStarredZeroes();
-
-  // Step 4.
-  // Find a noncovered zero and prime it.  If there is no starred zero in the
-  // row containing this primed zero, Go to Step 5.  Otherwise, cover this row
-  // and uncover the column containing the starred zero. Continue in this manner
-  // until there are no uncovered zeros left, then go to Step 6.
-  void PrimeZeroes();
-
-  // Step 5.
-  // Construct a series of alternating primed and starred zeros as follows.
-  // Let Z0 represent the uncovered primed zero found in Step 4.  Let Z1 denote
-  // the starred zero in the column of Z0 (if any). Let Z2 denote the primed
-  // zero in the row of Z1 (there will always be one).  Continue until the
-  // series terminates at a primed zero that has no starred zero in its column.
-  // Unstar each starred zero of the series, star each primed zero of the
-  // series, erase all primes and uncover every line in the matrix.  Return to
-  // Step 3.
-  void MakeAugmentingPath();
-
-  // Step 6.
-  // Add the smallest uncovered value in the matrix to every element of each
-  // covered row, and subtract it from every element of each uncovered column.
-  // Return to Step 4 without altering any stars, primes, or covered lines.
-  void AugmentPath();
-
-  // The size of the problem, i.e. std::max(#agents, #tasks).
-  int matrix_size_;
-
-  // The expanded cost matrix.
-  std::vector<std::vector<double> > costs_;
-
-  // The greatest cost in the initial cost matrix.
-  double max_cost_;
-
-  // Which rows and columns are currently covered.
-  std::vector<bool> rows_covered_;
-  std::vector<bool> cols_covered_;
-
-  // The marks_ (star/prime/none) on each element of the cost matrix.
-  std::vector<std::vector<Mark> > marks_;
-
-  // The number of stars in each column - used to speed up coverStarredZeroes.
-  std::vector<int> stars_in_col_;
-
-  // Representation of a path_ through the matrix - used in step 5.
-  std::vector<int> preimage_;  // i.e. the agents
-  std::vector<int> image_;     // i.e. the tasks
-
-  // The locations of a zero found in step 4.
-  int zero_col_, zero_row_;
-
-  // The width_ and height_ of the initial (non-expanded) cost matrix.
-  int width_;
-  int height_;
-
-  // The current state of the algorithm
-  HungarianOptimizer::Step state_;
+  // The number of agents and tasks.
+  int num_agents_;
+  int num_tasks_;
+
+  // The algorithm needs at least as many columns as rows: when there are more
+  // agents than tasks, the rows of the matrix are the tasks.
+  bool transposed_;
+  int num_rows_;
+  int num_cols_;
+
+  // The cost matrix, row by row: costs_[row * num_cols_ + col] is the cost of
+  // cell (row, col).
+  std::vector<double> costs_;
+
+  // The dual values of the rows and columns. The reduced cost of cell
+  // (row, col) is costs_[row * num_cols_ + col] - row_dual_[row] -
+  // col_dual_[col]. It is non-negative on all the cells, and zero on the
+  // assigned cells.
+  std::vector<double> row_dual_;
+  std::vector<double> col_dual_;
+
+  // The column assigned to each row and the row assigned to each column, or
+  // -1.
+  std::vector<int> col_of_row_;
+  std::vector<int> row_of_col_;
+
+  // The state of the shortest path computations, see
+  // FindShortestAugmentingPath().
+  std::vector<int> path_;
+  std::vector<double> shortest_path_costs_;
+  std::vector<bool> scanned_rows_;
+  std::vector<bool> scanned_cols_;
+
+  // The columns that are not scanned yet, in the first num_remaining entries.
+  std::vector<int> remaining_cols_;
 };
 
-HungarianOptimizer::HungarianOptimizer(const std::vector<std::vector<double> >& costs)
-    : matrix_size_(0),
+HungarianOptimizer::HungarianOptimizer(
+    const std::vector<std::vector<double> >& costs)
+    : num_agents_(costs.size()),
+      num_tasks_(costs.empty() ? 0 : costs[0].size()),
+      transposed_(false),
+      num_rows_(0),
+      num_cols_(0),
       costs_(),
-      max_cost_(0),
-      rows_covered_(),
-      cols_covered_(),
-      marks_(),
-      stars_in_col_(),
-      preimage_(),
-      image_(),
-      zero_col_(0),
-      zero_row_(0),
-      width_(0),
-      height_(0),
-      state_(NULL) {
-  width_ = costs.size();
-
-  if (width_ > 0) {
-    height_ = costs[0].size();
-  } else {
-    height_ = 0;
-  }
-
-  matrix_size_ = std::max(width_, height_);
-  max_cost_ = 0;
-
-  // Generate the expanded cost matrix by adding extra 0-valued elements in
-  // order to make a square matrix.  At the same time, find the greatest cost
-  // in the matrix (used later if we want to maximize rather than minimize the
-  // overall cost.)
-  costs_.resize(matrix_size_);
-  for (int row = 0; row < matrix_size_; ++row) {
-    costs_[row].resize(matrix_size_);
-  }
-
-  for (int row = 0; row < matrix_size_; ++row) {
-    for (int col = 0; col < matrix_size_; ++col) {
-      if ((row >= width_) || (col >= height_)) {
-        costs_[row][col] = 0;
-      } else {
-        costs_[row][col] = costs[row][col];
-        max_cost_ = std::max(max_cost_, costs_[row][col]);
+      row_dual_(),
+      col_dual_(),
+      col_of_row_(),
+      row_of_col_(),
+      path_(),
+      shortest_path_costs_(),
+      scanned_rows_(),
+      scanned_cols_(),
+      remaining_cols_() {
+  transposed_ = num_agents_ > num_tasks_;
+  num_rows_ = transposed_ ? num_tasks_ : num_agents_;
+  num_cols_ = transposed_ ? num_agents_ : num_tasks_;
+  // Copy the costs to a contiguous matrix, so that the scans of the rows are
+  // sequential memory accesses.
+  costs_.resize(static_cast<size_t>(num_rows_) * num_cols_);
+  for (int agent = 0; agent < num_agents_; ++agent) {
+    const std::vector<double>& agent_costs = costs[agent];
+    CHECK_EQ(num_tasks_, agent_costs.size());
+    if (transposed_) {
+      for (int task = 0; task < num_tasks_; ++task) {
+        costs_[static_cast<size_t>(task) * num_cols_ + agent] =
+            agent_costs[task];
       }
+    } else {
+      std::copy(agent_costs.begin(), agent_costs.end(),
+                costs_.begin() + static_cast<size_t>(agent) * num_cols_);
     }
   }
-
-  // Initially, none of the cells of the matrix are marked.
-  marks_.resize(matrix_size_);
-  for (int row = 0; row < matrix_size_; ++row) {
-    marks_[row].resize(matrix_size_);
-    for (int col = 0; col < matrix_size_; ++col) {
-      marks_[row][col] = NONE;
-    }
-  }
-
-  stars_in_col_.resize(matrix_size_);
-
-  rows_covered_.resize(matrix_size_);
-  cols_covered_.resize(matrix_size_);
-
-  preimage_.resize(matrix_size_ * 2);
-  image_.resize(matrix_size_ * 2);
 }
 
 // Find an assignment which maximizes the total cost.
 // Return an array of pairs of integers.  Each pair (i, j) corresponds to
 // assigning agent i to task j.
-void HungarianOptimizer::Maximize(std::vector<int>* preimage, std::vector<int>* image) {
-  // Find a maximal assignment by subtracting each of the
-  // original costs from max_cost_  and then minimizing.
-  for (int row = 0; row < width_; ++row) {
-    for (int col = 0; col < height_; ++col) {
-      costs_[row][col] = max_cost_ - costs_[row][col];
-    }
+void HungarianOptimizer::Maximize(std::vector<int>* preimage,
+                                  std::vector<int>* image) {
+  // Find a maximal assignment by minimizing the opposite costs.
+  for (size_t i = 0; i < costs_.size(); ++i) {
+    costs_[i] = -costs_[i];
   }
   Minimize(preimage, image);
 }
@@ -291,360 +167,168 @@ void HungarianOptimizer::Maximize(std::vector<int>* preimage, std::vector<int>*
 // Find an assignment which minimizes the total cost.
 // Return an array of pairs of integers.  Each pair (i, j) corresponds to
 // assigning agent i to task j.
-void HungarianOptimizer::Minimize(std::vector<int>* preimage, std::vector<int>* image) {
-  DoMunkres();
+void HungarianOptimizer::Minimize(std::vector<int>* preimage,
+                                  std::vector<int>* image) {
+  Solve();
   FindAssignments(preimage, image);
 }
 
-// Convert the final cost matrix into a set of assignments of agents -> tasks.
-// Return an array of pairs of integers, the same as the return values of
-// Minimize() and Maximize()
+// Convert the final assignment of the rows into a set of assignments of
+// agents -> tasks. Return an array of pairs of integers, the same as the
+// return values of Minimize() and Maximize()
 void HungarianOptimizer::FindAssignments(std::vector<int>* preimage,
                                          std::vector<int>* image) {
   preimage->clear();
   image->clear();
-  for (int row = 0; row < width_; ++row) {
-    for (int col = 0; col < height_; ++col) {
-      if (IsStarred(row, col)) {
-        preimage->push_back(row);
-        image->push_back(col);
-        break;
+  if (transposed_) {
+    for (int col = 0; col < num_cols_; ++col) {
+      if (row_of_col_[col] != -1) {
+        preimage->push_back(col);
+        image->push_back(row_of_col_[col]);
       }
     }
-  }
-  // TODO(user)
-  // result_size = std::min(width_, height_);
-  // CHECK image.size() == result_size
-  // CHECK preimage.size() == result_size
-}
-
-// Find a column in row 'row' containing a star, or return
-// kHungarianOptimizerColNotFound if no such column exists.
-int HungarianOptimizer::FindStarInRow(int row) const {
-  for (int col = 0; col < matrix_size_; ++col) {
-    if (IsStarred(row, col)) {
-      return col;
-    }
-  }
-
-  return kHungarianOptimizerColNotFound;
-}
-
-// Find a row in column 'col' containing a star, or return
-// kHungarianOptimizerRowNotFound if no such row exists.
-int HungarianOptimizer::FindStarInCol(int col) const {
-  if (!ColContainsStar(col)) {
-    return kHungarianOptimizerRowNotFound;
-  }
-
-  for (int row = 0; row < matrix_size_; ++row) {
-    if (IsStarred(row, col)) {
-      return row;
-    }
-  }
-
-  // NOTREACHED
-  return kHungarianOptimizerRowNotFound;
-}
-
-// Find a column in row containing a prime, or return
-// kHungarianOptimizerColNotFound if no such column exists.
-int HungarianOptimizer::FindPrimeInRow(int row) const {
-  for (int col = 0; col < matrix_size_; ++col) {
-    if (IsPrimed(row, col)) {
-      return col;
-    }
-  }
-
-  return kHungarianOptimizerColNotFound;
-}
-
-// Remove the prime marks from every cell in the matrix.
-void HungarianOptimizer::ClearPrimes() {
-  for (int row = 0; row < matrix_size_; ++row) {
-    for (int col = 0; col < matrix_size_; ++col) {
-      if (IsPrimed(row, col)) {
-        marks_[row][col] = NONE;
-      }
+  } else {
+    for (int row = 0; row < num_rows_; ++row) {
+      preimage->push_back(row);
+      image->push_back(col_of_row_[row]);
     }
   }
 }
 
-// Uncovery ever row and column in the matrix.
-void HungarianOptimizer::ClearCovers() {
-  for (int x = 0; x < matrix_size_; x++) {
-    UncoverRow(x);
-    UncoverCol(x);
+void HungarianOptimizer::Solve() {
+  row_dual_.assign(num_rows_, 0.0);
+  col_dual_.assign(num_cols_, 0.0);
+  col_of_row_.assign(num_rows_, -1);
+  row_of_col_.assign(num_cols_, -1);
+  path_.assign(num_cols_, -1);
+  shortest_path_costs_.resize(num_cols_);
+  scanned_rows_.resize(num_rows_);
+  scanned_cols_.resize(num_cols_);
+  remaining_cols_.resize(num_cols_);
+  // On rectangular problems, the dual values of the columns that end up not
+  // assigned must be the largest ones, which is the case when they all start
+  // at 0 and only decrease when the columns are scanned.
+  if (num_rows_ == num_cols_) ReduceColumns();
+  for (int row = 0; row < num_rows_; ++row) {
+    if (col_of_row_[row] == -1) Augment(row);
   }
 }
 
-// Find the smallest uncovered cell in the matrix.
-double HungarianOptimizer::FindSmallestUncovered() const {
-  double minval = std::numeric_limits<double>::max();
-
-  for (int row = 0; row < matrix_size_; ++row) {
-    if (RowCovered(row)) {
-      continue;
-    }
-
-    for (int col = 0; col < matrix_size_; ++col) {
-      if (ColCovered(col)) {
-        continue;
+void HungarianOptimizer::ReduceColumns() {
+  std::vector<int> num_min_cols(num_rows_, 0);
+  // The columns are scanned in reverse order, as in Jonker and Volgenant.
+  for (int col = num_cols_ - 1; col >= 0; --col) {
+    int min_row = 0;
+    double min_cost = costs_[col];
+    for (int row = 1; row < num_rows_; ++row) {
+      const double cost = costs_[static_cast<size_t>(row) * num_cols_ + col];
+      if (cost < min_cost) {
+        min_cost = cost;
+        min_row = row;
       }
-
-      minval = std::min(minval, costs_[row][col]);
     }
-  }
-
-  return minval;
-}
-
-// Find an uncovered zero and store its co-ordinates in (zeroRow, zeroCol)
-// and return true, or return false if no such cell exists.
-bool HungarianOptimizer::FindZero(int* zero_row, int* zero_col) const {
-  for (int row = 0; row < matrix_size_; ++row) {
-    if (RowCovered(row)) {
-      continue;
-    }
-
-    for (int col = 0; col < matrix_size_; ++col) {
-      if (ColCovered(col)) {
-        continue;
-      }
-
-      if (costs_[row][col] == 0) {
-        *zero_row = row;
-        *zero_col = col;
-        return true;
-      }
+    col_dual_[col] = min_cost;
+    ++num_min_cols[min_row];
+    if (col_of_row_[min_row] == -1) {
+      col_of_row_[min_row] = col;
+      row_of_col_[col] = min_row;
     }
   }
-
-  return false;
-}
-
-// Print the matrix to stdout (for debugging.)
-void HungarianOptimizer::PrintMatrix() {
-  for (int row = 0; row < matrix_size_; ++row) {
-    for (int col = 0; col < matrix_size_; ++col) {
-      printf("%g ", costs_[row][col]);
-
-      if (IsStarred(row, col)) {
-        printf("*");
-      }
-
-      if (IsPrimed(row, col)) {
-        printf("'");
-      }
+  // Reduction transfer: the rows assigned to the only column where they have
+  // their minimum give the slack of their second best column to this column.
+  for (int row = 0; row < num_rows_; ++row) {
+    const int assigned_col = col_of_row_[row];
+    if (assigned_col == -1 || num_min_cols[row] != 1) continue;
+    const double* const row_costs = RowCosts(row);
+    double min_reduced_cost = std::numeric_limits<double>::infinity();
+    for (int col = 0; col < num_cols_; ++col) {
+      if (col == assigned_col) continue;
+      min_reduced_cost = std::min(min_reduced_cost,
+                                  row_costs[col] - col_dual_[col]);
     }
-    printf("\n");
+    if (min_reduced_cost == std::numeric_limits<double>::infinity()) continue;
+    row_dual_[row] = min_reduced_cost;
+    col_dual_[assigned_col] = row_costs[assigned_col] - min_reduced_cost;
   }
 }
 
-//  Run the Munkres algorithm!
-void HungarianOptimizer::DoMunkres() {
-  state_ = &HungarianOptimizer::ReduceRows;
-  while (state_ != NULL) {
-    (this->*state_)();
+int HungarianOptimizer::FindShortestAugmentingPath(int start_row,
+                                                   double* path_cost) {
+  const double kInfinity = std::numeric_limits<double>::infinity();
+  int num_remaining = num_cols_;
+  for (int i = 0; i < num_cols_; ++i) {
+    // Filling the columns in reverse order gives an order close to the natural
+    // one once columns are removed, which keeps the accesses sequential.
+    remaining_cols_[i] = num_cols_ - i - 1;
   }
-}
+  std::fill(scanned_rows_.begin(), scanned_rows_.end(), false);
+  std::fill(scanned_cols_.begin(), scanned_cols_.end(), false);
+  std::fill(shortest_path_costs_.begin(), shortest_path_costs_.end(),
+            kInfinity);
 
-// Step 1.
-// For each row of the matrix, find the smallest element and subtract it
-// from every element in its row.  Go to Step 2.
-void HungarianOptimizer::ReduceRows() {
-  for (int row = 0; row < matrix_size_; ++row) {
-    double min_cost = costs_[row][0];
-    for (int col = 1; col < matrix_size_; ++col) {
-      min_cost = std::min(min_cost, costs_[row][col]);
-    }
-    for (int col = 0; col < matrix_size_; ++col) {
-      costs_[row][col] -= min_cost;
-    }
-  }
-  state_ = &HungarianOptimizer::StarZeroes;
-}
-
-// Step 2.
-// Find a zero (Z) in the matrix.  If there is no starred zero in its row
-// or column, star Z.  Repeat for every element in the matrix.  Go to step 3.
-// of the CPU - the next slowest step takes 0.6%.  I can't think of a way
-// of speeding it up though.
-void HungarianOptimizer::StarZeroes() {
-  // Since no rows or columns are covered on entry to this step, we use the
-  // covers as a quick way of marking which rows & columns have stars in them.
-  for (int row = 0; row < matrix_size_; ++row) {
-    if (RowCovered(row)) {
-      continue;
-    }
-
-    for (int col = 0; col < matrix_size_; ++col) {
-      if (ColCovered(col)) {
-        continue;
+  double min_cost = 0.0;
+  int row = start_row;
+  for (;;) {
+    scanned_rows_[row] = true;
+    const double* const row_costs = RowCosts(row);
+    const double row_offset = min_cost - row_dual_[row];
+    // The distances to the columns are updated with the arcs leaving 'row',
+    // and the closest column is selected, preferring free columns on ties,
+    // in the same scan.
+    int best_index = -1;
+    double lowest = kInfinity;
+    for (int i = 0; i < num_remaining; ++i) {
+      const int col = remaining_cols_[i];
+      const double cost = row_offset + row_costs[col] - col_dual_[col];
+      if (cost < shortest_path_costs_[col]) {
+        path_[col] = row;
+        shortest_path_costs_[col] = cost;
       }
-
-      if (costs_[row][col] == 0) {
-        Star(row, col);
-        CoverRow(row);
-        CoverCol(col);
-        break;
+      if (shortest_path_costs_[col] < lowest ||
+          (shortest_path_costs_[col] == lowest && row_of_col_[col] == -1)) {
+        lowest = shortest_path_costs_[col];
+        best_index = i;
       }
     }
-  }
-
-  ClearCovers();
-  state_ = &HungarianOptimizer::CoverStarredZeroes;
-}
-
-// Step 3.
-// Cover each column containing a starred zero.  If all columns are
-// covered, the starred zeros describe a complete set of unique assignments.
-// In this case, terminate the algorithm.  Otherwise, go to step 4.
-void HungarianOptimizer::CoverStarredZeroes() {
-  int num_covered = 0;
-
-  for (int col = 0; col < matrix_size_; ++col) {
-    if (ColContainsStar(col)) {
-      CoverCol(col);
-      num_covered++;
-    }
-  }
-
-  if (num_covered >= matrix_size_) {
-    state_ = NULL;
-    return;
-  }
-  state_ = &HungarianOptimizer::PrimeZeroes;
-}
-
-// Step 4.
-// Find a noncovered zero and prime it.  If there is no starred zero in the
-// row containing this primed zero, Go to Step 5.  Otherwise, cover this row
-// and uncover the column containing the starred zero. Continue in this manner
-// until there are no uncovered zeros left, then go to Step 6.
-
-void HungarianOptimizer::PrimeZeroes() {
-  // This loop is guaranteed to terminate in at most matrix_size_ iterations,
-  // as findZero() returns a location only if there is at least one uncovered
-  // zero in the matrix.  Each iteration, either one row is covered or the
-  // loop terminates.  Since there are matrix_size_ rows, after that many
-  // iterations there are no uncovered cells and hence no uncovered zeroes,
-  // so the loop terminates.
-  for (;;) {
-    int zero_row, zero_col;
-    if (!FindZero(&zero_row, &zero_col)) {
-      // No uncovered zeroes.
-      state_ = &HungarianOptimizer::AugmentPath;
-      return;
-    }
-
-    Prime(zero_row, zero_col);
-    int star_col = FindStarInRow(zero_row);
-
-    if (star_col != kHungarianOptimizerColNotFound) {
-      CoverRow(zero_row);
-      UncoverCol(star_col);
-    } else {
-      preimage_[0] = zero_row;
-      image_[0] = zero_col;
-      state_ = &HungarianOptimizer::MakeAugmentingPath;
-      return;
+    if (lowest == kInfinity) return -1;
+    min_cost = lowest;
+    const int col = remaining_cols_[best_index];
+    scanned_cols_[col] = true;
+    remaining_cols_[best_index] = remaining_cols_[--num_remaining];
+    if (row_of_col_[col] == -1) {
+      *path_cost = min_cost;
+      return col;
     }
+    row = row_of_col_[col];
   }
 }
 
-// Step 5.
-// Construct a series of alternating primed and starred zeros as follows.
-// Let Z0 represent the uncovered primed zero found in Step 4.  Let Z1 denote
-// the starred zero in the column of Z0 (if any). Let Z2 denote the primed
-// zero in the row of Z1 (there will always be one).  Continue until the
-// series terminates at a primed zero that has no starred zero in its column.
-// Unstar each starred zero of the series, star each primed zero of the
-// series, erase all primes and uncover every line in the matrix.  Return to
-// Step 3.
-void HungarianOptimizer::MakeAugmentingPath() {
-  bool done = false;
-  int count = 0;
-
-  // Note: this loop is guaranteed to terminate within matrix_size_ iterations
-  // because:
-  // 1) on entry to this step, there is at least 1 column with no starred zero
-  //    (otherwise we would have terminated the algorithm already.)
-  // 2) each row containing a star also contains exactly one primed zero.
-  // 4) each column contains at most one starred zero.
-  //
-  // Since the path_ we construct visits primed and starred zeroes alternately,
-  // and terminates if we reach a primed zero in a column with no star, our
-  // path_ must either contain matrix_size_ or fewer stars (in which case the
-  // loop iterates fewer than matrix_size_ times), or it contains more.  In
-  // that case, because (1) implies that there are fewer than
-  // matrix_size_ stars, we must have visited at least one star more than once.
-  // Consider the first such star that we visit more than once; it must have
-  // been reached immediately after visiting a prime in the same row.  By (2),
-  // this prime is unique and so must have also been visited more than once.
-  // Therefore, that prime must be in the same column as a star that has been
-  // visited more than once, contradicting the assumption that we chose the
-  // first multiply visited star, or it must be in the same column as more
-  // than one star, contradicting (3).  Therefore, we never visit any star
-  // more than once and the loop terminates within matrix_size_ iterations.
-
-  while (!done) {
-    // First construct the alternating path...
-    int row = FindStarInCol(image_[count]);
-
-    if (row != kHungarianOptimizerRowNotFound) {
-      count++;
-      preimage_[count] = row;
-      image_[count] = image_[count - 1];
-    } else {
-      done = true;
-    }
+void HungarianOptimizer::Augment(int start_row) {
+  double path_cost = 0.0;
+  const int sink = FindShortestAugmentingPath(start_row, &path_cost);
+  CHECK_NE(-1, sink) << "The costs must be finite.";
 
-    if (!done) {
-      int col = FindPrimeInRow(preimage_[count]);
-      count++;
-      preimage_[count] = preimage_[count - 1];
-      image_[count] = col;
+  // Update the dual values of the scanned rows and columns.
+  row_dual_[start_row] += path_cost;
+  for (int row = 0; row < num_rows_; ++row) {
+    if (scanned_rows_[row] && row != start_row) {
+      row_dual_[row] += path_cost - shortest_path_costs_[col_of_row_[row]];
     }
   }
-
-  // Then modify it.
-  for (int i = 0; i <= count; ++i) {
-    int row = preimage_[i];
-    int col = image_[i];
-
-    if (IsStarred(row, col)) {
-      UnStar(row, col);
-    } else {
-      Star(row, col);
+  for (int col = 0; col < num_cols_; ++col) {
+    if (scanned_cols_[col]) {
+      col_dual_[col] -= path_cost - shortest_path_costs_[col];
     }
   }
 
-  ClearCovers();
-  ClearPrimes();
-  state_ = &HungarianOptimizer::CoverStarredZeroes;
-}
-
-// Step 6
-// Add the smallest uncovered value in the matrix to every element of each
-// covered row, and subtract it from every element of each uncovered column.
-// Return to Step 4 without altering any stars, primes, or covered lines.
-void HungarianOptimizer::AugmentPath() {
-  double minval = FindSmallestUncovered();
-
-  for (int row = 0; row < matrix_size_; ++row) {
-    for (int col = 0; col < matrix_size_; ++col) {
-      if (RowCovered(row)) {
-        costs_[row][col] += minval;
-      }
-
-      if (!ColCovered(col)) {
-        costs_[row][col] -= minval;
-      }
-    }
+  // Augment along the path.
+  int col = sink;
+  for (;;) {
+    const int row = path_[col];
+    row_of_col_[col] = row;
+    std::swap(col_of_row_[row], col);
+    if (row == start_row) break;
   }
-
-  state_ = &HungarianOptimizer::PrimeZeroes;
 }
 
 void MinimizeLinearAssignment(const std::vector<std::vector<double> >& cost,
@@ -14,25 +14,32 @@
 //
 // IMPORTANT NOTE: we advise to use the code in
 // graph/linear_assignment.h whose complexity is
-// usually much smaller.
+// usually much smaller on sparse problems.
 // TODO(user): base this code on LinearSumAssignment.
-//
-// See: //depot/google3/java/com/google/wireless/genie/frontend
-//       /mixer/matching/HungarianOptimizer.java
 
-// An O(n^4) implementation of the Kuhn-Munkres algorithm (aka the
-// Hungarian algorithm) for solving the assignment problem.
+// An O(n^3) implementation of the shortest augmenting path algorithm of
+// Jonker and Volgenant for solving the assignment problem, on dense cost
+// matrices.
 // The assignment problem takes a set of agents, a set of tasks and a
 // cost associated with assigning each agent to each task and produces
 // an optimal (i.e. least cost) assignment of agents to tasks.
 // The code also enables to compute a maximum assignment by changing the
 // input matrix.
 //
-// This code is based on (read: translated from) the Java version
-// (read: translated from) the python version at
-//   http://www.clapper.org/software/python/munkres/
-// which in turn is based on
-//   http://www.public.iastate.edu/~ddoty/HungarianAlgorithm.html.
+// The costs are copied to a contiguous matrix, and square problems are first
+// reduced column by column, which assigns a large part of the agents on random
+// instances. Each unassigned agent is then assigned along a shortest
+// augmenting path, computed with the algorithm of Dijkstra on the reduced
+// costs: each step scans one row of the matrix. When there are more tasks
+// than agents, only the agents are assigned; when there are more agents than
+// tasks, only the tasks are.
+//
+// References:
+// - R. Jonker, A. Volgenant, "A shortest augmenting path algorithm for dense
+//   and sparse linear assignment problems", Computing 38 (4): 325-340, 1987.
+// - D. F. Crouse, "On implementing 2D rectangular assignment algorithms",
+//   IEEE Transactions on Aerospace and Electronic Systems 52 (4): 1679-1696,
+//   2016.
 
 #ifndef OR_TOOLS_ALGORITHMS_HUNGARIAN_H_
 #define OR_TOOLS_ALGORITHMS_HUNGARIAN_H_
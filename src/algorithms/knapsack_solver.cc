@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <queue>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "base/stl_util.h"
@@ -30,6 +31,10 @@ const int kNoSelection = -1;
 const int kMasterPropagatorId = 0;
 const int kMaxNumberOfBruteForceItems = 30;
 const int kMaxNumberOf64Items = 64;
+// The number of subtrees per thread explored in parallel by
+// KnapsackGenericSolver. More subtrees balance the work better, but the search
+// runs alone longer to open them.
+const int kNumSubtreesPerThread = 8;
 
 // Comparator used to sort item in decreasing efficiency order
 // (see KnapsackCapacityPropagator).
@@ -223,6 +228,7 @@ void KnapsackCapacityPropagator::ComputeProfitBounds() {
 
   int64 remaining_capacity = capacity_ - consumed_capacity_;
   int break_sorted_item_id = kNoSelection;
+  int last_added_sorted_item_id = kNoSelection;
   const int number_of_sorted_items = sorted_items_.size();
   for (int sorted_id = 0; sorted_id < number_of_sorted_items; ++sorted_id) {
     const KnapsackItem* const item = sorted_items_[sorted_id];
@@ -232,6 +238,7 @@ void KnapsackCapacityPropagator::ComputeProfitBounds() {
       if (remaining_capacity >= item->weight) {
         remaining_capacity -= item->weight;
         set_profit_lower_bound(profit_lower_bound() + item->profit);
+        last_added_sorted_item_id = sorted_id;
       } else {
         break_sorted_item_id = sorted_id;
         break;
@@ -242,8 +249,8 @@ void KnapsackCapacityPropagator::ComputeProfitBounds() {
   set_profit_upper_bound(profit_lower_bound());
 
   if (break_sorted_item_id != kNoSelection) {
-    const int64 additional_profit =
-        GetAdditionalProfit(remaining_capacity, break_sorted_item_id);
+    const int64 additional_profit = GetAdditionalProfit(
+        remaining_capacity, break_sorted_item_id, last_added_sorted_item_id);
     set_profit_upper_bound(profit_upper_bound() + additional_profit);
   }
 }
@@ -293,9 +300,17 @@ void KnapsackCapacityPropagator::CopyCurrentStateToSolutionPropagator(
   }
 }
 
-int64 KnapsackCapacityPropagator::GetAdditionalProfit(int64 remaining_capacity,
-                                                      int break_item_id) const {
-  const int after_break_item_id = break_item_id + 1;
+int64 KnapsackCapacityPropagator::GetAdditionalProfit(
+    int64 remaining_capacity, int break_item_id,
+    int before_break_item_id) const {
+  // The bound is tighter with the efficiencies of the unbound items closest to
+  // the break item, rather than those of its neighbors in sorted_items_: the
+  // bound items cannot fill or free capacity.
+  int after_break_item_id = break_item_id + 1;
+  while (after_break_item_id < sorted_items_.size() &&
+         state().is_bound(sorted_items_[after_break_item_id]->id)) {
+    ++after_break_item_id;
+  }
   int64 additional_profit_when_no_break_item = 0;
   if (after_break_item_id < sorted_items_.size()) {
     // As items are sorted by decreasing profit / weight ratio, and the current
@@ -306,9 +321,8 @@ int64 KnapsackCapacityPropagator::GetAdditionalProfit(int64 remaining_capacity,
         UpperBoundOfRatio(remaining_capacity, next_profit, next_weight);
   }
 
-  const int before_break_item_id = break_item_id - 1;
   int64 additional_profit_when_break_item = 0;
-  if (before_break_item_id >= 0) {
+  if (before_break_item_id != kNoSelection) {
     const int64 previous_weight = sorted_items_[before_break_item_id]->weight;
     // Having previous_weight == 0 means the total capacity is smaller than
     // the weight of the current item. In such a case the item cannot be part
@@ -338,7 +352,12 @@ KnapsackGenericSolver::KnapsackGenericSolver(const std::string& solver_name)
       search_nodes_(),
       state_(),
       best_solution_profit_(0),
-      best_solution_() {}
+      best_solution_(),
+      profits_(),
+      weights_(),
+      capacities_(),
+      num_threads_(1),
+      shared_best_profit_(NULL) {}
 
 KnapsackGenericSolver::~KnapsackGenericSolver() { Clear(); }
 
@@ -348,6 +367,9 @@ void KnapsackGenericSolver::Init(const std::vector<int64>& profits,
   CHECK_EQ(capacities.size(), weights.size());
 
   Clear();
+  profits_ = profits;
+  weights_ = weights;
+  capacities_ = capacities;
   const int number_of_items = profits.size();
   const int number_of_dimensions = weights.size();
   state_.Init(number_of_items);
@@ -391,7 +413,6 @@ void KnapsackGenericSolver::GetLowerAndUpperBoundWhenItem(int item_id,
 int64 KnapsackGenericSolver::Solve() {
   best_solution_profit_ = 0LL;
 
-  SearchQueue search_queue;
   const KnapsackAssignment assignment(kNoSelection, true);
   KnapsackSearchNode* root_node = new KnapsackSearchNode(NULL, assignment);
   root_node->set_current_profit(GetCurrentProfit());
@@ -399,6 +420,20 @@ int64 KnapsackGenericSolver::Solve() {
   root_node->set_next_item_id(GetNextItemId());
   search_nodes_.push_back(root_node);
 
+  if (num_threads_ == 1) {
+    Search(root_node, 0, NULL);
+  } else {
+    std::vector<Subtree> open_subtrees;
+    Search(root_node, kNumSubtreesPerThread * num_threads_, &open_subtrees);
+    if (!open_subtrees.empty()) SolveSubtreesInParallel(open_subtrees);
+  }
+  return best_solution_profit_;
+}
+
+void KnapsackGenericSolver::Search(KnapsackSearchNode* root_node,
+                                   int max_queue_size,
+                                   std::vector<Subtree>* open_subtrees) {
+  SearchQueue search_queue;
   if (MakeNewNode(*root_node, false)) {
     search_queue.push(search_nodes_.back());
   }
@@ -408,7 +443,8 @@ int64 KnapsackGenericSolver::Solve() {
 
   KnapsackSearchNode* current_node = root_node;
   while (!search_queue.empty() &&
-         search_queue.top()->profit_upper_bound() > best_solution_profit_) {
+         search_queue.top()->profit_upper_bound() > BestKnownProfit()) {
+    if (max_queue_size > 0 && search_queue.size() >= max_queue_size) break;
     KnapsackSearchNode* const node = search_queue.top();
     search_queue.pop();
 
@@ -427,7 +463,84 @@ int64 KnapsackGenericSolver::Solve() {
       search_queue.push(search_nodes_.back());
     }
   }
-  return best_solution_profit_;
+
+  if (open_subtrees != NULL) {
+    // The open nodes, by decreasing upper bound, as the assignments from the
+    // root to them.
+    while (!search_queue.empty() &&
+           search_queue.top()->profit_upper_bound() > BestKnownProfit()) {
+      open_subtrees->push_back(Subtree());
+      for (const KnapsackSearchNode* node = search_queue.top();
+           node != root_node; node = node->parent()) {
+        open_subtrees->back().push_back(node->assignment());
+      }
+      search_queue.pop();
+    }
+  }
+
+  // Go back to the state of the root node.
+  if (current_node != root_node) {
+    KnapsackSearchPath path(*current_node, *root_node);
+    path.Init();
+    UpdatePropagators(path);
+  }
+}
+
+void KnapsackGenericSolver::SolveSubtreesInParallel(
+    const std::vector<Subtree>& subtrees) {
+  std::atomic<int64> shared_best_profit(best_solution_profit_);
+  std::atomic<int> next_subtree(0);
+  std::vector<std::unique_ptr<KnapsackGenericSolver> > solvers(num_threads_);
+  for (int i = 0; i < num_threads_; ++i) {
+    solvers[i].reset(new KnapsackGenericSolver(GetName()));
+    solvers[i]->Init(profits_, weights_, capacities_);
+    solvers[i]->master_propagator_id_ = master_propagator_id_;
+    solvers[i]->shared_best_profit_ = &shared_best_profit;
+  }
+  std::vector<std::thread> threads;
+  for (int i = 1; i < num_threads_; ++i) {
+    threads.push_back(std::thread(&KnapsackGenericSolver::SolveSubtrees,
+                                  solvers[i].get(), &subtrees, &next_subtree));
+  }
+  solvers[0]->SolveSubtrees(&subtrees, &next_subtree);
+  for (int i = 0; i < threads.size(); ++i) threads[i].join();
+
+  for (int i = 0; i < num_threads_; ++i) {
+    if (solvers[i]->best_solution_profit_ > best_solution_profit_) {
+      best_solution_profit_ = solvers[i]->best_solution_profit_;
+      best_solution_ = solvers[i]->best_solution_;
+    }
+  }
+}
+
+void KnapsackGenericSolver::SolveSubtrees(const std::vector<Subtree>* subtrees,
+                                          std::atomic<int>* next_subtree) {
+  const KnapsackAssignment assignment(kNoSelection, true);
+  while (true) {
+    const int subtree_index = next_subtree->fetch_add(1);
+    if (subtree_index >= subtrees->size()) break;
+    const Subtree& subtree = (*subtrees)[subtree_index];
+    for (const KnapsackAssignment& decision : subtree) {
+      const bool no_fail = IncrementalUpdate(false, decision);
+      // The open nodes of the search are feasible.
+      DCHECK(no_fail);
+    }
+    KnapsackSearchNode* const root_node =
+        new KnapsackSearchNode(NULL, assignment);
+    root_node->set_current_profit(GetCurrentProfit());
+    root_node->set_profit_upper_bound(GetAggregatedProfitUpperBound());
+    root_node->set_next_item_id(GetNextItemId());
+    search_nodes_.push_back(root_node);
+    // The lower bound of the root node was already used when it was created
+    // in the first search.
+    if (root_node->profit_upper_bound() > BestKnownProfit()) {
+      Search(root_node, 0, NULL);
+    }
+    for (int i = subtree.size() - 1; i >= 0; --i) {
+      IncrementalUpdate(true, subtree[i]);
+    }
+    STLDeleteElements(&search_nodes_);
+  }
 }
 
 void KnapsackGenericSolver::Clear() {
@@ -487,7 +600,7 @@ bool KnapsackGenericSolver::MakeNewNode(const KnapsackSearchNode& node,
   revert_path.Init();
   UpdatePropagators(revert_path);
 
-  if (!no_fail || new_node.profit_upper_bound() < best_solution_profit_) {
+  if (!no_fail || new_node.profit_upper_bound() < BestKnownProfit()) {
     return false;
   }
 
@@ -522,6 +635,13 @@ void KnapsackGenericSolver::UpdateBestSolution() {
     best_solution_profit_ = profit_lower_bound;
     propagators_[master_propagator_id_]
         ->CopyCurrentStateToSolution(HasOnePropagator(), &best_solution_);
+    if (shared_best_profit_ != NULL) {
+      int64 shared_profit = shared_best_profit_->load();
+      while (shared_profit < profit_lower_bound &&
+             !shared_best_profit_->compare_exchange_weak(shared_profit,
+                                                         profit_lower_bound)) {
+      }
+    }
   }
 }
 
@@ -997,6 +1117,369 @@ int64 KnapsackDynamicProgrammingSolver::Solve() {
   return computed_profits_[capacity_];
 }
 
+// ----- KnapsackExpandingCoreSolver -----
+// KnapsackExpandingCoreSolver solves the 0-1 knapsack problem with the
+// expanding core branch and bound of Pisinger (expknap), see D. Pisinger, "An
+// expanding-core algorithm for the exact 0-1 knapsack problem", European
+// Journal of Operational Research 87 (1995) 175-187.
+// The items are sorted by decreasing efficiency, and the search starts from
+// the break solution, where all the items before the break item are in. A
+// search node adds the next items after the break item while the knapsack is
+// not full, and removes the next items before the break item while it is
+// overfull. Each item is pruned with the bound of Dembo and Hammer: the
+// remaining capacity (positive or negative) times the efficiency of the item.
+// As this bound prunes the items far from the break item, the search only
+// changes a small core of items around it. Pisinger sorts the items lazily, as
+// the core expands; here they are all sorted once, which is not the bottleneck
+// of the search. The search is depth first, with an explicit stack.
+class KnapsackExpandingCoreSolver : public BaseKnapsackSolver {
+ public:
+  explicit KnapsackExpandingCoreSolver(const std::string& solver_name);
+
+  // Initializes the solver and enters the problem to be solved.
+  void Init(const std::vector<int64>& profits,
+            const std::vector<std::vector<int64> >& weights,
+            const std::vector<int64>& capacities);
+
+  // Solves the problem and returns the profit of the optimal solution.
+  int64 Solve();
+
+  // Returns true if the item 'item_id' is packed in the optimal knapsack.
+  bool best_solution(int item_id) const { return best_solution_.at(item_id); }
+
+ private:
+  // A node of the search tree. The items in the knapsack are those of the
+  // break solution, changed by the changed_item of the nodes on the path from
+  // the root. The items after next_item_to_add and before
+  // next_item_to_remove (by index in sorted_items_) are not decided yet.
+  struct SearchNode {
+    SearchNode(int _next_item_to_remove, int _next_item_to_add, int64 _profit,
+               int64 _remaining_capacity, int _changed_item)
+        : next_item_to_remove(_next_item_to_remove),
+          next_item_to_add(_next_item_to_add),
+          profit(_profit),
+          remaining_capacity(_remaining_capacity),
+          changed_item(_changed_item) {}
+    int next_item_to_remove;
+    int next_item_to_add;
+    int64 profit;
+    // Negative when the knapsack is overfull.
+    int64 remaining_capacity;
+    int changed_item;
+  };
+
+  // Returns true if profit + remaining_capacity * efficiency of the item is
+  // larger than the best profit, i.e. if changing the item may lead to a
+  // better solution.
+  bool MayImprove(int64 profit, int64 remaining_capacity,
+                  const KnapsackItemWithEfficiency& item) const;
+
+  std::vector<int64> profits_;
+  std::vector<int64> weights_;
+  int64 capacity_;
+  std::vector<KnapsackItemWithEfficiency> sorted_items_;
+  int64 best_solution_profit_;
+  std::vector<bool> best_solution_;
+};
+
+// Comparator used to sort items in decreasing efficiency order, with exact
+// arithmetic when possible, so that the bounds are valid.
+bool CompareKnapsackItemWithEfficiencyExactly(
+    const KnapsackItemWithEfficiency& item1,
+    const KnapsackItemWithEfficiency& item2) {
+  if (!WillProductOverflow(item1.profit, item2.weight) &&
+      !WillProductOverflow(item2.profit, item1.weight)) {
+    return item1.profit * item2.weight > item2.profit * item1.weight;
+  }
+  return static_cast<double>(item1.profit) * item2.weight >
+         static_cast<double>(item2.profit) * item1.weight;
+}
+
+KnapsackExpandingCoreSolver::KnapsackExpandingCoreSolver(
+    const std::string& solver_name)
+    : BaseKnapsackSolver(solver_name),
+      profits_(),
+      weights_(),
+      capacity_(0),
+      sorted_items_(),
+      best_solution_profit_(0),
+      best_solution_() {}
+
+void KnapsackExpandingCoreSolver::Init(
+    const std::vector<int64>& profits,
+    const std::vector<std::vector<int64> >& weights,
+    const std::vector<int64>& capacities) {
+  CHECK_EQ(weights.size(), 1)
+      << "The expanding core solver only deals with one dimension.";
+  CHECK_EQ(capacities.size(), weights.size());
+  CHECK_EQ(profits.size(), weights[0].size());
+
+  profits_ = profits;
+  weights_ = weights[0];
+  capacity_ = capacities[0];
+}
+
+bool KnapsackExpandingCoreSolver::MayImprove(
+    int64 profit, int64 remaining_capacity,
+    const KnapsackItemWithEfficiency& item) const {
+  // profit + remaining_capacity * item.profit / item.weight >=
+  //     best_solution_profit_ + 1.
+  const int64 missing_profit = best_solution_profit_ + 1 - profit;
+  if (!WillProductOverflow(std::abs(remaining_capacity), item.profit) &&
+      !WillProductOverflow(std::abs(missing_profit), item.weight)) {
+    return remaining_capacity * item.profit >= missing_profit * item.weight;
+  }
+  return static_cast<double>(remaining_capacity) * item.profit >=
+         static_cast<double>(missing_profit) * item.weight;
+}
+
+int64 KnapsackExpandingCoreSolver::Solve() {
+  const int num_items = profits_.size();
+  best_solution_.assign(num_items, false);
+  // The items without weight are in, those that do not fit are out.
+  int64 fixed_profit = 0;
+  sorted_items_.clear();
+  for (int item_id = 0; item_id < num_items; ++item_id) {
+    if (profits_[item_id] <= 0 || weights_[item_id] > capacity_) continue;
+    if (weights_[item_id] == 0) {
+      best_solution_[item_id] = true;
+      fixed_profit += profits_[item_id];
+    } else {
+      sorted_items_.push_back(KnapsackItemWithEfficiency(
+          item_id, profits_[item_id], weights_[item_id], 0));
+    }
+  }
+  std::sort(sorted_items_.begin(), sorted_items_.end(),
+            CompareKnapsackItemWithEfficiencyExactly);
+
+  const int num_sorted_items = sorted_items_.size();
+  int break_item = 0;
+  int64 break_profit = 0;
+  int64 remaining_capacity = capacity_;
+  while (break_item < num_sorted_items &&
+         sorted_items_[break_item].weight <= remaining_capacity) {
+    remaining_capacity -= sorted_items_[break_item].weight;
+    break_profit += sorted_items_[break_item].profit;
+    ++break_item;
+  }
+
+  best_solution_profit_ = break_profit;
+  std::vector<int> best_changed_items;
+  std::vector<SearchNode> stack;
+  stack.push_back(SearchNode(break_item - 1, break_item, break_profit,
+                             remaining_capacity, kNoSelection));
+  while (!stack.empty()) {
+    SearchNode* const node = &stack.back();
+    int changed_item = kNoSelection;
+    if (node->remaining_capacity >= 0) {
+      if (node->next_item_to_add < num_sorted_items &&
+          MayImprove(node->profit, node->remaining_capacity,
+                     sorted_items_[node->next_item_to_add])) {
+        changed_item = node->next_item_to_add++;
+      }
+    } else {
+      if (node->next_item_to_remove >= 0 &&
+          MayImprove(node->profit, node->remaining_capacity,
+                     sorted_items_[node->next_item_to_remove])) {
+        changed_item = node->next_item_to_remove--;
+      }
+    }
+    if (changed_item == kNoSelection) {
+      stack.pop_back();
+      continue;
+    }
+    // When the search comes back to the node, the changed item is left as in
+    // the break solution.
+    const KnapsackItemWithEfficiency& item = sorted_items_[changed_item];
+    const bool is_added = changed_item >= break_item;
+    const SearchNode child(
+        is_added ? node->next_item_to_remove : changed_item - 1,
+        is_added ? changed_item + 1 : node->next_item_to_add,
+        is_added ? node->profit + item.profit : node->profit - item.profit,
+        is_added ? node->remaining_capacity - item.weight
+                 : node->remaining_capacity + item.weight,
+        changed_item);
+    stack.push_back(child);
+    if (child.remaining_capacity >= 0 && child.profit > best_solution_profit_) {
+      best_solution_profit_ = child.profit;
+      best_changed_items.clear();
+      for (const SearchNode& path_node : stack) {
+        if (path_node.changed_item != kNoSelection) {
+          best_changed_items.push_back(path_node.changed_item);
+        }
+      }
+    }
+  }
+
+  for (int sorted_id = 0; sorted_id < break_item; ++sorted_id) {
+    best_solution_[sorted_items_[sorted_id].id] = true;
+  }
+  for (const int sorted_id : best_changed_items) {
+    best_solution_[sorted_items_[sorted_id].id] = sorted_id >= break_item;
+  }
+  return fixed_profit + best_solution_profit_;
+}
+
+// ----- KnapsackBitsetDynamicProgrammingSolver -----
+// KnapsackBitsetDynamicProgrammingSolver solves subset sum instances of the
+// 0-1 knapsack problem, where the profit of each item is its weight, i.e. it
+// finds the largest total weight of a subset of the items that fits in the
+// knapsack. After each item, bit w of the bitset of reachable weights is set
+// when some subset of the items seen so far weighs w; adding an item of weight
+// x is then a shift of the bitset by x and an "or", done 64 bits at a time.
+// The search stops as soon as the capacity is reached.
+// To rebuild the solution without storing the bitsets of all the items, the
+// bitsets of one item out of sqrt(number of items) are stored, and those of
+// the other items are recomputed from them, block by block from the last
+// block: an item is in the solution when the weight to reach is not reachable
+// without it. This at most doubles the running time.
+// Instances that are not subset sum instances are solved by
+// KnapsackExpandingCoreSolver.
+class KnapsackBitsetDynamicProgrammingSolver : public BaseKnapsackSolver {
+ public:
+  explicit KnapsackBitsetDynamicProgrammingSolver(
+      const std::string& solver_name);
+
+  // Initializes the solver and enters the problem to be solved.
+  void Init(const std::vector<int64>& profits,
+            const std::vector<std::vector<int64> >& weights,
+            const std::vector<int64>& capacities);
+
+  // Solves the problem and returns the profit of the optimal solution.
+  int64 Solve();
+
+  // Returns true if the item 'item_id' is packed in the optimal knapsack.
+  bool best_solution(int item_id) const {
+    return core_solver_ != NULL ? core_solver_->best_solution(item_id)
+                                   : best_solution_.at(item_id);
+  }
+
+ private:
+  // Sets the bit w + weight of the bitset for each bit w that is set, in the
+  // first num_words words of the bitset.
+  static void AddWeight(int64 weight, int64 num_words, uint64* bitset);
+
+  static bool IsBitSet(const std::vector<uint64>& bitset, int64 bit) {
+    return IsBitSet64(bitset.data(), bit);
+  }
+
+  std::vector<int64> weights_;
+  int64 capacity_;
+  std::vector<bool> best_solution_;
+  std::unique_ptr<KnapsackExpandingCoreSolver> core_solver_;
+};
+
+KnapsackBitsetDynamicProgrammingSolver::KnapsackBitsetDynamicProgrammingSolver(
+    const std::string& solver_name)
+    : BaseKnapsackSolver(solver_name),
+      weights_(),
+      capacity_(0),
+      best_solution_(),
+      core_solver_() {}
+
+void KnapsackBitsetDynamicProgrammingSolver::Init(
+    const std::vector<int64>& profits,
+    const std::vector<std::vector<int64> >& weights,
+    const std::vector<int64>& capacities) {
+  CHECK_EQ(weights.size(), 1)
+      << "The bitset dynamic programming solver only deals with one "
+      << "dimension.";
+  CHECK_EQ(capacities.size(), weights.size());
+  CHECK_EQ(profits.size(), weights[0].size());
+
+  core_solver_.reset();
+  if (profits != weights[0]) {
+    core_solver_.reset(new KnapsackExpandingCoreSolver(GetName()));
+    core_solver_->Init(profits, weights, capacities);
+    return;
+  }
+  weights_ = weights[0];
+  capacity_ = capacities[0];
+}
+
+void KnapsackBitsetDynamicProgrammingSolver::AddWeight(int64 weight,
+                                                       int64 num_words,
+                                                       uint64* bitset) {
+  // The words are updated from the last one, so that the words read are not
+  // updated yet.
+  const int64 word_shift = BitOffset64(weight);
+  const int bit_shift = BitPos64(weight);
+  if (bit_shift == 0) {
+    for (int64 i = num_words - 1; i >= word_shift; --i) {
+      bitset[i] |= bitset[i - word_shift];
+    }
+    return;
+  }
+  for (int64 i = num_words - 1; i > word_shift; --i) {
+    bitset[i] |= (bitset[i - word_shift] << bit_shift) |
+                 (bitset[i - word_shift - 1] >> (64 - bit_shift));
+  }
+  if (word_shift < num_words) bitset[word_shift] |= bitset[0] << bit_shift;
+}
+
+int64 KnapsackBitsetDynamicProgrammingSolver::Solve() {
+  if (core_solver_ != NULL) return core_solver_->Solve();
+
+  const int num_items = weights_.size();
+  best_solution_.assign(num_items, false);
+  std::vector<int> item_ids;
+  int64 total_weight = 0;
+  for (int item_id = 0; item_id < num_items; ++item_id) {
+    if (weights_[item_id] <= 0 || weights_[item_id] > capacity_) continue;
+    item_ids.push_back(item_id);
+    total_weight += weights_[item_id];
+  }
+  if (total_weight <= capacity_) {
+    for (const int item_id : item_ids) best_solution_[item_id] = true;
+    return total_weight;
+  }
+
+  // checkpoints[i] is the bitset before the item block_size * i.
+  const int block_size =
+      std::max(1, static_cast<int>(ceil(sqrt(item_ids.size()))));
+  std::vector<std::vector<uint64> > checkpoints;
+  std::vector<uint64> reachable(BitLength64(capacity_ + 1), 0);
+  reachable[0] = 1;
+  int64 max_weight = 0;
+  int num_used_items = 0;
+  while (num_used_items < item_ids.size() &&
+         !IsBitSet(reachable, capacity_)) {
+    if (num_used_items % block_size == 0) checkpoints.push_back(reachable);
+    const int64 weight = weights_[item_ids[num_used_items]];
+    max_weight = std::min(capacity_, max_weight + weight);
+    AddWeight(weight, BitLength64(max_weight + 1), reachable.data());
+    ++num_used_items;
+  }
+  int64 best_weight = capacity_;
+  while (!IsBitSet(reachable, best_weight)) --best_weight;
+
+  int64 target = best_weight;
+  std::vector<std::vector<uint64> > block_bitsets;
+  for (int block = checkpoints.size() - 1; block >= 0; --block) {
+    const int begin = block * block_size;
+    const int end = std::min(num_used_items, begin + block_size);
+    // Only the bits up to the target are needed.
+    const int64 num_words = BitLength64(target + 1);
+    block_bitsets.resize(end - begin);
+    block_bitsets[0].assign(checkpoints[block].begin(),
+                            checkpoints[block].begin() + num_words);
+    for (int i = begin + 1; i < end; ++i) {
+      block_bitsets[i - begin] = block_bitsets[i - begin - 1];
+      AddWeight(weights_[item_ids[i - 1]], num_words,
+                block_bitsets[i - begin].data());
+    }
+    for (int i = end - 1; i >= begin; --i) {
+      if (!IsBitSet(block_bitsets[i - begin], target)) {
+        best_solution_[item_ids[i]] = true;
+        target -= weights_[item_ids[i]];
+      }
+    }
+    checkpoints.pop_back();
+  }
+  CHECK_EQ(0, target);
+  return best_weight;
+}
+
 // ----- KnapsackMIPSolver -----
 class KnapsackMIPSolver : public BaseKnapsackSolver {
  public:
@@ -1109,6 +1592,12 @@ KnapsackSolver::KnapsackSolver(SolverType solver_type,
     case KNAPSACK_MULTIDIMENSION_BRANCH_AND_BOUND_SOLVER:
       solver_.reset(new KnapsackGenericSolver(solver_name));
       break;
+    case KNAPSACK_EXPANDING_CORE_SOLVER:
+      solver_.reset(new KnapsackExpandingCoreSolver(solver_name));
+      break;
+    case KNAPSACK_BITSET_DYNAMIC_PROGRAMMING_SOLVER:
+      solver_.reset(new KnapsackBitsetDynamicProgrammingSolver(solver_name));
+      break;
     #if defined(USE_CBC)
     case KNAPSACK_MULTIDIMENSION_CBC_MIP_SOLVER:
       solver_.reset(new KnapsackMIPSolver(
@@ -1250,6 +1739,10 @@ bool KnapsackSolver::BestSolutionContains(int item_id) const {
 
 std::string KnapsackSolver::GetName() const { return solver_->GetName(); }
 
+void KnapsackSolver::set_num_threads(int num_threads) {
+  solver_->SetNumThreads(num_threads);
+}
+
 // ----- BaseKnapsackSolver -----
 void BaseKnapsackSolver::GetLowerAndUpperBoundWhenItem(int item_id,
                                                        bool is_item_in,
@@ -58,6 +58,8 @@
 #define OR_TOOLS_ALGORITHMS_KNAPSACK_SOLVER_H_
 
 #include <math.h>
+#include <algorithm>
+#include <atomic>
 #include "base/unique_ptr.h"
 #include <string>
 #include <vector>
@@ -73,7 +75,7 @@ namespace operations_research {
 // KnapsackSolver is a factory for knapsack solvers. Several solvers are
 // implemented, some can deal with a limited number of items, some can deal with
 // several dimensions...
-// Currently 4 algorithms are implemented:
+// Currently 6 algorithms are implemented:
 //  - KNAPSACK_BRUTE_FORCE_SOLVER: Limited to 30 items and one dimension, this
 //    solver uses a brute force algorithm, ie. explores all possible states.
 //    Experiments show competitive performance for instances with less than
@@ -86,7 +88,21 @@ namespace operations_research {
 //    complexity is O(capacity * number_of_items).
 //  - KNAPSACK_MULTIDIMENSION_BRANCH_AND_BOUND_SOLVER: This solver can deal
 //    with both large number of items and several dimensions. This solver is
-//    based on branch and bound.
+//    based on branch and bound, and can explore the subtrees of the search
+//    with several threads (see set_num_threads()).
+//  - KNAPSACK_EXPANDING_CORE_SOLVER: Limited to one dimension, this solver is
+//    based on the branch and bound of Pisinger (expknap), which starts from
+//    the greedy solution and only changes the items whose efficiency is close
+//    to the one of the break item (the core). It deals with large numbers of
+//    items and large capacities, and is the solver of choice for uncorrelated
+//    and weakly correlated instances.
+//  - KNAPSACK_BITSET_DYNAMIC_PROGRAMMING_SOLVER: Limited to one dimension, this
+//    solver is a dynamic programming on the set of reachable weights, stored
+//    in a bitset and updated 64 weights at a time, in O(capacity *
+//    number_of_items / 64) time and O(capacity * sqrt(number_of_items) / 8)
+//    bytes. It is meant for subset sum instances (each profit is equal to the
+//    weight of its item), which are the hardest ones for branch and bound;
+//    other instances are solved with KNAPSACK_EXPANDING_CORE_SOLVER.
 //  - KNAPSACK_MULTIDIMENSION_CBC_MIP_SOLVER: This solver can deal with both
 //    large number of items and several dimensions. This solver is based on
 //    Integer Programming solver CBC.
@@ -119,7 +135,9 @@ class KnapsackSolver {
     #if defined(USE_GLPK)
     KNAPSACK_MULTIDIMENSION_GLPK_MIP_SOLVER = 4,
     #endif  // USE_GLPK
-    KNAPSACK_MULTIDIMENSION_BRANCH_AND_BOUND_SOLVER = 5
+    KNAPSACK_MULTIDIMENSION_BRANCH_AND_BOUND_SOLVER = 5,
+    KNAPSACK_EXPANDING_CORE_SOLVER = 6,
+    KNAPSACK_BITSET_DYNAMIC_PROGRAMMING_SOLVER = 7
   };
 
   explicit KnapsackSolver(const std::string& solver_name);
@@ -140,6 +158,11 @@ class KnapsackSolver {
   bool use_reduction() const { return use_reduction_; }
   void set_use_reduction(bool use_reduction) { use_reduction_ = use_reduction; }
 
+  // Sets the number of threads used by Solve(), including the calling thread.
+  // Defaults to 1. Only KNAPSACK_MULTIDIMENSION_BRANCH_AND_BOUND_SOLVER uses
+  // several threads, the other solvers ignore this setting.
+  void set_num_threads(int num_threads);
+
  private:
   int ReduceProblem(int num_items);
   void ComputeAdditionalProfit(const std::vector<int64>& profits);
@@ -444,8 +467,11 @@ class KnapsackCapacityPropagator : public KnapsackPropagator {
   // ie. either the break item is part of the solution, either it is not.
   // So basically the linear relaxation is done on the item before the break
   // item, or the one after the break item.
-  // This is what GetAdditionalProfit method implements.
-  int64 GetAdditionalProfit(int64 remaining_capacity, int break_item_id) const;
+  // This is what GetAdditionalProfit method implements. The item before the
+  // break item is the last unbound item added to the knapsack by the greedy
+  // scan, or -1 if there is none.
+  int64 GetAdditionalProfit(int64 remaining_capacity, int break_item_id,
+                            int before_break_item_id) const;
 
   const int64 capacity_;
   int64 consumed_capacity_;
@@ -482,6 +508,10 @@ class BaseKnapsackSolver {
   // Returns true if the item 'item_id' is packed in the optimal knapsack.
   virtual bool best_solution(int item_id) const = 0;
 
+  // Sets the number of threads used by Solve(). Solvers that cannot use
+  // several threads ignore it.
+  virtual void SetNumThreads(int num_threads) {}
+
   virtual std::string GetName() const { return solver_name_; }
 
  private:
@@ -497,6 +527,11 @@ class BaseKnapsackSolver {
 // TODO(user): In case of multi-dimensional knapsack problem, implement an
 // aggregated propagator to combine all dimensions and give a better guide
 // to select next item (see for instance Dobson's aggregated efficiency).
+//
+// With several threads, the search first runs alone until it has enough open
+// search nodes, and each of these nodes then becomes a subtree explored by one
+// of the threads with its own copy of the propagators. The threads share the
+// profit of the best solution found, to prune their subtrees.
 class KnapsackGenericSolver : public BaseKnapsackSolver {
  public:
   explicit KnapsackGenericSolver(const std::string& solver_name);
@@ -524,10 +559,43 @@ class KnapsackGenericSolver : public BaseKnapsackSolver {
     return best_solution_.at(item_id);
   }
 
+  virtual void SetNumThreads(int num_threads) {
+    CHECK_GE(num_threads, 1);
+    num_threads_ = num_threads;
+  }
+
  private:
+  typedef std::vector<KnapsackAssignment> Subtree;
+
   // Clears internal data structure.
   void Clear();
 
+  // Runs the best first search from root_node, which must be the current
+  // node, until the queue is empty or optimality is proved, or until the queue
+  // contains max_queue_size nodes if max_queue_size is positive. In this case,
+  // the nodes that are still open are appended to open_subtrees. Restores the
+  // state of root_node at the end.
+  void Search(KnapsackSearchNode* root_node, int max_queue_size,
+              std::vector<Subtree>* open_subtrees);
+
+  // Explores the open subtrees with num_threads_ threads, and updates the
+  // best solution.
+  void SolveSubtreesInParallel(const std::vector<Subtree>& subtrees);
+
+  // Takes subtrees from *next_subtree and explores them, until there are no
+  // more subtrees. Runs in a thread, on a copy of the solver.
+  void SolveSubtrees(const std::vector<Subtree>* subtrees,
+                     std::atomic<int>* next_subtree);
+
+  // Returns the best profit found by this solver or, when several solvers
+  // explore subtrees of the same problem, by any of them.
+  int64 BestKnownProfit() const {
+    return shared_best_profit_ == NULL
+               ? best_solution_profit_
+               : std::max(best_solution_profit_,
+                          shared_best_profit_->load(std::memory_order_relaxed));
+  }
+
   // Updates all propagators reverting/applying all decision on the path.
   // Returns true if fails. Note that, even if fails, all propagators should
   // be updated to be in a stable state in order to stay incremental.
@@ -560,6 +628,15 @@ class KnapsackGenericSolver : public BaseKnapsackSolver {
   int64 best_solution_profit_;
   std::vector<bool> best_solution_;
 
+  // The problem, kept to initialize the copies of the solver used by the
+  // threads.
+  std::vector<int64> profits_;
+  std::vector<std::vector<int64> > weights_;
+  std::vector<int64> capacities_;
+  int num_threads_;
+  // The best profit over all the copies of the solver, or NULL.
+  std::atomic<int64>* shared_best_profit_;
+
   DISALLOW_COPY_AND_ASSIGN(KnapsackGenericSolver);
 };
 #endif  // SWIG
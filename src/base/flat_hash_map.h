@@ -0,0 +1,491 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// FlatHashMap and FlatHashSet are hash containers with open addressing: all
+// the elements are stored in a single array, instead of one node per element
+// for hash_map and hash_set. This needs less memory, and a lookup usually
+// reads a single cache line.
+//
+// The collisions are resolved by Robin Hood hashing with linear probing: the
+// elements are kept sorted by home slot within each run of consecutive
+// occupied slots, so that a lookup stops as soon as it reaches a slot whose
+// element is closer to its home slot than the searched key would be, and an
+// erased element is replaced by shifting back the elements that follow it
+// (there are no tombstones). The hash values are multiplied by a 64-bit odd
+// constant ("Fibonacci hashing"), so that the identity hash functions of the
+// integers and pointers are fine.
+//
+// The interface is a subset of the one of std::unordered_map and
+// std::unordered_set, so these containers work with the functions of
+// base/map_util.h. The main differences are:
+// - Any insertion may move the elements: it invalidates all the iterators,
+//   pointers and references to elements.
+// - erase(iterator) returns nothing, and invalidates all the iterators.
+// - The iteration order depends on the hash values and the insertion order.
+//
+// Example usage:
+//   FlatHashMap<int64, int> index_of_value;
+//   index_of_value[value] = index;
+//   const int* index = FindOrNull(index_of_value, value);
+//
+// See examples/cpp/hash_map_benchmark.cc for a comparison with hash_map and
+// std::unordered_map.
+//
+// Reference: P. Celis, "Robin Hood hashing", PhD thesis, University of
+// Waterloo, 1986.
+
+#ifndef OR_TOOLS_BASE_FLAT_HASH_MAP_H_
+#define OR_TOOLS_BASE_FLAT_HASH_MAP_H_
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "base/hash.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+
+namespace operations_research {
+
+// The default hash function of FlatHashMap and FlatHashSet: std::hash, which
+// is also defined here for the pairs and arrays of hashable types.
+template <class T>
+struct FlatHash {
+  size_t operator()(const T& x) const { return std::hash<T>()(x); }
+};
+
+template <class T, class U>
+struct FlatHash<std::pair<T, U> > {
+  size_t operator()(const std::pair<T, U>& p) const {
+    return static_cast<size_t>(Hash64NumWithSeed(FlatHash<T>()(p.first),
+                                                 FlatHash<U>()(p.second)));
+  }
+};
+
+template <class T, std::size_t N>
+struct FlatHash<std::array<T, N> > {
+  size_t operator()(const std::array<T, N>& a) const {
+    uint64 current = 71;
+    for (std::size_t i = 0; i < N; ++i) {
+      current = Hash64NumWithSeed(current, FlatHash<T>()(a[i]));
+    }
+    return static_cast<size_t>(current);
+  }
+};
+
+namespace internal {
+
+// The common implementation of FlatHashMap and FlatHashSet. Value is the type
+// of the elements, and ExtractKey returns the key of an element.
+template <class Key, class Value, class ExtractKey, class Hash, class Equal>
+class FlatHashTable {
+ public:
+  typedef Key key_type;
+  typedef Value value_type;
+  typedef size_t size_type;
+  typedef Hash hasher;
+  typedef Equal key_equal;
+
+  template <class TableValue>
+  class IteratorBase {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef TableValue value_type;
+    typedef ptrdiff_t difference_type;
+    typedef TableValue* pointer;
+    typedef TableValue& reference;
+
+    IteratorBase() : slot_(nullptr), distance_(nullptr), end_(nullptr) {}
+    // An iterator is convertible to a const_iterator.
+    template <class OtherValue>
+    IteratorBase(const IteratorBase<OtherValue>& other)  // NOLINT
+        : slot_(other.slot_), distance_(other.distance_), end_(other.end_) {}
+
+    TableValue& operator*() const { return *slot_; }
+    TableValue* operator->() const { return slot_; }
+    IteratorBase& operator++() {
+      ++slot_;
+      ++distance_;
+      SkipEmptySlots();
+      return *this;
+    }
+    IteratorBase operator++(int) {
+      IteratorBase copy(*this);
+      ++*this;
+      return copy;
+    }
+    template <class OtherValue>
+    bool operator==(const IteratorBase<OtherValue>& other) const {
+      return distance_ == other.distance_;
+    }
+    template <class OtherValue>
+    bool operator!=(const IteratorBase<OtherValue>& other) const {
+      return distance_ != other.distance_;
+    }
+
+   private:
+    friend class FlatHashTable;
+    template <class OtherValue>
+    friend class IteratorBase;
+
+    IteratorBase(TableValue* slot, const uint32* distance, const uint32* end)
+        : slot_(slot), distance_(distance), end_(end) {
+      SkipEmptySlots();
+    }
+    void SkipEmptySlots() {
+      while (distance_ != end_ && *distance_ == 0) {
+        ++slot_;
+        ++distance_;
+      }
+    }
+
+    TableValue* slot_;
+    const uint32* distance_;
+    const uint32* end_;
+  };
+  typedef IteratorBase<Value> iterator;
+  typedef IteratorBase<const Value> const_iterator;
+
+  FlatHashTable()
+      : slots_(nullptr), capacity_(0), mask_(0), shift_(64), size_(0) {}
+  FlatHashTable(const FlatHashTable& other)
+      : hash_(other.hash_),
+        equal_(other.equal_),
+        slots_(nullptr),
+        capacity_(0),
+        mask_(0),
+        shift_(64),
+        size_(0) {
+    CopyFrom(other);
+  }
+  FlatHashTable(FlatHashTable&& other)
+      : slots_(nullptr), capacity_(0), mask_(0), shift_(64), size_(0) {
+    swap(other);
+  }
+  FlatHashTable& operator=(const FlatHashTable& other) {
+    if (this != &other) {
+      Deallocate();
+      hash_ = other.hash_;
+      equal_ = other.equal_;
+      CopyFrom(other);
+    }
+    return *this;
+  }
+  FlatHashTable& operator=(FlatHashTable&& other) {
+    swap(other);
+    return *this;
+  }
+  ~FlatHashTable() { Deallocate(); }
+
+  iterator begin() { return IteratorAt(0); }
+  iterator end() { return IteratorAt(capacity_); }
+  const_iterator begin() const { return IteratorAt(0); }
+  const_iterator end() const { return IteratorAt(capacity_); }
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+
+  // The number of slots. The table grows when 7/8 of them are used.
+  size_t bucket_count() const { return capacity_; }
+
+  // Makes sure that the table holds num_elements elements without growing.
+  void reserve(size_t num_elements) {
+    size_t capacity = capacity_ == 0 ? kMinCapacity : capacity_;
+    while (num_elements * 8 > capacity * 7) capacity *= 2;
+    if (capacity != capacity_) Rehash(capacity);
+  }
+
+  // Removes all the elements, but keeps the memory.
+  void clear() {
+    for (size_t i = 0; i < capacity_; ++i) {
+      if (distances_[i] != 0) {
+        slots_[i].~Value();
+        distances_[i] = 0;
+      }
+    }
+    size_ = 0;
+  }
+
+  iterator find(const Key& key) { return IteratorAt(FindIndex(key)); }
+  const_iterator find(const Key& key) const {
+    return IteratorAt(FindIndex(key));
+  }
+  size_t count(const Key& key) const {
+    return FindIndex(key) == capacity_ ? 0 : 1;
+  }
+
+  std::pair<iterator, bool> insert(const Value& value) {
+    return InsertValue(value);
+  }
+  std::pair<iterator, bool> insert(Value&& value) {
+    return InsertValue(std::move(value));
+  }
+  template <class InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    for (; first != last; ++first) InsertValue(*first);
+  }
+
+  // Returns the number of erased elements, 0 or 1.
+  size_t erase(const Key& key) {
+    const size_t index = FindIndex(key);
+    if (index == capacity_) return 0;
+    EraseIndex(index);
+    return 1;
+  }
+  void erase(const_iterator it) {
+    EraseIndex(it.distance_ - distances_.data());
+  }
+
+  void swap(FlatHashTable& other) {
+    std::swap(hash_, other.hash_);
+    std::swap(equal_, other.equal_);
+    std::swap(slots_, other.slots_);
+    distances_.swap(other.distances_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(mask_, other.mask_);
+    std::swap(shift_, other.shift_);
+    std::swap(size_, other.size_);
+  }
+
+ protected:
+  // Returns the index of the element with the given key, or capacity_.
+  size_t FindIndex(const Key& key) const {
+    if (size_ == 0) return capacity_;
+    size_t index = HomeSlot(key);
+    // An element whose distance to its home slot is the same as ours has the
+    // same home slot, and we can stop at the first element with a smaller
+    // distance.
+    for (uint32 distance = 1; distance <= distances_[index]; ++distance) {
+      if (distances_[index] == distance &&
+          equal_(extract_key_(slots_[index]), key)) {
+        return index;
+      }
+      index = (index + 1) & mask_;
+    }
+    return capacity_;
+  }
+
+  template <class V>
+  std::pair<iterator, bool> InsertValue(V&& value) {
+    const size_t index = FindIndex(extract_key_(value));
+    if (index != capacity_) return std::make_pair(IteratorAt(index), false);
+    return std::make_pair(IteratorAt(InsertNew(std::forward<V>(value))), true);
+  }
+
+  // Inserts a value whose key is not in the table, and returns its index.
+  template <class V>
+  size_t InsertNew(V&& value) {
+    if ((size_ + 1) * 8 > capacity_ * 7) {
+      Rehash(capacity_ == 0 ? kMinCapacity : 2 * capacity_);
+    }
+    // The new element goes after the elements with the same or a previous
+    // home slot, and the following elements are shifted by one slot.
+    size_t index = HomeSlot(extract_key_(value));
+    uint32 distance = 1;
+    while (distances_[index] >= distance) {
+      index = (index + 1) & mask_;
+      ++distance;
+    }
+    if (distances_[index] != 0) {
+      size_t to = index;
+      while (distances_[to] != 0) to = (to + 1) & mask_;
+      while (to != index) {
+        const size_t from = (to - 1) & mask_;
+        new (slots_ + to) Value(std::move(slots_[from]));
+        slots_[from].~Value();
+        distances_[to] = distances_[from] + 1;
+        to = from;
+      }
+    }
+    new (slots_ + index) Value(std::forward<V>(value));
+    distances_[index] = distance;
+    ++size_;
+    return index;
+  }
+
+  void EraseIndex(size_t index) {
+    DCHECK_LT(index, capacity_);
+    DCHECK_NE(0, distances_[index]);
+    slots_[index].~Value();
+    // Shift back the following elements that are not in their home slot.
+    size_t next = (index + 1) & mask_;
+    while (distances_[next] > 1) {
+      new (slots_ + index) Value(std::move(slots_[next]));
+      slots_[next].~Value();
+      distances_[index] = distances_[next] - 1;
+      index = next;
+      next = (next + 1) & mask_;
+    }
+    distances_[index] = 0;
+    --size_;
+  }
+
+  iterator IteratorAt(size_t index) {
+    const uint32* const distances = distances_.data();
+    return iterator(slots_ + index, distances + index, distances + capacity_);
+  }
+  const_iterator IteratorAt(size_t index) const {
+    const uint32* const distances = distances_.data();
+    return const_iterator(slots_ + index, distances + index,
+                          distances + capacity_);
+  }
+
+ private:
+  static const size_t kMinCapacity = 8;
+
+  size_t HomeSlot(const Key& key) const {
+    // The high bits of the product depend on all the bits of the hash value.
+    return static_cast<size_t>(
+        (static_cast<uint64>(hash_(key)) * GG_ULONGLONG(0x9e3779b97f4a7c15)) >>
+        shift_);
+  }
+
+  void Rehash(size_t new_capacity) {
+    DCHECK_EQ(0, new_capacity & (new_capacity - 1));
+    Value* const old_slots = slots_;
+    std::vector<uint32> old_distances;
+    old_distances.swap(distances_);
+    const size_t old_capacity = capacity_;
+    Allocate(new_capacity);
+    size_ = 0;
+    for (size_t i = 0; i < old_capacity; ++i) {
+      if (old_distances[i] != 0) {
+        InsertNew(std::move(old_slots[i]));
+        old_slots[i].~Value();
+      }
+    }
+    std::allocator<Value>().deallocate(old_slots, old_capacity);
+  }
+
+  void Allocate(size_t capacity) {
+    slots_ =
+        capacity == 0 ? nullptr : std::allocator<Value>().allocate(capacity);
+    distances_.assign(capacity, 0);
+    capacity_ = capacity;
+    mask_ = capacity - 1;
+    shift_ = 64;
+    while ((size_t(1) << (64 - shift_)) < capacity) --shift_;
+  }
+
+  void Deallocate() {
+    clear();
+    if (slots_ != nullptr) {
+      std::allocator<Value>().deallocate(slots_, capacity_);
+    }
+    slots_ = nullptr;
+    distances_.clear();
+    capacity_ = 0;
+    mask_ = 0;
+    shift_ = 64;
+  }
+
+  // The elements keep their slots, since the hash function is the same.
+  void CopyFrom(const FlatHashTable& other) {
+    Allocate(other.capacity_);
+    for (size_t i = 0; i < capacity_; ++i) {
+      if (other.distances_[i] != 0) {
+        new (slots_ + i) Value(other.slots_[i]);
+        distances_[i] = other.distances_[i];
+      }
+    }
+    size_ = other.size_;
+  }
+
+  Hash hash_;
+  Equal equal_;
+  ExtractKey extract_key_;
+
+  // The elements. The slot i is used if and only if distances_[i] is not 0,
+  // in which case distances_[i] - 1 is the distance from the home slot of its
+  // element (modulo capacity_).
+  Value* slots_;
+  std::vector<uint32> distances_;
+  size_t capacity_;  // Zero or a power of two.
+  size_t mask_;      // capacity_ - 1.
+  int shift_;        // 64 - log2(capacity_).
+  size_t size_;
+};
+
+template <class Key, class Value>
+struct SelectFirst {
+  const Key& operator()(const std::pair<const Key, Value>& p) const {
+    return p.first;
+  }
+};
+
+template <class Key>
+struct Identity {
+  const Key& operator()(const Key& key) const { return key; }
+};
+
+}  // namespace internal
+
+template <class Key, class Value, class Hash = FlatHash<Key>,
+          class Equal = std::equal_to<Key> >
+class FlatHashMap
+    : public internal::FlatHashTable<Key, std::pair<const Key, Value>,
+                                     internal::SelectFirst<Key, Value>, Hash,
+                                     Equal> {
+ public:
+  typedef Value mapped_type;
+
+  FlatHashMap() {}
+  explicit FlatHashMap(size_t num_elements) { this->reserve(num_elements); }
+
+  Value& operator[](const Key& key) {
+    size_t index = this->FindIndex(key);
+    if (index == this->bucket_count()) {
+      index = this->InsertNew(std::pair<const Key, Value>(key, Value()));
+    }
+    return this->IteratorAt(index)->second;
+  }
+};
+
+template <class Key, class Hash = FlatHash<Key>,
+          class Equal = std::equal_to<Key> >
+class FlatHashSet
+    : public internal::FlatHashTable<Key, Key, internal::Identity<Key>, Hash,
+                                     Equal> {
+  typedef internal::FlatHashTable<Key, Key, internal::Identity<Key>, Hash,
+                                  Equal> Table;
+
+ public:
+  // The elements of a set can't be modified.
+  typedef typename Table::const_iterator iterator;
+
+  FlatHashSet() {}
+  explicit FlatHashSet(size_t num_elements) { this->reserve(num_elements); }
+
+  iterator begin() const { return Table::begin(); }
+  iterator end() const { return Table::end(); }
+  iterator find(const Key& key) const { return Table::find(key); }
+  std::pair<iterator, bool> insert(const Key& key) {
+    return Table::insert(key);
+  }
+  std::pair<iterator, bool> insert(Key&& key) {
+    return Table::insert(std::move(key));
+  }
+  template <class InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    for (; first != last; ++first) Table::insert(*first);
+  }
+};
+
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_BASE_FLAT_HASH_MAP_H_
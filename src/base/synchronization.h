@@ -14,8 +14,10 @@
 #ifndef OR_TOOLS_BASE_SYNCHRONIZATION_H_
 #define OR_TOOLS_BASE_SYNCHRONIZATION_H_
 
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
+#include <thread>
 
 #include "base/logging.h"
 
@@ -48,5 +50,67 @@ class Barrier {
   int num_to_exit_;
   DISALLOW_COPY_AND_ASSIGN(Barrier);
 };
+
+// Unlike Barrier, which can only be crossed once, this barrier can be used
+// repeatedly by the same group of threads: each call to Wait() blocks until
+// num_threads threads have called it.
+class ReusableBarrier {
+ public:
+  explicit ReusableBarrier(int num_threads)
+      : num_threads_(num_threads), num_waiting_(0), generation_(0) {}
+
+  void Wait() {
+    std::unique_lock<std::mutex> mutex_lock(mutex_);
+    const int generation = generation_;
+    if (++num_waiting_ == num_threads_) {
+      num_waiting_ = 0;
+      ++generation_;
+      condition_.notify_all();
+    } else {
+      while (generation == generation_) {
+        condition_.wait(mutex_lock);
+      }
+    }
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  const int num_threads_;
+  int num_waiting_;
+  int generation_;
+  DISALLOW_COPY_AND_ASSIGN(ReusableBarrier);
+};
+
+// A ReusableBarrier where the waiting threads spin instead of sleeping on a
+// condition variable. Crossing it costs far less than crossing a
+// ReusableBarrier, which matters when the threads synchronize after each of
+// many short steps, but the waiting threads keep their cores busy: it should
+// only be used when the threads do not wait long, and when there are no more
+// threads than cores.
+class SpinningBarrier {
+ public:
+  explicit SpinningBarrier(int num_threads)
+      : num_threads_(num_threads), num_waiting_(0), generation_(0) {}
+
+  void Wait() {
+    const int generation = generation_.load(std::memory_order_acquire);
+    if (num_waiting_.fetch_add(1, std::memory_order_acq_rel) + 1 ==
+        num_threads_) {
+      num_waiting_.store(0, std::memory_order_relaxed);
+      generation_.fetch_add(1, std::memory_order_release);
+    } else {
+      while (generation_.load(std::memory_order_acquire) == generation) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+ private:
+  const int num_threads_;
+  std::atomic<int> num_waiting_;
+  std::atomic<int> generation_;
+  DISALLOW_COPY_AND_ASSIGN(SpinningBarrier);
+};
 }  // namespace operations_research
 #endif  // OR_TOOLS_BASE_SYNCHRONIZATION_H_
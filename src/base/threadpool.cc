@@ -13,61 +13,246 @@
 
 #include "base/threadpool.h"
 
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+
+#include "base/logging.h"
+
 namespace operations_research {
-void RunWorker(void* data) {
-  ThreadPool* const thread_pool = reinterpret_cast<ThreadPool*>(data);
-  Closure* work = thread_pool->GetNextTask();
-  while (work != NULL) {
-    work->Run();
-    work = thread_pool->GetNextTask();
+namespace {
+// The shared state of the tasks of a ParallelFor(): each task runs the next
+// range of the loop until there is none left.
+class ParallelForLoop {
+ public:
+  ParallelForLoop(int64 begin, int64 end, int64 grain_size,
+                  Callback2<int64, int64>* const body)
+      : end_(end), grain_size_(grain_size), body_(body), next_(begin) {}
+
+  void RunRanges() {
+    for (;;) {
+      const int64 first = next_.fetch_add(grain_size_);
+      if (first >= end_) return;
+      body_->Run(first, std::min(end_, first + grain_size_));
+    }
   }
+
+ private:
+  const int64 end_;
+  const int64 grain_size_;
+  Callback2<int64, int64>* const body_;
+  std::atomic<int64> next_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelForLoop);
+};
+}  // namespace
+
+namespace internal {
+void RunAndSetVoidPromise(Closure* closure, std::promise<void>* promise) {
+  closure->Run();
+  promise->set_value();
+  delete promise;
 }
+}  // namespace internal
 
 ThreadPool::ThreadPool(const std::string& prefix, int num_workers)
-    : num_workers_(num_workers), waiting_to_finish_(false), started_(false) {}
+    : prefix_(prefix),
+      num_workers_(num_workers),
+      num_queued_tasks_(0),
+      num_sleeping_workers_(0),
+      waiting_to_finish_(false),
+      started_(false) {
+  CHECK_GE(num_workers, 0);
+  for (int i = 0; i <= num_workers_; ++i) {
+    queues_.emplace_back(new TaskQueue());
+  }
+}
 
 ThreadPool::~ThreadPool() {
-  if (started_) {
-    std::unique_lock<std::mutex> mutex_lock(mutex_);
-    waiting_to_finish_ = true;
-    mutex_lock.unlock();
-    condition_.notify_all();
-    for (int i = 0; i < num_workers_; ++i) {
-      all_workers_[i].join();
-    }
+  std::unique_lock<std::mutex> mutex_lock(mutex_);
+  waiting_to_finish_ = true;
+  mutex_lock.unlock();
+  condition_.notify_all();
+  for (int i = 0; i < all_workers_.size(); ++i) {
+    all_workers_[i].join();
+  }
+  // Runs the tasks that are left when there are no workers, or when they were
+  // never started.
+  while (RunPendingTask()) {
   }
 }
 
 void ThreadPool::StartWorkers() {
+  CHECK(!started_);
+  // The workers wait for mutex_ before running any task, so that they see all
+  // of worker_ids_.
+  std::unique_lock<std::mutex> mutex_lock(mutex_);
   started_ = true;
   for (int i = 0; i < num_workers_; ++i) {
-    all_workers_.push_back(std::thread(&RunWorker, this));
+    all_workers_.push_back(std::thread(&ThreadPool::RunWorker, this, i));
+    worker_ids_.push_back(all_workers_.back().get_id());
   }
 }
 
-Closure* ThreadPool::GetNextTask() {
-  std::unique_lock<std::mutex> lock(mutex_);
+void ThreadPool::RunWorker(int worker) {
+  { std::unique_lock<std::mutex> mutex_lock(mutex_); }
+  SetWorkerAffinity(worker);
   for (;;) {
-    if (!tasks_.empty()) {
-      Closure* const task = tasks_.front();
-      tasks_.pop_front();
-      return task;
+    Closure* const task = FindTask(worker);
+    if (task != NULL) {
+      task->Run();
+      continue;
+    }
+    std::unique_lock<std::mutex> mutex_lock(mutex_);
+    // Add() reads num_sleeping_workers_ after increasing num_queued_tasks_:
+    // either it sees this worker sleeping and notifies it, or this worker
+    // sees the new task.
+    ++num_sleeping_workers_;
+    while (num_queued_tasks_ == 0 && !waiting_to_finish_) {
+      condition_.wait(mutex_lock);
+    }
+    --num_sleeping_workers_;
+    if (num_queued_tasks_ == 0 && waiting_to_finish_) return;
+  }
+}
+
+int ThreadPool::CurrentWorker() const {
+  const std::thread::id id = std::this_thread::get_id();
+  for (int i = 0; i < worker_ids_.size(); ++i) {
+    if (worker_ids_[i] == id) return i;
+  }
+  return num_workers_;
+}
+
+Closure* ThreadPool::FindTask(int worker) {
+  if (num_queued_tasks_ == 0) return NULL;
+  Closure* task = NULL;
+  // The most recent task of the worker, or for the other threads the most
+  // recent task they added: this bounds the depth of the nested Wait() as in a
+  // sequential execution.
+  {
+    TaskQueue* const queue = queues_[worker].get();
+    std::unique_lock<std::mutex> queue_lock(queue->mutex);
+    if (!queue->tasks.empty()) {
+      task = queue->tasks.back();
+      queue->tasks.pop_back();
     }
-    if (waiting_to_finish_) {
-      return NULL;
-    } else {
-      condition_.wait(lock);
+  }
+  // The oldest task of the other queues.
+  for (int i = 1; task == NULL && i <= num_workers_; ++i) {
+    TaskQueue* const queue = queues_[(worker + i) % (num_workers_ + 1)].get();
+    std::unique_lock<std::mutex> queue_lock(queue->mutex);
+    if (!queue->tasks.empty()) {
+      task = queue->tasks.front();
+      queue->tasks.pop_front();
     }
   }
-  return NULL;
+  if (task != NULL) --num_queued_tasks_;
+  return task;
+}
+
+void ThreadPool::SetWorkerAffinity(int worker) {
+#if defined(__linux__)
+  // The names of the threads are limited to 15 characters.
+  pthread_setname_np(pthread_self(), prefix_.substr(0, 15).c_str());
+  if (cpu_affinity_.empty()) return;
+  const int cpu = cpu_affinity_[worker % cpu_affinity_.size()];
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(cpu, &cpu_set);
+  if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0) {
+    LOG(WARNING) << "Could not pin worker " << worker << " of " << prefix_
+                 << " to CPU " << cpu;
+  }
+#endif
 }
 
 void ThreadPool::Add(Closure* const closure) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  tasks_.push_back(closure);
-  if (started_) {
-    lock.unlock();
-    condition_.notify_all();
+  CHECK(closure != NULL);
+  TaskQueue* const queue = queues_[CurrentWorker()].get();
+  {
+    std::unique_lock<std::mutex> queue_lock(queue->mutex);
+    queue->tasks.push_back(closure);
+  }
+  ++num_queued_tasks_;
+  if (num_sleeping_workers_ > 0) {
+    std::unique_lock<std::mutex> mutex_lock(mutex_);
+    condition_.notify_one();
+  }
+}
+
+std::future<void> ThreadPool::Schedule(Closure* const closure) {
+  std::promise<void>* const promise = new std::promise<void>();
+  std::future<void> future = promise->get_future();
+  Add(NewCallback(&internal::RunAndSetVoidPromise, closure, promise));
+  return future;
+}
+
+bool ThreadPool::RunPendingTask() {
+  Closure* const task = FindTask(CurrentWorker());
+  if (task == NULL) return false;
+  task->Run();
+  return true;
+}
+
+void ThreadPool::ParallelFor(int64 begin, int64 end, int64 grain_size,
+                             Callback2<int64, int64>* const body) {
+  CHECK(body != NULL);
+  CHECK_GE(grain_size, 0);
+  if (begin >= end) return;
+  const int64 num_threads = num_workers_ + 1;
+  if (grain_size == 0) {
+    grain_size = std::max<int64>(
+        1, (end - begin + 4 * num_threads - 1) / (4 * num_threads));
+  }
+  const int64 num_ranges = (end - begin + grain_size - 1) / grain_size;
+  ParallelForLoop loop(begin, end, grain_size, body);
+  TaskGroup group(this);
+  // The calling thread runs ranges too, hence the - 1.
+  const int64 num_tasks = std::min<int64>(num_ranges - 1, num_workers_);
+  for (int64 i = 0; i < num_tasks; ++i) {
+    group.Add(NewCallback(&loop, &ParallelForLoop::RunRanges));
+  }
+  loop.RunRanges();
+  group.Wait();
+}
+
+TaskGroup::TaskGroup(ThreadPool* const pool)
+    : pool_(pool), num_pending_tasks_(0) {
+  CHECK(pool != NULL);
+}
+
+TaskGroup::~TaskGroup() { Wait(); }
+
+void TaskGroup::Add(Closure* const closure) {
+  CHECK(closure != NULL);
+  ++num_pending_tasks_;
+  pool_->Add(NewCallback(this, &TaskGroup::RunTask, closure));
+}
+
+void TaskGroup::RunTask(Closure* closure) {
+  closure->Run();
+  // The counter is decreased with mutex_ held, so that Wait() cannot return,
+  // and the group be destroyed, before the notification is done.
+  std::unique_lock<std::mutex> mutex_lock(mutex_);
+  if (--num_pending_tasks_ == 0) condition_.notify_all();
+}
+
+void TaskGroup::Wait() {
+  while (num_pending_tasks_ > 0) {
+    if (pool_->RunPendingTask()) continue;
+    // All the queues were empty: the pending tasks of the group are running in
+    // other threads. They may add new tasks to the group, hence the timeout.
+    std::unique_lock<std::mutex> mutex_lock(mutex_);
+    if (num_pending_tasks_ > 0) {
+      condition_.wait_for(mutex_lock, std::chrono::milliseconds(1));
+    }
   }
+  // Waits for the end of the last RunTask().
+  std::unique_lock<std::mutex> mutex_lock(mutex_);
 }
 }  // namespace operations_research
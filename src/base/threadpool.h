@@ -11,36 +11,182 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+// A pool of worker threads with work stealing.
+//
+// Each worker has its own deque of tasks: the tasks added by a worker (e.g.
+// the subtasks of a task) are pushed at the back of its deque, and the worker
+// runs the tasks of its deque from the back, i.e. the most recent first. An
+// idle worker steals the oldest task of the other deques, which is usually
+// the largest piece of work. The tasks added by the other threads go to a
+// shared queue. The idle workers sleep until a task is added.
+//
+// A thread waiting for a TaskGroup or a ParallelFor() runs the pending tasks
+// of the pool while it waits, so that tasks can wait for subtasks (e.g.
+// nested parallel loops) without blocking a worker or deadlocking the pool.
+//
+// Example usage:
+//   ThreadPool pool("Solvers", 4);
+//   pool.StartWorkers();
+//   std::future<int64> cost = pool.Schedule(NewCallback(&Solve, problem));
+//   {
+//     TaskGroup group(&pool);
+//     for (int i = 0; i < n; ++i) group.Add(NewCallback(&Preprocess, i));
+//     group.Wait();
+//   }
+//   // Calls Process(first, last) on ranges of 1000 elements of [0, n).
+//   std::unique_ptr<Callback2<int64, int64> > body(
+//       NewPermanentCallback(&Process));
+//   pool.ParallelFor(0, n, 1000, body.get());
+//   LOG(INFO) << cost.get();
+
 #ifndef OR_TOOLS_BASE_THREADPOOL_H_
 #define OR_TOOLS_BASE_THREADPOOL_H_
 
+#include <atomic>
 #include <condition_variable>  // NOLINT
-#include <list>
+#include <deque>
+#include <future>  // NOLINT
 #include <mutex>  // NOLINT
 #include <string>
 #include <vector>
 #include <thread>  // NOLINT
 
 #include "base/callback.h"
+#include "base/integral_types.h"
+#include "base/macros.h"
+#include "base/unique_ptr.h"
 
 namespace operations_research {
 class ThreadPool {
  public:
+  // The prefix is the name of the worker threads, on the platforms where
+  // threads have names. num_threads may be 0: the tasks are then run by the
+  // threads that wait for them (TaskGroup::Wait(), ParallelFor()) and by the
+  // destructor.
   explicit ThreadPool(const std::string& prefix, int num_threads);
+
+  // Waits until all the tasks, including the ones added by running tasks,
+  // have been run.
   ~ThreadPool();
 
+  // Pins the worker i to the CPU cpus[i % cpus.size()]. Must be called before
+  // StartWorkers(). The default, an empty vector, lets the operating system
+  // place the workers. Only supported on Linux, ignored elsewhere.
+  void set_cpu_affinity(const std::vector<int>& cpus) { cpu_affinity_ = cpus; }
+
   void StartWorkers();
+
+  // Adds a task. The closure must be self-deleting (see NewCallback()). The
+  // tasks may be added before StartWorkers().
   void Add(Closure* const closure);
-  Closure* GetNextTask();
+
+  // Adds a task whose result is returned through the future. The callback
+  // must be self-deleting. Note that a task should not wait for a future: this
+  // blocks its worker, contrary to TaskGroup::Wait(). For the same reason, a
+  // future of a pool without workers is only ready after a TaskGroup::Wait()
+  // or the destruction of the pool.
+  template <class T>
+  std::future<T> Schedule(ResultCallback<T>* const callback);
+  std::future<void> Schedule(Closure* const closure);
+
+  // Calls body->Run(first, last) on consecutive ranges [first, last) that
+  // partition [begin, end), in parallel on the workers and on the calling
+  // thread, and returns when all the calls are done. All the ranges have
+  // grain_size elements, except the last one. If grain_size is 0, it is
+  // chosen to give about 4 ranges per thread. The body must be a permanent
+  // callback (see NewPermanentCallback()); it is owned by the caller.
+  void ParallelFor(int64 begin, int64 end, int64 grain_size,
+                   Callback2<int64, int64>* const body);
+
+  // Runs one pending task in the calling thread, if any. Returns false if
+  // there was no pending task.
+  bool RunPendingTask();
+
+  int num_workers() const { return num_workers_; }
 
  private:
+  // A deque of tasks with its own mutex.
+  struct TaskQueue {
+    std::mutex mutex;
+    std::deque<Closure*> tasks;
+  };
+
+  // Runs the tasks of the worker until the destruction of the pool.
+  void RunWorker(int worker);
+
+  // Returns the index of the worker running in the calling thread, or
+  // num_workers_ if the caller is not a worker of this pool.
+  int CurrentWorker() const;
+
+  // Returns the next task to run for the given worker (or num_workers_ for the
+  // other threads), or NULL if all the queues are empty.
+  Closure* FindTask(int worker);
+
+  // Pins the given worker as specified by set_cpu_affinity().
+  void SetWorkerAffinity(int worker);
+
+  const std::string prefix_;
   const int num_workers_;
-  std::list<Closure*> tasks_;
+  std::vector<int> cpu_affinity_;
+  // queues_[w] is the deque of the worker w, and queues_[num_workers_] the
+  // queue of the tasks added by the other threads.
+  std::vector<std::unique_ptr<TaskQueue> > queues_;
+  // The number of tasks in all the queues, and the number of sleeping
+  // workers.
+  std::atomic<int> num_queued_tasks_;
+  std::atomic<int> num_sleeping_workers_;
+  // The idle workers wait on condition_, with mutex_.
   std::mutex mutex_;
   std::condition_variable condition_;
   bool waiting_to_finish_;
   bool started_;
   std::vector<std::thread> all_workers_;
+  std::vector<std::thread::id> worker_ids_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadPool);
 };
+
+// A group of tasks of a ThreadPool that can be waited for.
+class TaskGroup {
+ public:
+  explicit TaskGroup(ThreadPool* const pool);
+  // Waits for the tasks of the group.
+  ~TaskGroup();
+
+  // Adds a task to the group and to the pool. The closure must be
+  // self-deleting.
+  void Add(Closure* const closure);
+
+  // Returns when all the tasks added to the group have been run. The calling
+  // thread runs the pending tasks of the pool meanwhile.
+  void Wait();
+
+ private:
+  void RunTask(Closure* closure);
+
+  ThreadPool* const pool_;
+  std::atomic<int> num_pending_tasks_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+
+  DISALLOW_COPY_AND_ASSIGN(TaskGroup);
+};
+
+namespace internal {
+template <class T>
+void RunAndSetPromise(ResultCallback<T>* callback, std::promise<T>* promise) {
+  promise->set_value(callback->Run());
+  delete promise;
+}
+void RunAndSetVoidPromise(Closure* closure, std::promise<void>* promise);
+}  // namespace internal
+
+template <class T>
+std::future<T> ThreadPool::Schedule(ResultCallback<T>* const callback) {
+  std::promise<T>* const promise = new std::promise<T>();
+  std::future<T> future = promise->get_future();
+  Add(NewCallback(&internal::RunAndSetPromise<T>, callback, promise));
+  return future;
+}
 }  // namespace operations_research
 #endif  // OR_TOOLS_BASE_THREADPOOL_H_
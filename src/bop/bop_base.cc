@@ -204,13 +204,14 @@ void ProblemState::SynchronizationDone() {
 // StampedLearnedInfo
 //------------------------------------------------------------------------------
 StampedLearnedInfo::StampedLearnedInfo()
-    : learned_infos_(), last_stamp_reached_(false), mutex_() {}
+    : learned_infos_(), last_stamp_reached_(false), mutex_(), stamp_added_() {}
 
 void StampedLearnedInfo::AddLearnedInfo(SolverTimeStamp stamp,
                                         const LearnedInfo& learned_info) {
-  // MutexLock mutex_lock(&mutex_);
+  MutexLock mutex_lock(&mutex_);
   CHECK_EQ(stamp, learned_infos_.size());
   learned_infos_.push_back(learned_info);
+  stamp_added_.SignalAll();
 }
 
 bool StampedLearnedInfo::GetLearnedInfo(SolverTimeStamp stamp,
@@ -220,51 +221,29 @@ bool StampedLearnedInfo::GetLearnedInfo(SolverTimeStamp stamp,
 
   learned_info->Clear();
 
-  {
-    // MutexLock mutex_lock(&mutex_);
-    if (ContainsStamp(stamp)) {
-      *learned_info = learned_infos_[stamp];
-      return true;
-    }
-    if (LastStampReached()) {
-      return false;
-    }
-  }
-  // MutexConditionInfo m(this, stamp);
-  // mutex_.LockWhen(Condition(&SatisfiesStampCondition, &m));
-  // mutex_.AssertHeld();
-  if (LastStampReached()) {
-    // mutex_.Unlock();
-    return false;
+  MutexLock mutex_lock(&mutex_);
+  while (!ContainsStamp(stamp) && !LastStampReached()) {
+    stamp_added_.Wait(&mutex_);
   }
-
-  CHECK(ContainsStamp(stamp));
+  if (!ContainsStamp(stamp)) return false;
   *learned_info = learned_infos_[stamp];
-  // mutex_.Unlock();
   return true;
 }
 
 void StampedLearnedInfo::MarkLastStampReached() {
-  // MutexLock mutex_lock(&mutex_);
+  MutexLock mutex_lock(&mutex_);
   last_stamp_reached_ = true;
+  stamp_added_.SignalAll();
 }
 
 bool StampedLearnedInfo::LastStampReached() const {
-  // mutex_.AssertHeld();
   return last_stamp_reached_;
 }
 
 bool StampedLearnedInfo::ContainsStamp(SolverTimeStamp stamp) const {
-  // mutex_.AssertHeld();
   return stamp < learned_infos_.size();
 }
 
-bool StampedLearnedInfo::SatisfiesStampCondition(MutexConditionInfo* m) {
-  CHECK(nullptr != m);
-  return m->learned_infos->ContainsStamp(m->stamp) ||
-         m->learned_infos->LastStampReached();
-}
-
 //------------------------------------------------------------------------------
 // BopOptimizerBase
 //------------------------------------------------------------------------------
@@ -278,23 +278,12 @@ class StampedLearnedInfo {
   bool ContainsStamp(SolverTimeStamp stamp) const
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
-  struct MutexConditionInfo {
-    MutexConditionInfo(StampedLearnedInfo* i, SolverTimeStamp s)
-        : learned_infos(i), stamp(s) {}
-    const StampedLearnedInfo* learned_infos;
-    SolverTimeStamp stamp;
-  };
-
-  // Static function used as a Condition to wait for available info at a given
-  // stamp.
-  // Returns true when the info is available.
-  static bool SatisfiesStampCondition(MutexConditionInfo* const m)
-      NO_THREAD_SAFETY_ANALYSIS;
-
   ITIVector<SolverTimeStamp, LearnedInfo> learned_infos_ GUARDED_BY(mutex_);
   bool last_stamp_reached_ GUARDED_BY(mutex_);
   // TODO(user): Use ReadMutex and WriteMutex?
   mutable Mutex mutex_;
+  // Signaled when a stamp is added or the last stamp is reached.
+  CondVar stamp_added_;
 };
 
 }  // namespace bop
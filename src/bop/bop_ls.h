@@ -31,6 +31,7 @@
 
 #include "base/hash.h"
 
+#include "base/flat_hash_map.h"
 #include "base/hash.h"
 #include "bop/bop_base.h"
 #include "bop/bop_solution.h"
@@ -511,12 +512,7 @@ class LocalSearchAssignmentIterator {
   // Ideally, this should be related to the maximum number of decision in the
   // LS, but that requires templating the whole LS optimizer.
   bool use_transposition_table_;
-#if defined(_MSC_VER)
-  hash_set<std::array<int32, kStoredMaxDecisions>,
-           StdArrayHasher<int32, kStoredMaxDecisions>> transposition_table_;
-#else
-  hash_set<std::array<int32, kStoredMaxDecisions>> transposition_table_;
-#endif
+  FlatHashSet<std::array<int32, kStoredMaxDecisions>> transposition_table_;
 
   // The number of explored nodes.
   int64 num_nodes_;
@@ -211,7 +211,10 @@ void PortfolioOptimizer::CreateOptimizers(
   if (parameters.use_symmetry()) {
     VLOG(1) << "Finding symmetries of the problem.";
     std::vector<std::unique_ptr<SparsePermutation>> generators;
-    sat::FindLinearBooleanProblemSymmetries(problem, &generators);
+    TimeLimit time_limit(
+        parameters.max_time_in_seconds(),
+        parameters.symmetry_detection_deterministic_time_limit());
+    sat::FindLinearBooleanProblemSymmetries(problem, &time_limit, &generators);
     sat_propagator_.AddSymmetries(&generators);
   }
 
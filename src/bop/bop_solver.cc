@@ -21,6 +21,7 @@
 #include "google/protobuf/text_format.h"
 #include "base/threadpool.h"
 #include "base/stl_util.h"
+#include "base/timer.h"
 #include "bop/bop_fs.h"
 #include "bop/bop_lns.h"
 #include "bop/bop_ls.h"
@@ -33,6 +34,7 @@
 #include "sat/lp_utils.h"
 #include "sat/sat_solver.h"
 #include "util/bitset.h"
+#include "util/stats_registry.h"
 
 using operations_research::glop::ColIndex;
 using operations_research::glop::DenseRow;
@@ -223,7 +225,7 @@ void RunOptimizer(const std::string& name, SolverSynchronizer* solver_sync) {
     solver_sync->SynchronizeSolverInfos(stamp, &problem_changed, &stop_solver);
     if (stop_solver || problem_state->IsOptimal() ||
         problem_state->IsInfeasible()) {
-      return;
+      break;
     }
 
     if (optimization_status == BopOptimizerBase::SOLUTION_FOUND) {
@@ -264,8 +266,20 @@ BopSolveStatus BopSolver::Solve() {
 
   UpdateParameters();
 
-  return parameters_.number_of_solvers() > 1 ? InternalMultithreadSolver()
-                                             : InternalMonothreadSolver();
+  WallTimer timer;
+  timer.Start();
+  const BopSolveStatus status = parameters_.number_of_solvers() > 1
+                                    ? InternalMultithreadSolver()
+                                    : InternalMonothreadSolver();
+  static StatsCounter* const solves = StatsRegistry::Global()->GetCounter(
+      "bop_solves_total", "Number of calls to BopSolver::Solve().");
+  static StatsHistogram* const solve_time =
+      StatsRegistry::Global()->GetHistogram(
+          "bop_solve_time_seconds", "Wall time of BopSolver::Solve().",
+          StatsHistogram::ExponentialBuckets(1e-3, 10.0, 7));
+  solves->Increment();
+  solve_time->Record(timer.Get());
+  return status;
 }
 
 BopSolveStatus BopSolver::InternalMonothreadSolver() {
@@ -329,16 +343,15 @@ BopSolveStatus BopSolver::InternalMultithreadSolver() {
   }
 
   if (num_solvers > 1) {
-    LOG(FATAL) << "Multi threading is not supported";
-    // ThreadPool thread_pool("ParallelSolve", num_solvers);
-    // thread_pool.StartWorkers();
-    // for (int index = 0; index < num_solvers; ++index) {
-    //   const std::string solver_name = StringPrintf("Solver_%d", index);
-    //   SolverSynchronizer* const solver_sync = &synchronizers[index];
-    //   thread_pool.Schedule([solver_name, solver_sync]() {
-    //     RunOptimizer(solver_name, solver_sync);
-    //   });
-    // }
+    // The solvers wait for each other at each stamp, so they all need their
+    // own thread. The destructor of the pool waits for all of them.
+    ThreadPool thread_pool("ParallelSolve", num_solvers);
+    thread_pool.StartWorkers();
+    for (int index = 0; index < num_solvers; ++index) {
+      thread_pool.Add(NewCallback(&RunOptimizer,
+                                  StringPrintf("Solver_%d", index),
+                                  &synchronizers[index]));
+    }
   } else {
     // TODO(user): Consider having a dedicated method to solve with only one
     //              solver.
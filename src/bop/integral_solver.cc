@@ -19,6 +19,7 @@
 #include "base/threadpool.h"
 #include "bop/bop_solver.h"
 #include "lp_data/lp_decomposer.h"
+#include "sat/lp_utils.h"
 
 namespace operations_research {
 namespace bop {
@@ -910,6 +911,23 @@ BopSolveStatus IntegralSolver::Solve(const LinearProgram& linear_problem) {
   // we will simply change the target of this pointer.
   LinearProgram const* lp = &linear_problem;
 
+  // Removes the symmetric solutions of the problem with symmetry breaking
+  // constraints. Note that the symmetries found later on the Boolean problem
+  // are the ones of the problem with these constraints.
+  LinearProgram symmetry_broken_problem;
+  if (parameters_.use_symmetry()) {
+    std::vector<std::unique_ptr<SparsePermutation>> generators;
+    TimeLimit time_limit(
+        parameters_.max_time_in_seconds(),
+        parameters_.symmetry_detection_deterministic_time_limit());
+    sat::FindLinearProgramSymmetries(*lp, &time_limit, &generators);
+    if (!generators.empty()) {
+      symmetry_broken_problem.PopulateFromLinearProgram(
+          *lp, /*keep_table_names=*/false);
+      sat::AddSymmetryBreakingConstraints(generators, &symmetry_broken_problem);
+      lp = &symmetry_broken_problem;
+    }
+  }
 
   BopSolveStatus status;
   if (lp->num_variables() >= parameters_.decomposer_num_variables_threshold()) {
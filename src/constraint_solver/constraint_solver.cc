@@ -36,6 +36,7 @@
 #include "base/stl_util.h"
 #include "constraint_solver/constraint_solveri.h"
 #include "constraint_solver/model.pb.h"
+#include "util/stats_registry.h"
 #include "util/tuple_set.h"
 
 DEFINE_bool(cp_trace_propagation, false,
@@ -939,7 +940,9 @@ class Search {
         should_finish_(false),
         sentinel_pushed_(0),
         jmpbuf_filled_(false),
-        backtrack_at_the_end_of_the_search_(true) {}
+        backtrack_at_the_end_of_the_search_(true),
+        branches_at_start_(0),
+        fails_at_start_(0) {}
 
   // Constructor for a dummy search. The only difference between a dummy search
   // and a regular one is that the search depth and left search depth is
@@ -957,7 +960,9 @@ class Search {
         should_finish_(false),
         sentinel_pushed_(0),
         jmpbuf_filled_(false),
-        backtrack_at_the_end_of_the_search_(true) {}
+        backtrack_at_the_end_of_the_search_(true),
+        branches_at_start_(0),
+        fails_at_start_(0) {}
 
   ~Search() { STLDeleteElements(&marker_stack_); }
 
@@ -1045,6 +1050,10 @@ class Search {
   int sentinel_pushed_;
   bool jmpbuf_filled_;
   bool backtrack_at_the_end_of_the_search_;
+  // The branches and failures of the solver when entering the search, to
+  // export the ones of the search when it ends.
+  int64 branches_at_start_;
+  int64 fails_at_start_;
 };
 
 // Backtrack is implemented using 3 primitives:
@@ -1184,6 +1193,8 @@ void Search::EnterSearch() {
   // leaving search. This enables the information to persist outside of
   // top-level search.
   solution_counter_ = 0;
+  branches_at_start_ = solver_->branches();
+  fails_at_start_ = solver_->failures();
 
   for (int index = 0; index < monitors_.size(); ++index) {
     monitors_[index]->EnterSearch();
@@ -2300,6 +2311,19 @@ void Solver::EndSearch() {
   if (2 == searches_.size()) {  // Ending top level search.
     // Restores the state.
     state_ = OUTSIDE_SEARCH;
+    // The nested searches are accounted for in their top level search.
+    static StatsCounter* const searches = StatsRegistry::Global()->GetCounter(
+        "cp_searches_total", "Number of top level searches of the CP solver.");
+    static StatsCounter* const solutions = StatsRegistry::Global()->GetCounter(
+        "cp_solutions_total", "Number of solutions found by the CP solver.");
+    static StatsCounter* const branches = StatsRegistry::Global()->GetCounter(
+        "cp_branches_total", "Number of branches of the CP solver.");
+    static StatsCounter* const failures = StatsRegistry::Global()->GetCounter(
+        "cp_failures_total", "Number of failures of the CP solver.");
+    searches->Increment();
+    solutions->Add(search->solution_counter());
+    branches->Add(branches_ - search->branches_at_start_);
+    failures->Add(fails_ - search->fails_at_start_);
     // Checks if we want to export the profile info.
     if (!FLAGS_cp_profile_file.empty()) {
       LOG(INFO) << "Exporting profile to " << FLAGS_cp_profile_file;
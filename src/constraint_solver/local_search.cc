@@ -1109,7 +1109,7 @@ class TSPOpt : public PathOperator {
 
  private:
   std::vector<std::vector<int64> > cost_;
-  HamiltonianPathSolver<int64> hamiltonian_path_solver_;
+  ParallelHamiltonianPathSolver<int64> hamiltonian_path_solver_;
   std::unique_ptr<Solver::IndexEvaluator3> evaluator_;
   const int chain_length_;
 };
@@ -1178,7 +1178,7 @@ class TSPLns : public PathOperator {
 
  private:
   std::vector<std::vector<int64> > cost_;
-  HamiltonianPathSolver<int64> hamiltonian_path_solver_;
+  ParallelHamiltonianPathSolver<int64> hamiltonian_path_solver_;
   std::unique_ptr<Solver::IndexEvaluator3> evaluator_;
   const int tsp_size_;
   ACMRandom rand_;
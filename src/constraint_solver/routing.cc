@@ -33,6 +33,7 @@
 #include "base/hash.h"
 #include "graph/linear_assignment.h"
 #include "util/saturated_arithmetic.h"
+#include "util/stats_registry.h"
 
 namespace operations_research {
 class LocalSearchPhaseParameters;
@@ -2657,6 +2658,19 @@ const Assignment* RoutingModel::Solve(const Assignment* assignment) {
     solver_->Solve(improve_db_, monitors_);
   }
   const int64 elapsed_time_ms = solver_->wall_time() - start_time_ms;
+  static StatsCounter* const solves = StatsRegistry::Global()->GetCounter(
+      "routing_solves_total", "Number of calls to RoutingModel::Solve().");
+  static StatsCounter* const solutions_found =
+      StatsRegistry::Global()->GetCounter(
+          "routing_solutions_found_total",
+          "Number of calls to RoutingModel::Solve() that found a solution.");
+  static StatsHistogram* const solve_time =
+      StatsRegistry::Global()->GetHistogram(
+          "routing_solve_time_seconds", "Wall time of RoutingModel::Solve().",
+          StatsHistogram::ExponentialBuckets(1e-2, 10.0, 6));
+  solves->Increment();
+  solutions_found->Add(collect_assignments_->solution_count());
+  solve_time->Record(elapsed_time_ms / 1000.0);
   if (collect_assignments_->solution_count() == 1) {
     status_ = ROUTING_SUCCESS;
     return collect_assignments_->solution(0);
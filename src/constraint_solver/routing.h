@@ -163,6 +163,7 @@
 
 #include "base/callback.h"
 #include "base/commandlineflags.h"
+#include "base/flat_hash_map.h"
 #include "base/integral_types.h"
 #include "base/logging.h"
 #include "base/macros.h"
@@ -1238,7 +1239,7 @@ class RoutingModel {
 #endif  // SWIG
   std::unique_ptr<ResultCallback1<int, int64> > vehicle_start_class_callback_;
   // Cached callbacks
-  hash_map<const NodeEvaluator2*, NodeEvaluator2*> cached_node_callbacks_;
+  FlatHashMap<const NodeEvaluator2*, NodeEvaluator2*> cached_node_callbacks_;
   // Disjunctions
   ITIVector<DisjunctionIndex, Disjunction> disjunctions_;
   std::vector<DisjunctionIndex> node_to_disjunction_;
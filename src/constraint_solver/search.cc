@@ -23,6 +23,7 @@
 #include "base/callback.h"
 #include "base/casts.h"
 #include "base/commandlineflags.h"
+#include "base/flat_hash_map.h"
 #include "base/integral_types.h"
 #include "base/logging.h"
 #include "base/macros.h"
@@ -3149,7 +3150,7 @@ int64 GuidedLocalSearchPenaltiesTable::Value(const Arc& arc) const {
   }
 }
 
-// Sparse GLS penalties implementation using a hash_map to store penalties.
+// Sparse GLS penalties implementation using a FlatHashMap to store penalties.
 
 class GuidedLocalSearchPenaltiesMap : public GuidedLocalSearchPenalties {
  public:
@@ -3162,11 +3163,7 @@ class GuidedLocalSearchPenaltiesMap : public GuidedLocalSearchPenalties {
 
  private:
   Bitmap penalized_;
-#if defined(_MSC_VER)
-  hash_map<Arc, int64, PairInt64Hasher> penalties_;
-#else
-  hash_map<Arc, int64> penalties_;
-#endif
+  FlatHashMap<Arc, int64> penalties_;
 };
 
 GuidedLocalSearchPenaltiesMap::GuidedLocalSearchPenaltiesMap(int size)
@@ -0,0 +1,1156 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "flatzinc/fast_parser.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "base/flat_hash_map.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/stringpiece.h"
+#include "base/stringprintf.h"
+#include "util/memory_mapped_file.h"
+
+namespace operations_research {
+namespace {
+// The identifiers are pieces of the input buffer.
+struct IdentifierHash {
+  size_t operator()(const StringPiece& identifier) const {
+    // FNV-1a.
+    uint64 hash = GG_ULONGLONG(14695981039346656037);
+    for (int i = 0; i < identifier.size(); ++i) {
+      hash = (hash ^ static_cast<uint8>(identifier[i])) *
+             GG_ULONGLONG(1099511628211);
+    }
+    return static_cast<size_t>(hash);
+  }
+};
+
+struct IdentifierEqual {
+  bool operator()(const StringPiece& a, const StringPiece& b) const {
+    return a.size() == b.size() && memcmp(a.data(), b.data(), a.size()) == 0;
+  }
+};
+
+bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+bool IsLetter(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+bool IsIdentifierChar(char c) { return IsLetter(c) || IsDigit(c) || c == '_'; }
+
+// Whether the given list of annotations contains the given identifier
+// (or function call).
+bool ContainsId(const std::vector<FzAnnotation>& annotations,
+                const std::string& id) {
+  for (const FzAnnotation& annotation : annotations) {
+    if ((annotation.type == FzAnnotation::IDENTIFIER ||
+         annotation.type == FzAnnotation::FUNCTION_CALL) &&
+        annotation.id == id) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool AreAllSingleton(const std::vector<FzDomain>& domains) {
+  for (const FzDomain& domain : domains) {
+    if (!domain.IsSingleton()) return false;
+  }
+  return true;
+}
+
+class FzFastParser {
+ public:
+  FzFastParser(const char* const data, int64 size, FzModel* const model)
+      : model_(model),
+        data_(data),
+        end_(data + size),
+        position_(data),
+        token_start_(data),
+        token_type_(END_OF_INPUT),
+        token_char_(0),
+        token_integer_(0) {}
+
+  // Parses the whole input and fills the model. Returns false and logs the
+  // error if the input is not a valid flatzinc model.
+  bool Parse();
+
+ private:
+  enum TokenType {
+    END_OF_INPUT,
+    INT_VALUE,  // Including true and false.
+    DOUBLE_VALUE,
+    STRING_VALUE,
+    IDENTIFIER,
+    DOTDOT,
+    COLONCOLON,
+    CHARACTER,  // Any other character, e.g. ';'.
+    // The keywords.
+    ARRAY,
+    BOOL,
+    CONSTRAINT,
+    FLOAT,
+    INT,
+    MAXIMIZE,
+    MINIMIZE,
+    OF,
+    PREDICATE,
+    SATISFY,
+    SET,
+    SOLVE,
+    VAR,
+  };
+
+  // What a declared identifier denotes. The value of a symbol is stored at
+  // the given index of the vector of its kind, e.g. integers_ for INTEGER.
+  enum SymbolKind {
+    UNDECLARED,
+    INTEGER,
+    INTEGER_ARRAY,
+    DOMAIN,
+    DOMAIN_ARRAY,
+    VARIABLE,
+    VARIABLE_ARRAY,
+  };
+  struct Symbol {
+    explicit Symbol(const StringPiece& identifier)
+        : name(identifier.as_string()), kind(UNDECLARED), index(-1) {}
+    // The identifier, built once for all its occurrences.
+    std::string name;
+    SymbolKind kind;
+    int index;
+  };
+
+  // ----- Lexer -----
+
+  // Reads the next token of the input.
+  void NextToken();
+  void ReadNumber();
+  void ReadIdentifierOrKeyword();
+  void ReadString();
+
+  bool IsCharacter(char c) const {
+    return token_type_ == CHARACTER && token_char_ == c;
+  }
+  // Logs the error with the line of the current token, and returns false.
+  bool Error(const std::string& message) const;
+  bool UnexpectedToken() const;
+  // Reads a token of the given type or character, and fails otherwise.
+  bool Expect(TokenType type);
+  bool ExpectCharacter(char c);
+  bool ExpectInteger(int64* const value);
+  bool ExpectIdentifier(int* const symbol);
+
+  // ----- Symbols -----
+
+  // Returns the index in symbols_ of the given identifier.
+  int Intern(const StringPiece& identifier);
+  // Declares the symbol with the given kind, and returns the index of its
+  // value in the vector of this kind, of the given size before the
+  // declaration.
+  int Declare(int symbol, SymbolKind kind, int size);
+  // Checks that the index is in the 1-based array of the given symbol, which
+  // is of the given size.
+  bool CheckIndex(int symbol, int64 index, int size) const;
+  bool UnknownSymbol(int symbol) const;
+
+  // ----- Grammar rules -----
+
+  bool SkipPredicate();
+  bool ParseDeclaration();
+  bool ParseVariableDeclaration();
+  bool ParseArrayDeclaration();
+  bool ParseConstraint();
+  bool ParseSolve();
+
+  // int_domain, set_domain or float_domain in parser.yy.
+  bool ParseDomain(FzDomain* const domain);
+  // One integer value, or the value of a named constant.
+  bool ParseInteger(int64* const value);
+  // A non-empty list of integers separated by commas, added to values.
+  bool ParseIntegers(std::vector<int64>* const values);
+  bool ParseConstLiteral(FzDomain* const domain);
+  // One integer value, or a reference to a variable (in which case *variable
+  // is set, and *value to 0).
+  bool ParseVariableOrValue(FzIntegerVariable** const variable,
+                            int64* const value);
+  // A possibly empty list of variables or values ending with ']', which is
+  // read.
+  bool ParseVariablesOrValues(std::vector<FzIntegerVariable*>* const variables,
+                              std::vector<int64>* const values);
+  bool ParseArgument(FzArgument* const argument);
+  // The annotations of a declaration: (:: annotation)*.
+  bool ParseAnnotations(std::vector<FzAnnotation>* const annotations);
+  bool ParseAnnotation(FzAnnotation* const annotation);
+  // A possibly empty list of annotations ending with the given character,
+  // which is read.
+  bool ParseAnnotationList(char end, std::vector<FzAnnotation>* const list);
+
+  FzModel* const model_;
+
+  // The input, and the current position in it.
+  const char* const data_;
+  const char* const end_;
+  const char* position_;
+
+  // The current token.
+  const char* token_start_;
+  TokenType token_type_;
+  StringPiece token_text_;
+  char token_char_;
+  int64 token_integer_;
+
+  // The interned identifiers. The symbols are in a deque, so that the
+  // references to them stay valid when new identifiers are interned.
+  FlatHashMap<StringPiece, int, IdentifierHash, IdentifierEqual>
+      symbol_indices_;
+  std::deque<Symbol> symbols_;
+
+  // The values of the symbols of each kind.
+  std::vector<int64> integers_;
+  std::vector<std::vector<int64> > integer_arrays_;
+  std::vector<FzDomain> domains_;
+  std::vector<std::vector<FzDomain> > domain_arrays_;
+  std::vector<FzIntegerVariable*> variables_;
+  std::vector<std::vector<FzIntegerVariable*> > variable_arrays_;
+
+  // The buffers reused from one declaration to the next.
+  std::vector<int64> integer_buffer_;
+  std::vector<FzIntegerVariable*> variable_buffer_;
+  std::vector<FzArgument> arguments_;
+  std::vector<FzAnnotation> annotations_;
+
+  DISALLOW_COPY_AND_ASSIGN(FzFastParser);
+};
+
+// ----- Lexer -----
+
+void FzFastParser::NextToken() {
+  // Skips the blanks and the comments.
+  for (;;) {
+    while (position_ < end_ && (*position_ == ' ' || *position_ == '\t' ||
+                                *position_ == '\n' || *position_ == '\r')) {
+      ++position_;
+    }
+    if (position_ == end_ || *position_ != '%') break;
+    while (position_ < end_ && *position_ != '\n') ++position_;
+  }
+  token_start_ = position_;
+  if (position_ == end_) {
+    token_type_ = END_OF_INPUT;
+    token_text_.clear();
+    return;
+  }
+  const char c = *position_;
+  const char next = position_ + 1 < end_ ? position_[1] : '\0';
+  if (IsDigit(c) || (c == '-' && IsDigit(next))) {
+    ReadNumber();
+  } else if (IsLetter(c) || (c == '_' && IsIdentifierChar(next))) {
+    ReadIdentifierOrKeyword();
+  } else if (c == '"') {
+    ReadString();
+  } else {
+    if (c == '.' && next == '.') {
+      token_type_ = DOTDOT;
+      position_ += 2;
+    } else if (c == ':' && next == ':') {
+      token_type_ = COLONCOLON;
+      position_ += 2;
+    } else {
+      token_type_ = CHARACTER;
+      token_char_ = c;
+      ++position_;
+    }
+    token_text_.set(token_start_, position_ - token_start_);
+  }
+}
+
+void FzFastParser::ReadNumber() {
+  const bool negative = *position_ == '-';
+  if (negative) ++position_;
+  int base = 10;
+  if (*position_ == '0' && position_ + 2 < end_ &&
+      (position_[1] == 'x' || position_[1] == 'o')) {
+    base = position_[1] == 'x' ? 16 : 8;
+    position_ += 2;
+  }
+  uint64 magnitude = 0;
+  bool overflow = false;
+  int num_digits = 0;
+  for (; position_ < end_; ++position_) {
+    const char c = *position_;
+    int digit = base;
+    if (IsDigit(c)) {
+      digit = c - '0';
+    } else if (base == 16 && c >= 'a' && c <= 'f') {
+      digit = c - 'a' + 10;
+    } else if (base == 16 && c >= 'A' && c <= 'F') {
+      digit = c - 'A' + 10;
+    }
+    if (digit >= base) break;
+    ++num_digits;
+    if (magnitude > (kuint64max - digit) / base) overflow = true;
+    magnitude = magnitude * base + digit;
+  }
+  if (base == 10) {
+    // The decimal part and the exponent of a double.
+    bool is_double = false;
+    if (position_ + 1 < end_ && position_[0] == '.' && IsDigit(position_[1])) {
+      is_double = true;
+      for (++position_; position_ < end_ && IsDigit(*position_); ++position_) {
+      }
+    }
+    if (position_ < end_ && (*position_ == 'e' || *position_ == 'E')) {
+      const char* exponent = position_ + 1;
+      if (exponent < end_ && (*exponent == '+' || *exponent == '-')) {
+        ++exponent;
+      }
+      if (exponent < end_ && IsDigit(*exponent)) {
+        is_double = true;
+        for (position_ = exponent; position_ < end_ && IsDigit(*position_);
+             ++position_) {
+        }
+      }
+    }
+    if (is_double) {
+      token_type_ = DOUBLE_VALUE;
+      token_text_.set(token_start_, position_ - token_start_);
+      return;
+    }
+  }
+  token_text_.set(token_start_, position_ - token_start_);
+  const uint64 limit =
+      negative ? static_cast<uint64>(kint64max) + 1 : kint64max;
+  if (num_digits == 0 || overflow || magnitude > limit) {
+    // Reported as a syntax error by the parser.
+    token_type_ = CHARACTER;
+    token_char_ = '0';
+    return;
+  }
+  token_type_ = INT_VALUE;
+  token_integer_ = negative ? static_cast<int64>(0 - magnitude)
+                            : static_cast<int64>(magnitude);
+}
+
+void FzFastParser::ReadIdentifierOrKeyword() {
+  while (position_ < end_ && *position_ == '_') ++position_;
+  if (position_ == end_ || !IsLetter(*position_)) {
+    // The identifiers starting with '_' must contain a letter.
+    token_type_ = CHARACTER;
+    token_char_ = '_';
+    position_ = token_start_ + 1;
+    token_text_.set(token_start_, 1);
+    return;
+  }
+  while (position_ < end_ && IsIdentifierChar(*position_)) ++position_;
+  token_text_.set(token_start_, position_ - token_start_);
+  token_type_ = IDENTIFIER;
+  // Most identifiers are not keywords: only compare the ones of the right
+  // size.
+  struct Keyword {
+    const char* text;
+    int size;
+    TokenType type;
+  };
+  static const Keyword kKeywords[] = {
+      {"of", 2, OF},           {"int", 3, INT},
+      {"set", 3, SET},         {"var", 3, VAR},
+      {"bool", 4, BOOL},       {"true", 4, INT_VALUE},
+      {"array", 5, ARRAY},     {"false", 5, INT_VALUE},
+      {"float", 5, FLOAT},     {"solve", 5, SOLVE},
+      {"satisfy", 7, SATISFY}, {"maximize", 8, MAXIMIZE},
+      {"minimize", 8, MINIMIZE}, {"predicate", 9, PREDICATE},
+      {"constraint", 10, CONSTRAINT},
+  };
+  const int size = token_text_.size();
+  if (size > 10) return;
+  for (const Keyword& keyword : kKeywords) {
+    if (keyword.size == size &&
+        memcmp(keyword.text, token_text_.data(), size) == 0) {
+      token_type_ = keyword.type;
+      token_integer_ = token_text_[0] == 't' ? 1 : 0;
+      return;
+    }
+  }
+}
+
+void FzFastParser::ReadString() {
+  // As in parser.lex, the value of a string includes its quotes, and a string
+  // cannot span several lines.
+  for (++position_; position_ < end_; ++position_) {
+    if (*position_ == '\n') break;
+    if (*position_ == '"') {
+      ++position_;
+      token_type_ = STRING_VALUE;
+      token_text_.set(token_start_, position_ - token_start_);
+      return;
+    }
+  }
+  position_ = token_start_ + 1;
+  token_type_ = CHARACTER;
+  token_char_ = '"';
+  token_text_.set(token_start_, 1);
+}
+
+bool FzFastParser::Error(const std::string& message) const {
+  int line = 1;
+  for (const char* c = data_; c < token_start_; ++c) {
+    if (*c == '\n') ++line;
+  }
+  LOG(ERROR) << "Error: " << message << " in line no. " << line;
+  return false;
+}
+
+bool FzFastParser::UnexpectedToken() const {
+  if (token_type_ == END_OF_INPUT) {
+    return Error("syntax error, unexpected end of file");
+  }
+  return Error("syntax error, unexpected '" + token_text_.as_string() + "'");
+}
+
+bool FzFastParser::Expect(TokenType type) {
+  if (token_type_ != type) return UnexpectedToken();
+  NextToken();
+  return true;
+}
+
+bool FzFastParser::ExpectCharacter(char c) {
+  if (!IsCharacter(c)) return UnexpectedToken();
+  NextToken();
+  return true;
+}
+
+bool FzFastParser::ExpectInteger(int64* const value) {
+  if (token_type_ != INT_VALUE) return UnexpectedToken();
+  *value = token_integer_;
+  NextToken();
+  return true;
+}
+
+bool FzFastParser::ExpectIdentifier(int* const symbol) {
+  if (token_type_ != IDENTIFIER) return UnexpectedToken();
+  *symbol = Intern(token_text_);
+  NextToken();
+  return true;
+}
+
+// ----- Symbols -----
+
+int FzFastParser::Intern(const StringPiece& identifier) {
+  const auto it = symbol_indices_.find(identifier);
+  if (it != symbol_indices_.end()) return it->second;
+  const int symbol = symbols_.size();
+  symbols_.push_back(Symbol(identifier));
+  symbol_indices_[identifier] = symbol;
+  return symbol;
+}
+
+int FzFastParser::Declare(int symbol, SymbolKind kind, int size) {
+  symbols_[symbol].kind = kind;
+  symbols_[symbol].index = size;
+  return size;
+}
+
+bool FzFastParser::CheckIndex(int symbol, int64 index, int size) const {
+  if (index < 1 || index > size) {
+    return Error(StringPrintf("index %" GG_LL_FORMAT "d out of the bounds of %s",
+                              index, symbols_[symbol].name.c_str()));
+  }
+  return true;
+}
+
+bool FzFastParser::UnknownSymbol(int symbol) const {
+  return Error("Unknown symbol " + symbols_[symbol].name);
+}
+
+// ----- Grammar rules -----
+
+bool FzFastParser::Parse() {
+  NextToken();
+  while (token_type_ == PREDICATE) {
+    if (!SkipPredicate()) return false;
+  }
+  while (token_type_ != CONSTRAINT && token_type_ != SOLVE &&
+         token_type_ != END_OF_INPUT) {
+    if (!ParseDeclaration() || !ExpectCharacter(';')) return false;
+  }
+  while (token_type_ == CONSTRAINT) {
+    if (!ParseConstraint() || !ExpectCharacter(';')) return false;
+  }
+  if (!ParseSolve() || !ExpectCharacter(';')) return false;
+  if (token_type_ != END_OF_INPUT) return UnexpectedToken();
+  return true;
+}
+
+bool FzFastParser::SkipPredicate() {
+  // The predicates are ignored, as in parser.yy.
+  int symbol = 0;
+  if (!Expect(PREDICATE) || !ExpectIdentifier(&symbol) ||
+      !ExpectCharacter('(')) {
+    return false;
+  }
+  int depth = 1;
+  while (depth > 0) {
+    if (token_type_ == END_OF_INPUT) return UnexpectedToken();
+    if (IsCharacter('(')) ++depth;
+    if (IsCharacter(')')) --depth;
+    NextToken();
+  }
+  return ExpectCharacter(';');
+}
+
+bool FzFastParser::ParseDeclaration() {
+  if (token_type_ == ARRAY) return ParseArrayDeclaration();
+  if (token_type_ == VAR) return ParseVariableDeclaration();
+  // Declaration of a (named) constant: we simply register it, and don't store
+  // it in the model.
+  FzDomain domain;
+  int symbol = 0;
+  FzDomain assignment;
+  if (!ParseDomain(&domain) || !ExpectCharacter(':') ||
+      !ExpectIdentifier(&symbol) || !ParseAnnotations(&annotations_) ||
+      !ExpectCharacter('=') || !ParseConstLiteral(&assignment)) {
+    return false;
+  }
+  if (!assignment.IsSingleton()) {
+    // TODO(user): Check that the assignment is included in the domain.
+    Declare(symbol, DOMAIN, domains_.size());
+    domains_.push_back(assignment);
+  } else {
+    const int64 value = assignment.values.front();
+    if (!domain.Contains(value)) {
+      return Error("The value of " + symbols_[symbol].name +
+                   " is not in its domain");
+    }
+    Declare(symbol, INTEGER, integers_.size());
+    integers_.push_back(value);
+  }
+  return true;
+}
+
+bool FzFastParser::ParseVariableDeclaration() {
+  // Declaration of a variable. If it's unassigned or assigned to a constant,
+  // we create a new variable stored in the model. If it's assigned to another
+  // variable x then we simply adjust x according to the current
+  // (re-)declaration.
+  FzDomain domain;
+  int symbol = 0;
+  if (!Expect(VAR) || !ParseDomain(&domain) || !ExpectCharacter(':') ||
+      !ExpectIdentifier(&symbol) || !ParseAnnotations(&annotations_)) {
+    return false;
+  }
+  const std::string& identifier = symbols_[symbol].name;
+  const bool introduced = ContainsId(annotations_, "var_is_introduced");
+  FzIntegerVariable* var = nullptr;
+  if (IsCharacter('=')) {
+    NextToken();
+    int64 value = 0;
+    if (!ParseVariableOrValue(&var, &value)) return false;
+    if (var == nullptr) {  // Just an integer constant.
+      if (!domain.Contains(value)) {
+        return Error("The value of " + identifier + " is not in its domain");
+      }
+      var = model_->AddVariable(identifier, FzDomain::Singleton(value),
+                                introduced);
+    } else {
+      var->Merge(identifier, domain, nullptr, introduced);
+    }
+  } else {
+    var = model_->AddVariable(identifier, domain, introduced);
+  }
+  Declare(symbol, VARIABLE, variables_.size());
+  variables_.push_back(var);
+  if (ContainsId(annotations_, "output_var")) {
+    model_->AddOutput(FzOnSolutionOutput::SingleVariable(identifier, var,
+                                                         domain.is_boolean));
+  }
+  return true;
+}
+
+bool FzFastParser::ParseArrayDeclaration() {
+  int64 first = 0;
+  int64 size = 0;
+  if (!Expect(ARRAY) || !ExpectCharacter('[') || !ExpectInteger(&first) ||
+      !Expect(DOTDOT) || !ExpectInteger(&size) || !ExpectCharacter(']') ||
+      !Expect(OF)) {
+    return false;
+  }
+  if (first != 1) return Error("Only [1..n] array are supported here");
+  if (size < 0) return Error("Invalid array size");
+  const bool is_variable_array = token_type_ == VAR;
+  const bool is_set_array = token_type_ == SET;
+  if (is_variable_array) NextToken();
+  FzDomain domain;
+  int symbol = 0;
+  if (!ParseDomain(&domain) || !ExpectCharacter(':') ||
+      !ExpectIdentifier(&symbol) || !ParseAnnotations(&annotations_)) {
+    return false;
+  }
+  const std::string& identifier = symbols_[symbol].name;
+
+  if (!is_variable_array) {
+    // Declaration of a (named) constant array.
+    if (!ExpectCharacter('=') || !ExpectCharacter('[')) return false;
+    if (is_set_array) {
+      std::vector<FzDomain> assignments;
+      while (!IsCharacter(']')) {
+        if (!assignments.empty() && !ExpectCharacter(',')) return false;
+        assignments.push_back(FzDomain());
+        if (!ParseConstLiteral(&assignments.back())) return false;
+      }
+      NextToken();
+      if (assignments.size() != static_cast<size_t>(size)) {
+        return Error("Wrong number of values for " + identifier);
+      }
+      if (!AreAllSingleton(assignments)) {
+        // TODO(user): check that all assignments are included in the domain.
+        Declare(symbol, DOMAIN_ARRAY, domain_arrays_.size());
+        domain_arrays_.push_back(std::vector<FzDomain>());
+        domain_arrays_.back().swap(assignments);
+        return true;
+      }
+      integer_buffer_.clear();
+      for (const FzDomain& assignment : assignments) {
+        integer_buffer_.push_back(assignment.values.front());
+        if (!domain.Contains(integer_buffer_.back())) {
+          return Error("A value of " + identifier + " is not in its domain");
+        }
+      }
+    } else {
+      integer_buffer_.clear();
+      if (!IsCharacter(']') && !ParseIntegers(&integer_buffer_)) return false;
+      if (!ExpectCharacter(']')) return false;
+      if (integer_buffer_.size() != static_cast<size_t>(size)) {
+        return Error("Wrong number of values for " + identifier);
+      }
+      // TODO(user): CHECK all values within domain.
+    }
+    Declare(symbol, INTEGER_ARRAY, integer_arrays_.size());
+    integer_arrays_.push_back(std::vector<int64>());
+    integer_arrays_.back().swap(integer_buffer_);
+    return true;
+  }
+
+  // Declaration of a "variable array": this is exactly like N simple variable
+  // declarations, where the identifier for declaration #i is IDENTIFIER[i]
+  // (1-based index).
+  const bool assigned = IsCharacter('=');
+  if (assigned) {
+    NextToken();
+    if (!ExpectCharacter('[') ||
+        !ParseVariablesOrValues(&variable_buffer_, &integer_buffer_)) {
+      return false;
+    }
+    if (variable_buffer_.size() != static_cast<size_t>(size)) {
+      return Error("Wrong number of variables for " + identifier);
+    }
+  }
+  const bool introduced = ContainsId(annotations_, "introduced");
+  std::vector<FzIntegerVariable*> vars(size, nullptr);
+  for (int i = 0; i < size; ++i) {
+    const std::string var_name =
+        StringPrintf("%s[%d]", identifier.c_str(), i + 1);
+    if (!assigned) {
+      vars[i] = model_->AddVariable(var_name, domain, introduced);
+    } else if (variable_buffer_[i] == nullptr) {
+      // Assigned to an integer constant.
+      const int64 value = integer_buffer_[i];
+      if (!domain.Contains(value)) {
+        return Error("The value of " + var_name + " is not in its domain");
+      }
+      vars[i] =
+          model_->AddVariable(var_name, FzDomain::Singleton(value), introduced);
+    } else {
+      vars[i] = variable_buffer_[i];
+      vars[i]->Merge(var_name, domain, nullptr, introduced);
+    }
+  }
+
+  // We parse the annotations to build an output object if needed.
+  for (const FzAnnotation& ann : annotations_) {
+    if (!ann.IsFunctionCallWithIdentifier("output_array")) continue;
+    if (ann.annotations.size() != 1 ||
+        ann.annotations.back().type != FzAnnotation::ANNOTATION_LIST) {
+      return Error("Invalid output_array annotation of " + identifier);
+    }
+    std::vector<FzOnSolutionOutput::Bounds> bounds;
+    for (const FzAnnotation& bound : ann.annotations.back().annotations) {
+      if (bound.type != FzAnnotation::INTERVAL) {
+        return Error("Invalid output_array annotation of " + identifier);
+      }
+      bounds.push_back(
+          FzOnSolutionOutput::Bounds(bound.interval_min, bound.interval_max));
+    }
+    model_->AddOutput(FzOnSolutionOutput::MultiDimensionalArray(
+        identifier, bounds, vars, domain.is_boolean));
+  }
+
+  // Registers the variable array.
+  Declare(symbol, VARIABLE_ARRAY, variable_arrays_.size());
+  variable_arrays_.push_back(std::vector<FzIntegerVariable*>());
+  variable_arrays_.back().swap(vars);
+  return true;
+}
+
+bool FzFastParser::ParseConstraint() {
+  int symbol = 0;
+  if (!Expect(CONSTRAINT) || !ExpectIdentifier(&symbol) ||
+      !ExpectCharacter('(')) {
+    return false;
+  }
+  arguments_.clear();
+  do {
+    if (!arguments_.empty()) NextToken();
+    arguments_.push_back(FzArgument());
+    if (!ParseArgument(&arguments_.back())) return false;
+  } while (IsCharacter(','));
+  if (!ExpectCharacter(')') || !ParseAnnotations(&annotations_)) return false;
+
+  // Does the constraint have a defines_var annotation?
+  FzIntegerVariable* defines_var = nullptr;
+  for (const FzAnnotation& ann : annotations_) {
+    if (ann.IsFunctionCallWithIdentifier("defines_var")) {
+      if (ann.annotations.size() != 1 ||
+          ann.annotations.back().type != FzAnnotation::INT_VAR_REF) {
+        return Error("Invalid defines_var annotation");
+      }
+      defines_var = ann.annotations.back().variables[0];
+      break;
+    }
+  }
+  // The arguments are moved to the model.
+  model_->AddConstraint(symbols_[symbol].name, &arguments_,
+                        ContainsId(annotations_, "domain"), defines_var);
+  return true;
+}
+
+bool FzFastParser::ParseSolve() {
+  if (!Expect(SOLVE) || !ParseAnnotations(&annotations_)) return false;
+  if (token_type_ == SATISFY) {
+    NextToken();
+    model_->Satisfy(&annotations_);
+    return true;
+  }
+  const bool maximize = token_type_ == MAXIMIZE;
+  if (!maximize && token_type_ != MINIMIZE) return UnexpectedToken();
+  NextToken();
+  FzArgument objective;
+  if (!ParseArgument(&objective)) return false;
+  if (objective.type != FzArgument::INT_VAR_REF) {
+    return Error("The objective must be a variable");
+  }
+  if (maximize) {
+    model_->Maximize(objective.Var(), &annotations_);
+  } else {
+    model_->Minimize(objective.Var(), &annotations_);
+  }
+  return true;
+}
+
+bool FzFastParser::ParseDomain(FzDomain* const domain) {
+  const bool is_set = token_type_ == SET;
+  if (is_set && (!Expect(SET) || !Expect(OF))) return false;
+  switch (token_type_) {
+    case BOOL:
+      NextToken();
+      *domain = FzDomain::Boolean();
+      return true;
+    case INT:
+      NextToken();
+      *domain = FzDomain::AllInt64();
+      return true;
+    case INT_VALUE: {
+      int64 min_value = 0;
+      int64 max_value = 0;
+      if (!ExpectInteger(&min_value) || !Expect(DOTDOT) ||
+          !ExpectInteger(&max_value)) {
+        return false;
+      }
+      *domain = FzDomain::Interval(min_value, max_value);
+      return true;
+    }
+    case FLOAT:
+    case DOUBLE_VALUE:
+      // TODO(user): implement floats.
+      if (is_set) break;
+      if (token_type_ == DOUBLE_VALUE) {
+        NextToken();
+        if (!Expect(DOTDOT) || !Expect(DOUBLE_VALUE)) return false;
+      } else {
+        NextToken();
+      }
+      *domain = FzDomain::AllInt64();
+      return true;
+    default:
+      if (!IsCharacter('{')) break;
+      NextToken();
+      integer_buffer_.clear();
+      if (!ParseIntegers(&integer_buffer_) || !ExpectCharacter('}')) {
+        return false;
+      }
+      *domain = FzDomain::IntegerList(integer_buffer_);
+      return true;
+  }
+  return UnexpectedToken();
+}
+
+bool FzFastParser::ParseInteger(int64* const value) {
+  if (token_type_ == INT_VALUE) {
+    *value = token_integer_;
+    NextToken();
+    return true;
+  }
+  int symbol = 0;
+  if (!ExpectIdentifier(&symbol)) return false;
+  const Symbol& s = symbols_[symbol];
+  if (IsCharacter('[')) {
+    int64 index = 0;
+    if (!ExpectCharacter('[') || !ExpectInteger(&index) ||
+        !ExpectCharacter(']')) {
+      return false;
+    }
+    if (s.kind != INTEGER_ARRAY) return UnknownSymbol(symbol);
+    const std::vector<int64>& array = integer_arrays_[s.index];
+    if (!CheckIndex(symbol, index, array.size())) return false;
+    *value = array[index - 1];
+    return true;
+  }
+  if (s.kind != INTEGER) return UnknownSymbol(symbol);
+  *value = integers_[s.index];
+  return true;
+}
+
+bool FzFastParser::ParseIntegers(std::vector<int64>* const values) {
+  int64 value = 0;
+  if (!ParseInteger(&value)) return false;
+  values->push_back(value);
+  while (IsCharacter(',')) {
+    NextToken();
+    if (!ParseInteger(&value)) return false;
+    values->push_back(value);
+  }
+  return true;
+}
+
+bool FzFastParser::ParseConstLiteral(FzDomain* const domain) {
+  if (token_type_ == INT_VALUE) {
+    const int64 value = token_integer_;
+    NextToken();
+    if (token_type_ != DOTDOT) {
+      *domain = FzDomain::Singleton(value);
+      return true;
+    }
+    NextToken();
+    int64 max_value = 0;
+    if (!ExpectInteger(&max_value)) return false;
+    *domain = FzDomain::Interval(value, max_value);
+    return true;
+  }
+  if (token_type_ == DOUBLE_VALUE) {
+    // TODO(user): implement floats.
+    NextToken();
+    *domain = FzDomain::AllInt64();
+    return true;
+  }
+  if (IsCharacter('{')) {
+    NextToken();
+    integer_buffer_.clear();
+    if (!IsCharacter('}') && !ParseIntegers(&integer_buffer_)) return false;
+    if (!ExpectCharacter('}')) return false;
+    *domain = FzDomain::IntegerList(integer_buffer_);
+    return true;
+  }
+  int64 value = 0;
+  if (!ParseInteger(&value)) return false;
+  *domain = FzDomain::Singleton(value);
+  return true;
+}
+
+bool FzFastParser::ParseVariableOrValue(FzIntegerVariable** const variable,
+                                        int64* const value) {
+  *variable = nullptr;
+  *value = 0;
+  if (token_type_ == INT_VALUE) {
+    *value = token_integer_;
+    NextToken();
+    return true;
+  }
+  int symbol = 0;
+  if (!ExpectIdentifier(&symbol)) return false;
+  const Symbol& s = symbols_[symbol];
+  if (IsCharacter('[')) {
+    // A given element of an existing constant array or variable array.
+    int64 index = 0;
+    if (!ExpectCharacter('[') || !ExpectInteger(&index) ||
+        !ExpectCharacter(']')) {
+      return false;
+    }
+    if (s.kind == INTEGER_ARRAY) {
+      const std::vector<int64>& array = integer_arrays_[s.index];
+      if (!CheckIndex(symbol, index, array.size())) return false;
+      *value = array[index - 1];
+      return true;
+    }
+    if (s.kind == VARIABLE_ARRAY) {
+      const std::vector<FzIntegerVariable*>& array = variable_arrays_[s.index];
+      if (!CheckIndex(symbol, index, array.size())) return false;
+      *variable = array[index - 1];
+      return true;
+    }
+    return UnknownSymbol(symbol);
+  }
+  // A reference to an existing integer constant or variable.
+  if (s.kind == INTEGER) {
+    *value = integers_[s.index];
+    return true;
+  }
+  if (s.kind == VARIABLE) {
+    *variable = variables_[s.index];
+    return true;
+  }
+  return UnknownSymbol(symbol);
+}
+
+bool FzFastParser::ParseVariablesOrValues(
+    std::vector<FzIntegerVariable*>* const variables,
+    std::vector<int64>* const values) {
+  variables->clear();
+  values->clear();
+  while (!IsCharacter(']')) {
+    if (!variables->empty() && !ExpectCharacter(',')) return false;
+    FzIntegerVariable* variable = nullptr;
+    int64 value = 0;
+    if (!ParseVariableOrValue(&variable, &value)) return false;
+    variables->push_back(variable);
+    values->push_back(value);
+  }
+  NextToken();
+  return true;
+}
+
+bool FzFastParser::ParseArgument(FzArgument* const argument) {
+  switch (token_type_) {
+    case INT_VALUE: {
+      const int64 value = token_integer_;
+      NextToken();
+      if (token_type_ != DOTDOT) {
+        *argument = FzArgument::IntegerValue(value);
+        return true;
+      }
+      NextToken();
+      int64 max_value = 0;
+      if (!ExpectInteger(&max_value)) return false;
+      *argument = FzArgument::Interval(value, max_value);
+      return true;
+    }
+    case DOUBLE_VALUE:
+    case STRING_VALUE:
+      NextToken();
+      *argument = FzArgument::VoidArgument();
+      return true;
+    case IDENTIFIER: {
+      int symbol = 0;
+      if (!ExpectIdentifier(&symbol)) return false;
+      const Symbol& s = symbols_[symbol];
+      if (IsCharacter('[')) {
+        int64 index = 0;
+        if (!ExpectCharacter('[') || !ExpectInteger(&index) ||
+            !ExpectCharacter(']')) {
+          return false;
+        }
+        if (s.kind == INTEGER_ARRAY) {
+          const std::vector<int64>& array = integer_arrays_[s.index];
+          if (!CheckIndex(symbol, index, array.size())) return false;
+          *argument = FzArgument::IntegerValue(array[index - 1]);
+        } else if (s.kind == VARIABLE_ARRAY) {
+          const std::vector<FzIntegerVariable*>& array =
+              variable_arrays_[s.index];
+          if (!CheckIndex(symbol, index, array.size())) return false;
+          *argument = FzArgument::IntVarRef(array[index - 1]);
+        } else if (s.kind == DOMAIN_ARRAY) {
+          const std::vector<FzDomain>& array = domain_arrays_[s.index];
+          if (!CheckIndex(symbol, index, array.size())) return false;
+          *argument = FzArgument::FromDomain(array[index - 1]);
+        } else {
+          return UnknownSymbol(symbol);
+        }
+        return true;
+      }
+      switch (s.kind) {
+        case INTEGER:
+          *argument = FzArgument::IntegerValue(integers_[s.index]);
+          return true;
+        case INTEGER_ARRAY:
+          *argument = FzArgument::IntegerList(integer_arrays_[s.index]);
+          return true;
+        case VARIABLE:
+          *argument = FzArgument::IntVarRef(variables_[s.index]);
+          return true;
+        case VARIABLE_ARRAY:
+          *argument = FzArgument::IntVarRefArray(variable_arrays_[s.index]);
+          return true;
+        case DOMAIN:
+          *argument = FzArgument::FromDomain(domains_[s.index]);
+          return true;
+        default:
+          return UnknownSymbol(symbol);
+      }
+    }
+    default:
+      break;
+  }
+  if (IsCharacter('{')) {
+    NextToken();
+    integer_buffer_.clear();
+    if (!IsCharacter('}') && !ParseIntegers(&integer_buffer_)) return false;
+    if (!ExpectCharacter('}')) return false;
+    *argument = FzArgument::IntegerList(&integer_buffer_);
+    return true;
+  }
+  if (!ExpectCharacter('[') ||
+      !ParseVariablesOrValues(&variable_buffer_, &integer_buffer_)) {
+    return false;
+  }
+  bool has_variables = false;
+  for (const FzIntegerVariable* const var : variable_buffer_) {
+    if (var != nullptr) {
+      has_variables = true;
+      break;
+    }
+  }
+  if (!has_variables) {
+    *argument = FzArgument::IntegerList(&integer_buffer_);
+    return true;
+  }
+  for (int i = 0; i < variable_buffer_.size(); ++i) {
+    if (variable_buffer_[i] == nullptr) {
+      variable_buffer_[i] = FzIntegerVariable::Constant(integer_buffer_[i]);
+    }
+  }
+  argument->type = FzArgument::INT_VAR_REF_ARRAY;
+  argument->values.clear();
+  argument->variables.clear();
+  argument->variables.swap(variable_buffer_);
+  return true;
+}
+
+bool FzFastParser::ParseAnnotations(
+    std::vector<FzAnnotation>* const annotations) {
+  annotations->clear();
+  while (token_type_ == COLONCOLON) {
+    NextToken();
+    annotations->push_back(FzAnnotation());
+    if (!ParseAnnotation(&annotations->back())) return false;
+  }
+  return true;
+}
+
+bool FzFastParser::ParseAnnotation(FzAnnotation* const annotation) {
+  switch (token_type_) {
+    case INT_VALUE: {
+      const int64 value = token_integer_;
+      NextToken();
+      if (token_type_ != DOTDOT) {
+        *annotation = FzAnnotation::IntegerValue(value);
+        return true;
+      }
+      NextToken();
+      int64 max_value = 0;
+      if (!ExpectInteger(&max_value)) return false;
+      *annotation = FzAnnotation::Interval(value, max_value);
+      return true;
+    }
+    case STRING_VALUE:
+      *annotation = FzAnnotation::String(token_text_.as_string());
+      NextToken();
+      return true;
+    case IDENTIFIER: {
+      int symbol = 0;
+      if (!ExpectIdentifier(&symbol)) return false;
+      const Symbol& s = symbols_[symbol];
+      if (IsCharacter('(')) {
+        NextToken();
+        std::vector<FzAnnotation> arguments;
+        if (!ParseAnnotationList(')', &arguments)) return false;
+        *annotation = FzAnnotation::FunctionCall(s.name, &arguments);
+        return true;
+      }
+      if (IsCharacter('[')) {
+        int64 index = 0;
+        if (!ExpectCharacter('[') || !ExpectInteger(&index) ||
+            !ExpectCharacter(']')) {
+          return false;
+        }
+        if (s.kind != VARIABLE_ARRAY) return UnknownSymbol(symbol);
+        const std::vector<FzIntegerVariable*>& array =
+            variable_arrays_[s.index];
+        if (!CheckIndex(symbol, index, array.size())) return false;
+        *annotation = FzAnnotation::Variable(array[index - 1]);
+        return true;
+      }
+      if (s.kind == VARIABLE) {
+        *annotation = FzAnnotation::Variable(variables_[s.index]);
+      } else if (s.kind == VARIABLE_ARRAY) {
+        *annotation = FzAnnotation::VariableList(variable_arrays_[s.index]);
+      } else {
+        *annotation = FzAnnotation::Identifier(s.name);
+      }
+      return true;
+    }
+    default:
+      break;
+  }
+  if (!ExpectCharacter('[')) return false;
+  std::vector<FzAnnotation> list;
+  if (!ParseAnnotationList(']', &list)) return false;
+  *annotation = FzAnnotation::AnnotationList(&list);
+  return true;
+}
+
+bool FzFastParser::ParseAnnotationList(char end,
+                                       std::vector<FzAnnotation>* const list) {
+  while (!IsCharacter(end)) {
+    if (!list->empty() && !ExpectCharacter(',')) return false;
+    list->push_back(FzAnnotation());
+    if (!ParseAnnotation(&list->back())) return false;
+  }
+  NextToken();
+  return true;
+}
+}  // namespace
+
+// ----- public parsing API -----
+
+bool FastParseFlatzincFile(const std::string& filename, FzModel* const model) {
+  MemoryMappedFile file;
+  const util::Status status = file.Open(filename);
+  if (!status.ok()) {
+    LOG(INFO) << status.ToString();
+    return false;
+  }
+  return FastParseFlatzincBuffer(file.data(), file.size(), model);
+}
+
+bool FastParseFlatzincString(const std::string& input, FzModel* const model) {
+  return FastParseFlatzincBuffer(input.data(), input.size(), model);
+}
+
+bool FastParseFlatzincBuffer(const char* const data, int64 size,
+                             FzModel* const model) {
+  FzFastParser parser(data, size, model);
+  return parser.Parse();
+}
+}  // namespace operations_research
@@ -0,0 +1,48 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A hand-written recursive descent parser of the flatzinc format, which builds
+// the same FzModel as the flex/bison parser of parser.h, several times faster
+// on large files.
+//
+// The input file is mapped in memory and never copied: the tokens and the
+// identifiers are pieces of the mapped buffer. The identifiers are interned
+// in a single hash table, which maps each of them to the named constant,
+// array, domain or variable it denotes. The lists of integers, arguments and
+// annotations are built in buffers reused from one declaration to the next,
+// and then moved to the model, so that the only allocations are the ones of
+// the objects kept by the model.
+//
+// On valid files, the two parsers build the same model, except for the
+// hexadecimal and octal integers (e.g. 0x1F, 0o17), which the bison parser
+// reads as 0. The parsing stops at the first error, which is logged with its
+// line number.
+//
+// See flatzinc/parser_benchmark.cc for a comparison of the two parsers.
+
+#ifndef OR_TOOLS_FLATZINC_FAST_PARSER_H_
+#define OR_TOOLS_FLATZINC_FAST_PARSER_H_
+
+#include <string>
+
+#include "base/integral_types.h"
+#include "flatzinc/model.h"
+
+namespace operations_research {
+bool FastParseFlatzincFile(const std::string& filename, FzModel* const model);
+bool FastParseFlatzincString(const std::string& input, FzModel* const model);
+// The buffer must stay valid during the call only.
+bool FastParseFlatzincBuffer(const char* const data, int64 size,
+                             FzModel* const model);
+}       // namespace operations_research
+#endif  // OR_TOOLS_FLATZINC_FAST_PARSER_H_
@@ -28,9 +28,11 @@
 #include "base/logging.h"
 #include "base/threadpool.h"
 #include "base/timer.h"
+#include "flatzinc/fast_parser.h"
 #include "flatzinc/model.h"
 #include "flatzinc/parser.h"
 #include "flatzinc/presolve.h"
+#include "flatzinc/sat_backend.h"
 #include "flatzinc/search.h"
 #include "flatzinc/solver.h"
 
@@ -44,9 +46,18 @@ DEFINE_bool(use_impact, false, "Use impact based search");
 DEFINE_double(restart_log_size, -1, "Restart log size for impact search");
 DEFINE_int32(luby_restart, -1, "Luby restart factor, <= 0 = no luby");
 DEFINE_int32(heuristic_period, 100, "Period to call heuristics in free search");
+DEFINE_int32(lns_fragment_size, 10,
+             "Number of variables relaxed by each neighbor of the LNS workers");
 DEFINE_bool(verbose_impact, false, "Verbose impact");
 DEFINE_bool(verbose_mt, false, "Verbose Multi-Thread");
 DEFINE_bool(presolve, true, "Use presolve.");
+DEFINE_int32(presolve_time_limit, 0, "Presolve time limit in ms, 0 = none.");
+DEFINE_bool(fast_parser, true,
+            "Use the hand-written parser instead of the bison one.");
+DEFINE_bool(lcg, false,
+            "Solve the model with the lazy clause generation backend when it "
+            "supports all its constraints. In parallel mode, only the last "
+            "worker uses it.");
 
 DECLARE_bool(fz_logging);
 DECLARE_bool(log_prefix);
@@ -58,6 +69,15 @@ extern void interrupt_handler(int s);
 namespace operations_research {
 void Solve(const FzModel* const model, const FzSolverParameters& parameters,
            FzParallelSupportInterface* parallel_support) {
+  if (FLAGS_lcg && (parameters.worker_id == -1 ||
+                    parameters.worker_id == parameters.threads - 1)) {
+    FzSatBackend backend(*model);
+    if (backend.Extract()) {
+      backend.Solve(parameters, parallel_support);
+      return;
+    }
+    FZLOG << "  - falling back to the cp solver" << FZENDL;
+  }
   FzSolver solver(*model);
   CHECK(solver.Extract());
   solver.Solve(parameters, parallel_support);
@@ -145,6 +165,17 @@ void ParallelRun(const FzModel* const model, int worker_id,
               : operations_research::FzSolverParameters::RANDOM_MAX;
       parameters.restart_log_size = -1.0;
       parameters.luby_restart = 250;
+      // On optimization problems, one in three of the remaining workers
+      // runs a large neighborhood search around the solutions of the
+      // defined search, with fragments of growing size.
+      if (model->objective() != nullptr && worker_id % 3 == 2) {
+        parameters.free_search = false;
+        parameters.search_type =
+            operations_research::FzSolverParameters::DEFAULT;
+        parameters.luby_restart = -1;
+        parameters.lns_fragment_size =
+            FLAGS_lns_fragment_size * (worker_id / 3);
+      }
     }
   }
   Solve(model, parameters, parallel_support);
@@ -199,7 +230,8 @@ void ParseAndRun(const std::string& filename, int num_workers) {
     problem_name = problem_name.substr(found + 1);
   }
   FzModel model(problem_name);
-  CHECK(ParseFlatzincFile(filename, &model));
+  CHECK(FLAGS_fast_parser ? FastParseFlatzincFile(filename, &model)
+                          : ParseFlatzincFile(filename, &model));
   FZLOG << "File " << filename << " parsed in " << timer.GetInMs() << " ms"
         << FZENDL;
   FzPresolver presolve;
@@ -208,6 +240,9 @@ void ParseAndRun(const std::string& filename, int num_workers) {
     FZLOG << "Presolve model" << FZENDL;
     timer.Reset();
     timer.Start();
+    if (FLAGS_presolve_time_limit > 0) {
+      presolve.set_time_limit_in_seconds(FLAGS_presolve_time_limit / 1000.0);
+    }
     presolve.Run(&model);
     FZLOG << "  - done in " << timer.GetInMs() << " ms" << FZENDL;
   }
@@ -0,0 +1,474 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This binary benchmarks the flatzinc interpreter: it runs the fz binary
+// on a list of .fzn instances, sequentially and with several workers, and
+// collects for each run the parse, presolve, extraction and search times,
+// the time to the best solution, the number of branches (nodes) and
+// failures, and the final status and objective.
+//
+// The results are printed, and written in JSON with --output. When a
+// --baseline written by a previous run is given, the two runs are compared,
+// and the binary fails on regressions: wrong answers (a different proven
+// objective, or sat against unsat), runs that no longer complete, and runs
+// slower than --slowdown_threshold times the baseline.
+//
+// The statistics are read from the output of fz with --fz_logging, so that
+// the benchmark measures the binary exactly as it is used.
+//
+// Example:
+//   bin/fz_benchmark --output=/tmp/new.json --baseline=/tmp/old.json
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/file.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/numbers.h"
+#include "base/split.h"
+#include "base/stringprintf.h"
+#include "base/strutil.h"
+#include "base/timer.h"
+
+#if defined(_MSC_VER)
+#define popen _popen
+#define pclose _pclose
+#endif
+
+DEFINE_string(fz_binary, "bin/fz", "Path of the fz binary to benchmark.");
+DEFINE_string(instances, "examples/flatzinc/benchmark_instances.txt",
+              "File listing the .fzn instances, one per line. Relative paths "
+              "are relative to the directory of the file. Empty lines and "
+              "lines starting with '#' are ignored.");
+DEFINE_string(workers, "0,4",
+              "Comma separated numbers of workers of the runs, 0 means a "
+              "sequential run.");
+DEFINE_int32(time_limit, 10000, "Time limit of each run in ms.");
+DEFINE_string(fz_flags, "", "Additional flags passed to fz, e.g. --lcg.");
+DEFINE_string(output, "", "If not empty, the JSON file of the results.");
+DEFINE_string(baseline, "",
+              "If not empty, a JSON file written by a previous run of the "
+              "benchmark to compare the results with.");
+DEFINE_double(slowdown_threshold, 1.25,
+              "A run is reported as a regression when its total time is more "
+              "than this times the one of the baseline.");
+DEFINE_int32(min_compared_time, 100,
+             "Runs that take less than this many ms in the baseline are not "
+             "compared on time, as they are dominated by noise.");
+
+namespace operations_research {
+// The results of one run of fz on one instance.
+struct FzRun {
+  FzRun()
+      : workers(0),
+        has_objective(false),
+        objective(0),
+        parse_time_in_ms(-1),
+        presolve_time_in_ms(-1),
+        extraction_time_in_ms(-1),
+        search_time_in_ms(-1),
+        time_to_best_in_ms(-1),
+        nodes(-1),
+        failures(-1),
+        wall_time_in_ms(0) {}
+
+  // Runs that ended with a proof, of optimality or unfeasibility, or
+  // found a solution of a satisfaction problem.
+  bool Completed() const {
+    return status == "proven" || status == "sat" || status == "unsat";
+  }
+  bool HasSolution() const {
+    return status == "proven" || status == "sat" || status == "feasible";
+  }
+
+  std::string instance;
+  int workers;
+  // One of "sat", "unsat", "proven", "feasible", "timeout", or "error" if
+  // fz failed or its output could not be read.
+  std::string status;
+  bool has_objective;
+  int64 objective;
+  // The statistics are -1 when fz did not report them.
+  int64 parse_time_in_ms;
+  int64 presolve_time_in_ms;
+  int64 extraction_time_in_ms;
+  int64 search_time_in_ms;
+  int64 time_to_best_in_ms;
+  int64 nodes;
+  int64 failures;
+  int64 wall_time_in_ms;
+};
+
+// ----- Reading the output of fz -----
+
+// If 'key' appears in 'line', parses the integer that follows it.
+bool ParseValueAfter(const std::string& line, const std::string& key,
+                     int64* value) {
+  const size_t pos = line.find(key);
+  if (pos == std::string::npos) return false;
+  char* end = nullptr;
+  const char* const start = line.c_str() + pos + key.size();
+  const int64 parsed = strtoll(start, &end, 10);
+  if (end == start) return false;
+  *value = parsed;
+  return true;
+}
+
+// Parses the status and the objective of the csv line of the final output,
+// e.g. "%%  csv: name, **proven**, 12, 5, 76 ms, ...".
+void ParseCsvLine(const std::string& line, FzRun* run) {
+  const std::vector<std::string> fields =
+      strings::Split(line, ",", strings::SkipEmpty());
+  if (fields.size() < 3) return;
+  std::string status = fields[1];
+  status.erase(std::remove(status.begin(), status.end(), ' '), status.end());
+  status.erase(std::remove(status.begin(), status.end(), '*'), status.end());
+  run->status = status;
+  int64 objective = 0;
+  std::string objective_string = fields[2];
+  objective_string.erase(std::remove(objective_string.begin(),
+                                     objective_string.end(), ' '),
+                         objective_string.end());
+  if (!objective_string.empty() &&
+      safe_strto64(objective_string, &objective)) {
+    run->has_objective = true;
+    run->objective = objective;
+  }
+}
+
+void ParseFzOutputLine(const std::string& line, bool* in_presolve,
+                       FzRun* run) {
+  if (!HasPrefixString(line, "%%")) return;
+  if (line.find(" parsed in ") != std::string::npos) {
+    ParseValueAfter(line, " parsed in ", &run->parse_time_in_ms);
+  } else if (line == "%% Presolve model") {
+    *in_presolve = true;
+  } else if (*in_presolve && HasPrefixString(line, "%%   - done in ")) {
+    ParseValueAfter(line, "done in ", &run->presolve_time_in_ms);
+    *in_presolve = false;
+  } else if (HasPrefixString(line, "%%  build time:")) {
+    ParseValueAfter(line, "build time:", &run->extraction_time_in_ms);
+  } else if (HasPrefixString(line, "%%  solve time:")) {
+    ParseValueAfter(line, "solve time:", &run->search_time_in_ms);
+  } else if (HasPrefixString(line, "%%  time to best:")) {
+    ParseValueAfter(line, "time to best:", &run->time_to_best_in_ms);
+  } else if (HasPrefixString(line, "%%  branches:")) {
+    ParseValueAfter(line, "branches:", &run->nodes);
+  } else if (HasPrefixString(line, "%%  failures:")) {
+    ParseValueAfter(line, "failures:", &run->failures);
+  } else if (HasPrefixString(line, "%%  csv:")) {
+    ParseCsvLine(line, run);
+  }
+}
+
+// Runs fz on one instance, and reads the statistics from its output.
+void RunFz(const std::string& path, int workers, FzRun* run) {
+  run->status = "error";
+  const std::string command = StringPrintf(
+      "%s --fz_logging --time_limit=%d --workers=%d %s %s 2>&1",
+      FLAGS_fz_binary.c_str(), FLAGS_time_limit, workers,
+      FLAGS_fz_flags.c_str(), path.c_str());
+  WallTimer timer;
+  timer.Start();
+  FILE* const pipe = popen(command.c_str(), "r");
+  if (pipe == nullptr) {
+    LOG(ERROR) << "Cannot run " << command;
+    return;
+  }
+  bool in_presolve = false;
+  std::string line;
+  char buffer[4096];
+  while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+    line.append(buffer);
+    if (line.empty() || line[line.size() - 1] != '\n') continue;
+    line.resize(line.size() - 1);
+    ParseFzOutputLine(line, &in_presolve, run);
+    line.clear();
+  }
+  if (!line.empty()) ParseFzOutputLine(line, &in_presolve, run);
+  const int exit_code = pclose(pipe);
+  run->wall_time_in_ms = timer.GetInMs();
+  if (exit_code != 0) {
+    LOG(ERROR) << command << " failed with exit code " << exit_code;
+    run->status = "error";
+  }
+}
+
+// ----- JSON -----
+
+std::string JsonString(const std::string& value) {
+  std::string out = "\"";
+  for (const char c : value) {
+    if (c == '"' || c == '\\') out.push_back('\\');
+    out.push_back(c);
+  }
+  out.push_back('"');
+  return out;
+}
+
+// Writes one run per line, so that ReadRuns() does not need a full JSON
+// parser.
+std::string RunsToJson(const std::vector<FzRun>& runs) {
+  std::string out = "{\n";
+  StringAppendF(&out, "  \"fz_binary\": %s,\n",
+                JsonString(FLAGS_fz_binary).c_str());
+  StringAppendF(&out, "  \"fz_flags\": %s,\n",
+                JsonString(FLAGS_fz_flags).c_str());
+  StringAppendF(&out, "  \"time_limit_ms\": %d,\n", FLAGS_time_limit);
+  out.append("  \"runs\": [\n");
+  for (int i = 0; i < runs.size(); ++i) {
+    const FzRun& run = runs[i];
+    const std::string objective =
+        run.has_objective
+            ? StringPrintf("%" GG_LL_FORMAT "d", run.objective)
+            : "null";
+    StringAppendF(
+        &out,
+        "    {\"instance\": %s, \"workers\": %d, \"status\": %s, "
+        "\"objective\": %s, \"parse_ms\": %" GG_LL_FORMAT
+        "d, \"presolve_ms\": %" GG_LL_FORMAT "d, \"extraction_ms\": %" GG_LL_FORMAT
+        "d, \"search_ms\": %" GG_LL_FORMAT "d, \"time_to_best_ms\": %" GG_LL_FORMAT
+        "d, \"nodes\": %" GG_LL_FORMAT "d, \"failures\": %" GG_LL_FORMAT
+        "d, \"wall_ms\": %" GG_LL_FORMAT "d}%s\n",
+        JsonString(run.instance).c_str(), run.workers,
+        JsonString(run.status).c_str(), objective.c_str(),
+        run.parse_time_in_ms, run.presolve_time_in_ms,
+        run.extraction_time_in_ms, run.search_time_in_ms,
+        run.time_to_best_in_ms, run.nodes, run.failures, run.wall_time_in_ms,
+        i + 1 < runs.size() ? "," : "");
+  }
+  out.append("  ]\n}\n");
+  return out;
+}
+
+// Returns the raw value of '"key": value' in 'line', without the quotes of
+// the strings.
+bool JsonField(const std::string& line, const std::string& key,
+               std::string* value) {
+  const std::string pattern = "\"" + key + "\": ";
+  size_t pos = line.find(pattern);
+  if (pos == std::string::npos) return false;
+  pos += pattern.size();
+  if (pos < line.size() && line[pos] == '"') {
+    value->clear();
+    for (++pos; pos < line.size() && line[pos] != '"'; ++pos) {
+      if (line[pos] == '\\') ++pos;
+      if (pos < line.size()) value->push_back(line[pos]);
+    }
+    return true;
+  }
+  const size_t end = line.find_first_of(",}", pos);
+  *value = line.substr(pos, end == std::string::npos ? end : end - pos);
+  return true;
+}
+
+int64 JsonInt64Field(const std::string& line, const std::string& key) {
+  std::string value;
+  int64 result = -1;
+  if (JsonField(line, key, &value)) safe_strto64(value, &result);
+  return result;
+}
+
+// Reads the runs written by RunsToJson().
+bool ReadRuns(const std::string& filename, std::vector<FzRun>* runs) {
+  std::string contents;
+  if (!file::GetContents(filename, &contents, file::Defaults()).ok()) {
+    return false;
+  }
+  const std::vector<std::string> lines =
+      strings::Split(contents, "\n", strings::SkipEmpty());
+  for (const std::string& line : lines) {
+    FzRun run;
+    if (!JsonField(line, "instance", &run.instance)) continue;
+    run.workers = JsonInt64Field(line, "workers");
+    JsonField(line, "status", &run.status);
+    std::string objective;
+    if (JsonField(line, "objective", &objective) && objective != "null") {
+      run.has_objective = safe_strto64(objective, &run.objective);
+    }
+    run.parse_time_in_ms = JsonInt64Field(line, "parse_ms");
+    run.presolve_time_in_ms = JsonInt64Field(line, "presolve_ms");
+    run.extraction_time_in_ms = JsonInt64Field(line, "extraction_ms");
+    run.search_time_in_ms = JsonInt64Field(line, "search_ms");
+    run.time_to_best_in_ms = JsonInt64Field(line, "time_to_best_ms");
+    run.nodes = JsonInt64Field(line, "nodes");
+    run.failures = JsonInt64Field(line, "failures");
+    run.wall_time_in_ms = JsonInt64Field(line, "wall_ms");
+    runs->push_back(run);
+  }
+  return true;
+}
+
+// ----- Comparison -----
+
+// Compares the runs with the baseline, prints the differences, and returns
+// the number of regressions.
+int CompareWithBaseline(const std::vector<FzRun>& runs,
+                        const std::vector<FzRun>& baseline) {
+  int num_regressions = 0;
+  int num_compared_times = 0;
+  double sum_log_ratios = 0.0;
+  printf("\nComparison with %s\n", FLAGS_baseline.c_str());
+  for (const FzRun& run : runs) {
+    const FzRun* old = nullptr;
+    for (const FzRun& candidate : baseline) {
+      if (candidate.instance == run.instance &&
+          candidate.workers == run.workers) {
+        old = &candidate;
+        break;
+      }
+    }
+    if (old == nullptr) continue;
+    const std::string name =
+        StringPrintf("%s (%d workers)", run.instance.c_str(), run.workers);
+    const bool different_optimum = run.status == "proven" &&
+                                   old->status == "proven" &&
+                                   run.objective != old->objective;
+    const bool sat_vs_unsat = (run.status == "unsat" && old->HasSolution()) ||
+                              (old->status == "unsat" && run.HasSolution());
+    if (different_optimum || sat_vs_unsat) {
+      printf("  WRONG ANSWER  %s: %s %s, baseline %s %s\n", name.c_str(),
+             run.status.c_str(),
+             run.has_objective
+                 ? StringPrintf("%" GG_LL_FORMAT "d", run.objective).c_str()
+                 : "",
+             old->status.c_str(),
+             old->has_objective
+                 ? StringPrintf("%" GG_LL_FORMAT "d", old->objective).c_str()
+                 : "");
+      num_regressions++;
+      continue;
+    }
+    if (old->Completed() && !run.Completed()) {
+      printf("  REGRESSION    %s: %s, baseline %s\n", name.c_str(),
+             run.status.c_str(), old->status.c_str());
+      num_regressions++;
+      continue;
+    }
+    if (!old->Completed() && run.Completed()) {
+      printf("  IMPROVEMENT   %s: %s, baseline %s\n", name.c_str(),
+             run.status.c_str(), old->status.c_str());
+      continue;
+    }
+    if (!run.Completed() || !old->Completed() ||
+        old->wall_time_in_ms < FLAGS_min_compared_time) {
+      continue;
+    }
+    const double ratio = std::max<int64>(run.wall_time_in_ms, 1) /
+                         static_cast<double>(old->wall_time_in_ms);
+    sum_log_ratios += log(ratio);
+    num_compared_times++;
+    if (ratio > FLAGS_slowdown_threshold) {
+      printf("  SLOWDOWN      %s: %" GG_LL_FORMAT "d ms, baseline %" GG_LL_FORMAT
+             "d ms (%.2fx)\n",
+             name.c_str(), run.wall_time_in_ms, old->wall_time_in_ms, ratio);
+      num_regressions++;
+    } else if (ratio < 1.0 / FLAGS_slowdown_threshold) {
+      printf("  SPEEDUP       %s: %" GG_LL_FORMAT "d ms, baseline %" GG_LL_FORMAT
+             "d ms (%.2fx)\n",
+             name.c_str(), run.wall_time_in_ms, old->wall_time_in_ms, ratio);
+    }
+  }
+  if (num_compared_times > 0) {
+    printf("Geometric mean of the time ratios over %d runs: %.3f\n",
+           num_compared_times, exp(sum_log_ratios / num_compared_times));
+  }
+  printf("%d regressions\n", num_regressions);
+  return num_regressions;
+}
+
+// ----- Main -----
+
+// Reads the list of instances, with paths relative to the list file.
+void ReadInstances(const std::string& filename,
+                   std::vector<std::string>* paths) {
+  std::string contents;
+  CHECK(file::GetContents(filename, &contents, file::Defaults()).ok())
+      << "Cannot read " << filename;
+  const size_t slash = filename.find_last_of("/\\");
+  const std::string directory =
+      slash == std::string::npos ? "" : filename.substr(0, slash + 1);
+  const std::vector<std::string> lines =
+      strings::Split(contents, "\n", strings::SkipEmpty());
+  for (std::string line : lines) {
+    if (!line.empty() && line[line.size() - 1] == '\r') {
+      line.resize(line.size() - 1);
+    }
+    if (line.empty() || line[0] == '#') continue;
+    const bool is_absolute = line[0] == '/' || line[0] == '\\' ||
+                             (line.size() > 1 && line[1] == ':');
+    paths->push_back(is_absolute ? line : directory + line);
+  }
+}
+
+std::string InstanceName(const std::string& path) {
+  const size_t slash = path.find_last_of("/\\");
+  std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+  if (HasSuffixString(name, ".fzn")) name.resize(name.size() - 4);
+  return name;
+}
+
+int RunFzBenchmark() {
+  std::vector<std::string> paths;
+  ReadInstances(FLAGS_instances, &paths);
+  std::vector<int64> workers;
+  CHECK(SplitStringAndParse(FLAGS_workers, ",", &safe_strto64, &workers))
+      << "Invalid --workers: " << FLAGS_workers;
+  printf("%-36s %7s %-9s %10s %7s %8s %8s %8s %8s %10s %10s\n", "instance",
+         "workers", "status", "objective", "parse", "presolve", "extract",
+         "search", "best", "nodes", "failures");
+  std::vector<FzRun> runs;
+  for (const int64 num_workers : workers) {
+    for (const std::string& path : paths) {
+      FzRun run;
+      run.instance = InstanceName(path);
+      run.workers = num_workers;
+      RunFz(path, num_workers, &run);
+      printf("%-36s %7d %-9s %10s %7" GG_LL_FORMAT "d %8" GG_LL_FORMAT
+             "d %8" GG_LL_FORMAT "d %8" GG_LL_FORMAT "d %8" GG_LL_FORMAT
+             "d %10" GG_LL_FORMAT "d %10" GG_LL_FORMAT "d\n",
+             run.instance.c_str(), run.workers, run.status.c_str(),
+             run.has_objective
+                 ? StringPrintf("%" GG_LL_FORMAT "d", run.objective).c_str()
+                 : "-",
+             run.parse_time_in_ms, run.presolve_time_in_ms,
+             run.extraction_time_in_ms, run.search_time_in_ms,
+             run.time_to_best_in_ms, run.nodes, run.failures);
+      fflush(stdout);
+      runs.push_back(run);
+    }
+  }
+  if (!FLAGS_output.empty()) {
+    CHECK(file::SetContents(FLAGS_output, RunsToJson(runs), file::Defaults())
+              .ok())
+        << "Cannot write " << FLAGS_output;
+  }
+  if (FLAGS_baseline.empty()) return 0;
+  std::vector<FzRun> baseline;
+  CHECK(ReadRuns(FLAGS_baseline, &baseline)) << "Cannot read "
+                                             << FLAGS_baseline;
+  return CompareWithBaseline(runs, baseline) > 0 ? 1 : 0;
+}
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  FLAGS_log_prefix = false;
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  return operations_research::RunFzBenchmark();
+}
@@ -620,6 +620,18 @@ void FzModel::AddConstraint(const std::string& id,
   }
 }
 
+void FzModel::AddConstraint(const std::string& id,
+                            std::vector<FzArgument>* const arguments,
+                            bool is_domain, FzIntegerVariable* const defines) {
+  FzConstraint* const constraint =
+      new FzConstraint(id, std::vector<FzArgument>(), is_domain, defines);
+  constraint->arguments.swap(*arguments);
+  constraints_.push_back(constraint);
+  if (defines != nullptr) {
+    defines->defining_constraint = constraint;
+  }
+}
+
 void FzModel::AddOutput(const FzOnSolutionOutput& output) {
   output_.push_back(output);
 }
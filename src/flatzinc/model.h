@@ -179,7 +179,8 @@ struct FzConstraint {
         target_variable(target_variable_),
         strong_propagation(strong_propagation_),
         active(true),
-        presolve_propagation_done(false) {}
+        presolve_propagation_done(false),
+        presolve_queued(false) {}
 
   std::string DebugString() const;
 
@@ -208,6 +209,8 @@ struct FzConstraint {
 
   // Indicates if presolve has finished propagating this constraint.
   bool presolve_propagation_done : 1;
+  // Indicates if the constraint is in the worklist of the presolve.
+  bool presolve_queued : 1;
 
   // Helpers
   void MarkAsInactive();
@@ -315,6 +318,11 @@ class FzModel {
   void AddConstraint(const std::string& type,
                      const std::vector<FzArgument>& arguments, bool is_domain,
                      FzIntegerVariable* const target_variable);
+  // Same as above, but the arguments are moved to the constraint: *arguments
+  // is empty after the call.
+  void AddConstraint(const std::string& type,
+                     std::vector<FzArgument>* const arguments, bool is_domain,
+                     FzIntegerVariable* const target_variable);
   void AddOutput(const FzOnSolutionOutput& output);
 
   // Set the search annotations and the objective: either simply satisfy the
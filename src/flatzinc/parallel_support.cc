@@ -10,10 +10,16 @@
 // WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 // See the License for the specific language governing permissions and
 // limitations under the License.
+#include <algorithm>
+#include <atomic>
 #include <iostream>  // NOLINT
 #include <string>
+#include <utility>
+#include <vector>
+#include "base/hash.h"
 #include "base/integral_types.h"
 #include "base/logging.h"
+#include "base/map_util.h"
 #include "base/mutex.h"
 #include "base/stringprintf.h"
 #include "constraint_solver/constraint_solver.h"
@@ -79,6 +85,375 @@ class MtCustomLimit : public SearchLimit {
   const int worker_id_;
 };
 
+// Maximum number of terms of a nogood shared between workers, and
+// maximum number of shared nogoods. Each worker checks all its nogoods
+// at each decision, so both are kept small.
+const int kMaxSharedNoGoodSize = 3;
+const int kMaxSharedNoGoods = 1000;
+
+// Bounds of a variable found at the root of the search of one worker.
+struct SharedBounds {
+  SharedBounds(FzIntegerVariable* v, int64 vmin, int64 vmax, int w)
+      : var(v), min(vmin), max(vmax), worker_id(w) {}
+
+  FzIntegerVariable* var;
+  int64 min;
+  int64 max;
+  int worker_id;
+};
+
+// A nogood learned by one worker: the conjunction of its terms is
+// infeasible. Term i is 'vars[i] == values[i]' if assigns[i] is true,
+// and 'vars[i] != values[i]' otherwise.
+struct SharedNoGood {
+  std::vector<FzIntegerVariable*> vars;
+  std::vector<int64> values;
+  std::vector<bool> assigns;
+  int worker_id;
+};
+
+// The thread-safe store of the bounds and nogoods shared by the
+// workers. Both are kept in append-only logs, and each worker
+// remembers how much of each log it has already read. The sizes of the
+// logs can be polled without taking the lock.
+class SharedKnowledge {
+ public:
+  SharedKnowledge() : num_bounds_(0), num_nogoods_(0) {}
+
+  // Appends the bounds that tighten the ones already shared.
+  void AddBounds(int worker_id, const std::vector<FzIntegerVariable*>& vars,
+                 const std::vector<int64>& mins,
+                 const std::vector<int64>& maxs) {
+    MutexLock lock(&mutex_);
+    for (int i = 0; i < vars.size(); ++i) {
+      std::pair<int64, int64>* const bounds = FindOrNull(best_bounds_, vars[i]);
+      if (bounds == nullptr) {
+        best_bounds_[vars[i]] = std::make_pair(mins[i], maxs[i]);
+      } else if (mins[i] > bounds->first || maxs[i] < bounds->second) {
+        bounds->first = std::max(bounds->first, mins[i]);
+        bounds->second = std::min(bounds->second, maxs[i]);
+      } else {
+        continue;
+      }
+      const std::pair<int64, int64>& best = best_bounds_[vars[i]];
+      bounds_.push_back(
+          SharedBounds(vars[i], best.first, best.second, worker_id));
+    }
+    num_bounds_ = bounds_.size();
+  }
+
+  // Appends a nogood, unless the store is full.
+  void AddNoGood(const SharedNoGood& nogood) {
+    MutexLock lock(&mutex_);
+    if (nogoods_.size() < kMaxSharedNoGoods) {
+      nogoods_.push_back(nogood);
+      num_nogoods_ = nogoods_.size();
+    }
+  }
+
+  int NumBounds() const { return num_bounds_; }
+  int NumNoGoods() const { return num_nogoods_; }
+
+  // Copies the bounds (resp. nogoods) from position 'start' to the end
+  // of the log.
+  void GetBounds(int start, std::vector<SharedBounds>* bounds) {
+    MutexLock lock(&mutex_);
+    bounds->assign(bounds_.begin() + start, bounds_.end());
+  }
+
+  void GetNoGoods(int start, std::vector<SharedNoGood>* nogoods) {
+    MutexLock lock(&mutex_);
+    nogoods->assign(nogoods_.begin() + start, nogoods_.end());
+  }
+
+ private:
+  Mutex mutex_;
+  hash_map<const FzIntegerVariable*, std::pair<int64, int64> > best_bounds_;
+  std::vector<SharedBounds> bounds_;
+  std::vector<SharedNoGood> nogoods_;
+  std::atomic<int> num_bounds_;
+  std::atomic<int> num_nogoods_;
+};
+
+// Extracts the variable and the value of a decision of the form
+// 'var == value'.
+class AssignmentFinder : public DecisionVisitor {
+ public:
+  AssignmentFinder() : var_(nullptr), value_(0), num_assignments_(0) {}
+  virtual ~AssignmentFinder() {}
+
+  virtual void VisitSetVariableValue(IntVar* const var, int64 value) {
+    var_ = var;
+    value_ = value;
+    num_assignments_++;
+  }
+
+  // Returns true if the decision assigns exactly one variable.
+  bool Find(Decision* const d) {
+    var_ = nullptr;
+    num_assignments_ = 0;
+    d->Accept(this);
+    return num_assignments_ == 1;
+  }
+
+  IntVar* var() const { return var_; }
+  int64 value() const { return value_; }
+
+ private:
+  IntVar* var_;
+  int64 value_;
+  int num_assignments_;
+};
+
+// A decision on the current search path. 'index' is the position of
+// the variable in the shared variables, or -1 if the decision cannot be
+// expressed as a nogood term.
+struct SharingChoice {
+  SharingChoice() : index(-1), value(0), left(false) {}
+  SharingChoice(int i, int64 v, bool l) : index(i), value(v), left(l) {}
+
+  int index;
+  int64 value;
+  bool left;
+};
+
+// This search monitor exchanges information with the other workers:
+//   - At the root of the search (initially, and after each restart),
+//     it exports the bounds of the shared variables that are tighter
+//     than the ones it has already exported.
+//   - When the left branch of a shallow decision has been fully
+//     explored, it exports the path to this decision as a nogood.
+//   - At each decision and each refutation, it applies the bounds
+//     shared by the other workers, and adds their nogoods to its
+//     nogood manager.
+// Root bounds and nogoods are only valid for solutions strictly better
+// than the best one found by this worker, which is never better than the
+// best solution shared by all workers, so they remain valid for all.
+class MtSharingMonitor : public SearchMonitor {
+ public:
+  MtSharingMonitor(Solver* const s,
+                   const std::vector<FzIntegerVariable*>& fz_vars,
+                   const std::vector<IntVar*>& vars, bool share_nogoods,
+                   SharedKnowledge* const knowledge,
+                   FzParallelSupportInterface* const support, int worker_id)
+      : SearchMonitor(s),
+        fz_vars_(fz_vars),
+        vars_(vars),
+        share_nogoods_(share_nogoods),
+        knowledge_(knowledge),
+        support_(support),
+        worker_id_(worker_id),
+        nogood_manager_(s->MakeNoGoodManager()),
+        exported_min_(vars.size(), kint64min),
+        exported_max_(vars.size(), kint64max),
+        imported_min_(vars.size(), kint64min),
+        imported_max_(vars.size(), kint64max),
+        is_imported_(vars.size(), false),
+        num_read_bounds_(0),
+        num_read_nogoods_(0),
+        path_size_(0),
+        initialized_(false) {
+    CHECK_EQ(fz_vars.size(), vars.size());
+    for (int i = 0; i < vars.size(); ++i) {
+      InsertIfNotPresent(&var_index_, vars[i], i);
+      InsertIfNotPresent(&fz_var_index_, fz_vars[i], i);
+    }
+  }
+
+  virtual ~MtSharingMonitor() {}
+
+  virtual void EnterSearch() {
+    // The initial propagation has not happened yet, the domains are the
+    // ones of the model.
+    if (!initialized_) {
+      for (int i = 0; i < vars_.size(); ++i) {
+        exported_min_[i] = vars_[i]->Min();
+        exported_max_[i] = vars_[i]->Max();
+      }
+      initialized_ = true;
+    }
+    nogood_manager_->EnterSearch();
+  }
+
+  virtual void BeginNextDecision(DecisionBuilder* const db) {
+    ImportAndApply();
+    nogood_manager_->BeginNextDecision(db);
+    if (solver()->SearchDepth() == 0) {  // initially and after a restart.
+      ExportRootBounds();
+    }
+  }
+
+  virtual void ApplyDecision(Decision* const d) {
+    if (share_nogoods_) {
+      PushChoice(d, true);
+    }
+  }
+
+  virtual void RefuteDecision(Decision* const d) {
+    if (share_nogoods_) {
+      ExportNoGood(d);
+      PushChoice(d, false);
+    }
+    ImportAndApply();
+  }
+
+  virtual bool AcceptSolution() { return nogood_manager_->AcceptSolution(); }
+
+  virtual std::string DebugString() const {
+    return StringPrintf("MtSharingMonitor(worker = %d, %d nogoods)",
+                        worker_id_, nogood_manager_->NoGoodCount());
+  }
+
+ private:
+  void PushChoice(Decision* const d, bool left) {
+    const int size = path_size_.Value();
+    path_size_.SetValue(solver(), size + 1);
+    if (size < kMaxSharedNoGoodSize) {
+      int index = -1;
+      if (finder_.Find(d)) {
+        index = FindWithDefault(var_index_, finder_.var(), -1);
+      }
+      choices_.Push(solver(), SharingChoice(index, finder_.value(), left));
+    }
+  }
+
+  // Called before refuting 'd': the path above 'd' followed by the
+  // assignment of 'd' has no (better) solution.
+  void ExportNoGood(Decision* const d) {
+    if (path_size_.Value() >= kMaxSharedNoGoodSize || !finder_.Find(d)) {
+      return;
+    }
+    const int index = FindWithDefault(var_index_, finder_.var(), -1);
+    if (index == -1) {
+      return;
+    }
+    SharedNoGood nogood;
+    nogood.worker_id = worker_id_;
+    nogood.vars.push_back(fz_vars_[index]);
+    nogood.values.push_back(finder_.value());
+    nogood.assigns.push_back(true);
+    for (SimpleRevFIFO<SharingChoice>::Iterator it(&choices_); it.ok();
+         ++it) {
+      const SharingChoice& choice = *it;
+      if (choice.index == -1) {
+        return;
+      }
+      nogood.vars.push_back(fz_vars_[choice.index]);
+      nogood.values.push_back(choice.value);
+      nogood.assigns.push_back(choice.left);
+    }
+    knowledge_->AddNoGood(nogood);
+  }
+
+  void ExportRootBounds() {
+    std::vector<FzIntegerVariable*> vars;
+    std::vector<int64> mins;
+    std::vector<int64> maxs;
+    for (int i = 0; i < vars_.size(); ++i) {
+      IntVar* const var = vars_[i];
+      if (var->Min() > exported_min_[i] || var->Max() < exported_max_[i]) {
+        exported_min_[i] = var->Min();
+        exported_max_[i] = var->Max();
+        vars.push_back(fz_vars_[i]);
+        mins.push_back(var->Min());
+        maxs.push_back(var->Max());
+      }
+    }
+    if (!vars.empty()) {
+      support_->Log(worker_id_, StringPrintf("sharing %d root bounds",
+                                             static_cast<int>(vars.size())));
+      knowledge_->AddBounds(worker_id_, vars, mins, maxs);
+    }
+  }
+
+  void ImportAndApply() {
+    if (knowledge_->NumBounds() > num_read_bounds_) {
+      ImportBounds();
+    }
+    if (knowledge_->NumNoGoods() > num_read_nogoods_) {
+      ImportNoGoods();
+    }
+    // Domain reductions are undone on backtrack, so the imported bounds
+    // are applied again at each call, like the objective bound.
+    for (const int index : imported_) {
+      vars_[index]->SetRange(imported_min_[index], imported_max_[index]);
+    }
+  }
+
+  void ImportBounds() {
+    std::vector<SharedBounds> bounds;
+    knowledge_->GetBounds(num_read_bounds_, &bounds);
+    num_read_bounds_ += bounds.size();
+    for (const SharedBounds& shared : bounds) {
+      const int index = FindWithDefault(fz_var_index_, shared.var, -1);
+      if (shared.worker_id == worker_id_ || index == -1) {
+        continue;
+      }
+      imported_min_[index] = std::max(imported_min_[index], shared.min);
+      imported_max_[index] = std::min(imported_max_[index], shared.max);
+      if (!is_imported_[index]) {
+        is_imported_[index] = true;
+        imported_.push_back(index);
+      }
+    }
+  }
+
+  void ImportNoGoods() {
+    std::vector<SharedNoGood> nogoods;
+    knowledge_->GetNoGoods(num_read_nogoods_, &nogoods);
+    num_read_nogoods_ += nogoods.size();
+    for (const SharedNoGood& shared : nogoods) {
+      if (shared.worker_id == worker_id_) {
+        continue;
+      }
+      NoGood* const nogood = nogood_manager_->MakeNoGood();
+      bool valid = true;
+      for (int i = 0; i < shared.vars.size(); ++i) {
+        const int index = FindWithDefault(fz_var_index_, shared.vars[i], -1);
+        if (index == -1) {
+          valid = false;
+          break;
+        }
+        if (shared.assigns[i]) {
+          nogood->AddIntegerVariableEqualValueTerm(vars_[index],
+                                                   shared.values[i]);
+        } else {
+          nogood->AddIntegerVariableNotEqualValueTerm(vars_[index],
+                                                      shared.values[i]);
+        }
+      }
+      if (valid) {
+        nogood_manager_->AddNoGood(nogood);
+      } else {
+        delete nogood;
+      }
+    }
+  }
+
+  const std::vector<FzIntegerVariable*> fz_vars_;
+  const std::vector<IntVar*> vars_;
+  const bool share_nogoods_;
+  SharedKnowledge* const knowledge_;
+  FzParallelSupportInterface* const support_;
+  const int worker_id_;
+  NoGoodManager* const nogood_manager_;
+  hash_map<IntVar*, int> var_index_;
+  hash_map<const FzIntegerVariable*, int> fz_var_index_;
+  std::vector<int64> exported_min_;
+  std::vector<int64> exported_max_;
+  std::vector<int64> imported_min_;
+  std::vector<int64> imported_max_;
+  std::vector<bool> is_imported_;
+  std::vector<int> imported_;
+  int num_read_bounds_;
+  int num_read_nogoods_;
+  AssignmentFinder finder_;
+  // The first decisions of the current search path, and its length.
+  SimpleRevFIFO<SharingChoice> choices_;
+  Rev<int> path_size_;
+  bool initialized_;
+};
+
 class MtSupportInterface : public FzParallelSupportInterface {
  public:
   MtSupportInterface(bool print_all, int num_solutions, bool verbose)
@@ -202,6 +577,14 @@ class MtSupportInterface : public FzParallelSupportInterface {
     return s->RevAlloc(new MtCustomLimit(s, this, worker_id));
   }
 
+  virtual SearchMonitor* Sharing(Solver* s,
+                                 const std::vector<FzIntegerVariable*>& fz_vars,
+                                 const std::vector<IntVar*>& vars,
+                                 bool share_nogoods, int worker_id) {
+    return s->RevAlloc(new MtSharingMonitor(s, fz_vars, vars, share_nogoods,
+                                            &knowledge_, this, worker_id));
+  }
+
   virtual void Log(int worker_id, const std::string& message) {
     if (verbose_) {
       MutexLock lock(&mutex_);
@@ -228,6 +611,7 @@ class MtSupportInterface : public FzParallelSupportInterface {
   int64 best_solution_;
   bool should_finish_;
   bool interrupted_;
+  SharedKnowledge knowledge_;
 };
 }  // namespace
 
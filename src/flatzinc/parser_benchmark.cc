@@ -0,0 +1,154 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This binary compares the flex/bison flatzinc parser (flatzinc/parser.h)
+// with the hand-written one (flatzinc/fast_parser.h): it parses the same
+// input with both, prints their times, and checks that they build the same
+// model.
+//
+// The input is either a .fzn file, or a generated model shaped like the
+// flattened timetabling models: arrays of boolean and integer variables
+// linked by many bool2int and int_lin_le constraints with annotations.
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/stringprintf.h"
+#include "base/timer.h"
+#include "flatzinc/fast_parser.h"
+#include "flatzinc/model.h"
+#include "flatzinc/parser.h"
+
+DEFINE_string(file, "", "Input file in the flatzinc format. If empty, a model "
+              "is generated.");
+DEFINE_int32(num_events, 20000, "Number of events of the generated model.");
+DEFINE_int32(num_slots, 40, "Number of time slots of the generated model.");
+DEFINE_int32(num_runs, 3, "Number of times each parser is run.");
+DEFINE_bool(check, true, "Check that the two parsers build the same model.");
+
+namespace operations_research {
+// Generates a model where each event is scheduled in one slot, with a
+// capacity per slot.
+std::string GenerateTimetablingModel(int num_events, int num_slots) {
+  std::string model;
+  const int num_vars = num_events * num_slots;
+  StringAppendF(&model, "array [1..%d] of int: ones = [", num_events);
+  for (int e = 0; e < num_events; ++e) {
+    model.append(e == 0 ? "1" : ", 1");
+  }
+  model.append("];\n");
+  StringAppendF(&model,
+                "array [1..%d] of var bool: x :: output_array([1..%d, 1..%d]);"
+                "\n",
+                num_vars, num_events, num_slots);
+  for (int i = 1; i <= num_vars; ++i) {
+    StringAppendF(&model, "var 0..1: b%d :: var_is_introduced;\n", i);
+  }
+  StringAppendF(&model,
+                "array [1..%d] of var 1..%d: slot :: output_array([1..%d]);\n",
+                num_events, num_slots, num_events);
+  for (int i = 1; i <= num_vars; ++i) {
+    StringAppendF(&model,
+                  "constraint bool2int(x[%d], b%d) :: defines_var(b%d);\n", i,
+                  i, i);
+  }
+  // Each event is in exactly one slot.
+  for (int e = 0; e < num_events; ++e) {
+    std::string vars;
+    std::string coefficients;
+    for (int s = 0; s < num_slots; ++s) {
+      StringAppendF(&vars, "%sb%d", s == 0 ? "" : ", ", e * num_slots + s + 1);
+      coefficients.append(s == 0 ? "1" : ", 1");
+    }
+    StringAppendF(&model, "constraint int_lin_eq([%s], [%s], 1);\n",
+                  coefficients.c_str(), vars.c_str());
+    StringAppendF(&model, "constraint int_le(1, slot[%d]);\n", e + 1);
+  }
+  // The capacity of each slot.
+  const int capacity = std::max(1, 2 * num_events / num_slots);
+  for (int s = 0; s < num_slots; ++s) {
+    std::string vars;
+    for (int e = 0; e < num_events; ++e) {
+      StringAppendF(&vars, "%sb%d", e == 0 ? "" : ", ", e * num_slots + s + 1);
+    }
+    StringAppendF(&model, "constraint int_lin_le(ones, [%s], %d) :: domain;\n",
+                  vars.c_str(), capacity);
+  }
+  model.append(
+      "solve :: int_search(slot, input_order, indomain_min, complete) "
+      "satisfy;\n");
+  return model;
+}
+
+// Parses the input with the given parser, and returns the best time in
+// seconds.
+double TimeParser(const std::string& name,
+                  bool (*parse_string)(const std::string&, FzModel* const),
+                  bool (*parse_file)(const std::string&, FzModel* const),
+                  const std::string& input, std::string* const debug_string) {
+  double best_time = 0.0;
+  for (int run = 0; run < FLAGS_num_runs; ++run) {
+    FzModel model("benchmark");
+    WallTimer timer;
+    timer.Start();
+    const bool ok = FLAGS_file.empty() ? parse_string(input, &model)
+                                       : parse_file(FLAGS_file, &model);
+    timer.Stop();
+    CHECK(ok) << name << " failed";
+    best_time = run == 0 ? timer.Get() : std::min(best_time, timer.Get());
+    if (run == 0 && FLAGS_check) *debug_string = model.DebugString();
+    if (run == 0) {
+      printf("  %-12s %d variables, %d constraints\n", name.c_str(),
+             static_cast<int>(model.variables().size()),
+             static_cast<int>(model.constraints().size()));
+    }
+  }
+  return best_time;
+}
+
+void RunParserBenchmark() {
+  std::string input;
+  if (FLAGS_file.empty()) {
+    input = GenerateTimetablingModel(FLAGS_num_events, FLAGS_num_slots);
+    printf("Generated model of %d events and %d slots, %.1f MB\n",
+           FLAGS_num_events, FLAGS_num_slots, input.size() / 1e6);
+  } else {
+    printf("File %s\n", FLAGS_file.c_str());
+  }
+  std::string bison_model;
+  std::string fast_model;
+  const double bison_time = TimeParser("bison", &ParseFlatzincString,
+                                       &ParseFlatzincFile, input, &bison_model);
+  const double fast_time =
+      TimeParser("hand-written", &FastParseFlatzincString,
+                 &FastParseFlatzincFile, input, &fast_model);
+  printf("bison:        %8.3f s\n", bison_time);
+  printf("hand-written: %8.3f s (%.1fx faster)\n", fast_time,
+         bison_time / std::max(fast_time, 1e-9));
+  if (FLAGS_check) {
+    CHECK(bison_model == fast_model) << "The models are different.";
+    printf("The two parsers built the same model.\n");
+  }
+}
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  FLAGS_log_prefix = false;
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::RunParserBenchmark();
+  return 0;
+}
@@ -18,6 +18,7 @@
 
 #include "base/commandlineflags.h"
 #include "base/commandlineflags.h"
+#include "flatzinc/fast_parser.h"
 #include "flatzinc/model.h"
 #include "flatzinc/parser.h"
 #include "flatzinc/presolve.h"
@@ -26,6 +27,8 @@ DEFINE_string(file, "", "Input file in the flatzinc format.");
 DEFINE_bool(print, false, "Print model.");
 DEFINE_bool(presolve, false, "Presolve loaded file.");
 DEFINE_bool(statistics, false, "Print model statistics");
+DEFINE_bool(fast_parser, true,
+            "Use the hand-written parser instead of the bison one.");
 DECLARE_bool(fz_logging);
 
 namespace operations_research {
@@ -40,7 +43,8 @@ void ParseFile(const std::string& filename, bool presolve) {
     problem_name = problem_name.substr(found + 1);
   }
   FzModel model(problem_name);
-  CHECK(ParseFlatzincFile(filename, &model));
+  CHECK(FLAGS_fast_parser ? FastParseFlatzincFile(filename, &model)
+                          : ParseFlatzincFile(filename, &model));
   if (presolve) {
     FzPresolver presolve;
     presolve.CleanUpModelForTheCpSolver(&model, true);
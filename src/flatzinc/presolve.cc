@@ -17,6 +17,7 @@
 
 #include "base/map_util.h"
 #include "base/strutil.h"
+#include "util/time_limit.h"
 
 DECLARE_bool(fz_logging);
 DECLARE_bool(fz_verbose);
@@ -39,8 +40,6 @@ bool IsBooleanValue(int64 value) { return value == 0 || value == 1; }
 //   - table_int -> intersect variables domains with tuple set.
 //
 // TODO(user):
-//   - store dependency graph of constraints -> variable to speed up presolve.
-//   - use the same dependency graph to speed up variable substitution.
 //   - add more check when presolving out a variable or a constraint.
 
 // ----- Presolve rules -----
@@ -898,6 +897,7 @@ bool FzPresolver::PresolveStoreMapping(FzConstraint* ct) {
       ct->strong_propagation) {
     affine_map_[ct->target_variable] = AffineMapping(
         ct->Arg(1).variables[1], ct->Arg(0).values[1], -ct->Arg(2).Value(), ct);
+    mapping_dependents_[ct->Arg(1).variables[1]].push_back(ct->target_variable);
     FZVLOG << "Store affine mapping info for " << ct->DebugString() << FZENDL;
     return true;
   }
@@ -909,6 +909,8 @@ bool FzPresolver::PresolveStoreMapping(FzConstraint* ct) {
     flatten_map_[ct->target_variable] =
         FlatteningMapping(ct->Arg(1).variables[1], ct->Arg(0).values[1],
                           ct->Arg(1).variables[2], -ct->Arg(2).Value(), ct);
+    mapping_dependents_[ct->Arg(1).variables[1]].push_back(ct->target_variable);
+    mapping_dependents_[ct->Arg(1).variables[2]].push_back(ct->target_variable);
     FZVLOG << "Store affine mapping info for " << ct->DebugString() << FZENDL;
     //    ct->MarkAsInactive();
     return true;
@@ -920,6 +922,8 @@ bool FzPresolver::PresolveStoreMapping(FzConstraint* ct) {
     flatten_map_[ct->target_variable] =
         FlatteningMapping(ct->Arg(1).variables[2], ct->Arg(0).values[2],
                           ct->Arg(1).variables[1], -ct->Arg(2).Value(), ct);
+    mapping_dependents_[ct->Arg(1).variables[1]].push_back(ct->target_variable);
+    mapping_dependents_[ct->Arg(1).variables[2]].push_back(ct->target_variable);
     FZVLOG << "Store affine mapping info for " << ct->DebugString() << FZENDL;
     //    ct->MarkAsInactive();
     return true;
@@ -1473,19 +1477,21 @@ bool FzPresolver::PresolveOneConstraint(FzConstraint* ct) {
   if (HasSuffixString(id, "_reif") &&
       ct->Arg(num_arguments - 1).HasOneValue()) {
     Unreify(ct);
-    changed = true;
+    changed = RecordRule("Unreify", true);
+  }
+  if (id == "bool2int") {
+    changed |= RecordRule("PresolveBool2Int", PresolveBool2Int(ct));
   }
-  if (id == "bool2int") changed |= PresolveBool2Int(ct);
   if (id == "int_le" || id == "int_lt" || id == "int_ge" || id == "int_gt" ||
       id == "bool_le" || id == "bool_lt" || id == "bool_ge" ||
       id == "bool_gt") {
-    changed |= PresolveInequalities(ct);
+    changed |= RecordRule("PresolveInequalities", PresolveInequalities(ct));
   }
   if (id == "int_abs" && !ContainsKey(abs_map_, ct->Arg(1).Var())) {
     // Stores abs() map.
     FZVLOG << "Stores abs map for " << ct->DebugString() << FZENDL;
     abs_map_[ct->Arg(1).Var()] = ct->Arg(0).Var();
-    changed = true;
+    changed = RecordRule("StoreAbsMap", true);
   }
   if ((id == "int_eq_reif" || id == "int_ne_reif" || id == "int_ne") &&
       ct->Arg(1).HasOneValue() && ct->Arg(1).Value() == 0 &&
@@ -1495,60 +1501,88 @@ bool FzPresolver::PresolveOneConstraint(FzConstraint* ct) {
     // Output: int_eq(y, 0) or int_ne(y, 0)
     FZVLOG << "Remove abs() from " << ct->DebugString() << FZENDL;
     ct->MutableArg(0)->variables[0] = abs_map_[ct->Arg(0).Var()];
-    changed = true;
+    changed = RecordRule("RemoveAbsFromIntEqNe", true);
   }
   if ((id == "int_le_reif") && ct->Arg(1).HasOneValue() &&
       ContainsKey(abs_map_, ct->Arg(0).Var())) {
-    changed |= RemoveAbsFromIntLinReif(ct);
+    changed |= RecordRule("RemoveAbsFromIntLinReif",
+                          RemoveAbsFromIntLinReif(ct));
+  }
+  if (id == "int_eq" || id == "bool_eq") {
+    changed |= RecordRule("PresolveIntEq", PresolveIntEq(ct));
+  }
+  if (id == "int_ne" || id == "bool_not") {
+    changed |= RecordRule("PresolveIntNe", PresolveIntNe(ct));
+  }
+  if (id == "set_in") changed |= RecordRule("PresolveSetIn", PresolveSetIn(ct));
+  if (id == "array_bool_and") {
+    changed |= RecordRule("PresolveArrayBoolAnd", PresolveArrayBoolAnd(ct));
+  }
+  if (id == "array_bool_or") {
+    changed |= RecordRule("PresolveArrayBoolOr", PresolveArrayBoolOr(ct));
   }
-  if (id == "int_eq" || id == "bool_eq") changed |= PresolveIntEq(ct);
-  if (id == "int_ne" || id == "bool_not") changed |= PresolveIntNe(ct);
-  if (id == "set_in") changed |= PresolveSetIn(ct);
-  if (id == "array_bool_and") changed |= PresolveArrayBoolAnd(ct);
-  if (id == "array_bool_or") changed |= PresolveArrayBoolOr(ct);
   if (id == "bool_eq_reif" || id == "bool_ne_reif") {
-    changed |= PresolveBoolEqNeReif(ct);
+    changed |= RecordRule("PresolveBoolEqNeReif", PresolveBoolEqNeReif(ct));
   }
   if (id == "bool_not") {
-    changed |= PresolveBoolNot(ct);
+    changed |= RecordRule("PresolveBoolNot", PresolveBoolNot(ct));
+  }
+  if (id == "int_div") {
+    changed |= RecordRule("PresolveIntDiv", PresolveIntDiv(ct));
+  }
+  if (id == "int_times") {
+    changed |= RecordRule("PresolveIntTimes", PresolveIntTimes(ct));
+  }
+  if (id == "int_lin_gt") {
+    changed |= RecordRule("PresolveIntLinGt", PresolveIntLinGt(ct));
+  }
+  if (id == "int_lin_lt") {
+    changed |= RecordRule("PresolveIntLinLt", PresolveIntLinLt(ct));
   }
-  if (id == "int_div") changed |= PresolveIntDiv(ct);
-  if (id == "int_times") changed |= PresolveIntTimes(ct);
-  if (id == "int_lin_gt") changed |= PresolveIntLinGt(ct);
-  if (id == "int_lin_lt") changed |= PresolveIntLinLt(ct);
   if (HasPrefixString(id, "int_lin_")) {
-    changed |= PresolveLinear(ct);
-    changed |= RegroupLinear(ct);
-    changed |= SimplifyUnaryLinear(ct);
+    changed |= RecordRule("PresolveLinear", PresolveLinear(ct));
+    changed |= RecordRule("RegroupLinear", RegroupLinear(ct));
+    changed |= RecordRule("SimplifyUnaryLinear", SimplifyUnaryLinear(ct));
   }
   if (id == "int_lin_eq" || id == "int_lin_le" || id == "int_lin_ge") {
     const bool upper = !(id == "int_lin_ge");
-    changed |= PropagatePositiveLinear(ct, upper);
+    changed |= RecordRule("PropagatePositiveLinear",
+                          PropagatePositiveLinear(ct, upper));
+  }
+  if (id == "int_lin_eq") {
+    changed |= RecordRule("CreateLinearTarget", CreateLinearTarget(ct));
   }
   if (id == "int_lin_eq") {
-    changed |= CreateLinearTarget(ct);
+    changed |= RecordRule("PresolveStoreMapping", PresolveStoreMapping(ct));
+  }
+  if (id == "int_lin_eq_reif") {
+    changed |= RecordRule("CheckIntLinReifBounds", CheckIntLinReifBounds(ct));
+  }
+  if (id == "int_lin_eq_reif") {
+    changed |= RecordRule("SimplifyIntLinEqReif", SimplifyIntLinEqReif(ct));
   }
-  if (id == "int_lin_eq") changed |= PresolveStoreMapping(ct);
-  if (id == "int_lin_eq_reif") changed |= CheckIntLinReifBounds(ct);
-  if (id == "int_lin_eq_reif") changed |= SimplifyIntLinEqReif(ct);
   if (id == "array_int_element") {
-    changed |= PresolveSimplifyElement(ct);
+    changed |= RecordRule("PresolveSimplifyElement",
+                          PresolveSimplifyElement(ct));
   }
   // Type could have changed in the previous rule. We need to test again.
   if (id == "array_int_element") {
-    changed |= PresolveArrayIntElement(ct);
+    changed |= RecordRule("PresolveArrayIntElement",
+                          PresolveArrayIntElement(ct));
   }
   if (id == "array_var_int_element") {
-    changed |= PresolveSimplifyExprElement(ct);
+    changed |= RecordRule("PresolveSimplifyExprElement",
+                          PresolveSimplifyExprElement(ct));
   }
   if (id == "int_eq_reif" || id == "int_ne_reif" || id == "int_le_reif" ||
       id == "int_lt_reif" || id == "int_ge_reif" || id == "int_gt_reif" ||
       id == "bool_eq_reif" || id == "bool_ne_reif" || id == "bool_le_reif" ||
       id == "bool_lt_reif" || id == "bool_ge_reif" || id == "bool_gt_reif") {
-    changed |= PropagateReifiedComparisons(ct);
+    changed |= RecordRule("PropagateReifiedComparisons",
+                          PropagateReifiedComparisons(ct));
   }
   if (id == "int_mod") {
-    changed |= PresolveIntMod(ct);
+    changed |= RecordRule("PresolveIntMod", PresolveIntMod(ct));
   }
   // Last rule: if the target variable of a constraint is fixed, removed it
   // the target part.
@@ -1557,7 +1591,7 @@ bool FzPresolver::PresolveOneConstraint(FzConstraint* ct) {
            << " as it is fixed to a single value" << FZENDL;
     ct->target_variable->defining_constraint = nullptr;
     ct->target_variable = nullptr;
-    changed = true;
+    changed = RecordRule("RemoveFixedTargetVariable", true);
   }
   return changed;
 }
@@ -1606,6 +1640,7 @@ void FzPresolver::MergeIntEqNe(FzModel* model) {
           ct->arguments.clear();
           ct->arguments.push_back(FzArgument::IntVarRef(stored));
           ct->arguments.push_back(FzArgument::IntVarRef(boolvar));
+          AddOccurrences(ct);
           FZVLOG << "  -> " << ct->DebugString() << FZENDL;
         }
       }
@@ -1632,6 +1667,7 @@ void FzPresolver::MergeIntEqNe(FzModel* model) {
           ct->arguments.clear();
           ct->arguments.push_back(FzArgument::IntVarRef(stored));
           ct->arguments.push_back(FzArgument::IntVarRef(boolvar));
+          AddOccurrences(ct);
           FZVLOG << "  -> " << ct->DebugString() << FZENDL;
         }
       }
@@ -1656,46 +1692,181 @@ void FzPresolver::FirstPassModelScan(FzModel* model) {
 }
 
 bool FzPresolver::Run(FzModel* model) {
+  TimeLimit time_limit(time_limit_in_seconds_);
   FirstPassModelScan(model);
 
+  // The index is usually built by CleanUpModelForTheCpSolver(), and kept up to
+  // date since.
+  if (var_to_constraints_.empty()) {
+    BuildOccurrenceIndex(model);
+  }
+
   MergeIntEqNe(model);
 
   bool changed_since_start = false;
   // Let's presolve the bool2int predicates first.
   for (FzConstraint* const ct : model->constraints()) {
     if (ct->active && ct->type == "bool2int") {
-      changed_since_start |= PresolveBool2Int(ct);
+      changed_since_start |= RecordRule("PresolveBool2Int",
+                                        PresolveBool2Int(ct));
+    }
+  }
+  // Some new substitutions may have been introduced. Let's process them.
+  SubstituteInConstraints();
+
+  // Apply the rest of the presolve rules, until the worklist is empty. When a
+  // constraint is modified, the constraints sharing a variable with it, before
+  // or after the modification, are visited again.
+  for (FzConstraint* const ct : model->constraints()) {
+    Enqueue(ct);
+  }
+  std::vector<VariableState> old_states;
+  while (!worklist_.empty()) {
+    if (time_limit.LimitReached()) {
+      FZLOG << "  - presolve time limit reached, " << worklist_.size()
+            << " constraints left in the worklist" << FZENDL;
+      break;
     }
+    FzConstraint* const ct = worklist_.front();
+    worklist_.pop_front();
+    ct->presolve_queued = false;
+    if (!ct->active) continue;
+    ++num_constraint_visits_;
+    old_states.clear();
+    for (const FzArgument& arg : ct->arguments) {
+      for (FzIntegerVariable* const var : arg.variables) {
+        old_states.push_back(VariableState(var));
+      }
+    }
+    const int num_mappings = NumStoredMappings();
+    if (PresolveOneConstraint(ct)) {
+      changed_since_start = true;
+      EnqueueNeighbors(ct, old_states, NumStoredMappings() != num_mappings);
+    }
+    SubstituteInConstraints();
   }
+  for (FzConstraint* const ct : worklist_) {
+    ct->presolve_queued = false;
+  }
+  worklist_.clear();
+
   if (!var_representative_map_.empty()) {
-    // Some new substitutions were introduced. Let's process them.
+    // The constraints are already rewritten.
     SubstituteEverywhere(model);
     var_representative_map_.clear();
   }
+  LogStatistics();
+  return changed_since_start;
+}
 
-  // Apply the rest of the presolve rules.
-  for (;;) {
-    bool changed = false;
-    var_representative_map_.clear();
-    for (FzConstraint* const ct : model->constraints()) {
-      if (ct->active) {
-        changed |= PresolveOneConstraint(ct);
-      }
-      if (!var_representative_map_.empty()) {
-        break;
+bool FzPresolver::RecordRule(const char* rule, bool changed) {
+  if (changed) {
+    rule_applications_[rule]++;
+  }
+  return changed;
+}
+
+// ----- Worklist support -----
+
+void FzPresolver::BuildOccurrenceIndex(FzModel* model) {
+  var_to_constraints_.clear();
+  for (FzConstraint* const ct : model->constraints()) {
+    AddOccurrences(ct);
+  }
+}
+
+void FzPresolver::AddOccurrences(FzConstraint* ct) {
+  for (const FzArgument& arg : ct->arguments) {
+    for (FzIntegerVariable* const var : arg.variables) {
+      AddOccurrence(var, ct);
+    }
+  }
+}
+
+void FzPresolver::AddOccurrence(FzIntegerVariable* var, FzConstraint* ct) {
+  std::vector<FzConstraint*>* const constraints = &var_to_constraints_[var];
+  if (constraints->empty() || constraints->back() != ct) {
+    constraints->push_back(ct);
+  }
+}
+
+void FzPresolver::Enqueue(FzConstraint* ct) {
+  if (ct->active && !ct->presolve_queued) {
+    ct->presolve_queued = true;
+    worklist_.push_back(ct);
+  }
+}
+
+void FzPresolver::EnqueueConstraintsOf(const FzIntegerVariable* var) {
+  for (FzConstraint* const ct : var_to_constraints_[var]) {
+    Enqueue(ct);
+  }
+  const std::vector<FzIntegerVariable*>* const dependents =
+      FindOrNull(mapping_dependents_, var);
+  if (dependents != nullptr) {
+    for (FzIntegerVariable* const dependent : *dependents) {
+      for (FzConstraint* const ct : var_to_constraints_[dependent]) {
+        Enqueue(ct);
       }
     }
-    if (!var_representative_map_.empty()) {
-      // Some new substitutions were introduced. Let's process them.
-      DCHECK(changed);
-      changed = true;  // To be safe in opt mode.
-      SubstituteEverywhere(model);
-      var_representative_map_.clear();
+  }
+}
+
+void FzPresolver::EnqueueNeighbors(FzConstraint* ct,
+                                   const std::vector<VariableState>& old_states,
+                                   bool mappings_changed) {
+  for (const VariableState& old_state : old_states) {
+    if (mappings_changed || !(VariableState(old_state.variable) == old_state)) {
+      EnqueueConstraintsOf(old_state.variable);
+    }
+  }
+  // Most rules do not rewrite the variables of ct: only the variables that
+  // are not at the same position as before are registered. Their state before
+  // the rules is unknown, and their constraints are visited again.
+  int position = 0;
+  for (const FzArgument& arg : ct->arguments) {
+    for (FzIntegerVariable* const var : arg.variables) {
+      const bool is_new = position >= old_states.size() ||
+                          old_states[position].variable != var;
+      if (is_new) AddOccurrence(var, ct);
+      if (is_new || mappings_changed) EnqueueConstraintsOf(var);
+      ++position;
     }
-    changed_since_start |= changed;
-    if (!changed) break;
   }
-  return changed_since_start;
+  Enqueue(ct);
+}
+
+int FzPresolver::NumStoredMappings() const {
+  return abs_map_.size() + affine_map_.size() + flatten_map_.size();
+}
+
+FzPresolver::VariableState::VariableState(const FzIntegerVariable* var)
+    : variable(var),
+      defining_constraint(var->defining_constraint),
+      domain_min(var->domain.values.empty() ? 0 : var->domain.values.front()),
+      domain_max(var->domain.values.empty() ? 0 : var->domain.values.back()),
+      domain_size(var->domain.values.size()),
+      is_interval(var->domain.is_interval),
+      active(var->active) {}
+
+bool FzPresolver::VariableState::operator==(const VariableState& other) const {
+  return variable == other.variable &&
+         defining_constraint == other.defining_constraint &&
+         domain_min == other.domain_min && domain_max == other.domain_max &&
+         domain_size == other.domain_size && is_interval == other.is_interval &&
+         active == other.active;
+}
+
+void FzPresolver::LogStatistics() const {
+  int64 num_rule_applications = 0;
+  for (const auto& rule : rule_applications_) {
+    num_rule_applications += rule.second;
+  }
+  FZLOG << "  - " << num_constraint_visits_ << " constraint visits, "
+        << num_rule_applications << " rule applications" << FZENDL;
+  for (const auto& rule : rule_applications_) {
+    FZLOG << "    - " << rule.first << ": " << rule.second << FZENDL;
+  }
 }
 
 // ----- Substitution support -----
@@ -1726,6 +1897,7 @@ void FzPresolver::MarkVariablesAsEquivalent(FzIntegerVariable* from,
                     from->temporary));
     from->active = false;
     var_representative_map_[from] = to;
+    pending_substitutions_.push_back(from);
   }
 }
 
@@ -1749,11 +1921,12 @@ FzIntegerVariable* FzPresolver::FindRepresentativeOfVar(
   return FindWithDefault(var_representative_map_, var, var);
 }
 
-void FzPresolver::SubstituteEverywhere(FzModel* model) {
+void FzPresolver::SubstituteInConstraints() {
+  if (pending_substitutions_.empty()) return;
   // Collected impacted constraints.
   hash_set<FzConstraint*> impacted;
-  for (const auto& p : var_representative_map_) {
-    const hash_set<FzConstraint*>& contains = var_to_constraints_[p.first];
+  for (FzIntegerVariable* const var : pending_substitutions_) {
+    const std::vector<FzConstraint*>& contains = var_to_constraints_[var];
     impacted.insert(contains.begin(), contains.end());
   }
   // Rewrite the constraints.
@@ -1770,7 +1943,7 @@ void FzPresolver::SubstituteEverywhere(FzModel* model) {
                   FindRepresentativeOfVar(old_var);
               if (new_var != old_var) {
                 argument->variables[i] = new_var;
-                var_to_constraints_[new_var].insert(ct);
+                AddOccurrence(new_var, ct);
               }
             }
             break;
@@ -1781,8 +1954,23 @@ void FzPresolver::SubstituteEverywhere(FzModel* model) {
       // No need to update var_to_constraints, it should have been done already
       // in the arguments of the constraints.
       ct->target_variable = FindRepresentativeOfVar(ct->target_variable);
+      // The constraint now shares variables with new ones.
+      Enqueue(ct);
     }
   }
+  // Do not forget to merge domain that could have evolved asynchronously
+  // during presolve. The representatives may have been reduced by the merges:
+  // their constraints are visited again.
+  for (FzIntegerVariable* const var : pending_substitutions_) {
+    FzIntegerVariable* const representative = FindRepresentativeOfVar(var);
+    representative->domain.IntersectWithFzDomain(var->domain);
+    EnqueueConstraintsOf(representative);
+  }
+  pending_substitutions_.clear();
+}
+
+void FzPresolver::SubstituteEverywhere(FzModel* model) {
+  SubstituteInConstraints();
   // Rewrite the search.
   for (FzAnnotation* const ann : model->mutable_search_annotations()) {
     SubstituteAnnotation(ann);
@@ -1795,11 +1983,6 @@ void FzPresolver::SubstituteEverywhere(FzModel* model) {
           FindRepresentativeOfVar(output->flat_variables[i]);
     }
   }
-  // Do not forget to merge domain that could have evolved asynchronously
-  // during presolve.
-  for (const auto& iter : var_representative_map_) {
-    iter.second->domain.IntersectWithFzDomain(iter.first->domain);
-  }
 }
 
 void FzPresolver::SubstituteAnnotation(FzAnnotation* ann) {
@@ -1954,14 +2137,7 @@ void FzPresolver::CleanUpModelForTheCpSolver(FzModel* model, bool use_sat) {
   FzConstraint* start = nullptr;
   std::vector<FzIntegerVariable*> chain;
   std::vector<FzIntegerVariable*> carry_over;
-  var_to_constraints_.clear();
-  for (FzConstraint* const ct : model->constraints()) {
-    for (const FzArgument& arg : ct->arguments) {
-      for (FzIntegerVariable* const var : arg.variables) {
-        var_to_constraints_[var].insert(ct);
-      }
-    }
-  }
+  BuildOccurrenceIndex(model);
   for (FzConstraint* const ct : model->constraints()) {
     if (start == nullptr) {
       CheckRegroupStart(ct, &start, &chain, &carry_over);
@@ -1975,6 +2151,7 @@ void FzPresolver::CleanUpModelForTheCpSolver(FzModel* model, bool use_sat) {
       carry_over.back()->defining_constraint = nullptr;
     } else {
       Regroup(start, chain, carry_over);
+      AddOccurrences(start);
       // Clean
       start = nullptr;
       chain.clear();
@@ -1986,6 +2163,7 @@ void FzPresolver::CleanUpModelForTheCpSolver(FzModel* model, bool use_sat) {
   // Checks left over from the loop.
   if (start != nullptr) {
     Regroup(start, chain, carry_over);
+    AddOccurrences(start);
   }
 }
 }  // namespace operations_research
@@ -13,7 +13,11 @@
 #ifndef OR_TOOLS_FLATZINC_PRESOLVE_H_
 #define OR_TOOLS_FLATZINC_PRESOLVE_H_
 
+#include <deque>
+#include <limits>
+#include <map>
 #include <string>
+#include <vector>
 #include "base/hash.h"
 #include "base/integral_types.h"
 #include "base/logging.h"
@@ -23,8 +27,25 @@
 namespace operations_research {
 // The FzPresolver "pre-solves" a FzModel by applying some iterative
 // transformations to it, which may simplify and/or reduce the model.
+//
+// The rules are applied from a worklist of constraints: when a rule modifies
+// a constraint, only the constraints sharing a variable with it are visited
+// again, instead of the whole model. The variables are linked to their
+// constraints by an occurrence index, which is also used to substitute the
+// equivalent variables in the impacted constraints only.
 class FzPresolver {
  public:
+  FzPresolver()
+      : time_limit_in_seconds_(std::numeric_limits<double>::infinity()),
+        num_constraint_visits_(0) {}
+
+  // Limits the time spent in Run(). When the limit is reached, the rules are
+  // no longer applied, and the model is left in a valid, partially presolved,
+  // state.
+  void set_time_limit_in_seconds(double seconds) {
+    time_limit_in_seconds_ = seconds;
+  }
+
   // Recursively apply all the pre-solve rules to the model, until exhaustion.
   // The reduced model will:
   // - Have some unused variables
@@ -87,6 +108,22 @@ class FzPresolver {
           constraint(ct) {}
   };
 
+  // The state of a variable that the presolve rules read. The neighbors of a
+  // modified constraint are only visited again through the variables whose
+  // state changed.
+  struct VariableState {
+    explicit VariableState(const FzIntegerVariable* var);
+    bool operator==(const VariableState& other) const;
+
+    const FzIntegerVariable* variable;
+    const FzConstraint* defining_constraint;
+    int64 domain_min;
+    int64 domain_max;
+    int domain_size;
+    bool is_interval;
+    bool active;
+  };
+
   // First pass of model scanning. Useful to get information that will
   // prevent some destructive modifications of the model.
   void FirstPassModelScan(FzModel* model);
@@ -98,8 +135,31 @@ class FzPresolver {
   // Returns true iff the model was modified.
   bool PresolveOneConstraint(FzConstraint* ct);
 
+  // Counts the applications of a presolve rule, and returns changed.
+  bool RecordRule(const char* rule, bool changed);
+
+  // Worklist support.
+  void BuildOccurrenceIndex(FzModel* model);
+  void Enqueue(FzConstraint* ct);
+  // Adds ct to the constraints containing var, or all its variables.
+  void AddOccurrence(FzIntegerVariable* var, FzConstraint* ct);
+  void AddOccurrences(FzConstraint* ct);
+  void EnqueueConstraintsOf(const FzIntegerVariable* var);
+  // Enqueues ct and the constraints containing one of the variables whose
+  // state changed, or all the constraints sharing a variable with ct when
+  // some mappings were stored. Registers ct as containing the variables that
+  // it now refers to.
+  void EnqueueNeighbors(FzConstraint* ct,
+                        const std::vector<VariableState>& old_states,
+                        bool mappings_changed);
+  int NumStoredMappings() const;
+  void LogStatistics() const;
+
   // Substitution support.
   void SubstituteEverywhere(FzModel* model);
+  // Rewrites the constraints that contain the variables marked as equivalent
+  // since the last call, and enqueues them.
+  void SubstituteInConstraints();
   void SubstituteAnnotation(FzAnnotation* ann);
 
   // Presolve rules. They returns true iff that some presolve has been
@@ -155,6 +215,11 @@ class FzPresolver {
   // Stores flatten_map_[z] = a * x + y + b.
   hash_map<const FzIntegerVariable*, FlatteningMapping> flatten_map_;
 
+  // Stores the variables mapped on a variable in affine_map_ and flatten_map_.
+  // The presolve of their constraints depends on the domain of the variable.
+  hash_map<const FzIntegerVariable*, std::vector<FzIntegerVariable*>>
+      mapping_dependents_;
+
   // Stores x == (y - z).
   hash_map<const FzIntegerVariable*,
            std::pair<FzIntegerVariable*, FzIntegerVariable*> > difference_map_;
@@ -162,9 +227,23 @@ class FzPresolver {
   // Stores all variables defined in the search annotations.
   hash_set<FzIntegerVariable*> decision_variables_;
 
-  // Stores all constraints containing a variable.
-  hash_map<const FzIntegerVariable*,
-           hash_set<FzConstraint*>> var_to_constraints_;
+  // Stores all constraints containing a variable. A constraint can appear
+  // more than once in the list of a variable if it was rewritten by presolve.
+  hash_map<const FzIntegerVariable*, std::vector<FzConstraint*>>
+      var_to_constraints_;
+
+  // The variables marked as equivalent to another one, and not yet replaced in
+  // the constraints.
+  std::vector<FzIntegerVariable*> pending_substitutions_;
+
+  // The constraints to visit, each one at most once.
+  std::deque<FzConstraint*> worklist_;
+
+  double time_limit_in_seconds_;
+
+  // Statistics.
+  int64 num_constraint_visits_;
+  std::map<std::string, int64> rule_applications_;
 };
 }  // namespace operations_research
 
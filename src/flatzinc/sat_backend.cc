@@ -0,0 +1,1491 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "flatzinc/sat_backend.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/map_util.h"
+#include "base/stringprintf.h"
+#include "base/timer.h"
+#include "sat/sat_parameters.pb.h"
+#include "util/time_limit.h"
+
+DECLARE_bool(fz_logging);
+DECLARE_bool(fz_verbose);
+
+namespace operations_research {
+namespace {
+// Variables with more values are not encoded: they would need too many
+// order literals.
+const int64 kMaxDomainSize = 1 << 16;
+// Models whose encoding needs more sat variables are left to the cp
+// solver.
+const int kMaxNumSatVariables = 1 << 22;
+// Inferred bounds are only used if they are smaller than this in
+// magnitude, which also protects their computation against overflows.
+const int64 kMaxInferredBound = 1LL << 40;
+// Number of passes over the constraints to propagate inferred bounds.
+const int kMaxBoundsPasses = 10;
+// Maximum number of pairs of values enumerated for int_times, int_div
+// and int_mod.
+const int64 kMaxFunctionalPairs = 1 << 16;
+// Maximum number of values in a table constraint.
+const int64 kMaxTableSize = 1 << 20;
+// When running as a parallel worker, the search stops that often to
+// import the best objective of the other workers, and to check if it
+// should finish.
+const double kParallelSliceInSeconds = 0.1;
+
+bool IsSmall(int64 value) {
+  return value >= -kMaxInferredBound && value <= kMaxInferredBound;
+}
+}  // namespace
+
+FzSatBackend::FzSatBackend(const FzModel& model)
+    : model_(model),
+      objective_encoding_(-1),
+      num_extracted_constraints_(0),
+      extraction_time_in_ms_(0) {
+  sat_.SetNumVariables(1);
+  true_literal_ = sat::Literal(sat::VariableIndex(0), true);
+  sat_.AddUnitClause(true_literal_);
+}
+
+FzSatBackend::~FzSatBackend() {}
+
+// ----- Bounds -----
+
+bool FzSatBackend::Bounds(const FzIntegerVariable* var, int64* lb,
+                          int64* ub) const {
+  if (!var->IsAllInt64()) {
+    *lb = var->Min();
+    *ub = var->Max();
+    return true;
+  }
+  const std::pair<int64, int64>* const bounds =
+      FindOrNull(inferred_bounds_, var);
+  if (bounds == nullptr) {
+    return false;
+  }
+  *lb = bounds->first;
+  *ub = bounds->second;
+  return true;
+}
+
+bool FzSatBackend::ArgumentBounds(const FzArgument& arg, int64* lb,
+                                  int64* ub) const {
+  switch (arg.type) {
+    case FzArgument::INT_VALUE: {
+      *lb = arg.values[0];
+      *ub = arg.values[0];
+      return true;
+    }
+    case FzArgument::INT_VAR_REF: {
+      return Bounds(arg.variables[0], lb, ub) && IsSmall(*lb) && IsSmall(*ub);
+    }
+    default: { return false; }
+  }
+}
+
+bool FzSatBackend::ImpliedBounds(const FzConstraint* ct,
+                                 FzIntegerVariable** var, int64* lb,
+                                 int64* ub) const {
+  const std::string& type = ct->type;
+  int64 lb0 = 0;
+  int64 ub0 = 0;
+  int64 lb1 = 0;
+  int64 ub1 = 0;
+  if (type == "int_lin_eq") {
+    // Only sum(coefficients[i] * variables[i]) +/- x = rhs, with x
+    // unbounded, is used.
+    const std::vector<int64>& coefficients = ct->Arg(0).values;
+    const std::vector<FzIntegerVariable*>& variables = ct->Arg(1).variables;
+    if (coefficients.size() != variables.size() || !ct->Arg(2).HasOneValue()) {
+      return false;
+    }
+    int unbounded = -1;
+    int64 sum_lb = 0;
+    int64 sum_ub = 0;
+    for (int i = 0; i < variables.size(); ++i) {
+      if (!Bounds(variables[i], &lb0, &ub0)) {
+        if (unbounded != -1) {
+          return false;
+        }
+        unbounded = i;
+        continue;
+      }
+      const int64 coefficient = coefficients[i];
+      if (!IsSmall(lb0) || !IsSmall(ub0) || std::abs(coefficient) > (1 << 20)) {
+        return false;
+      }
+      sum_lb += coefficient > 0 ? coefficient * lb0 : coefficient * ub0;
+      sum_ub += coefficient > 0 ? coefficient * ub0 : coefficient * lb0;
+      if (!IsSmall(sum_lb) || !IsSmall(sum_ub)) {
+        return false;
+      }
+    }
+    if (unbounded == -1 || std::abs(coefficients[unbounded]) != 1) {
+      return false;
+    }
+    const int64 rhs = ct->Arg(2).Value();
+    *var = variables[unbounded];
+    if (coefficients[unbounded] == 1) {
+      *lb = rhs - sum_ub;
+      *ub = rhs - sum_lb;
+    } else {
+      *lb = sum_lb - rhs;
+      *ub = sum_ub - rhs;
+    }
+  } else if (type == "int_plus" || type == "int_minus" || type == "int_times" ||
+             type == "int_max" || type == "int_min") {
+    if (!ArgumentBounds(ct->Arg(0), &lb0, &ub0) ||
+        !ArgumentBounds(ct->Arg(1), &lb1, &ub1)) {
+      return false;
+    }
+    *var = ct->Arg(2).Var();
+    if (type == "int_plus") {
+      *lb = lb0 + lb1;
+      *ub = ub0 + ub1;
+    } else if (type == "int_minus") {
+      *lb = lb0 - ub1;
+      *ub = ub0 - lb1;
+    } else if (type == "int_times") {
+      if (std::max(std::abs(lb0), std::abs(ub0)) > (1 << 20) ||
+          std::max(std::abs(lb1), std::abs(ub1)) > (1 << 20)) {
+        return false;
+      }
+      *lb = std::min(std::min(lb0 * lb1, lb0 * ub1),
+                     std::min(ub0 * lb1, ub0 * ub1));
+      *ub = std::max(std::max(lb0 * lb1, lb0 * ub1),
+                     std::max(ub0 * lb1, ub0 * ub1));
+    } else {
+      *lb = std::min(lb0, lb1);
+      *ub = std::max(ub0, ub1);
+    }
+  } else if (type == "int_abs" || type == "int_negate") {
+    if (!ArgumentBounds(ct->Arg(0), &lb0, &ub0)) {
+      return false;
+    }
+    *var = ct->Arg(1).Var();
+    if (type == "int_abs") {
+      *lb = 0;
+      *ub = std::max(std::abs(lb0), std::abs(ub0));
+    } else {
+      *lb = -ub0;
+      *ub = -lb0;
+    }
+  } else if (type == "array_int_element") {
+    const std::vector<int64>& values = ct->Arg(1).values;
+    if (values.empty()) {
+      return false;
+    }
+    *var = ct->Arg(2).Var();
+    *lb = *std::min_element(values.begin(), values.end());
+    *ub = *std::max_element(values.begin(), values.end());
+  } else if (type == "array_var_int_element" || type == "maximum_int" ||
+             type == "minimum_int") {
+    const FzArgument& array = ct->Arg(1);
+    if (array.variables.empty()) {
+      return false;
+    }
+    *var = ct->Arg(type == "array_var_int_element" ? 2 : 0).Var();
+    *lb = kint64max;
+    *ub = kint64min;
+    for (FzIntegerVariable* const element : array.variables) {
+      if (!Bounds(element, &lb0, &ub0)) {
+        return false;
+      }
+      *lb = std::min(*lb, lb0);
+      *ub = std::max(*ub, ub0);
+    }
+  } else {
+    return false;
+  }
+  return *var != nullptr && IsSmall(*lb) && IsSmall(*ub) && *lb <= *ub;
+}
+
+void FzSatBackend::InferBounds() {
+  for (int pass = 0; pass < kMaxBoundsPasses; ++pass) {
+    bool changed = false;
+    for (FzConstraint* const ct : model_.constraints()) {
+      FzIntegerVariable* var = nullptr;
+      int64 lb = 0;
+      int64 ub = 0;
+      int64 current_lb = 0;
+      int64 current_ub = 0;
+      if (ct->active && ImpliedBounds(ct, &var, &lb, &ub) &&
+          !Bounds(var, &current_lb, &current_ub)) {
+        FZVLOG << "  - inferred bounds [" << lb << ".." << ub << "] for "
+               << var->DebugString() << FZENDL;
+        inferred_bounds_[var] = std::make_pair(lb, ub);
+        changed = true;
+      }
+    }
+    if (!changed) {
+      break;
+    }
+  }
+}
+
+bool FzSatBackend::DomainValues(const FzIntegerVariable* var,
+                                std::vector<int64>* values) const {
+  values->clear();
+  if (var->domain.is_interval) {
+    int64 lb = 0;
+    int64 ub = 0;
+    if (!Bounds(var, &lb, &ub) || !IsSmall(lb) || !IsSmall(ub) ||
+        ub - lb >= kMaxDomainSize) {
+      return false;
+    }
+    for (int64 value = lb; value <= ub; ++value) {
+      values->push_back(value);
+    }
+  } else {
+    if (var->domain.values.size() > kMaxDomainSize) {
+      return false;
+    }
+    *values = var->domain.values;
+    std::sort(values->begin(), values->end());
+    values->erase(std::unique(values->begin(), values->end()), values->end());
+  }
+  return true;
+}
+
+// ----- Encodings -----
+
+int FzSatBackend::Encode(FzIntegerVariable* var) {
+  const int* const found = FindOrNull(variable_to_encoding_, var);
+  if (found != nullptr) {
+    return *found;
+  }
+  std::vector<int64> values;
+  if (!DomainValues(var, &values)) {
+    FZLOG << "  - cannot encode " << var->DebugString() << FZENDL;
+    return -1;
+  }
+  const int encoding =
+      values.size() == 1 ? EncodeConstant(values[0]) : EncodeValues(values);
+  if (encoding != -1) {
+    variable_to_encoding_[var] = encoding;
+  }
+  return encoding;
+}
+
+int FzSatBackend::EncodeConstant(int64 value) {
+  const int* const found = FindOrNull(constant_to_encoding_, value);
+  if (found != nullptr) {
+    return *found;
+  }
+  IntegerEncoding encoding;
+  encoding.values.push_back(value);
+  encoding.first_order_variable = -1;
+  const int index = encodings_.size();
+  encodings_.push_back(encoding);
+  constant_to_encoding_[value] = index;
+  return index;
+}
+
+int FzSatBackend::EncodeValues(const std::vector<int64>& values) {
+  if (values.empty()) {
+    // Empty domain, the model is infeasible.
+    sat_.AddUnitClause(FalseLiteral());
+    return EncodeConstant(0);
+  }
+  if (values.size() == 1) {
+    return EncodeConstant(values[0]);
+  }
+  const int num_variables = sat_.NumVariables();
+  if (num_variables + values.size() > kMaxNumSatVariables) {
+    return -1;
+  }
+  IntegerEncoding encoding;
+  encoding.values = values;
+  encoding.first_order_variable = num_variables;
+  encoding.value_variables.assign(values.size(), -1);
+  sat_.SetNumVariables(num_variables + values.size() - 1);
+  // [x >= values[k]] implies [x >= values[k - 1]].
+  for (int k = 2; k < values.size(); ++k) {
+    AddImplication(encoding.OrderLiteral(k), encoding.OrderLiteral(k - 1));
+  }
+  const int index = encodings_.size();
+  encodings_.push_back(encoding);
+  return index;
+}
+
+int FzSatBackend::EncodeArgument(const FzArgument& arg) {
+  switch (arg.type) {
+    case FzArgument::INT_VALUE: { return EncodeConstant(arg.values[0]); }
+    case FzArgument::INT_VAR_REF: { return Encode(arg.variables[0]); }
+    default: { return -1; }
+  }
+}
+
+bool FzSatBackend::EncodeArray(const FzArgument& arg,
+                               std::vector<int>* encodings) {
+  encodings->clear();
+  switch (arg.type) {
+    case FzArgument::INT_LIST: {
+      for (const int64 value : arg.values) {
+        encodings->push_back(EncodeConstant(value));
+      }
+      return true;
+    }
+    case FzArgument::INT_VAR_REF_ARRAY: {
+      for (FzIntegerVariable* const var : arg.variables) {
+        const int encoding = Encode(var);
+        if (encoding == -1) {
+          return false;
+        }
+        encodings->push_back(encoding);
+      }
+      return true;
+    }
+    case FzArgument::VOID_ARGUMENT: { return true; }
+    default: { return false; }
+  }
+}
+
+bool FzSatBackend::FixedValues(const FzArgument& arg,
+                               std::vector<int64>* values) const {
+  values->clear();
+  switch (arg.type) {
+    case FzArgument::INT_LIST: {
+      *values = arg.values;
+      return true;
+    }
+    case FzArgument::INT_VAR_REF_ARRAY: {
+      for (FzIntegerVariable* const var : arg.variables) {
+        if (!var->HasOneValue()) {
+          return false;
+        }
+        values->push_back(var->Min());
+      }
+      return true;
+    }
+    case FzArgument::VOID_ARGUMENT: { return true; }
+    default: { return false; }
+  }
+}
+
+bool FzSatBackend::Contains(int encoding, int64 value) const {
+  const std::vector<int64>& values = encodings_[encoding].values;
+  return std::binary_search(values.begin(), values.end(), value);
+}
+
+// ----- Literals -----
+
+sat::Literal FzSatBackend::NewLiteral() {
+  const int num_variables = sat_.NumVariables();
+  sat_.SetNumVariables(num_variables + 1);
+  return sat::Literal(sat::VariableIndex(num_variables), true);
+}
+
+sat::Literal FzSatBackend::GreaterOrEqual(int encoding, int64 value) {
+  const IntegerEncoding& e = encodings_[encoding];
+  if (value <= e.values.front()) {
+    return TrueLiteral();
+  }
+  if (value > e.values.back()) {
+    return FalseLiteral();
+  }
+  const int k =
+      std::lower_bound(e.values.begin(), e.values.end(), value) -
+      e.values.begin();
+  return e.OrderLiteral(k);
+}
+
+sat::Literal FzSatBackend::LessOrEqual(int encoding, int64 value) {
+  if (value >= encodings_[encoding].values.back()) {
+    return TrueLiteral();
+  }
+  return GreaterOrEqual(encoding, value + 1).Negated();
+}
+
+sat::Literal FzSatBackend::Equal(int encoding, int64 value) {
+  IntegerEncoding* const e = &encodings_[encoding];
+  const std::vector<int64>::const_iterator it =
+      std::lower_bound(e->values.begin(), e->values.end(), value);
+  if (it == e->values.end() || *it != value) {
+    return FalseLiteral();
+  }
+  const int size = e->values.size();
+  const int k = it - e->values.begin();
+  if (size == 1) {
+    return TrueLiteral();
+  } else if (k == 0) {
+    return e->OrderLiteral(1).Negated();
+  } else if (k == size - 1) {
+    return e->OrderLiteral(k);
+  }
+  if (e->value_variables[k] == -1) {
+    // [x == v_k] <=> [x >= v_k] and not [x >= v_k+1].
+    const sat::Literal equal = NewLiteral();
+    const sat::Literal greater_or_equal = e->OrderLiteral(k);
+    const sat::Literal greater = e->OrderLiteral(k + 1);
+    AddImplication(equal, greater_or_equal);
+    AddImplication(equal, greater.Negated());
+    sat_.AddTernaryClause(greater_or_equal.Negated(), greater, equal);
+    e->value_variables[k] = equal.Variable().value();
+  }
+  return sat::Literal(sat::VariableIndex(e->value_variables[k]), true);
+}
+
+sat::Literal FzSatBackend::BooleanLiteral(int encoding) {
+  return GreaterOrEqual(encoding, 1);
+}
+
+// ----- Constraints -----
+
+void FzSatBackend::AddClause(const std::vector<sat::Literal>& literals) {
+  if (literals.empty()) {
+    sat_.AddUnitClause(FalseLiteral());
+  } else {
+    sat_.AddProblemClause(literals);
+  }
+}
+
+void FzSatBackend::AddImplication(sat::Literal a, sat::Literal b) {
+  sat_.AddBinaryClause(a.Negated(), b);
+}
+
+void FzSatBackend::AddTerms(int encoding, int64 coefficient,
+                            std::vector<sat::LiteralWithCoeff>* terms,
+                            int64* offset) {
+  const IntegerEncoding& e = encodings_[encoding];
+  *offset += coefficient * e.values[0];
+  if (coefficient == 0) {
+    return;
+  }
+  for (int k = 1; k < e.values.size(); ++k) {
+    terms->push_back(sat::LiteralWithCoeff(
+        e.OrderLiteral(k), coefficient * (e.values[k] - e.values[k - 1])));
+  }
+}
+
+void FzSatBackend::PostLinearLessOrEqual(
+    const std::vector<sat::LiteralWithCoeff>& terms, int64 offset,
+    int64 upper_bound, sat::Literal enforcement) {
+  const int64 rhs = upper_bound - offset;
+  int64 max_sum = 0;
+  for (const sat::LiteralWithCoeff& term : terms) {
+    max_sum += std::max<int64>(term.coefficient.value(), 0);
+  }
+  if (max_sum <= rhs) {
+    return;
+  }
+  if (terms.empty()) {
+    sat_.AddUnitClause(enforcement.Negated());
+    return;
+  }
+  std::vector<sat::LiteralWithCoeff> constraint(terms);
+  if (enforcement == TrueLiteral()) {
+    sat_.AddLinearConstraint(false, sat::Coefficient(0), true,
+                             sat::Coefficient(rhs), &constraint);
+  } else {
+    // sum(terms) + (max_sum - rhs) * enforcement <= max_sum is trivially
+    // true when enforcement is false, and sum(terms) <= rhs otherwise.
+    constraint.push_back(sat::LiteralWithCoeff(enforcement, max_sum - rhs));
+    sat_.AddLinearConstraint(false, sat::Coefficient(0), true,
+                             sat::Coefficient(max_sum), &constraint);
+  }
+}
+
+void FzSatBackend::PostLinearRelation(
+    Relation relation, const std::vector<sat::LiteralWithCoeff>& terms,
+    int64 offset, int64 rhs, sat::Literal enforcement) {
+  std::vector<sat::LiteralWithCoeff> negated_terms;
+  if (relation == GE || relation == GT || relation == EQ) {
+    for (const sat::LiteralWithCoeff& term : terms) {
+      negated_terms.push_back(
+          sat::LiteralWithCoeff(term.literal, -term.coefficient.value()));
+    }
+  }
+  switch (relation) {
+    case EQ: {
+      PostLinearLessOrEqual(terms, offset, rhs, enforcement);
+      PostLinearLessOrEqual(negated_terms, -offset, -rhs, enforcement);
+      break;
+    }
+    case NE: {
+      // Either smaller or greater.
+      const sat::Literal smaller = NewLiteral();
+      const sat::Literal greater = NewLiteral();
+      sat_.AddTernaryClause(enforcement.Negated(), smaller, greater);
+      PostLinearRelation(LT, terms, offset, rhs, smaller);
+      PostLinearRelation(GT, terms, offset, rhs, greater);
+      break;
+    }
+    case LE: {
+      PostLinearLessOrEqual(terms, offset, rhs, enforcement);
+      break;
+    }
+    case LT: {
+      PostLinearLessOrEqual(terms, offset, rhs - 1, enforcement);
+      break;
+    }
+    case GE: {
+      PostLinearLessOrEqual(negated_terms, -offset, -rhs, enforcement);
+      break;
+    }
+    case GT: {
+      PostLinearLessOrEqual(negated_terms, -offset, -rhs - 1, enforcement);
+      break;
+    }
+  }
+}
+
+void FzSatBackend::PostLessOrEqual(int x, int y, int64 offset,
+                                   sat::Literal enforcement) {
+  // [x >= v] implies [y >= v - offset], for all values v of x.
+  const std::vector<int64> values = encodings_[x].values;
+  for (const int64 value : values) {
+    sat_.AddTernaryClause(enforcement.Negated(),
+                          GreaterOrEqual(x, value).Negated(),
+                          GreaterOrEqual(y, value - offset));
+  }
+}
+
+void FzSatBackend::PostNotEqual(int x, int y, sat::Literal enforcement) {
+  const std::vector<int64> values = encodings_[x].values;
+  for (const int64 value : values) {
+    if (Contains(y, value)) {
+      sat_.AddTernaryClause(enforcement.Negated(), Equal(x, value).Negated(),
+                            Equal(y, value).Negated());
+    }
+  }
+}
+
+void FzSatBackend::PostRelation(Relation relation, int x, int y,
+                                sat::Literal enforcement) {
+  switch (relation) {
+    case EQ: {
+      PostLessOrEqual(x, y, 0, enforcement);
+      PostLessOrEqual(y, x, 0, enforcement);
+      break;
+    }
+    case NE: {
+      PostNotEqual(x, y, enforcement);
+      break;
+    }
+    case LE: {
+      PostLessOrEqual(x, y, 0, enforcement);
+      break;
+    }
+    case LT: {
+      PostLessOrEqual(x, y, -1, enforcement);
+      break;
+    }
+    case GE: {
+      PostLessOrEqual(y, x, 0, enforcement);
+      break;
+    }
+    case GT: {
+      PostLessOrEqual(y, x, -1, enforcement);
+      break;
+    }
+  }
+}
+
+void FzSatBackend::PostMaximum(int target, const std::vector<int>& encodings) {
+  for (const int encoding : encodings) {
+    PostLessOrEqual(encoding, target, 0, TrueLiteral());
+  }
+  // [target >= v] implies that one of the [x_i >= v] holds.
+  const std::vector<int64> values = encodings_[target].values;
+  for (const int64 value : values) {
+    std::vector<sat::Literal> clause(1, GreaterOrEqual(target, value).Negated());
+    for (const int encoding : encodings) {
+      clause.push_back(GreaterOrEqual(encoding, value));
+    }
+    AddClause(clause);
+  }
+}
+
+void FzSatBackend::PostMinimum(int target, const std::vector<int>& encodings) {
+  for (const int encoding : encodings) {
+    PostLessOrEqual(target, encoding, 0, TrueLiteral());
+  }
+  const std::vector<int64> values = encodings_[target].values;
+  for (const int64 value : values) {
+    std::vector<sat::Literal> clause(1, LessOrEqual(target, value).Negated());
+    for (const int encoding : encodings) {
+      clause.push_back(LessOrEqual(encoding, value));
+    }
+    AddClause(clause);
+  }
+}
+
+bool FzSatBackend::PostFunctional(const std::string& type, int x, int y,
+                                  int z) {
+  const std::vector<int64> x_values = encodings_[x].values;
+  const std::vector<int64> y_values = encodings_[y].values;
+  if (static_cast<int64>(x_values.size()) * y_values.size() >
+      kMaxFunctionalPairs) {
+    return false;
+  }
+  for (const int64 a : x_values) {
+    for (const int64 b : y_values) {
+      const sat::Literal not_a = Equal(x, a).Negated();
+      const sat::Literal not_b = Equal(y, b).Negated();
+      if (type == "int_times") {
+        if (std::abs(static_cast<double>(a) * b) < kMaxInferredBound) {
+          sat_.AddTernaryClause(not_a, not_b, Equal(z, a * b));
+        } else {
+          sat_.AddBinaryClause(not_a, not_b);
+        }
+      } else if (b == 0) {
+        sat_.AddBinaryClause(not_a, not_b);
+      } else if (type == "int_div") {
+        sat_.AddTernaryClause(not_a, not_b, Equal(z, a / b));
+      } else {
+        sat_.AddTernaryClause(not_a, not_b, Equal(z, a % b));
+      }
+    }
+  }
+  return true;
+}
+
+bool FzSatBackend::PostTable(const std::vector<int>& encodings,
+                             const std::vector<int64>& tuples) {
+  const int arity = encodings.size();
+  if (arity == 0 || tuples.size() > kMaxTableSize) {
+    return false;
+  }
+  // One literal per tuple compatible with the domains, which implies the
+  // values of the tuple. Each value is supported by the literals of the
+  // tuples that contain it.
+  std::vector<sat::Literal> tuple_literals;
+  std::vector<std::map<int64, std::vector<sat::Literal> > > supports(arity);
+  for (int start = 0; start + arity <= tuples.size(); start += arity) {
+    bool valid = true;
+    for (int i = 0; i < arity; ++i) {
+      if (!Contains(encodings[i], tuples[start + i])) {
+        valid = false;
+        break;
+      }
+    }
+    if (!valid) {
+      continue;
+    }
+    const sat::Literal tuple_literal = NewLiteral();
+    for (int i = 0; i < arity; ++i) {
+      const int64 value = tuples[start + i];
+      AddImplication(tuple_literal, Equal(encodings[i], value));
+      supports[i][value].push_back(tuple_literal);
+    }
+    tuple_literals.push_back(tuple_literal);
+  }
+  AddClause(tuple_literals);
+  for (int i = 0; i < arity; ++i) {
+    const std::vector<int64> values = encodings_[encodings[i]].values;
+    for (const int64 value : values) {
+      std::vector<sat::Literal> clause(1,
+                                       Equal(encodings[i], value).Negated());
+      const std::vector<sat::Literal>* const support =
+          FindOrNull(supports[i], value);
+      if (support != nullptr) {
+        clause.insert(clause.end(), support->begin(), support->end());
+      }
+      AddClause(clause);
+    }
+  }
+  return true;
+}
+
+void FzSatBackend::PostAtMostOneValue(const std::vector<int>& encodings,
+                                      bool except_zero) {
+  std::map<int64, std::vector<int> > encodings_per_value;
+  for (const int encoding : encodings) {
+    for (const int64 value : encodings_[encoding].values) {
+      if (!except_zero || value != 0) {
+        encodings_per_value[value].push_back(encoding);
+      }
+    }
+  }
+  for (const auto& it : encodings_per_value) {
+    if (it.second.size() < 2) {
+      continue;
+    }
+    std::vector<sat::LiteralWithCoeff> terms;
+    for (const int encoding : it.second) {
+      terms.push_back(sat::LiteralWithCoeff(Equal(encoding, it.first), 1));
+    }
+    sat_.AddLinearConstraint(false, sat::Coefficient(0), true,
+                             sat::Coefficient(1), &terms);
+  }
+}
+
+bool FzSatBackend::PostCumulative(const FzConstraint* ct) {
+  std::vector<int> starts;
+  std::vector<int64> durations;
+  std::vector<int64> demands;
+  if (!EncodeArray(ct->Arg(0), &starts) ||
+      !FixedValues(ct->Arg(1), &durations) ||
+      !FixedValues(ct->Arg(2), &demands) || !ct->Arg(3).HasOneValue() ||
+      durations.size() != starts.size() || demands.size() != starts.size()) {
+    return false;
+  }
+  const int64 capacity = ct->Arg(3).Value();
+  // The resource usage only increases at a start time, so it is enough
+  // to check it at the possible start times.
+  std::set<int64> times;
+  std::vector<int> tasks;
+  for (int i = 0; i < starts.size(); ++i) {
+    if (durations[i] > 0 && demands[i] > 0) {
+      tasks.push_back(i);
+      const std::vector<int64>& values = encodings_[starts[i]].values;
+      times.insert(values.begin(), values.end());
+    }
+  }
+  for (const int64 time : times) {
+    // A task can run at 'time' if it can start in [time - duration + 1,
+    // time].
+    std::vector<int> running;
+    int64 max_usage = 0;
+    for (const int i : tasks) {
+      const std::vector<int64>& values = encodings_[starts[i]].values;
+      const std::vector<int64>::const_iterator it = std::lower_bound(
+          values.begin(), values.end(), time - durations[i] + 1);
+      if (it != values.end() && *it <= time) {
+        running.push_back(i);
+        max_usage += demands[i];
+      }
+    }
+    if (max_usage <= capacity) {
+      continue;
+    }
+    std::vector<sat::LiteralWithCoeff> terms;
+    for (const int i : running) {
+      const sat::Literal started =
+          GreaterOrEqual(starts[i], time - durations[i] + 1);
+      const sat::Literal not_finished = LessOrEqual(starts[i], time);
+      sat::Literal runs = TrueLiteral();
+      if (started != TrueLiteral() || not_finished != TrueLiteral()) {
+        runs = NewLiteral();
+        sat_.AddTernaryClause(started.Negated(), not_finished.Negated(), runs);
+      }
+      terms.push_back(sat::LiteralWithCoeff(runs, demands[i]));
+    }
+    sat_.AddLinearConstraint(false, sat::Coefficient(0), true,
+                             sat::Coefficient(capacity), &terms);
+    if (sat_.NumVariables() > kMaxNumSatVariables) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool FzSatBackend::ParseComparison(const std::string& type, Relation* relation,
+                                   bool* is_linear, bool* is_reified) {
+  std::string name;
+  if (type.compare(0, 4, "int_") == 0) {
+    name = type.substr(4);
+  } else if (type.compare(0, 5, "bool_") == 0) {
+    name = type.substr(5);
+  } else {
+    return false;
+  }
+  *is_linear = name.compare(0, 4, "lin_") == 0;
+  if (*is_linear) {
+    name = name.substr(4);
+  }
+  *is_reified = name.size() > 5 && name.compare(name.size() - 5, 5, "_reif") == 0;
+  if (*is_reified) {
+    name.resize(name.size() - 5);
+  }
+  if (name == "eq") {
+    *relation = EQ;
+  } else if (name == "ne") {
+    *relation = NE;
+  } else if (name == "le") {
+    *relation = LE;
+  } else if (name == "lt") {
+    *relation = LT;
+  } else if (name == "ge") {
+    *relation = GE;
+  } else if (name == "gt") {
+    *relation = GT;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+FzSatBackend::Relation FzSatBackend::Negation(Relation relation) {
+  switch (relation) {
+    case EQ: { return NE; }
+    case NE: { return EQ; }
+    case LE: { return GT; }
+    case LT: { return GE; }
+    case GE: { return LT; }
+    case GT: { return LE; }
+  }
+  return EQ;
+}
+
+bool FzSatBackend::ExtractLinear(const FzConstraint* ct, Relation relation,
+                                 sat::Literal enforcement) {
+  const std::vector<int64>& coefficients = ct->Arg(0).values;
+  std::vector<int> encodings;
+  if (!EncodeArray(ct->Arg(1), &encodings) ||
+      encodings.size() != coefficients.size()) {
+    return false;
+  }
+  std::vector<sat::LiteralWithCoeff> terms;
+  int64 offset = 0;
+  for (int i = 0; i < encodings.size(); ++i) {
+    AddTerms(encodings[i], coefficients[i], &terms, &offset);
+  }
+  int64 rhs = 0;
+  if (ct->Arg(2).HasOneValue()) {
+    rhs = ct->Arg(2).Value();
+  } else {
+    const int encoding = EncodeArgument(ct->Arg(2));
+    if (encoding == -1) {
+      return false;
+    }
+    AddTerms(encoding, -1, &terms, &offset);
+  }
+  PostLinearRelation(relation, terms, offset, rhs, enforcement);
+  return true;
+}
+
+bool FzSatBackend::ExtractConstraint(const FzConstraint* ct) {
+  const std::string& type = ct->type;
+  // Encodes the arguments of the constraint, in order. Their meaning
+  // depends on the constraint.
+  std::vector<int> args;
+  std::vector<std::vector<int> > arrays;
+  for (const FzArgument& arg : ct->arguments) {
+    if (arg.type == FzArgument::INT_VALUE ||
+        arg.type == FzArgument::INT_VAR_REF) {
+      args.push_back(EncodeArgument(arg));
+      if (args.back() == -1) {
+        return false;
+      }
+      arrays.push_back(std::vector<int>());
+    } else {
+      args.push_back(-1);
+      arrays.push_back(std::vector<int>());
+      if ((arg.type == FzArgument::INT_VAR_REF_ARRAY ||
+           arg.type == FzArgument::INT_LIST) &&
+          !EncodeArray(arg, &arrays.back())) {
+        return false;
+      }
+    }
+  }
+
+  Relation relation = EQ;
+  bool is_linear = false;
+  bool is_reified = false;
+  if (ParseComparison(type, &relation, &is_linear, &is_reified)) {
+    sat::Literal enforcement = TrueLiteral();
+    if (is_reified) {
+      const int target = args[is_linear ? 3 : 2];
+      if (target == -1) {
+        return false;
+      }
+      enforcement = BooleanLiteral(target);
+    }
+    if (is_linear) {
+      return ExtractLinear(ct, relation, enforcement) &&
+             (!is_reified ||
+              ExtractLinear(ct, Negation(relation), enforcement.Negated()));
+    }
+    if (args[0] == -1 || args[1] == -1) {
+      return false;
+    }
+    PostRelation(relation, args[0], args[1], enforcement);
+    if (is_reified) {
+      PostRelation(Negation(relation), args[0], args[1],
+                   enforcement.Negated());
+    }
+  } else if (type == "bool2int" || type == "bool_not") {
+    PostRelation(type == "bool2int" ? EQ : NE, args[0], args[1],
+                 TrueLiteral());
+  } else if (type == "bool_and" || type == "bool_or") {
+    const sat::Literal a = BooleanLiteral(args[0]);
+    const sat::Literal b = BooleanLiteral(args[1]);
+    const sat::Literal target = BooleanLiteral(args[2]);
+    if (type == "bool_and") {
+      AddImplication(target, a);
+      AddImplication(target, b);
+      sat_.AddTernaryClause(a.Negated(), b.Negated(), target);
+    } else {
+      AddImplication(a, target);
+      AddImplication(b, target);
+      sat_.AddTernaryClause(a, b, target.Negated());
+    }
+  } else if (type == "bool_xor") {
+    if (ct->arguments.size() == 2) {
+      PostRelation(NE, args[0], args[1], TrueLiteral());
+    } else {
+      const sat::Literal target = BooleanLiteral(args[2]);
+      PostRelation(NE, args[0], args[1], target);
+      PostRelation(EQ, args[0], args[1], target.Negated());
+    }
+  } else if (type == "bool_left_imp" || type == "bool_right_imp") {
+    // bool_left_imp(a, b, r) is r <=> (b -> a) <=> a >= b.
+    const Relation implication = type == "bool_left_imp" ? GE : LE;
+    const sat::Literal target = BooleanLiteral(args[2]);
+    PostRelation(implication, args[0], args[1], target);
+    PostRelation(Negation(implication), args[0], args[1], target.Negated());
+  } else if (type == "array_bool_and" || type == "array_bool_or") {
+    const bool is_and = type == "array_bool_and";
+    const sat::Literal target = BooleanLiteral(args[1]);
+    // For the and, not(target) <=> or(not(literals)).
+    const sat::Literal result = is_and ? target.Negated() : target;
+    std::vector<sat::Literal> clause(1, result.Negated());
+    for (const int encoding : arrays[0]) {
+      const sat::Literal literal =
+          is_and ? BooleanLiteral(encoding).Negated() : BooleanLiteral(encoding);
+      AddImplication(literal, result);
+      clause.push_back(literal);
+    }
+    AddClause(clause);
+  } else if (type == "array_bool_xor") {
+    // Chains the parities of the prefixes of the array.
+    sat::Literal parity = FalseLiteral();
+    for (const int encoding : arrays[0]) {
+      const sat::Literal literal = BooleanLiteral(encoding);
+      const sat::Literal next = NewLiteral();
+      sat_.AddTernaryClause(next.Negated(), parity, literal);
+      sat_.AddTernaryClause(next.Negated(), parity.Negated(),
+                            literal.Negated());
+      sat_.AddTernaryClause(next, parity.Negated(), literal);
+      sat_.AddTernaryClause(next, parity, literal.Negated());
+      parity = next;
+    }
+    sat_.AddUnitClause(parity);
+  } else if (type == "bool_clause") {
+    std::vector<sat::Literal> clause;
+    for (const int encoding : arrays[0]) {
+      clause.push_back(BooleanLiteral(encoding));
+    }
+    for (const int encoding : arrays[1]) {
+      clause.push_back(BooleanLiteral(encoding).Negated());
+    }
+    AddClause(clause);
+  } else if (type == "set_in" || type == "int_in" || type == "set_in_reif") {
+    const int x = args[0];
+    const FzArgument& set = ct->Arg(1);
+    const sat::Literal target =
+        type == "set_in_reif" ? BooleanLiteral(args[2]) : TrueLiteral();
+    if (set.type == FzArgument::INT_INTERVAL) {
+      const sat::Literal above = GreaterOrEqual(x, set.values[0]);
+      const sat::Literal below = LessOrEqual(x, set.values[1]);
+      AddImplication(target, above);
+      AddImplication(target, below);
+      sat_.AddTernaryClause(above.Negated(), below.Negated(), target);
+    } else if (set.type == FzArgument::INT_LIST ||
+               set.type == FzArgument::INT_VALUE) {
+      std::vector<sat::Literal> clause(1, target.Negated());
+      for (const int64 value : set.values) {
+        const sat::Literal member = Equal(x, value);
+        AddImplication(member, target);
+        clause.push_back(member);
+      }
+      AddClause(clause);
+    } else {
+      return false;
+    }
+  } else if (type == "array_int_element" || type == "array_bool_element") {
+    std::vector<int64> values;
+    if (!FixedValues(ct->Arg(1), &values) || args[0] == -1 || args[2] == -1) {
+      return false;
+    }
+    const int index = args[0];
+    const int target = args[2];
+    sat_.AddUnitClause(GreaterOrEqual(index, 1));
+    sat_.AddUnitClause(LessOrEqual(index, values.size()));
+    const std::vector<int64> indices = encodings_[index].values;
+    for (const int64 i : indices) {
+      if (i >= 1 && i <= values.size()) {
+        AddImplication(Equal(index, i), Equal(target, values[i - 1]));
+      }
+    }
+    // Each value of the target is supported by the indices of its
+    // occurrences.
+    const std::vector<int64> target_values = encodings_[target].values;
+    for (const int64 value : target_values) {
+      std::vector<sat::Literal> clause(1, Equal(target, value).Negated());
+      for (const int64 i : indices) {
+        if (i >= 1 && i <= values.size() && values[i - 1] == value) {
+          clause.push_back(Equal(index, i));
+        }
+      }
+      AddClause(clause);
+    }
+  } else if (type == "array_var_int_element" ||
+             type == "array_var_bool_element") {
+    const std::vector<int>& encodings = arrays[1];
+    const int index = args[0];
+    const int target = args[2];
+    if (index == -1 || target == -1) {
+      return false;
+    }
+    sat_.AddUnitClause(GreaterOrEqual(index, 1));
+    sat_.AddUnitClause(LessOrEqual(index, encodings.size()));
+    const std::vector<int64> indices = encodings_[index].values;
+    for (const int64 i : indices) {
+      if (i >= 1 && i <= encodings.size()) {
+        PostRelation(EQ, target, encodings[i - 1], Equal(index, i));
+      }
+    }
+  } else if (type == "int_max" || type == "int_min") {
+    std::vector<int> encodings;
+    encodings.push_back(args[0]);
+    encodings.push_back(args[1]);
+    if (type == "int_max") {
+      PostMaximum(args[2], encodings);
+    } else {
+      PostMinimum(args[2], encodings);
+    }
+  } else if (type == "maximum_int" || type == "minimum_int") {
+    if (args[0] == -1 || arrays[1].empty()) {
+      return false;
+    }
+    if (type == "maximum_int") {
+      PostMaximum(args[0], arrays[1]);
+    } else {
+      PostMinimum(args[0], arrays[1]);
+    }
+  } else if (type == "int_plus" || type == "int_minus" ||
+             type == "int_negate") {
+    std::vector<sat::LiteralWithCoeff> terms;
+    int64 offset = 0;
+    if (type == "int_negate") {
+      AddTerms(args[0], 1, &terms, &offset);
+      AddTerms(args[1], 1, &terms, &offset);
+    } else {
+      AddTerms(args[0], 1, &terms, &offset);
+      AddTerms(args[1], type == "int_plus" ? 1 : -1, &terms, &offset);
+      AddTerms(args[2], -1, &terms, &offset);
+    }
+    PostLinearRelation(EQ, terms, offset, 0, TrueLiteral());
+  } else if (type == "int_times" || type == "int_div" || type == "int_mod") {
+    return PostFunctional(type, args[0], args[1], args[2]);
+  } else if (type == "int_abs") {
+    const int x = args[0];
+    const int target = args[1];
+    const std::vector<int64> values = encodings_[x].values;
+    for (const int64 value : values) {
+      AddImplication(Equal(x, value), Equal(target, std::abs(value)));
+    }
+  } else if (type == "all_different_int" || type == "alldifferent_except_0") {
+    PostAtMostOneValue(arrays[0], type == "alldifferent_except_0");
+  } else if (type == "table_int" || type == "table_bool") {
+    std::vector<int64> tuples;
+    return FixedValues(ct->Arg(1), &tuples) && PostTable(arrays[0], tuples);
+  } else if (type == "cumulative" || type == "var_cumulative" ||
+             type == "variable_cumulative" || type == "fixed_cumulative") {
+    return PostCumulative(ct);
+  } else if (type == "count_eq" || type == "count") {
+    if (!ct->Arg(1).HasOneValue() || args[2] == -1) {
+      return false;
+    }
+    const int64 value = ct->Arg(1).Value();
+    std::vector<sat::LiteralWithCoeff> terms;
+    int64 offset = 0;
+    for (const int encoding : arrays[0]) {
+      terms.push_back(sat::LiteralWithCoeff(Equal(encoding, value), 1));
+    }
+    AddTerms(args[2], -1, &terms, &offset);
+    PostLinearRelation(EQ, terms, offset, 0, TrueLiteral());
+  } else if (type == "global_cardinality" ||
+             type == "global_cardinality_closed" ||
+             type == "global_cardinality_low_up" ||
+             type == "global_cardinality_low_up_closed") {
+    const bool low_up = type.find("low_up") != std::string::npos;
+    const bool closed = type.find("closed") != std::string::npos;
+    const std::vector<int>& encodings = arrays[0];
+    const std::vector<int64>& cover = ct->Arg(1).values;
+    std::vector<int64> low;
+    std::vector<int64> up;
+    if (low_up && (!FixedValues(ct->Arg(2), &low) ||
+                   !FixedValues(ct->Arg(3), &up))) {
+      return false;
+    }
+    for (int j = 0; j < cover.size(); ++j) {
+      std::vector<sat::LiteralWithCoeff> terms;
+      int64 offset = 0;
+      for (const int encoding : encodings) {
+        terms.push_back(sat::LiteralWithCoeff(Equal(encoding, cover[j]), 1));
+      }
+      if (low_up) {
+        PostLinearRelation(GE, terms, offset, low[j], TrueLiteral());
+        PostLinearRelation(LE, terms, offset, up[j], TrueLiteral());
+      } else {
+        if (j >= arrays[2].size()) {
+          return false;
+        }
+        AddTerms(arrays[2][j], -1, &terms, &offset);
+        PostLinearRelation(EQ, terms, offset, 0, TrueLiteral());
+      }
+    }
+    if (closed) {
+      for (const int encoding : encodings) {
+        std::vector<sat::Literal> clause;
+        for (const int64 value : cover) {
+          clause.push_back(Equal(encoding, value));
+        }
+        AddClause(clause);
+      }
+    }
+  } else if (type == "true_constraint") {
+    // Nothing to do.
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool FzSatBackend::Extract() {
+  WallTimer timer;
+  timer.Start();
+  InferBounds();
+  if (model_.objective() != nullptr) {
+    objective_encoding_ = Encode(model_.objective());
+    if (objective_encoding_ == -1) {
+      return false;
+    }
+  }
+  for (FzConstraint* const ct : model_.constraints()) {
+    if (!ct->active) {
+      continue;
+    }
+    if (sat_.IsModelUnsat()) {
+      FZLOG << "  - model found infeasible during encoding" << FZENDL;
+      break;
+    }
+    FZVLOG << "Encode " << ct->DebugString() << FZENDL;
+    if (!ExtractConstraint(ct)) {
+      FZLOG << "  - cannot encode " << ct->DebugString() << FZENDL;
+      return false;
+    }
+    if (sat_.NumVariables() > kMaxNumSatVariables) {
+      FZLOG << "  - encoding too large" << FZENDL;
+      return false;
+    }
+    num_extracted_constraints_++;
+  }
+  // The variables not used by any constraint still need a value in the
+  // solutions, and an empty domain makes the model infeasible.
+  for (FzIntegerVariable* const var : model_.variables()) {
+    if (var->active && Encode(var) == -1) {
+      return false;
+    }
+  }
+  for (const FzOnSolutionOutput& output : model_.output()) {
+    if (output.variable != nullptr && Encode(output.variable) == -1) {
+      return false;
+    }
+    for (FzIntegerVariable* const var : output.flat_variables) {
+      if (Encode(var) == -1) {
+        return false;
+      }
+    }
+  }
+  if (sat_.NumVariables() > kMaxNumSatVariables) {
+    FZLOG << "  - encoding too large" << FZENDL;
+    return false;
+  }
+  extraction_time_in_ms_ = timer.GetInMs();
+  FZLOG << "Model encoded with " << sat_.NumVariables()
+        << " Boolean variables in " << extraction_time_in_ms_ << " ms"
+        << FZENDL;
+  return true;
+}
+
+// ----- Search -----
+
+void FzSatBackend::StoreSolution() {
+  const sat::VariablesAssignment& assignment = sat_.Assignment();
+  solution_.resize(encodings_.size());
+  for (int i = 0; i < encodings_.size(); ++i) {
+    const IntegerEncoding& e = encodings_[i];
+    // Finds the last true order literal by dichotomy.
+    int low = 0;
+    int high = e.values.size() - 1;
+    while (low < high) {
+      const int middle = (low + high + 1) / 2;
+      if (assignment.IsLiteralTrue(e.OrderLiteral(middle))) {
+        low = middle;
+      } else {
+        high = middle - 1;
+      }
+    }
+    solution_[i] = e.values[low];
+  }
+}
+
+void FzSatBackend::ConstrainObjective(int64 value) {
+  sat_.Backtrack(0);
+  sat_.AddUnitClause(model_.maximize()
+                         ? GreaterOrEqual(objective_encoding_, value + 1)
+                         : LessOrEqual(objective_encoding_, value - 1));
+}
+
+void FzSatBackend::BlockSolution() {
+  sat_.Backtrack(0);
+  std::set<int> blocked;
+  for (const FzOnSolutionOutput& output : model_.output()) {
+    if (output.variable != nullptr) {
+      const int* const encoding =
+          FindOrNull(variable_to_encoding_, output.variable);
+      if (encoding != nullptr) {
+        blocked.insert(*encoding);
+      }
+    }
+    for (FzIntegerVariable* const var : output.flat_variables) {
+      const int* const encoding = FindOrNull(variable_to_encoding_, var);
+      if (encoding != nullptr) {
+        blocked.insert(*encoding);
+      }
+    }
+  }
+  if (model_.output().empty()) {
+    for (const auto& it : variable_to_encoding_) {
+      blocked.insert(it.second);
+    }
+  }
+  std::vector<sat::Literal> clause;
+  for (const int encoding : blocked) {
+    if (encodings_[encoding].values.size() > 1) {
+      clause.push_back(Equal(encoding, solution_[encoding]).Negated());
+    }
+  }
+  AddClause(clause);
+}
+
+int64 FzSatBackend::SolutionValue(FzIntegerVariable* var) const {
+  const int* const encoding = FindOrNull(variable_to_encoding_, var);
+  CHECK(encoding != nullptr) << "Variable not encoded: " << var->DebugString();
+  return solution_[*encoding];
+}
+
+// The format is fixed in the flatzinc specification.
+std::string FzSatBackend::SolutionString(
+    const FzOnSolutionOutput& output) const {
+  if (output.variable != nullptr) {
+    const int64 value = SolutionValue(output.variable);
+    if (output.is_boolean) {
+      return StringPrintf("%s = %s;", output.name.c_str(),
+                          value == 1 ? "true" : "false");
+    } else {
+      return StringPrintf("%s = %" GG_LL_FORMAT "d;", output.name.c_str(),
+                          value);
+    }
+  }
+  const int bound_size = output.bounds.size();
+  std::string result =
+      StringPrintf("%s = array%dd(", output.name.c_str(), bound_size);
+  for (int i = 0; i < bound_size; ++i) {
+    result.append(StringPrintf("%" GG_LL_FORMAT "d..%" GG_LL_FORMAT "d, ",
+                               output.bounds[i].min_value,
+                               output.bounds[i].max_value));
+  }
+  result.append("[");
+  for (int i = 0; i < output.flat_variables.size(); ++i) {
+    const int64 value = SolutionValue(output.flat_variables[i]);
+    if (output.is_boolean) {
+      result.append(value ? "true" : "false");
+    } else {
+      result.append(StringPrintf("%" GG_LL_FORMAT "d", value));
+    }
+    if (i != output.flat_variables.size() - 1) {
+      result.append(", ");
+    }
+  }
+  result.append("]);");
+  return result;
+}
+
+void FzSatBackend::Solve(const FzSolverParameters& p,
+                         FzParallelSupportInterface* parallel_support) {
+  WallTimer timer;
+  timer.Start();
+  sat::SatParameters parameters;
+  if (p.random_seed != 0) {
+    parameters.set_random_seed(p.random_seed);
+  }
+  sat_.SetParameters(parameters);
+  const bool optimize = objective_encoding_ != -1;
+  const bool maximize = model_.maximize();
+  if (optimize) {
+    parallel_support->StartSearch(
+        p.worker_id, maximize ? FzParallelSupportInterface::MAXIMIZE
+                              : FzParallelSupportInterface::MINIMIZE);
+  } else {
+    parallel_support->StartSearch(p.worker_id,
+                                  FzParallelSupportInterface::SATISFY);
+  }
+
+  TimeLimit time_limit(p.time_limit_in_ms > 0
+                           ? p.time_limit_in_ms / 1000.0
+                           : std::numeric_limits<double>::infinity());
+  const double slice_in_seconds = p.worker_id >= 0
+                                      ? kParallelSliceInSeconds
+                                      : std::numeric_limits<double>::infinity();
+  bool interrupted = false;
+  bool breaked = false;
+  bool has_bound = false;
+  int64 bound = 0;
+  while (!parallel_support->ShouldFinish()) {
+    if (time_limit.LimitReached()) {
+      interrupted = true;
+      break;
+    }
+    TimeLimit slice_limit(std::min(slice_in_seconds, time_limit.GetTimeLeft()));
+    const sat::SatSolver::Status status = sat_.SolveWithTimeLimit(&slice_limit);
+    if (status == sat::SatSolver::MODEL_UNSAT) {
+      // The search is complete.
+      break;
+    }
+    if (status == sat::SatSolver::LIMIT_REACHED) {
+      // Imports the best objective value of the other workers.
+      if (optimize && parallel_support->NumSolutions() > 0) {
+        const int64 best = parallel_support->BestSolution();
+        if (!has_bound || (maximize ? best > bound : best < bound)) {
+          has_bound = true;
+          bound = best;
+          ConstrainObjective(bound);
+        }
+      }
+      continue;
+    }
+    CHECK_EQ(sat::SatSolver::MODEL_SAT, status);
+    StoreSolution();
+    std::string solution_string;
+    for (const FzOnSolutionOutput& output : model_.output()) {
+      solution_string.append(SolutionString(output));
+      solution_string.append("\n");
+    }
+    solution_string.append("----------");
+    if (optimize) {
+      const int64 value = solution_[objective_encoding_];
+      parallel_support->OptimizeSolution(p.worker_id, value, solution_string);
+      if ((p.num_solutions != 1 &&
+           parallel_support->NumSolutions() >= p.num_solutions) ||
+          (p.all_solutions && p.num_solutions == 1 &&
+           parallel_support->NumSolutions() >= 1)) {
+        breaked = true;
+        break;
+      }
+      has_bound = true;
+      bound = value;
+      ConstrainObjective(bound);
+    } else {
+      parallel_support->SatSolution(p.worker_id, solution_string);
+      if (parallel_support->NumSolutions() >= p.num_solutions) {
+        breaked = true;
+        break;
+      }
+      BlockSolution();
+    }
+  }
+  parallel_support->EndSearch(p.worker_id, interrupted);
+  const int64 solve_time = timer.GetInMs();
+  if (p.worker_id > 0) {
+    return;
+  }
+
+  const int num_solutions = parallel_support->NumSolutions();
+  if (p.worker_id == 0) {
+    // Recompute the breaked variable.
+    if (!optimize) {
+      breaked = num_solutions >= p.num_solutions;
+    } else {
+      breaked = (p.num_solutions != 1 && num_solutions >= p.num_solutions) ||
+                (p.all_solutions && p.num_solutions == 1 && num_solutions >= 1);
+    }
+  }
+  const bool timeout = parallel_support->Interrupted();
+  bool proven = false;
+  std::string final_output;
+  if (timeout) {
+    final_output.append("%% TIMEOUT\n");
+  } else if (!breaked && num_solutions == 0) {
+    final_output.append("=====UNSATISFIABLE=====\n");
+  } else if (!breaked) {
+    final_output.append("==========\n");
+    proven = true;
+  }
+  final_output.append(
+      StringPrintf("%%%%  total runtime:        %" GG_LL_FORMAT "d ms\n",
+                   solve_time + extraction_time_in_ms_));
+  final_output.append(
+      StringPrintf("%%%%  build time:           %" GG_LL_FORMAT "d ms\n",
+                   extraction_time_in_ms_));
+  final_output.append(StringPrintf(
+      "%%%%  solve time:           %" GG_LL_FORMAT "d ms\n", solve_time));
+  final_output.append(
+      StringPrintf("%%%%  solutions:            %d\n", num_solutions));
+  if (num_solutions > 0) {
+    final_output.append(
+        StringPrintf("%%%%  time to best:         %" GG_LL_FORMAT "d ms\n",
+                     parallel_support->LastSolutionTimeInMs()));
+  }
+  final_output.append(StringPrintf("%%%%  constraints:          %d\n",
+                                   num_extracted_constraints_));
+  final_output.append(StringPrintf("%%%%  Boolean variables:    %d\n",
+                                   sat_.NumVariables()));
+  final_output.append(
+      StringPrintf("%%%%  propagations:         %" GG_LL_FORMAT "d\n",
+                   sat_.num_propagations()));
+  final_output.append(
+      StringPrintf("%%%%  branches:             %" GG_LL_FORMAT "d\n",
+                   sat_.num_branches()));
+  final_output.append(
+      StringPrintf("%%%%  failures:             %" GG_LL_FORMAT "d\n",
+                   sat_.num_failures()));
+  final_output.append(StringPrintf("%%%%  memory:               %s\n",
+                                   FzMemoryUsage().c_str()));
+  const int64 best = parallel_support->BestSolution();
+  if (optimize && num_solutions > 0) {
+    final_output.append(
+        StringPrintf("%%%%  %s objective:        %" GG_LL_FORMAT "d%s\n",
+                     maximize ? "max" : "min", best,
+                     proven ? " (proven)" : ""));
+  }
+  const bool no_solutions = num_solutions == 0;
+  const std::string status_string =
+      no_solutions ? (timeout ? "**timeout**" : "**unsat**")
+                   : (!optimize ? "**sat**"
+                                : (timeout ? "**feasible**" : "**proven**"));
+  const std::string obj_string =
+      optimize && !no_solutions ? StringPrintf("%" GG_LL_FORMAT "d", best)
+                                : "";
+  final_output.append("%%  name, status, obj, solns, s_time, b_time, br, "
+                      "fails, cts, demon, delayed, mem, search\n");
+  final_output.append(StringPrintf(
+      "%%%%  csv: %s, %s, %s, %d, %" GG_LL_FORMAT "d ms, %" GG_LL_FORMAT
+      "d ms, %" GG_LL_FORMAT "d, %" GG_LL_FORMAT "d, %d, %" GG_LL_FORMAT
+      "d, %d, %s, %s",
+      model_.name().c_str(), status_string.c_str(), obj_string.c_str(),
+      num_solutions, solve_time, extraction_time_in_ms_, sat_.num_branches(),
+      sat_.num_failures(), num_extracted_constraints_,
+      sat_.num_propagations(), 0, FzMemoryUsage().c_str(), "lcg"));
+  parallel_support->FinalOutput(p.worker_id, final_output);
+}
+}  // namespace operations_research
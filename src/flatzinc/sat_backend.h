@@ -0,0 +1,196 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef OR_TOOLS_FLATZINC_SAT_BACKEND_H_
+#define OR_TOOLS_FLATZINC_SAT_BACKEND_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/hash.h"
+#include "base/integral_types.h"
+#include "flatzinc/model.h"
+#include "flatzinc/search.h"
+#include "sat/pb_constraint.h"
+#include "sat/sat_base.h"
+#include "sat/sat_solver.h"
+
+namespace operations_research {
+// A lazy clause generation backend: the whole flatzinc model, integer
+// variables included, is encoded into the sat::SatSolver, which then
+// does all the search, conflict analysis and restarts.
+//
+// Each integer variable x with sorted values v_0 < ... < v_n-1 gets one
+// order literal [x >= v_k] per k > 0, chained by binary clauses, and
+// x = v_0 + sum_k (v_k - v_k-1) [x >= v_k]. The value literals
+// [x == v_k] are only created when a constraint needs them. Linear
+// constraints become pseudo-Boolean constraints over the order literals,
+// which the pseudo-Boolean propagator of the sat solver explains when
+// they propagate or fail. Comparisons, element, table and the Boolean
+// constraints are encoded into clauses. The cumulative constraint with
+// fixed durations and demands uses a time-indexed decomposition: one
+// pseudo-Boolean constraint per possible start time.
+//
+// Only bounded variables with reasonably small domains are supported.
+// Extract() returns false on unsupported models, which should then be
+// solved by the FzSolver.
+class FzSatBackend {
+ public:
+  explicit FzSatBackend(const FzModel& model);
+  ~FzSatBackend();
+
+  // Encodes the active constraints and variables of the model. Returns
+  // false if the model uses a constraint or a variable that the backend
+  // cannot encode.
+  bool Extract();
+
+  // Searches for solutions of the extracted model. Search annotations
+  // are ignored. The parameters and the parallel support have the same
+  // meaning as in FzSolver::Solve().
+  void Solve(const FzSolverParameters& p,
+             FzParallelSupportInterface* parallel_support);
+
+  // Output support, on the last solution found.
+  std::string SolutionString(const FzOnSolutionOutput& output) const;
+  // The variable must be active or part of the output.
+  int64 SolutionValue(FzIntegerVariable* var) const;
+
+ private:
+  // The relations of the flatzinc comparison constraints.
+  enum Relation { EQ, NE, LE, LT, GE, GT };
+
+  // The encoding of one integer variable or constant.
+  struct IntegerEncoding {
+    // The possible values, sorted.
+    std::vector<int64> values;
+    // The order literal [x >= values[k]] is the sat variable
+    // first_order_variable + k - 1, for k > 0.
+    int first_order_variable;
+    // The sat variable of the value literal [x == values[k]], or -1 if
+    // it has not been created yet. Only used for 0 < k < size - 1, the
+    // other value literals are order literals.
+    std::vector<int> value_variables;
+
+    sat::Literal OrderLiteral(int k) const {
+      return sat::Literal(sat::VariableIndex(first_order_variable + k - 1),
+                          true);
+    }
+  };
+
+  // Parses the comparison constraints, such as "int_le", "bool_eq_reif"
+  // or "int_lin_ne".
+  static bool ParseComparison(const std::string& type, Relation* relation,
+                              bool* is_linear, bool* is_reified);
+  static Relation Negation(Relation relation);
+
+  // ----- Variables -----
+
+  // Computes bounds for the unbounded variables defined by a functional
+  // constraint on bounded variables.
+  void InferBounds();
+  bool ImpliedBounds(const FzConstraint* ct, FzIntegerVariable** var,
+                     int64* lb, int64* ub) const;
+  bool Bounds(const FzIntegerVariable* var, int64* lb, int64* ub) const;
+  bool ArgumentBounds(const FzArgument& arg, int64* lb, int64* ub) const;
+  bool DomainValues(const FzIntegerVariable* var,
+                    std::vector<int64>* values) const;
+
+  // The Encode*() methods return the index of the encoding, or -1 if the
+  // variable cannot be encoded.
+  int Encode(FzIntegerVariable* var);
+  int EncodeConstant(int64 value);
+  int EncodeValues(const std::vector<int64>& values);
+  int EncodeArgument(const FzArgument& arg);
+  bool EncodeArray(const FzArgument& arg, std::vector<int>* encodings);
+  // Returns true if the argument is a fixed value or array of fixed
+  // values, and fills them.
+  bool FixedValues(const FzArgument& arg, std::vector<int64>* values) const;
+  bool Contains(int encoding, int64 value) const;
+
+  // ----- Literals -----
+
+  sat::Literal NewLiteral();
+  sat::Literal TrueLiteral() const { return true_literal_; }
+  sat::Literal FalseLiteral() const { return true_literal_.Negated(); }
+  // [x >= value], [x <= value] and [x == value], where x is the encoded
+  // variable.
+  sat::Literal GreaterOrEqual(int encoding, int64 value);
+  sat::Literal LessOrEqual(int encoding, int64 value);
+  sat::Literal Equal(int encoding, int64 value);
+  // The literal of a Boolean encoding.
+  sat::Literal BooleanLiteral(int encoding);
+
+  // ----- Constraints -----
+
+  // The Post*() methods taking an 'enforcement' literal only enforce the
+  // constraint when it is true.
+  void AddClause(const std::vector<sat::Literal>& literals);
+  void AddImplication(sat::Literal a, sat::Literal b);
+  // Appends the order literals of 'coefficient * x' to 'terms', and its
+  // constant part to 'offset'.
+  void AddTerms(int encoding, int64 coefficient,
+                std::vector<sat::LiteralWithCoeff>* terms, int64* offset);
+  // offset + sum(terms) <= upper_bound.
+  void PostLinearLessOrEqual(const std::vector<sat::LiteralWithCoeff>& terms,
+                             int64 offset, int64 upper_bound,
+                             sat::Literal enforcement);
+  // offset + sum(terms) 'relation' rhs.
+  void PostLinearRelation(Relation relation,
+                          const std::vector<sat::LiteralWithCoeff>& terms,
+                          int64 offset, int64 rhs, sat::Literal enforcement);
+  // x <= y + offset.
+  void PostLessOrEqual(int x, int y, int64 offset, sat::Literal enforcement);
+  // x != y.
+  void PostNotEqual(int x, int y, sat::Literal enforcement);
+  // x 'relation' y.
+  void PostRelation(Relation relation, int x, int y, sat::Literal enforcement);
+  // target == max(encodings), or min(encodings).
+  void PostMaximum(int target, const std::vector<int>& encodings);
+  void PostMinimum(int target, const std::vector<int>& encodings);
+  // z == x 'type' y, by enumerating the pairs of values of x and y.
+  bool PostFunctional(const std::string& type, int x, int y, int z);
+  bool PostTable(const std::vector<int>& encodings,
+                 const std::vector<int64>& tuples);
+  void PostAtMostOneValue(const std::vector<int>& encodings,
+                          bool except_zero);
+  bool PostCumulative(const FzConstraint* ct);
+
+  bool ExtractLinear(const FzConstraint* ct, Relation relation,
+                     sat::Literal enforcement);
+  bool ExtractConstraint(const FzConstraint* ct);
+
+  // ----- Search -----
+
+  void StoreSolution();
+  // Forbids solutions that are not strictly better than 'value' for the
+  // objective.
+  void ConstrainObjective(int64 value);
+  // Forbids the last solution, projected on the output variables.
+  void BlockSolution();
+
+  const FzModel& model_;
+  sat::SatSolver sat_;
+  sat::Literal true_literal_;
+  std::vector<IntegerEncoding> encodings_;
+  hash_map<const FzIntegerVariable*, int> variable_to_encoding_;
+  hash_map<int64, int> constant_to_encoding_;
+  hash_map<const FzIntegerVariable*, std::pair<int64, int64> > inferred_bounds_;
+  int objective_encoding_;
+  int num_extracted_constraints_;
+  int64 extraction_time_in_ms_;
+  // The values of the encodings in the last solution.
+  std::vector<int64> solution_;
+};
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_FLATZINC_SAT_BACKEND_H_
@@ -13,6 +13,7 @@
 #if defined(__GNUC__)  // Linux or Mac OS X.
 #include <signal.h>
 #endif  // __GNUC__
+#include <algorithm>
 #include <iostream>  // NOLINT
 #include <string>
 #include "base/integral_types.h"
@@ -47,6 +48,37 @@ class FzLog : public SearchLog {
 
 static bool ControlC = false;
 
+// The limit of the nested searches: it checks the limits of the main
+// search without changing their state.
+class FzNestedLimit : public SearchLimit {
+ public:
+  FzNestedLimit(Solver* const solver, SearchLimit* const limit,
+                SearchLimit* const parallel_limit)
+      : SearchLimit(solver), limit_(limit), parallel_limit_(parallel_limit) {}
+  virtual ~FzNestedLimit() {}
+
+  virtual bool Check() {
+    return (limit_ != nullptr && limit_->Check()) ||
+           (parallel_limit_ != nullptr && parallel_limit_->Check());
+  }
+
+  virtual void Init() {}
+
+  virtual void Copy(const SearchLimit* const limit) {}
+
+  virtual SearchLimit* MakeClone() const {
+    return solver()->RevAlloc(
+        new FzNestedLimit(solver(), limit_, parallel_limit_));
+  }
+
+ private:
+  SearchLimit* const limit_;
+  SearchLimit* const parallel_limit_;
+};
+
+// Maximum number of failures to complete one LNS neighbor.
+const int kLnsFailuresLimit = 100;
+
 class FzInterrupt : public SearchLimit {
  public:
   FzInterrupt(Solver* const solver) : SearchLimit(solver) {}
@@ -122,6 +154,8 @@ void SortVariableByDegree(const std::vector<int>& occurrences, bool use_size,
   }
 }
 
+}  // namespace
+
 // Report memory usage in a nice way.
 std::string FzMemoryUsage() {
   static const int64 kDisplayThreshold = 2;
@@ -140,8 +174,6 @@ std::string FzMemoryUsage() {
   }
 }
 
-}  // namespace
-
 FzSolverParameters::FzSolverParameters()
     : all_solutions(false),
       free_search(false),
@@ -152,6 +184,7 @@ FzSolverParameters::FzSolverParameters()
       restart_log_size(-1.0),
       log_period(1000000),
       luby_restart(0),
+      lns_fragment_size(0),
       num_solutions(1),
       random_seed(0),
       threads(1),
@@ -544,6 +577,35 @@ DecisionBuilder* FzSolver::CreateDecisionBuilders(const FzSolverParameters& p,
   for (DecisionBuilder* const db : builders) {
     FZVLOG << "  - adding decision builder = " << db->DebugString() << FZENDL;
   }
+  if (p.lns_fragment_size > 0 && model_.objective() != nullptr &&
+      !defined_variables.empty()) {
+    // The search above finds the first solution, then each neighbor
+    // relaxes a random fragment of the decision variables and completes
+    // it with a small failure limit. The failure limit is not given to
+    // the local search phase, as it would also apply to the first
+    // solution.
+    search_name_ += " + lns";
+    std::vector<DecisionBuilder*> lns_builders;
+    lns_builders.push_back(solver()->MakePhase(defined_variables,
+                                               Solver::CHOOSE_FIRST_UNBOUND,
+                                               Solver::ASSIGN_MIN_VALUE));
+    AddCompletionDecisionBuilders(defined_variables, active_variables, limit,
+                                  &lns_builders);
+    const int fragment_size = std::min(
+        p.lns_fragment_size, static_cast<int>(defined_variables.size()));
+    LocalSearchOperator* const lns = solver()->MakeRandomLNSOperator(
+        defined_variables, fragment_size, p.random_seed);
+    LocalSearchPhaseParameters* const lns_parameters =
+        solver()->MakeLocalSearchPhaseParameters(
+            lns, solver()->MakeSolveOnce(
+                     solver()->Compose(lns_builders),
+                     solver()->MakeFailuresLimit(kLnsFailuresLimit)),
+            limit);
+    FZLOG << "  - using lns with fragments of " << fragment_size
+          << " variables" << FZENDL;
+    return solver()->MakeLocalSearchPhase(
+        defined_variables, solver()->Compose(builders), lns_parameters);
+  }
   return solver()->Compose(builders);
 }
 
@@ -572,14 +634,32 @@ void FzSolver::SyncWithModel() {
   }
 }
 
+void FzSolver::CollectSharedVariables(
+    std::vector<FzIntegerVariable*>* fz_vars, std::vector<IntVar*>* vars) {
+  for (FzIntegerVariable* const fz_var : model_.variables()) {
+    IntExpr* const expr = FindPtrOrNull(extrated_map_, fz_var);
+    if (fz_var->active && expr != nullptr && expr->IsVar() &&
+        !expr->Var()->Bound()) {
+      fz_vars->push_back(fz_var);
+      vars->push_back(expr->Var());
+    }
+  }
+}
+
 void FzSolver::Solve(FzSolverParameters p,
                      FzParallelSupportInterface* parallel_support) {
   SyncWithModel();
   SearchLimit* const limit =
       p.time_limit_in_ms > 0 ? solver()->MakeTimeLimit(p.time_limit_in_ms)
                              : nullptr;
-  SearchLimit* const shadow = limit == nullptr ? nullptr :
-      solver()->MakeCustomLimit(NewPermanentCallback(limit, &SearchLimit::Check));
+  // Custom limit in case of parallelism.
+  SearchLimit* const parallel_limit =
+      parallel_support->Limit(solver(), p.worker_id);
+  SearchLimit* const shadow =
+      limit == nullptr && parallel_limit == nullptr
+          ? nullptr
+          : solver()->RevAlloc(
+                new FzNestedLimit(solver(), limit, parallel_limit));
   DecisionBuilder* const db = CreateDecisionBuilders(p, shadow);
   std::vector<SearchMonitor*> monitors;
   if (model_.objective() != nullptr) {
@@ -605,8 +685,19 @@ void FzSolver::Solve(FzSolverParameters p,
     parallel_support->StartSearch(p.worker_id,
                                   FzParallelSupportInterface::SATISFY);
   }
-  // Custom limit in case of parallelism.
-  monitors.push_back(parallel_support->Limit(solver(), p.worker_id));
+  monitors.push_back(parallel_limit);
+  // Exchange of bounds and nogoods in case of parallelism. Nogoods are
+  // only valid if the search is complete and stops at the first
+  // solution, or only looks for improving solutions.
+  std::vector<FzIntegerVariable*> shared_fz_vars;
+  std::vector<IntVar*> shared_vars;
+  CollectSharedVariables(&shared_fz_vars, &shared_vars);
+  const bool share_nogoods =
+      p.lns_fragment_size <= 0 &&
+      (model_.objective() != nullptr ||
+       (!p.all_solutions && p.num_solutions == 1));
+  monitors.push_back(parallel_support->Sharing(
+      solver(), shared_fz_vars, shared_vars, share_nogoods, p.worker_id));
 
   if (limit != nullptr) {
     FZLOG << "  - adding a time limit of " << p.time_limit_in_ms << " ms"
@@ -662,8 +753,12 @@ void FzSolver::Solve(FzSolverParameters p,
     }
   }
   solver()->EndSearch();
-  parallel_support->EndSearch(p.worker_id,
-                              limit != nullptr ? limit->crossed() : false);
+  // The end of a large neighborhood search proves nothing, the other
+  // workers continue.
+  if (p.lns_fragment_size <= 0 || parallel_support->ShouldFinish()) {
+    parallel_support->EndSearch(p.worker_id,
+                                limit != nullptr ? limit->crossed() : false);
+  }
   const int64 solve_time = solver()->wall_time() - build_time;
   const int num_solutions = parallel_support->NumSolutions();
   bool proven = false;
@@ -699,6 +794,11 @@ void FzSolver::Solve(FzSolverParameters p,
         "%%%%  solve time:           %" GG_LL_FORMAT "d ms\n", solve_time));
     final_output.append(
         StringPrintf("%%%%  solutions:            %d\n", num_solutions));
+    if (num_solutions > 0) {
+      final_output.append(
+          StringPrintf("%%%%  time to best:         %" GG_LL_FORMAT "d ms\n",
+                       parallel_support->LastSolutionTimeInMs()));
+    }
     final_output.append(StringPrintf("%%%%  constraints:          %d\n",
                                      solver()->constraints()));
     final_output.append(
@@ -13,6 +13,10 @@
 #ifndef OR_TOOLS_FLATZINC_SEARCH_H_
 #define OR_TOOLS_FLATZINC_SEARCH_H_
 
+#include <string>
+#include <vector>
+
+#include "base/timer.h"
 #include "constraint_solver/constraint_solver.h"
 #include "flatzinc/model.h"
 
@@ -40,6 +44,7 @@ struct FzSolverParameters {
   int heuristic_period;
   int log_period;
   int luby_restart;
+  int lns_fragment_size;
   int num_solutions;
   int random_seed;
   int threads;
@@ -50,7 +55,8 @@ struct FzSolverParameters {
 
 // This class is used to abstract the interface to parallelism from
 // the search code. It offers two sets of API:
-//    - Create specific search objects (Objective(), Limit(), Log()).
+//    - Create specific search objects (Objective(), Limit(), Sharing(),
+//                                      Log()).
 //    - Report solution (SatSolution(), OptimizeSolution(), FinalOutput(),
 //                       EndSearch(), BestSolution(), Interrupted()).
 class FzParallelSupportInterface {
@@ -62,7 +68,10 @@ class FzParallelSupportInterface {
     MAXIMIZE,
   };
 
-  FzParallelSupportInterface() : num_solutions_(0) {}
+  FzParallelSupportInterface()
+      : num_solutions_(0), last_solution_time_in_ms_(0) {
+    timer_.Start();
+  }
   virtual ~FzParallelSupportInterface() {}
   // Initialize the interface for a given worker id.
   // In sequential mode, the worker id is always -1.
@@ -93,6 +102,15 @@ class FzParallelSupportInterface {
                                  int64 step, int worker_id) = 0;
   // Creates a dedicated search limit.
   virtual SearchLimit* Limit(Solver* s, int worker_id) = 0;
+  // Creates a dedicated search monitor that exchanges the root-level
+  // bounds of 'vars', the extraction of 'fz_vars', with the other
+  // workers. If 'share_nogoods' is true, it also exports the short
+  // nogoods learned by this worker. All workers import the nogoods of
+  // the others. It returns nullptr if there is nothing to share.
+  virtual SearchMonitor* Sharing(Solver* s,
+                                 const std::vector<FzIntegerVariable*>& fz_vars,
+                                 const std::vector<IntVar*>& vars,
+                                 bool share_nogoods, int worker_id) = 0;
   // Creates a dedicated search log.
   virtual void Log(int worker_id, const std::string& message) = 0;
   // Returns if the search was interrupted, usually by a time or
@@ -100,12 +118,22 @@ class FzParallelSupportInterface {
   virtual bool Interrupted() const = 0;
 
   // Increments the number of solutions found.
-  void IncrementSolutions() { num_solutions_++; }
+  void IncrementSolutions() {
+    num_solutions_++;
+    last_solution_time_in_ms_ = timer_.GetInMs();
+  }
   // Returns the number of solutions found.
   int NumSolutions() const { return num_solutions_; }
+  // Returns when the last solution was found, in ms since the creation
+  // of the interface. The solutions of an optimization problem are only
+  // counted when they improve the objective, so this is the time to the
+  // best solution.
+  int64 LastSolutionTimeInMs() const { return last_solution_time_in_ms_; }
 
  private:
   int num_solutions_;
+  int64 last_solution_time_in_ms_;
+  WallTimer timer_;
 };
 
 // Create an interface suitable for a sequential search.
@@ -114,6 +142,9 @@ FzParallelSupportInterface* MakeSequentialSupport(bool print_all,
 // Creates an interface suitable for a multi-threaded search.
 FzParallelSupportInterface* MakeMtSupport(bool print_all, int num_solutions,
                                           bool verbose);
+
+// Reports the memory usage of the process in a human readable way.
+std::string FzMemoryUsage();
 }  // namespace operations_research
 
 #endif  // OR_TOOLS_FLATZINC_SEARCH_H_
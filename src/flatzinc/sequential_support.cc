@@ -12,6 +12,7 @@
 // limitations under the License.
 #include <iostream>  // NOLINT
 #include <string>
+#include <vector>
 #include "base/integral_types.h"
 #include "base/logging.h"
 #include "base/stringprintf.h"
@@ -88,6 +89,13 @@ class SequentialSupportInterface : public FzParallelSupportInterface {
 
   virtual SearchLimit* Limit(Solver* s, int worker_id) { return nullptr; }
 
+  virtual SearchMonitor* Sharing(Solver* s,
+                                 const std::vector<FzIntegerVariable*>& fz_vars,
+                                 const std::vector<IntVar*>& vars,
+                                 bool share_nogoods, int worker_id) {
+    return nullptr;
+  }
+
   virtual void Log(int worker_id, const std::string& message) {
     std::cout << "%%  worker " << worker_id << ": " << message << std::endl;
   }
@@ -75,6 +75,10 @@ class FzSolver {
   DecisionBuilder* CreateDecisionBuilders(const FzSolverParameters& p,
                                           SearchLimit* limit);
   void CollectOutputVariables(std::vector<IntVar*>* output_variables);
+  // Collects the active model variables extracted as solver variables,
+  // and their extraction.
+  void CollectSharedVariables(std::vector<FzIntegerVariable*>* fz_vars,
+                              std::vector<IntVar*>* vars);
   void SyncWithModel();
 
   const FzModel& model_;
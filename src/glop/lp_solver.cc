@@ -30,6 +30,7 @@
 #include "lp_data/lp_utils.h"
 #include "util/fp_utils.h"
 #include "util/proto_tools.h"
+#include "util/stats_registry.h"
 
 DEFINE_bool(lp_solver_enable_fp_exceptions, true,
             "NaNs and division / zero produce errors. "
@@ -150,7 +151,21 @@ ProblemStatus LPSolver::Solve(const LinearProgram& lp) {
   solution.status = status_;
   RunRevisedSimplexIfNeeded(&solution);
   PostprocessSolution(&solution);
-  return LoadAndVerifySolution(lp, solution);
+  const ProblemStatus status = LoadAndVerifySolution(lp, solution);
+
+  static StatsCounter* const solves = StatsRegistry::Global()->GetCounter(
+      "glop_solves_total", "Number of calls to LPSolver::Solve().");
+  static StatsCounter* const iterations = StatsRegistry::Global()->GetCounter(
+      "glop_simplex_iterations_total",
+      "Number of iterations of the revised simplex.");
+  static StatsHistogram* const solve_time =
+      StatsRegistry::Global()->GetHistogram(
+          "glop_solve_time_seconds", "Wall time of LPSolver::Solve().",
+          StatsHistogram::ExponentialBuckets(1e-4, 10.0, 8));
+  solves->Increment();
+  iterations->Add(num_revised_simplex_iterations_);
+  solve_time->Record(time_limit.GetElapsedTime());
+  return status;
 }
 
 void LPSolver::Clear() {
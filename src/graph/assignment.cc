@@ -15,6 +15,7 @@
 
 #include "base/commandlineflags.h"
 #include "graph/ebert_graph.h"
+#include "graph/graph.h"
 #include "graph/linear_assignment.h"
 
 namespace operations_research {
@@ -62,12 +63,23 @@ SimpleLinearSumAssignment::Status SimpleLinearSumAssignment::Solve() {
     if (unscaled_arc_cost > max_supported_arc_cost) return POSSIBLE_OVERFLOW;
   }
 
+  // The arcs are stored in a StaticGraph, where the outgoing arcs of each left
+  // node are contiguous. Build() may renumber the arcs, so we keep the
+  // permutation to map the arcs of the graph back to the user arcs.
   const ArcIndex num_arcs = arc_cost_.size();
-  ForwardStarGraph graph(2 * num_nodes_, num_arcs);
-  LinearSumAssignment<ForwardStarGraph> assignment(graph, num_nodes_);
+  StaticGraph<> graph(2 * num_nodes_, num_arcs);
   for (ArcIndex arc = 0; arc < num_arcs; ++arc) {
     graph.AddArc(arc_tail_[arc], num_nodes_ + arc_head_[arc]);
-    assignment.SetArcCost(arc, arc_cost_[arc]);
+  }
+  std::vector<ArcIndex> arc_permutation;
+  graph.Build(&arc_permutation);
+  std::vector<ArcIndex> user_arc(num_arcs);
+  LinearSumAssignment<StaticGraph<> > assignment(graph, num_nodes_);
+  for (ArcIndex arc = 0; arc < num_arcs; ++arc) {
+    const ArcIndex graph_arc =
+        arc < arc_permutation.size() ? arc_permutation[arc] : arc;
+    user_arc[graph_arc] = arc;
+    assignment.SetArcCost(graph_arc, arc_cost_[arc]);
   }
   // TODO(user): Improve the LinearSumAssignment api to clearly define
   // the error cases.
@@ -75,7 +87,7 @@ SimpleLinearSumAssignment::Status SimpleLinearSumAssignment::Solve() {
   if (!assignment.ComputeAssignment()) return INFEASIBLE;
   optimal_cost_ = assignment.GetCost();
   for (NodeIndex node = 0; node < num_nodes_; ++node) {
-    assignment_arcs_.push_back(assignment.GetAssignmentArc(node));
+    assignment_arcs_.push_back(user_arc[assignment.GetAssignmentArc(node)]);
   }
   return OPTIMAL;
 }
@@ -0,0 +1,432 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "graph/auction_assignment.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <thread>  // NOLINT
+
+#include "base/stringprintf.h"
+
+namespace operations_research {
+
+namespace {
+// Below this number of unassigned left nodes, the calling thread finishes the
+// phase alone.
+const int kMinParallelBidders = 1024;
+
+const CostValue kNoBid = std::numeric_limits<CostValue>::max();
+
+// Atomically sets *value to min(*value, candidate).
+template <typename T>
+void AtomicMin(std::atomic<T>* value, T candidate) {
+  T current = value->load(std::memory_order_relaxed);
+  while (candidate < current &&
+         !value->compare_exchange_weak(current, candidate,
+                                       std::memory_order_relaxed)) {
+  }
+}
+}  // namespace
+
+template <typename Graph>
+ParallelAuctionAssignment<Graph>::ParallelAuctionAssignment(
+    const Graph* graph, NodeIndex num_left_nodes)
+    : graph_(graph),
+      num_left_nodes_(num_left_nodes),
+      num_threads_(1),
+      alpha_(5),
+      cost_scaling_factor_(num_left_nodes + 1),
+      scaled_arc_cost_(graph->num_arcs(), 0),
+      largest_scaled_cost_magnitude_(0),
+      max_price_range_(0),
+      price_(num_left_nodes, 0),
+      matched_node_(num_left_nodes, -1),
+      has_prices_(false),
+      matched_arc_(num_left_nodes, Graph::kNilArc),
+      epsilon_(0),
+      slack_price_(0),
+      price_lower_bound_(0),
+      bid_arc_(num_left_nodes, Graph::kNilArc),
+      bid_price_(num_left_nodes, 0),
+      best_bid_(new std::atomic<CostValue>[num_left_nodes]),
+      best_bidder_(new std::atomic<NodeIndex>[num_left_nodes]),
+      infeasible_(false),
+      parallel_rounds_done_(false),
+      success_(false),
+      was_warm_started_(false),
+      num_phases_(0),
+      num_rounds_(0),
+      num_bids_(0) {
+  CHECK_EQ(2 * num_left_nodes, graph->num_nodes());
+  for (NodeIndex i = 0; i < num_left_nodes; ++i) {
+    best_bid_[i] = kNoBid;
+    best_bidder_[i] = std::numeric_limits<NodeIndex>::max();
+  }
+}
+
+template <typename Graph>
+void ParallelAuctionAssignment<Graph>::SetArcCost(ArcIndex arc,
+                                                  CostValue cost) {
+  DCHECK(graph_->IsArcValid(arc));
+  DCHECK_LT(graph_->Tail(arc), num_left_nodes_);
+  scaled_arc_cost_[arc] = cost * cost_scaling_factor_;
+  success_ = false;
+}
+
+template <typename Graph>
+void ParallelAuctionAssignment<Graph>::SetPrice(NodeIndex right_node,
+                                                CostValue price) {
+  DCHECK_GE(right_node, num_left_nodes_);
+  price_[right_node - num_left_nodes_] = price * cost_scaling_factor_;
+  has_prices_ = true;
+  success_ = false;
+}
+
+template <typename Graph>
+CostValue ParallelAuctionAssignment<Graph>::Price(NodeIndex right_node) const {
+  DCHECK_GE(right_node, num_left_nodes_);
+  const CostValue price = price_[right_node - num_left_nodes_];
+  // Rounds down, the division rounds towards zero.
+  return price >= 0 ? price / cost_scaling_factor_
+                    : -((-price + cost_scaling_factor_ - 1) /
+                        cost_scaling_factor_);
+}
+
+template <typename Graph>
+bool ParallelAuctionAssignment<Graph>::ComputeAssignment() {
+  success_ = false;
+  num_phases_ = 0;
+  num_rounds_ = 0;
+  num_bids_ = 0;
+  if (num_left_nodes_ == 0) {
+    success_ = true;
+    return true;
+  }
+  for (NodeIndex node = 0; node < num_left_nodes_; ++node) {
+    typename Graph::OutgoingArcIterator arc_it(*graph_, node);
+    if (!arc_it.Ok()) {
+      VLOG(1) << "Left node " << node << " has no arc.";
+      ResetPrices();
+      return false;
+    }
+  }
+
+  if (!ComputeCostRange()) {
+    ResetPrices();
+    return false;
+  }
+
+  // Starting from good prices, a large epsilon would only undo them.
+  CostValue epsilon = std::max<CostValue>(
+      1, largest_scaled_cost_magnitude_ / alpha_);
+  was_warm_started_ = has_prices_;
+  if (was_warm_started_) epsilon = std::min(epsilon, cost_scaling_factor_);
+  has_prices_ = true;
+  while (true) {
+    epsilon_ = epsilon;
+    ++num_phases_;
+    if (!RunPhase()) {
+      ResetPrices();
+      return false;
+    }
+    if (epsilon_ == 1) break;
+    epsilon = std::max<CostValue>(1, epsilon_ / alpha_);
+  }
+  VLOG(1) << StatsString();
+  success_ = true;
+  return true;
+}
+
+// The prices of an infeasible or aborted auction are meaningless, they must
+// not seed the next warm start.
+template <typename Graph>
+void ParallelAuctionAssignment<Graph>::ResetPrices() {
+  std::fill(price_.begin(), price_.end(), 0);
+  std::fill(matched_node_.begin(), matched_node_.end(), -1);
+  std::fill(matched_arc_.begin(), matched_arc_.end(), Graph::kNilArc);
+  has_prices_ = false;
+}
+
+template <typename Graph>
+bool ParallelAuctionAssignment<Graph>::ComputeCostRange() {
+  CostValue min_cost = std::numeric_limits<CostValue>::max();
+  CostValue max_cost = std::numeric_limits<CostValue>::min();
+  for (NodeIndex node = 0; node < num_left_nodes_; ++node) {
+    for (const ArcIndex arc : graph_->OutgoingArcs(node)) {
+      min_cost = std::min(min_cost, scaled_arc_cost_[arc]);
+      max_cost = std::max(max_cost, scaled_arc_cost_[arc]);
+    }
+  }
+  const double range = static_cast<double>(num_left_nodes_) *
+                       (static_cast<double>(max_cost) -
+                        static_cast<double>(min_cost));
+  if (range > static_cast<double>(std::numeric_limits<CostValue>::max()) / 8) {
+    LOG(ERROR) << "The arc costs are too large, the auction could overflow.";
+    return false;
+  }
+  max_price_range_ = static_cast<CostValue>(range);
+  largest_scaled_cost_magnitude_ =
+      std::max(std::abs(min_cost), std::abs(max_cost));
+  return true;
+}
+
+template <typename Graph>
+CostValue ParallelAuctionAssignment<Graph>::GetCost() const {
+  DCHECK(success_);
+  CostValue cost = 0;
+  for (NodeIndex node = 0; node < num_left_nodes_; ++node) {
+    cost += GetAssignmentCost(node);
+  }
+  return cost;
+}
+
+template <typename Graph>
+std::string ParallelAuctionAssignment<Graph>::StatsString() const {
+  return StringPrintf("%lld phases; %lld parallel rounds; %lld bids%s",
+                      num_phases_, num_rounds_, num_bids_,
+                      was_warm_started_ ? " (warm start)" : "");
+}
+
+// With the prices p0 at the beginning of a phase, if the problem is feasible
+// the price of a right node decreases by at most
+//   (max p0 - min p0) + (n - 1) * (C + epsilon)
+// during the phase, where C is the range of the scaled costs, see [Bertsekas
+// 1988]. The prices only matter up to a constant, and a feasible problem has
+// optimal prices within a range of (n - 1) * C, so the prices are first
+// shifted to a maximum of zero, and those below -n * C are raised to it. The
+// auction stays correct from any prices, and without this the range of the
+// prices, and thus the bound below, would grow with each warm start.
+//
+// We use B = n * C + n * (2 * C' + 2 * epsilon), with C' the largest scaled
+// cost magnitude, for the amount by which a single-arc left node lowers its
+// price, and twice B as the infeasibility threshold, like LinearSumAssignment
+// does. All the reduced costs and bids are then within 5 * B + C' of zero in
+// magnitude, and we check that this does not overflow.
+template <typename Graph>
+bool ParallelAuctionAssignment<Graph>::ComputePriceBounds() {
+  const CostValue max_price = *std::max_element(price_.begin(), price_.end());
+  for (CostValue& price : price_) {
+    price = std::max(price - max_price, -max_price_range_);
+  }
+  const double bound =
+      static_cast<double>(max_price_range_) +
+      static_cast<double>(num_left_nodes_) * 2.0 *
+          (static_cast<double>(largest_scaled_cost_magnitude_) +
+           static_cast<double>(epsilon_));
+  const double magnitude = 5.0 * bound +
+                           static_cast<double>(largest_scaled_cost_magnitude_);
+  if (magnitude >
+      static_cast<double>(std::numeric_limits<CostValue>::max()) / 2) {
+    LOG(ERROR) << "The arc costs or the prices are too large, the auction "
+               << "could overflow.";
+    return false;
+  }
+  slack_price_ = static_cast<CostValue>(bound);
+  price_lower_bound_ = -max_price_range_ - 2 * slack_price_;
+  return true;
+}
+
+template <typename Graph>
+bool ParallelAuctionAssignment<Graph>::ComputeBid(NodeIndex left_node,
+                                                  ArcIndex* best_arc,
+                                                  CostValue* bid) const {
+  CostValue min_partial_reduced_cost = std::numeric_limits<CostValue>::max();
+  CostValue second_min_partial_reduced_cost = min_partial_reduced_cost;
+  for (const ArcIndex arc : graph_->OutgoingArcs(left_node)) {
+    const CostValue partial_reduced_cost = PartialReducedCost(arc);
+    if (partial_reduced_cost < second_min_partial_reduced_cost) {
+      if (partial_reduced_cost < min_partial_reduced_cost) {
+        *best_arc = arc;
+        second_min_partial_reduced_cost = min_partial_reduced_cost;
+        min_partial_reduced_cost = partial_reduced_cost;
+      } else {
+        second_min_partial_reduced_cost = partial_reduced_cost;
+      }
+    }
+  }
+  // A left node with a single arc has no second best choice, and it may have
+  // to outbid everybody else. The gap is capped for the same reason.
+  const CostValue gap =
+      second_min_partial_reduced_cost == std::numeric_limits<CostValue>::max()
+          ? slack_price_ - epsilon_
+          : std::min(second_min_partial_reduced_cost - min_partial_reduced_cost,
+                     slack_price_ - epsilon_);
+  *bid = price_[graph_->Head(*best_arc) - num_left_nodes_] - gap - epsilon_;
+  return *bid >= price_lower_bound_;
+}
+
+template <typename Graph>
+typename ParallelAuctionAssignment<Graph>::NodeIndex
+ParallelAuctionAssignment<Graph>::Assign(NodeIndex left_node, ArcIndex arc,
+                                         CostValue bid) {
+  const NodeIndex right = graph_->Head(arc) - num_left_nodes_;
+  const NodeIndex previous_owner = matched_node_[right];
+  if (previous_owner != -1) matched_arc_[previous_owner] = Graph::kNilArc;
+  matched_node_[right] = left_node;
+  matched_arc_[left_node] = arc;
+  price_[right] = bid;
+  return previous_owner;
+}
+
+template <typename Graph>
+bool ParallelAuctionAssignment<Graph>::RunPhase() {
+  if (!ComputePriceBounds()) return false;
+
+  // The left nodes that are still epsilon-happy with their right node for the
+  // new epsilon and the current costs keep it, the others have to bid again.
+  // After a small change of the costs or of epsilon, most of the assignment
+  // is kept.
+  unassigned_nodes_.clear();
+  for (NodeIndex node = num_left_nodes_ - 1; node >= 0; --node) {
+    const ArcIndex matched_arc = matched_arc_[node];
+    if (matched_arc != Graph::kNilArc) {
+      CostValue min_partial_reduced_cost =
+          std::numeric_limits<CostValue>::max();
+      for (const ArcIndex arc : graph_->OutgoingArcs(node)) {
+        min_partial_reduced_cost =
+            std::min(min_partial_reduced_cost, PartialReducedCost(arc));
+      }
+      if (PartialReducedCost(matched_arc) <=
+          min_partial_reduced_cost + epsilon_) {
+        continue;
+      }
+      matched_node_[graph_->Head(matched_arc) - num_left_nodes_] = -1;
+      matched_arc_[node] = Graph::kNilArc;
+    }
+    unassigned_nodes_.push_back(node);
+  }
+  if (num_threads_ > 1 && unassigned_nodes_.size() >= kMinParallelBidders) {
+    RunParallelRounds();
+    if (infeasible_) return false;
+  }
+  return RunSequentialBids();
+}
+
+template <typename Graph>
+bool ParallelAuctionAssignment<Graph>::RunSequentialBids() {
+  // The unassigned nodes are processed in stack order.
+  while (!unassigned_nodes_.empty()) {
+    const NodeIndex node = unassigned_nodes_.back();
+    unassigned_nodes_.pop_back();
+    ArcIndex arc;
+    CostValue bid;
+    if (!ComputeBid(node, &arc, &bid)) return false;
+    ++num_bids_;
+    const NodeIndex previous_owner = Assign(node, arc, bid);
+    if (previous_owner != -1) unassigned_nodes_.push_back(previous_owner);
+  }
+  return true;
+}
+
+template <typename Graph>
+void ParallelAuctionAssignment<Graph>::RunParallelRounds() {
+  infeasible_ = false;
+  parallel_rounds_done_ = false;
+  thread_data_.resize(num_threads_);
+  barrier_.reset(new ReusableBarrier(num_threads_));
+  std::vector<std::thread> threads;
+  for (int thread = 1; thread < num_threads_; ++thread) {
+    threads.push_back(
+        std::thread(&ParallelAuctionAssignment::ParallelRounds, this, thread));
+  }
+  ParallelRounds(0);
+  for (int thread = 0; thread < threads.size(); ++thread) {
+    threads[thread].join();
+  }
+  barrier_.reset();
+}
+
+template <typename Graph>
+void ParallelAuctionAssignment<Graph>::GetStaticRange(int thread, int* begin,
+                                                      int* end) const {
+  const int64 size = unassigned_nodes_.size();
+  *begin = size * thread / num_threads_;
+  *end = size * (thread + 1) / num_threads_;
+}
+
+// Each round has three steps separated by barriers: all the unassigned left
+// nodes bid with the prices of the previous round, then the best bid for each
+// right node is chosen (the lowest price, then the lowest left node to make
+// the result deterministic), and finally the winners are assigned. Only the
+// winner of a right node writes its price and owner, so the last step does
+// not need any synchronization.
+template <typename Graph>
+void ParallelAuctionAssignment<Graph>::ParallelRounds(int thread) {
+  ThreadData* const data = &thread_data_[thread];
+  while (true) {
+    int begin;
+    int end;
+    GetStaticRange(thread, &begin, &end);
+    for (int i = begin; i < end; ++i) {
+      const NodeIndex node = unassigned_nodes_[i];
+      if (!ComputeBid(node, &bid_arc_[node], &bid_price_[node])) {
+        infeasible_ = true;
+      }
+      AtomicMin(&best_bid_[graph_->Head(bid_arc_[node]) - num_left_nodes_],
+                bid_price_[node]);
+    }
+    barrier_->Wait();
+    for (int i = begin; i < end; ++i) {
+      const NodeIndex node = unassigned_nodes_[i];
+      const NodeIndex right = graph_->Head(bid_arc_[node]) - num_left_nodes_;
+      if (bid_price_[node] == best_bid_[right].load(std::memory_order_relaxed)) {
+        AtomicMin(&best_bidder_[right], node);
+      }
+    }
+    barrier_->Wait();
+    data->unassigned_nodes.clear();
+    for (int i = begin; i < end; ++i) {
+      const NodeIndex node = unassigned_nodes_[i];
+      const NodeIndex right = graph_->Head(bid_arc_[node]) - num_left_nodes_;
+      if (best_bidder_[right].load(std::memory_order_relaxed) == node) {
+        ++data->num_bids;
+        const NodeIndex previous_owner =
+            Assign(node, bid_arc_[node], bid_price_[node]);
+        if (previous_owner != -1) {
+          data->unassigned_nodes.push_back(previous_owner);
+        }
+        best_bid_[right].store(kNoBid, std::memory_order_relaxed);
+        best_bidder_[right].store(std::numeric_limits<NodeIndex>::max(),
+                                  std::memory_order_relaxed);
+      } else {
+        data->unassigned_nodes.push_back(node);
+      }
+    }
+    barrier_->Wait();
+    if (thread == 0) {
+      unassigned_nodes_.clear();
+      for (int t = 0; t < num_threads_; ++t) {
+        ThreadData* const other = &thread_data_[t];
+        unassigned_nodes_.insert(unassigned_nodes_.end(),
+                                 other->unassigned_nodes.begin(),
+                                 other->unassigned_nodes.end());
+        num_bids_ += other->num_bids;
+        other->num_bids = 0;
+      }
+      ++num_rounds_;
+      parallel_rounds_done_ =
+          infeasible_ || unassigned_nodes_.size() < kMinParallelBidders;
+    }
+    barrier_->Wait();
+    if (parallel_rounds_done_) break;
+  }
+}
+
+// Explicit instantiations that can be used by a client.
+template class ParallelAuctionAssignment<StaticGraph<> >;
+template class ParallelAuctionAssignment<ReverseArcStaticGraph<> >;
+
+}  // namespace operations_research
@@ -0,0 +1,263 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// An auction algorithm for the linear sum assignment problem (minimum-cost
+// perfect bipartite matching) on the graph classes of graph.h, that can use
+// several threads. It is meant for large sparse instances, e.g. assigning
+// 10^5 drivers to jobs, that have to be re-solved often with slightly
+// different costs. See linear_assignment.h for the definitions and for the
+// sequential cost-scaling algorithm of Goldberg and Kennedy, which is closely
+// related: its double push is exactly an auction bid.
+//
+// The left nodes are [0, num_left_nodes) and the right nodes are
+// [num_left_nodes, 2 * num_left_nodes); all the arcs go from a left node to a
+// right node. Each right node w has a price p(w), and an unassigned left node
+// v bids for the right node w that minimizes the partial reduced cost
+// c(v, w) - p(w): it takes w from its current owner, and lowers p(w) so that
+// w is worse than the second best choice of v by epsilon. A left node is
+// epsilon-happy with its right node when its partial reduced cost is within
+// epsilon of the minimum, and the algorithm stops when all the left nodes are
+// assigned. As in LinearSumAssignment, the costs are multiplied by
+// num_left_nodes + 1, so that the final assignment with epsilon = 1 is
+// optimal. Epsilon is divided by a constant factor between auction phases
+// (epsilon scaling). The prices are kept from one phase to the next, and so
+// are the assignments that are still epsilon-happy.
+//
+// With one thread, the bids are done one at a time (Gauss-Seidel auction).
+// With several threads, the unassigned left nodes all bid at the same time
+// with the same prices, and each right node goes to its best bidder (Jacobi
+// auction). When few left nodes remain unassigned, the calling thread finishes
+// the phase alone, since the synchronization of the threads would cost more
+// than the bids.
+//
+// The prices are kept from one ComputeAssignment() to the next, so that after
+// some SetArcCost() calls, the auction starts from the previous prices and a
+// small epsilon (warm start). They can also be set with SetPrice(), e.g. from
+// the prices of a similar problem solved earlier. A ComputeAssignment() that
+// fails forgets the prices, and the next one is a cold start. The prices are
+// only defined up to a constant: they are shifted so that the highest one is
+// zero, and kept within n times the range of the costs.
+//
+// References:
+// - D. P. Bertsekas, "The auction algorithm: A distributed relaxation method
+//   for the assignment problem," Annals of Operations Research, (1988)
+//   14:105-123.
+// - D. P. Bertsekas and D. A. Castanon, "Parallel synchronous and
+//   asynchronous implementations of the auction algorithm," Parallel
+//   Computing, (1991) 17:707-732.
+//
+// Example usage:
+//   StaticGraph<> graph(2 * num_left_nodes, num_arcs);
+//   ... add the arcs, call graph.Build(&permutation) ...
+//   ParallelAuctionAssignment<StaticGraph<> > assignment(&graph,
+//                                                       num_left_nodes);
+//   for (...) assignment.SetArcCost(arc, cost);
+//   assignment.set_num_threads(8);
+//   if (assignment.ComputeAssignment()) {
+//     ... use assignment.GetCost() and assignment.GetMate(left_node) ...
+//   }
+//
+// See the end of auction_assignment.cc for the graph types this class is
+// compiled for.
+
+#ifndef OR_TOOLS_GRAPH_AUCTION_ASSIGNMENT_H_
+#define OR_TOOLS_GRAPH_AUCTION_ASSIGNMENT_H_
+
+#include <atomic>
+#include "base/unique_ptr.h"
+#include <string>
+#include <vector>
+
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/synchronization.h"
+#include "graph/ebert_graph.h"
+#include "graph/graph.h"
+
+namespace operations_research {
+
+template <typename Graph>
+class ParallelAuctionAssignment {
+ public:
+  typedef typename Graph::NodeIndex NodeIndex;
+  typedef typename Graph::ArcIndex ArcIndex;
+
+  // The graph must be fully built, have 2 * num_left_nodes nodes, and must not
+  // change while this object is in use. All the arc costs are initially zero.
+  ParallelAuctionAssignment(const Graph* graph, NodeIndex num_left_nodes);
+
+  const Graph* graph() const { return graph_; }
+  NodeIndex NumLeftNodes() const { return num_left_nodes_; }
+
+  // Sets the number of threads used by ComputeAssignment(), including the
+  // calling thread. Defaults to 1.
+  void set_num_threads(int num_threads) {
+    CHECK_GE(num_threads, 1);
+    num_threads_ = num_threads;
+  }
+
+  // Sets the amount by which epsilon is divided between two phases.
+  void SetCostScalingDivisor(CostValue factor) {
+    CHECK_GE(factor, 2);
+    alpha_ = factor;
+  }
+
+  // Sets the cost of an arc.
+  void SetArcCost(ArcIndex arc, CostValue cost);
+
+  // Returns the cost of an arc.
+  CostValue ArcCost(ArcIndex arc) const {
+    return scaled_arc_cost_[arc] / cost_scaling_factor_;
+  }
+
+  // Sets the price of a right node, in the unit of the costs, for the next
+  // ComputeAssignment(). Setting a price enables the warm start.
+  void SetPrice(NodeIndex right_node, CostValue price);
+
+  // Returns the price of a right node after ComputeAssignment(), rounded down
+  // to the unit of the costs. Higher (less negative) prices mean less
+  // contended right nodes.
+  CostValue Price(NodeIndex right_node) const;
+
+  // Computes the optimum assignment. Returns false if there is no perfect
+  // matching, or if the costs are too large to rule out arithmetic overflow.
+  bool ComputeAssignment();
+
+  // Returns the cost of the optimum assignment.
+  CostValue GetCost() const;
+
+  // Returns the arc matching left_node, and the right node at its head.
+  ArcIndex GetAssignmentArc(NodeIndex left_node) const {
+    DCHECK_LT(left_node, num_left_nodes_);
+    return matched_arc_[left_node];
+  }
+  NodeIndex GetMate(NodeIndex left_node) const {
+    return graph_->Head(GetAssignmentArc(left_node));
+  }
+  CostValue GetAssignmentCost(NodeIndex left_node) const {
+    return ArcCost(GetAssignmentArc(left_node));
+  }
+
+  // Returns whether the last ComputeAssignment() started from the previous
+  // prices, and a description of the work it did.
+  bool was_warm_started() const { return was_warm_started_; }
+  std::string StatsString() const;
+
+ private:
+  // Data owned by each thread. It is padded to avoid false sharing between
+  // the threads.
+  struct ThreadData {
+    ThreadData() : num_bids(0) {}
+    std::vector<NodeIndex> unassigned_nodes;
+    int64 num_bids;
+    char padding[64];
+  };
+
+  // Returns the partial reduced cost c(v, w) - p(w) of an arc (v, w).
+  CostValue PartialReducedCost(ArcIndex arc) const {
+    return scaled_arc_cost_[arc] - price_[graph_->Head(arc) - num_left_nodes_];
+  }
+
+  // Computes the best arc of an unassigned left node, and its bid for the
+  // head of this arc. Returns false if the bid proves the infeasibility.
+  bool ComputeBid(NodeIndex left_node, ArcIndex* best_arc,
+                  CostValue* bid) const;
+
+  // Runs an auction phase for the current epsilon. Returns false if the
+  // problem is infeasible or if the prices may overflow.
+  bool RunPhase();
+
+  // Normalizes the prices and computes their bounds for the current phase,
+  // see price_lower_bound_.
+  bool ComputePriceBounds();
+
+  // Computes max_price_range_ and largest_scaled_cost_magnitude_ from the
+  // current costs. Returns false if the costs are too large.
+  bool ComputeCostRange();
+
+  // Forgets the prices and the assignment, so that the next
+  // ComputeAssignment() is a cold start.
+  void ResetPrices();
+
+  // Assigns left_node to the head of arc at the price bid, and returns the
+  // previous owner of this right node or -1.
+  NodeIndex Assign(NodeIndex left_node, ArcIndex arc, CostValue bid);
+
+  // Runs the Jacobi auction with all the threads, until few left nodes are
+  // unassigned.
+  void RunParallelRounds();
+  void ParallelRounds(int thread);
+
+  // Runs the Gauss-Seidel auction with the calling thread until all the left
+  // nodes are assigned. Returns false if the problem is infeasible.
+  bool RunSequentialBids();
+
+  // Returns the range [*begin, *end) of the unassigned left nodes processed
+  // by thread.
+  void GetStaticRange(int thread, int* begin, int* end) const;
+
+  const Graph* const graph_;
+  const NodeIndex num_left_nodes_;
+  int num_threads_;
+  CostValue alpha_;
+
+  // The costs are multiplied by cost_scaling_factor_ = num_left_nodes_ + 1.
+  const CostValue cost_scaling_factor_;
+  std::vector<CostValue> scaled_arc_cost_;
+  CostValue largest_scaled_cost_magnitude_;
+  // n * (max scaled cost - min scaled cost): the prices are kept in
+  // [-max_price_range_, 0] at the beginning of each phase.
+  CostValue max_price_range_;
+
+  // Indexed by right node - num_left_nodes_.
+  std::vector<CostValue> price_;
+  std::vector<NodeIndex> matched_node_;
+  bool has_prices_;
+
+  // Indexed by left node.
+  std::vector<ArcIndex> matched_arc_;
+
+  // The current phase. A left node with a single arc bids so that the price
+  // of its right node decreases by slack_price_ (there is no second best
+  // choice). If the problem is feasible, no price can go below
+  // price_lower_bound_ during the phase, see ComputePriceBounds().
+  CostValue epsilon_;
+  CostValue slack_price_;
+  CostValue price_lower_bound_;
+
+  // The left nodes that are not assigned. During the parallel rounds, each of
+  // them bids for the head of bid_arc_[node] at price bid_price_[node], and
+  // best_bid_ and best_bidder_ collect the best bid for each right node.
+  std::vector<NodeIndex> unassigned_nodes_;
+  std::vector<ArcIndex> bid_arc_;
+  std::vector<CostValue> bid_price_;
+  std::unique_ptr<std::atomic<CostValue>[]> best_bid_;
+  std::unique_ptr<std::atomic<NodeIndex>[]> best_bidder_;
+  std::atomic<bool> infeasible_;
+  bool parallel_rounds_done_;
+  std::unique_ptr<ReusableBarrier> barrier_;
+  std::vector<ThreadData> thread_data_;
+
+  bool success_;
+  bool was_warm_started_;
+  int64 num_phases_;
+  int64 num_rounds_;
+  int64 num_bids_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelAuctionAssignment);
+};
+
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_GRAPH_AUCTION_ASSIGNMENT_H_
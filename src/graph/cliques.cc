@@ -17,11 +17,13 @@
 #include <algorithm>
 #include "base/hash.h"
 #include "base/unique_ptr.h"
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 
 #include "base/callback.h"
 #include "base/hash.h"
+#include "util/bitset.h"
 
 namespace operations_research {
 
@@ -228,4 +230,513 @@ void CoverArcsByCliques(
          node_count, &actual, &stop);
 }
 
+// ----- BitsetCliqueFinder -----
+
+namespace {
+
+// Shrinks [*begin, *end) to the smallest range that contains all the non-zero
+// words of 'words' in this range. Returns false if this range is empty.
+inline bool TrimWordRange(const uint64* const words, int* begin, int* end) {
+  while (*begin < *end && words[*begin] == 0) ++*begin;
+  while (*end > *begin && words[*end - 1] == 0) --*end;
+  return *begin < *end;
+}
+
+// Sets result = words & row on the range [*begin, *end) of 'words', and sets
+// [*result_begin, *result_end) to the non-zero range of the result.
+inline void IntersectWords(const uint64* const words, int begin, int end,
+                           const uint64* const row, uint64* const result,
+                           int* result_begin, int* result_end) {
+  for (int w = begin; w < end; ++w) result[w] = words[w] & row[w];
+  *result_begin = begin;
+  *result_end = end;
+  TrimWordRange(result, result_begin, result_end);
+}
+
+// Sets the bit of 'node' in the words [*begin, *end) of a bitset, and extends
+// this range if needed. The words outside of the range are not initialized.
+inline void AddNodeToRange(int node, uint64* const words, int* begin,
+                           int* end) {
+  const int word = node >> 6;
+  if (*begin >= *end) {
+    words[word] = 0;
+    *begin = word;
+    *end = word + 1;
+  }
+  while (word < *begin) words[--*begin] = 0;
+  while (word >= *end) words[(*end)++] = 0;
+  words[word] |= GG_ULONGLONG(1) << (node & 63);
+}
+
+inline bool TestEdge(const uint64* const matrix, int num_words, int node1,
+                     int node2) {
+  return (matrix[static_cast<int64>(node1) * num_words + (node2 >> 6)] >>
+          (node2 & 63)) & 1;
+}
+
+inline void ClearEdge(uint64* const matrix, int num_words, int node1,
+                      int node2) {
+  matrix[static_cast<int64>(node1) * num_words + (node2 >> 6)] &=
+      ~(GG_ULONGLONG(1) << (node2 & 63));
+  matrix[static_cast<int64>(node2) * num_words + (node1 >> 6)] &=
+      ~(GG_ULONGLONG(1) << (node1 & 63));
+}
+
+}  // namespace
+
+// The search state of a thread. The bitsets of each depth of the search are
+// allocated once, and only their words in [begin, end) are meaningful.
+struct BitsetCliqueFinder::SearchState {
+  struct Level {
+    explicit Level(int num_words)
+        : candidates(num_words),
+          excluded(num_words),
+          branches(num_words),
+          candidates_begin(0),
+          candidates_end(0),
+          excluded_begin(0),
+          excluded_end(0) {}
+    // The nodes that can extend the current clique, and the nodes that would
+    // extend it but whose branches are already explored (the sets P and X of
+    // Bron and Kerbosch).
+    std::vector<uint64> candidates;
+    std::vector<uint64> excluded;
+    std::vector<uint64> branches;
+    int candidates_begin;
+    int candidates_end;
+    int excluded_begin;
+    int excluded_end;
+    // The candidates that can improve the best clique, by increasing color.
+    std::vector<int> colored_nodes;
+    std::vector<int> colors;
+  };
+
+  explicit SearchState(int num_words)
+      : num_words(num_words),
+        uncolored(num_words),
+        color_class(num_words),
+        num_search_nodes(0) {}
+
+  Level* GetLevel(int depth) {
+    while (depth >= levels.size()) {
+      levels.push_back(std::unique_ptr<Level>(new Level(num_words)));
+    }
+    return levels[depth].get();
+  }
+
+  const int num_words;
+  std::vector<std::unique_ptr<Level> > levels;
+  std::vector<int> clique;
+  std::vector<int> reported_clique;
+  std::vector<uint64> uncolored;
+  std::vector<uint64> color_class;
+  int64 num_search_nodes;
+};
+
+BitsetCliqueFinder::BitsetCliqueFinder(int num_nodes)
+    : num_nodes_(num_nodes),
+      num_words_(BitLength64(num_nodes)),
+      adjacency_(static_cast<int64>(num_nodes) * num_words_, 0),
+      num_threads_(1),
+      num_search_nodes_(0),
+      search_callback_(nullptr),
+      cover_edges_(false),
+      next_branch_(0),
+      stop_(false),
+      best_size_(0) {
+  CHECK_GE(num_nodes, 0);
+}
+
+void BitsetCliqueFinder::AddEdgesFromCallback(
+    ResultCallback2<bool, int, int>* const graph) {
+  graph->CheckIsRepeatable();
+  for (int i = 0; i < num_nodes_; ++i) {
+    for (int j = i + 1; j < num_nodes_; ++j) {
+      if (graph->Run(i, j)) AddEdge(i, j);
+    }
+  }
+}
+
+// The bucket algorithm of V. Batagelj and M. Zaversnik, "An O(m) algorithm
+// for cores decomposition of networks", 2003.
+std::vector<int> BitsetCliqueFinder::DegeneracyOrdering() const {
+  std::vector<int> degree(num_nodes_, 0);
+  int max_degree = 0;
+  for (int node = 0; node < num_nodes_; ++node) {
+    const uint64* const row = Row(node);
+    for (int w = 0; w < num_words_; ++w) degree[node] += BitCount64(row[w]);
+    max_degree = std::max(max_degree, degree[node]);
+  }
+  // bucket_start[d] is the position in order of the first node of degree d.
+  std::vector<int> bucket_start(max_degree + 1, 0);
+  for (int node = 0; node < num_nodes_; ++node) ++bucket_start[degree[node]];
+  int start = 0;
+  for (int d = 0; d <= max_degree; ++d) {
+    const int size = bucket_start[d];
+    bucket_start[d] = start;
+    start += size;
+  }
+  std::vector<int> order(num_nodes_);
+  std::vector<int> position(num_nodes_);
+  for (int node = 0; node < num_nodes_; ++node) {
+    position[node] = bucket_start[degree[node]]++;
+    order[position[node]] = node;
+  }
+  for (int d = max_degree; d > 0; --d) bucket_start[d] = bucket_start[d - 1];
+  bucket_start[0] = 0;
+  for (int i = 0; i < num_nodes_; ++i) {
+    const int node = order[i];
+    const uint64* const row = Row(node);
+    for (int w = 0; w < num_words_; ++w) {
+      for (uint64 bits = row[w]; bits != 0; bits &= bits - 1) {
+        const int neighbor = (w << 6) + LeastSignificantBitPosition64(bits);
+        if (degree[neighbor] <= degree[node]) continue;
+        // Moves neighbor to the start of its bucket, and the bucket start
+        // after it, which decreases its degree by one.
+        const int neighbor_degree = degree[neighbor];
+        const int neighbor_position = position[neighbor];
+        const int first_position = bucket_start[neighbor_degree];
+        const int first = order[first_position];
+        if (first != neighbor) {
+          position[neighbor] = first_position;
+          order[neighbor_position] = first;
+          position[first] = neighbor_position;
+          order[first_position] = neighbor;
+        }
+        ++bucket_start[neighbor_degree];
+        --degree[neighbor];
+      }
+    }
+  }
+  return order;
+}
+
+void BitsetCliqueFinder::RelabelAdjacency(
+    const std::vector<int>& order, std::vector<uint64>* relabeled) const {
+  std::vector<int> rank(num_nodes_);
+  for (int i = 0; i < num_nodes_; ++i) rank[order[i]] = i;
+  relabeled->assign(adjacency_.size(), 0);
+  for (int i = 0; i < num_nodes_; ++i) {
+    const uint64* const row = Row(order[i]);
+    uint64* const relabeled_row =
+        relabeled->data() + static_cast<int64>(i) * num_words_;
+    for (int w = 0; w < num_words_; ++w) {
+      for (uint64 bits = row[w]; bits != 0; bits &= bits - 1) {
+        const int neighbor = rank[(w << 6) + LeastSignificantBitPosition64(bits)];
+        relabeled_row[neighbor >> 6] |= OneBit(neighbor);
+      }
+    }
+  }
+}
+
+void BitsetCliqueFinder::RunSearch(
+    int num_threads, void (BitsetCliqueFinder::*worker)(SearchState* state)) {
+  num_threads = std::max(1, std::min(num_threads, num_nodes_));
+  next_branch_ = 0;
+  stop_ = false;
+  std::vector<std::unique_ptr<SearchState> > states;
+  for (int thread = 0; thread < num_threads; ++thread) {
+    states.push_back(std::unique_ptr<SearchState>(new SearchState(num_words_)));
+  }
+  std::vector<std::thread> threads;
+  for (int thread = 1; thread < num_threads; ++thread) {
+    threads.push_back(std::thread(worker, this, states[thread].get()));
+  }
+  (this->*worker)(states[0].get());
+  for (int thread = 0; thread < threads.size(); ++thread) {
+    threads[thread].join();
+  }
+  num_search_nodes_ = 0;
+  for (int thread = 0; thread < num_threads; ++thread) {
+    num_search_nodes_ += states[thread]->num_search_nodes;
+  }
+}
+
+// The search runs on the graph relabeled by a degeneracy ordering. The
+// top-level branch of node i only looks for the cliques whose smallest node
+// is i, so its candidates are the neighbors of i after i, and it excludes the
+// neighbors of i before i. There are few candidates in each branch on sparse
+// graphs, and the branches are independent.
+void BitsetCliqueFinder::FindMaximalCliques(
+    ResultCallback1<bool, const std::vector<int>&>* const callback) {
+  callback->CheckIsRepeatable();
+  std::unique_ptr<ResultCallback1<bool, const std::vector<int>&> >
+      callback_deleter(callback);
+  search_order_ = DegeneracyOrdering();
+  RelabelAdjacency(search_order_, &search_adjacency_);
+  search_callback_ = callback;
+  cover_edges_ = false;
+  RunSearch(num_threads_, &BitsetCliqueFinder::MaximalCliqueWorker);
+  search_callback_ = nullptr;
+  std::vector<uint64>().swap(search_adjacency_);
+}
+
+void BitsetCliqueFinder::CoverEdgesByCliques(
+    ResultCallback1<bool, const std::vector<int>&>* const callback) {
+  callback->CheckIsRepeatable();
+  std::unique_ptr<ResultCallback1<bool, const std::vector<int>&> >
+      callback_deleter(callback);
+  search_order_ = DegeneracyOrdering();
+  RelabelAdjacency(search_order_, &search_adjacency_);
+  search_callback_ = callback;
+  cover_edges_ = true;
+  RunSearch(1, &BitsetCliqueFinder::MaximalCliqueWorker);
+  search_callback_ = nullptr;
+  cover_edges_ = false;
+  std::vector<uint64>().swap(search_adjacency_);
+}
+
+void BitsetCliqueFinder::MaximalCliqueWorker(SearchState* state) {
+  while (!stop_) {
+    const int node = next_branch_.fetch_add(1);
+    if (node >= num_nodes_) break;
+    SearchState::Level* const level = state->GetLevel(0);
+    const uint64* const row =
+        &search_adjacency_[static_cast<int64>(node) * num_words_];
+    const int word = node >> 6;
+    const uint64 lower_bits = OneBit(node) - 1;
+    level->candidates[word] = row[word] & ~lower_bits & ~OneBit(node);
+    for (int w = word + 1; w < num_words_; ++w) level->candidates[w] = row[w];
+    level->candidates_begin = word;
+    level->candidates_end = num_words_;
+    TrimWordRange(level->candidates.data(), &level->candidates_begin,
+                  &level->candidates_end);
+    for (int w = 0; w < word; ++w) level->excluded[w] = row[w];
+    level->excluded[word] = row[word] & lower_bits;
+    level->excluded_begin = 0;
+    level->excluded_end = word + 1;
+    TrimWordRange(level->excluded.data(), &level->excluded_begin,
+                  &level->excluded_end);
+    state->clique.assign(1, node);
+    ExpandMaximalClique(0, state);
+  }
+}
+
+void BitsetCliqueFinder::ExpandMaximalClique(int depth, SearchState* state) {
+  ++state->num_search_nodes;
+  SearchState::Level* const level = state->GetLevel(depth);
+  SearchState::Level* const next = state->GetLevel(depth + 1);
+  uint64* const candidates = level->candidates.data();
+  uint64* const excluded = level->excluded.data();
+  const int begin = level->candidates_begin;
+  const int end = level->candidates_end;
+  if (begin >= end) {
+    if (level->excluded_begin >= level->excluded_end) ReportClique(state);
+    return;
+  }
+
+  // Chooses the pivot u among the candidates and the excluded nodes, with the
+  // largest number of neighbors among the candidates. Only the candidates
+  // that are not neighbors of u need to be branched on.
+  int num_candidates = 0;
+  for (int w = begin; w < end; ++w) num_candidates += BitCount64(candidates[w]);
+  int pivot = -1;
+  int max_count = -1;
+  for (int set = 0; set < 2 && max_count < num_candidates; ++set) {
+    const uint64* const words = set == 0 ? candidates : excluded;
+    const int set_begin = set == 0 ? begin : level->excluded_begin;
+    const int set_end = set == 0 ? end : level->excluded_end;
+    for (int w = set_begin; w < set_end && max_count < num_candidates; ++w) {
+      for (uint64 bits = words[w]; bits != 0; bits &= bits - 1) {
+        const int node = (w << 6) + LeastSignificantBitPosition64(bits);
+        const uint64* const row =
+            &search_adjacency_[static_cast<int64>(node) * num_words_];
+        int count = 0;
+        for (int i = begin; i < end; ++i) {
+          count += BitCount64(candidates[i] & row[i]);
+        }
+        if (count > max_count) {
+          max_count = count;
+          pivot = node;
+          if (max_count == num_candidates) break;
+        }
+      }
+    }
+  }
+  const uint64* const pivot_row =
+      &search_adjacency_[static_cast<int64>(pivot) * num_words_];
+  uint64* const branches = level->branches.data();
+  for (int w = begin; w < end; ++w) branches[w] = candidates[w] & ~pivot_row[w];
+
+  for (int w = begin; w < end; ++w) {
+    for (uint64 bits = branches[w]; bits != 0; bits &= bits - 1) {
+      const int node = (w << 6) + LeastSignificantBitPosition64(bits);
+      const uint64* const row =
+          &search_adjacency_[static_cast<int64>(node) * num_words_];
+      IntersectWords(candidates, begin, end, row, next->candidates.data(),
+                     &next->candidates_begin, &next->candidates_end);
+      IntersectWords(excluded, level->excluded_begin, level->excluded_end, row,
+                     next->excluded.data(), &next->excluded_begin,
+                     &next->excluded_end);
+      state->clique.push_back(node);
+      ExpandMaximalClique(depth + 1, state);
+      state->clique.pop_back();
+      if (stop_) return;
+      candidates[w] &= ~OneBit(node);
+      AddNodeToRange(node, excluded, &level->excluded_begin,
+                     &level->excluded_end);
+    }
+  }
+}
+
+void BitsetCliqueFinder::ReportClique(SearchState* state) {
+  std::vector<int>* const clique = &state->reported_clique;
+  clique->clear();
+  for (const int node : state->clique) clique->push_back(search_order_[node]);
+  std::sort(clique->begin(), clique->end());
+  if (cover_edges_) {
+    if (clique->size() < 2) return;
+    // The candidates of the enclosing levels were computed before the edges
+    // of the previous cliques were removed, so the clique may cover none.
+    bool covers_new_edge = false;
+    for (int i = 0; i < state->clique.size() && !covers_new_edge; ++i) {
+      for (int j = i + 1; j < state->clique.size(); ++j) {
+        if (TestEdge(search_adjacency_.data(), num_words_, state->clique[i],
+                     state->clique[j])) {
+          covers_new_edge = true;
+          break;
+        }
+      }
+    }
+    if (!covers_new_edge) return;
+    for (int i = 0; i < state->clique.size(); ++i) {
+      for (int j = i + 1; j < state->clique.size(); ++j) {
+        ClearEdge(search_adjacency_.data(), num_words_, state->clique[i],
+                  state->clique[j]);
+        ClearEdge(adjacency_.data(), num_words_, (*clique)[i], (*clique)[j]);
+      }
+    }
+    search_callback_->Run(*clique);
+    return;
+  }
+  MutexLock lock(&mutex_);
+  if (!stop_ && search_callback_->Run(*clique)) stop_ = true;
+}
+
+// The search runs on the graph relabeled so that the nodes are sorted by
+// their color in a greedy coloring of the graph, itself computed in reverse
+// degeneracy ordering. A clique has at most one node of each color, so the
+// top-level branch of node i, whose candidates are the neighbors of i before
+// i, can only find cliques of size at most top_level_colors_[i]. The same
+// bound is used at each depth of the search with a coloring of the candidates.
+std::vector<int> BitsetCliqueFinder::FindMaximumClique() {
+  std::vector<int> order = DegeneracyOrdering();
+  std::reverse(order.begin(), order.end());
+  RelabelAdjacency(order, &search_adjacency_);
+  SearchState coloring_state(num_words_);
+  SearchState::Level* const level = coloring_state.GetLevel(0);
+  for (int node = 0; node < num_nodes_; ++node) {
+    level->candidates[node >> 6] |= OneBit(node);
+  }
+  GreedyColoring(level->candidates.data(), 0, num_words_, 1, &coloring_state,
+                 &level->colored_nodes, &top_level_colors_);
+  search_order_.resize(num_nodes_);
+  for (int i = 0; i < num_nodes_; ++i) {
+    search_order_[i] = order[level->colored_nodes[i]];
+  }
+  RelabelAdjacency(search_order_, &search_adjacency_);
+  best_size_ = 0;
+  best_clique_.clear();
+  RunSearch(num_threads_, &BitsetCliqueFinder::MaximumCliqueWorker);
+  std::vector<uint64>().swap(search_adjacency_);
+  return best_clique_;
+}
+
+void BitsetCliqueFinder::GreedyColoring(const uint64* const nodes, int begin,
+                                        int end, int min_color,
+                                        SearchState* state,
+                                        std::vector<int>* colored_nodes,
+                                        std::vector<int>* colors) const {
+  colored_nodes->clear();
+  colors->clear();
+  uint64* const uncolored = state->uncolored.data();
+  uint64* const color_class = state->color_class.data();
+  for (int w = begin; w < end; ++w) uncolored[w] = nodes[w];
+  for (int color = 1; TrimWordRange(uncolored, &begin, &end); ++color) {
+    // Builds the color class greedily: takes the first uncolored node, then
+    // the first uncolored node that is not adjacent to it, and so on.
+    for (int w = begin; w < end; ++w) color_class[w] = uncolored[w];
+    for (int w = begin; w < end; ++w) {
+      while (color_class[w] != 0) {
+        const int node = (w << 6) + LeastSignificantBitPosition64(color_class[w]);
+        const uint64* const row =
+            &search_adjacency_[static_cast<int64>(node) * num_words_];
+        uncolored[w] &= ~OneBit(node);
+        color_class[w] &= ~OneBit(node) & ~row[w];
+        for (int i = w + 1; i < end; ++i) color_class[i] &= ~row[i];
+        if (color >= min_color) {
+          colored_nodes->push_back(node);
+          colors->push_back(color);
+        }
+      }
+    }
+  }
+}
+
+void BitsetCliqueFinder::MaximumCliqueWorker(SearchState* state) {
+  for (;;) {
+    const int index = next_branch_.fetch_add(1);
+    if (index >= num_nodes_) break;
+    const int node = num_nodes_ - 1 - index;
+    // The colors are nondecreasing with the nodes, so the next branches of
+    // all the threads are pruned too.
+    if (top_level_colors_[node] <= best_size_) break;
+    SearchState::Level* const level = state->GetLevel(0);
+    const uint64* const row =
+        &search_adjacency_[static_cast<int64>(node) * num_words_];
+    const int word = node >> 6;
+    for (int w = 0; w < word; ++w) level->candidates[w] = row[w];
+    level->candidates[word] = row[word] & (OneBit(node) - 1);
+    level->candidates_begin = 0;
+    level->candidates_end = word + 1;
+    state->clique.assign(1, node);
+    if (TrimWordRange(level->candidates.data(), &level->candidates_begin,
+                      &level->candidates_end)) {
+      ExpandMaximumClique(0, state);
+    } else {
+      UpdateBestClique(state);
+    }
+  }
+}
+
+void BitsetCliqueFinder::ExpandMaximumClique(int depth, SearchState* state) {
+  ++state->num_search_nodes;
+  SearchState::Level* const level = state->GetLevel(depth);
+  SearchState::Level* const next = state->GetLevel(depth + 1);
+  uint64* const candidates = level->candidates.data();
+  const int begin = level->candidates_begin;
+  const int end = level->candidates_end;
+  const int clique_size = state->clique.size();
+  GreedyColoring(candidates, begin, end,
+                 std::max(1, best_size_ - clique_size + 1), state,
+                 &level->colored_nodes, &level->colors);
+  for (int i = level->colored_nodes.size() - 1; i >= 0; --i) {
+    if (clique_size + level->colors[i] <= best_size_) return;
+    const int node = level->colored_nodes[i];
+    const uint64* const row =
+        &search_adjacency_[static_cast<int64>(node) * num_words_];
+    IntersectWords(candidates, begin, end, row, next->candidates.data(),
+                   &next->candidates_begin, &next->candidates_end);
+    state->clique.push_back(node);
+    if (next->candidates_begin < next->candidates_end) {
+      ExpandMaximumClique(depth + 1, state);
+    } else {
+      UpdateBestClique(state);
+    }
+    state->clique.pop_back();
+    candidates[node >> 6] &= ~OneBit(node);
+  }
+}
+
+void BitsetCliqueFinder::UpdateBestClique(SearchState* state) {
+  MutexLock lock(&mutex_);
+  if (state->clique.size() <= best_size_) return;
+  best_size_ = state->clique.size();
+  best_clique_.clear();
+  for (const int node : state->clique) {
+    best_clique_.push_back(search_order_[node]);
+  }
+  std::sort(best_clique_.begin(), best_clique_.end());
+}
+
 }  // namespace operations_research
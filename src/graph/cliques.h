@@ -19,14 +19,38 @@
 // undirected graph", CACM 16 (9): 575–577, 1973.
 // http://dl.acm.org/citation.cfm?id=362367&bnc=1
 //
+// The functions FindCliques() and CoverArcsByCliques() take an adjacency
+// oracle and scan the candidate nodes with it at each step of the search. The
+// class BitsetCliqueFinder below stores the adjacency matrix as bitsets, and
+// implements the same searches with word-level set operations, the pivoting
+// rule of Tomita et al., and several threads. It also computes maximum cliques
+// with greedy coloring bounds (San Segundo et al.). It uses n^2 / 8 bytes of
+// memory for n nodes, and is much faster on graphs of up to a few ten
+// thousand nodes.
+//
+// References:
+// - E. Tomita, A. Tanaka, H. Takahashi, "The worst-case time complexity for
+//   generating all maximal cliques and computational experiments",
+//   Theoretical Computer Science 363 (2006) 28-42.
+// - D. Eppstein, M. Loffler, D. Strash, "Listing all maximal cliques in
+//   sparse graphs in near-optimal time", ISAAC 2010.
+// - P. San Segundo, D. Rodriguez-Losada, A. Jimenez, "An exact bit-parallel
+//   algorithm for the maximum clique problem", Computers & Operations
+//   Research 38 (2011) 571-581.
+//
 // Keywords: undirected graph, clique, clique cover, Bron, Kerbosch.
 
 #ifndef OR_TOOLS_GRAPH_CLIQUES_H_
 #define OR_TOOLS_GRAPH_CLIQUES_H_
 
+#include <atomic>
 #include <vector>
 
 #include "base/callback.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/mutex.h"
 
 namespace operations_research {
 
@@ -48,6 +72,148 @@ void CoverArcsByCliques(
     ResultCallback2<bool, int, int>* const graph, int node_count,
     ResultCallback1<bool, const std::vector<int>&>* const callback);
 
+// Clique algorithms on an undirected graph stored as a dense adjacency matrix
+// of bits. Example usage:
+//   BitsetCliqueFinder finder(num_nodes);
+//   finder.AddEdgesFromGraph(graph);  // or finder.AddEdge(i, j) for each edge.
+//   finder.set_num_threads(8);
+//   finder.FindMaximalCliques(NewPermanentCallback(...));
+//   const std::vector<int> clique = finder.FindMaximumClique();
+class BitsetCliqueFinder {
+ public:
+  explicit BitsetCliqueFinder(int num_nodes);
+
+  int num_nodes() const { return num_nodes_; }
+
+  // Adds the undirected edge between node1 and node2. Self-loops are ignored.
+  void AddEdge(int node1, int node2) {
+    DCHECK_GE(node1, 0);
+    DCHECK_LT(node1, num_nodes_);
+    DCHECK_GE(node2, 0);
+    DCHECK_LT(node2, num_nodes_);
+    if (node1 == node2) return;
+    Row(node1)[node2 >> 6] |= OneBit(node2);
+    Row(node2)[node1 >> 6] |= OneBit(node1);
+  }
+  bool HasEdge(int node1, int node2) const {
+    return Row(node1)[node2 >> 6] & OneBit(node2);
+  }
+
+  // Adds the edges given by an adjacency oracle: graph->Run(i, j) indicates if
+  // there is an arc between i and j. It is called once for each i < j. This
+  // function does not take ownership of 'graph'.
+  void AddEdgesFromCallback(ResultCallback2<bool, int, int>* const graph);
+
+  // Adds an undirected edge for each arc of a graph of graph.h, e.g. a
+  // StaticGraph<> with num_nodes() nodes.
+  template <typename Graph>
+  void AddEdgesFromGraph(const Graph& graph);
+
+  // Sets the number of threads used by the searches, including the calling
+  // thread. Defaults to 1. CoverEdgesByCliques() always uses one thread.
+  void set_num_threads(int num_threads) {
+    CHECK_GE(num_threads, 1);
+    num_threads_ = num_threads;
+  }
+
+  // Same as FindCliques(): calls 'callback' on all the maximal cliques, even
+  // of size 1, and stops as soon as it returns true. The nodes of each clique
+  // are sorted. With several threads, the calls to 'callback' are serialized
+  // but their order is not deterministic. This function takes ownership of
+  // 'callback' and deletes it after it has run.
+  void FindMaximalCliques(
+      ResultCallback1<bool, const std::vector<int>&>* const callback);
+
+  // Same as CoverArcsByCliques(): calls 'callback' on cliques of size at least
+  // 2, each of which covers at least one edge not covered by the previous
+  // ones. The edges of the reported cliques are removed from the graph. This
+  // function takes ownership of 'callback' and deletes it after it has run.
+  void CoverEdgesByCliques(
+      ResultCallback1<bool, const std::vector<int>&>* const callback);
+
+  // Returns a clique of maximum size, with its nodes sorted.
+  std::vector<int> FindMaximumClique();
+
+  // Returns the number of nodes of the search trees explored by the last
+  // search.
+  int64 num_search_nodes() const { return num_search_nodes_; }
+
+ private:
+  struct SearchState;
+
+  static uint64 OneBit(int node) { return GG_ULONGLONG(1) << (node & 63); }
+  uint64* Row(int node) {
+    return &adjacency_[static_cast<int64>(node) * num_words_];
+  }
+  const uint64* Row(int node) const {
+    return &adjacency_[static_cast<int64>(node) * num_words_];
+  }
+
+  // Returns the nodes sorted by a degeneracy ordering: each node has the
+  // smallest degree in the graph induced by itself and the nodes after it.
+  std::vector<int> DegeneracyOrdering() const;
+
+  // Fills *relabeled with the adjacency matrix of the graph whose node i is
+  // the node order[i] of this graph.
+  void RelabelAdjacency(const std::vector<int>& order,
+                        std::vector<uint64>* relabeled) const;
+
+  // Runs worker with num_threads threads, each with its own search state.
+  // The workers take the top-level branches of the search from next_branch_.
+  void RunSearch(int num_threads,
+                 void (BitsetCliqueFinder::*worker)(SearchState* state));
+
+  // Bron-Kerbosch search with pivoting on the relabeled graph.
+  void MaximalCliqueWorker(SearchState* state);
+  void ExpandMaximalClique(int depth, SearchState* state);
+  void ReportClique(SearchState* state);
+
+  // Branch and bound search for a maximum clique on the relabeled graph,
+  // whose node i has color top_level_colors_[i] in a greedy coloring.
+  void MaximumCliqueWorker(SearchState* state);
+  void ExpandMaximumClique(int depth, SearchState* state);
+  void UpdateBestClique(SearchState* state);
+
+  // Appends to *colored_nodes the nodes of a bitset, sorted by increasing
+  // color in a greedy coloring of the relabeled graph, and their colors to
+  // *colors. Skips the nodes whose color is smaller than min_color.
+  void GreedyColoring(const uint64* const nodes, int begin, int end,
+                      int min_color, SearchState* state,
+                      std::vector<int>* colored_nodes,
+                      std::vector<int>* colors) const;
+
+  const int num_nodes_;
+  const int num_words_;
+  std::vector<uint64> adjacency_;
+  int num_threads_;
+  int64 num_search_nodes_;
+
+  // The state shared by the threads of a search. The search runs on a copy of
+  // the graph where node i is the node search_order_[i] of this graph.
+  std::vector<uint64> search_adjacency_;
+  std::vector<int> search_order_;
+  std::vector<int> top_level_colors_;
+  ResultCallback1<bool, const std::vector<int>&>* search_callback_;
+  bool cover_edges_;
+  std::atomic<int> next_branch_;
+  std::atomic<bool> stop_;
+  std::atomic<int> best_size_;
+  std::vector<int> best_clique_;
+  Mutex mutex_;
+
+  DISALLOW_COPY_AND_ASSIGN(BitsetCliqueFinder);
+};
+
+template <typename Graph>
+void BitsetCliqueFinder::AddEdgesFromGraph(const Graph& graph) {
+  CHECK_LE(graph.num_nodes(), num_nodes_);
+  for (const typename Graph::NodeIndex node : graph.AllNodes()) {
+    for (const typename Graph::ArcIndex arc : graph.OutgoingArcs(node)) {
+      AddEdge(node, graph.Head(arc));
+    }
+  }
+}
+
 }  // namespace operations_research
 
 #endif  // OR_TOOLS_GRAPH_CLIQUES_H_
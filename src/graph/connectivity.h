@@ -15,12 +15,18 @@
 // Graph connectivity algorithm for undirected graphs.
 // Memory consumption: O(n) where m is the number of arcs and n the number
 // of nodes.
-// TODO(user): add depth-first-search based connectivity for directed graphs.
+// See strongly_connected_components.h for the connectivity of directed graphs.
 // TODO(user): add depth-first-search based biconnectivity for directed graphs.
 
 #ifndef OR_TOOLS_GRAPH_CONNECTIVITY_H_
 #define OR_TOOLS_GRAPH_CONNECTIVITY_H_
 
+#include <algorithm>
+#include <atomic>
+#include "base/unique_ptr.h"
+#include <thread>  // NOLINT
+#include <vector>
+
 #include "base/integral_types.h"
 #include "base/logging.h"
 #include "base/macros.h"
@@ -125,6 +131,170 @@ class ConnectedComponents {
   DISALLOW_COPY_AND_ASSIGN(ConnectedComponents);
 };
 
+// Computes the connected components of a graph of graph.h, whose arcs are
+// seen as undirected edges, with several threads. It is meant for very large
+// graphs (10^8 arcs and more), where a sequential union-find is bounded by
+// the latency of its random memory accesses.
+//
+// The threads share a lock-free union-find: they take blocks of nodes and
+// merge the classes of the ends of their outgoing arcs. As in the hooking
+// step of Shiloach and Vishkin, the root of a class is always linked to a
+// smaller root, with a compare-and-swap, so that the root of each class is
+// its smallest node. The finds use path halving. The components are then
+// numbered in the order of their smallest node, so the result does not
+// depend on the number of threads.
+//
+// References:
+// - Y. Shiloach and U. Vishkin, "An O(log n) parallel connectivity
+//   algorithm", Journal of Algorithms 3 (1): 57-67, 1982.
+// - S. V. Jayanti and R. E. Tarjan, "A randomized concurrent algorithm for
+//   disjoint set union", PODC 2016.
+//
+// Usage example (the object can be reused for several graphs):
+// ParallelConnectedComponents<StaticGraph<> > components;
+// components.set_num_threads(16);
+// std::vector<int32> component_of_node;
+// const int32 num_components =
+//     components.ComputeComponents(graph, &component_of_node);
+template <typename Graph>
+class ParallelConnectedComponents {
+ public:
+  typedef typename Graph::NodeIndex NodeIndex;
+
+  ParallelConnectedComponents()
+      : num_threads_(1), graph_(nullptr), parent_size_(0), next_block_(0) {}
+
+  // Sets the number of threads, including the calling thread. Defaults to 1.
+  void set_num_threads(int num_threads) {
+    CHECK_GE(num_threads, 1);
+    num_threads_ = num_threads;
+  }
+
+  // Fills component_of_node[node] with the index of the component of each
+  // node, in [0, number of components), and returns the number of
+  // components. The components are numbered by increasing smallest node.
+  NodeIndex ComputeComponents(const Graph& graph,
+                              std::vector<NodeIndex>* component_of_node);
+
+ private:
+  // The number of nodes in the blocks taken by the threads.
+  static const NodeIndex kBlockSize = 4096;
+
+  NodeIndex Find(NodeIndex node) {
+    NodeIndex parent = parent_[node].load(std::memory_order_relaxed);
+    while (parent != node) {
+      const NodeIndex grandparent =
+          parent_[parent].load(std::memory_order_relaxed);
+      // node is not a root, so its parent can only be changed by path
+      // halving, to one of its ancestors. The races are thus harmless.
+      if (grandparent != parent) {
+        parent_[node].store(grandparent, std::memory_order_relaxed);
+      }
+      node = parent;
+      parent = grandparent;
+    }
+    return node;
+  }
+
+  void Union(NodeIndex node1, NodeIndex node2) {
+    for (;;) {
+      node1 = Find(node1);
+      node2 = Find(node2);
+      if (node1 == node2) return;
+      if (node1 < node2) std::swap(node1, node2);
+      // Links the larger root to the smaller one, if it is still a root.
+      NodeIndex expected = node1;
+      if (parent_[node1].compare_exchange_strong(expected, node2)) return;
+    }
+  }
+
+  // Takes blocks of nodes and merges the classes of the ends of their arcs.
+  void MergeArcs();
+
+  // Takes blocks of nodes and links each node directly to its root.
+  void CompressPaths();
+
+  int num_threads_;
+  const Graph* graph_;
+  std::unique_ptr<std::atomic<NodeIndex>[]> parent_;
+  NodeIndex parent_size_;
+  std::atomic<int> next_block_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelConnectedComponents);
+};
+
+template <typename Graph>
+typename Graph::NodeIndex ParallelConnectedComponents<Graph>::ComputeComponents(
+    const Graph& graph, std::vector<NodeIndex>* component_of_node) {
+  const NodeIndex num_nodes = graph.num_nodes();
+  if (parent_size_ < num_nodes) {
+    parent_.reset(new std::atomic<NodeIndex>[num_nodes]);
+    parent_size_ = num_nodes;
+  }
+  for (NodeIndex node = 0; node < num_nodes; ++node) {
+    parent_[node].store(node, std::memory_order_relaxed);
+  }
+  graph_ = &graph;
+  const int64 num_blocks =
+      (static_cast<int64>(num_nodes) + kBlockSize - 1) / kBlockSize;
+  const int num_threads =
+      std::max<int64>(1, std::min<int64>(num_threads_, num_blocks));
+  for (int phase = 0; phase < 2; ++phase) {
+    void (ParallelConnectedComponents::*work)() =
+        phase == 0 ? &ParallelConnectedComponents::MergeArcs
+                   : &ParallelConnectedComponents::CompressPaths;
+    next_block_ = 0;
+    std::vector<std::thread> threads;
+    for (int thread = 1; thread < num_threads; ++thread) {
+      threads.push_back(std::thread(work, this));
+    }
+    (this->*work)();
+    for (int thread = 0; thread < threads.size(); ++thread) {
+      threads[thread].join();
+    }
+  }
+  graph_ = nullptr;
+
+  // The roots are the smallest nodes of their classes, so they are numbered
+  // before the other nodes of their classes.
+  component_of_node->resize(num_nodes);
+  NodeIndex num_components = 0;
+  for (NodeIndex node = 0; node < num_nodes; ++node) {
+    const NodeIndex root = parent_[node].load(std::memory_order_relaxed);
+    (*component_of_node)[node] =
+        root == node ? num_components++ : (*component_of_node)[root];
+  }
+  return num_components;
+}
+
+template <typename Graph>
+void ParallelConnectedComponents<Graph>::MergeArcs() {
+  const NodeIndex num_nodes = graph_->num_nodes();
+  for (;;) {
+    const int64 begin = static_cast<int64>(kBlockSize) * next_block_++;
+    if (begin >= num_nodes) break;
+    const NodeIndex end = std::min<int64>(num_nodes, begin + kBlockSize);
+    for (NodeIndex node = begin; node < end; ++node) {
+      for (const typename Graph::ArcIndex arc : graph_->OutgoingArcs(node)) {
+        Union(node, graph_->Head(arc));
+      }
+    }
+  }
+}
+
+template <typename Graph>
+void ParallelConnectedComponents<Graph>::CompressPaths() {
+  const NodeIndex num_nodes = graph_->num_nodes();
+  for (;;) {
+    const int64 begin = static_cast<int64>(kBlockSize) * next_block_++;
+    if (begin >= num_nodes) break;
+    const NodeIndex end = std::min<int64>(num_nodes, begin + kBlockSize);
+    for (NodeIndex node = begin; node < end; ++node) {
+      parent_[node].store(Find(node), std::memory_order_relaxed);
+    }
+  }
+}
+
 }  // namespace operations_research
 
 #endif  // OR_TOOLS_GRAPH_CONNECTIVITY_H_
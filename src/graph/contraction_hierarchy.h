@@ -0,0 +1,844 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Contraction hierarchies: a preprocessing of a static directed graph with
+// nonnegative arc lengths that answers point-to-point shortest path queries
+// orders of magnitude faster than Dijkstra on road-like graphs.
+//
+// Reference: R. Geisberger, P. Sanders, D. Schultes, D. Delling, "Contraction
+// Hierarchies: Faster and Simpler Hierarchical Routing in Road Networks",
+// WEA 2008.
+//
+// Preprocessing: the nodes are "contracted" one by one, in increasing order of
+// importance. Contracting a node v removes it from the remaining graph and, for
+// each pair of remaining arcs u->v and v->w, adds a "shortcut" arc u->w of the
+// same length as u->v->w, unless a local "witness" search finds a path from u
+// to w avoiding v that is not longer. The importance of a node is its edge
+// difference (number of shortcuts that its contraction would add minus the
+// number of arcs it removes) plus its number of already contracted neighbors,
+// and it is updated lazily. The rank of a node is its contraction order.
+//
+// Query: any shortest path in the original graph has a counterpart of the same
+// length in the graph with shortcuts that first goes up in rank and then goes
+// down. It is found by two Dijkstra searches that only follow arcs towards
+// higher ranks: a forward one from the source in the "upward" graph and a
+// backward one from the target in the "downward" graph. Both searches are
+// tiny, and use stall-on-demand to prune them further. Shortcuts store their
+// middle node so that the path in the original graph can be recovered.
+//
+// The hierarchy can be saved to a compact binary file and loaded back with
+// mmap(), in O(1) and without copy; see WriteToFile() and LoadFromFile().
+//
+// Example:
+//   ContractionHierarchy<int64> hierarchy;
+//   ContractionHierarchyBuilder<int64> builder;
+//   builder.Build(graph, arc_lengths, &hierarchy);
+//   CHECK_OK(hierarchy.WriteToFile("roads.ch"));
+//   ...
+//   ContractionHierarchy<int64> loaded;
+//   CHECK_OK(loaded.LoadFromFile("roads.ch"));
+//   ContractionHierarchyQuery<int64> query(&loaded);  // One per thread.
+//   const int64 distance = query.Distance(source, target);
+//
+// Nodes and arcs are int32, like the default types of ./graph.h.
+//
+// Keywords: shortest path, contraction hierarchies, road network, routing.
+
+#ifndef OR_TOOLS_GRAPH_CONTRACTION_HIERARCHY_H_
+#define OR_TOOLS_GRAPH_CONTRACTION_HIERARCHY_H_
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "base/integral_types.h"
+#include "base/join.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/status.h"
+#include "util/dary_heap.h"
+#include "util/memory_mapped_file.h"
+
+namespace operations_research {
+
+template <typename DistanceType>
+class ContractionHierarchyBuilder;
+template <typename DistanceType>
+class ContractionHierarchyQuery;
+
+// The result of the preprocessing. It is immutable once built or loaded, and
+// can thus be shared by several ContractionHierarchyQuery objects running in
+// different threads.
+template <typename DistanceType = int64>
+class ContractionHierarchy {
+ public:
+  // Arcs leaving each node, in compressed sparse row format: the arcs of node
+  // n are [start[n], start[n + 1]). For a shortcut arc, middle is the node
+  // that was contracted to create it, and -1 for an original arc.
+  struct ArcArrays {
+    ArcArrays() : start(nullptr), head(nullptr), middle(nullptr),
+                  length(nullptr) {}
+    const int32* start;
+    const int32* head;
+    const int32* middle;
+    const DistanceType* length;
+  };
+
+  ContractionHierarchy() : num_nodes_(0), rank_(nullptr) {}
+
+  int32 num_nodes() const { return num_nodes_; }
+  int32 num_upward_arcs() const {
+    return num_nodes_ == 0 ? 0 : upward_.start[num_nodes_];
+  }
+  int32 num_downward_arcs() const {
+    return num_nodes_ == 0 ? 0 : downward_.start[num_nodes_];
+  }
+
+  // The position of the node in the contraction order.
+  int32 Rank(int32 node) const { return rank_[node]; }
+
+  // The upward graph has an arc tail->head for each arc (original or
+  // shortcut) such that Rank(head) > Rank(tail). The downward graph has an arc
+  // head->tail for each arc tail->head such that Rank(tail) > Rank(head). Thus
+  // both only go towards higher ranks.
+  const ArcArrays& upward() const { return upward_; }
+  const ArcArrays& downward() const { return downward_; }
+
+  // Writes the hierarchy in a binary format. The arrays are written as they
+  // are in memory, so the file can only be read back on a machine with the
+  // same endianness, and with the same DistanceType.
+  util::Status WriteToFile(const std::string& filename) const;
+
+  // Replaces the hierarchy by the one stored in the given file, which is
+  // mapped in memory. Only the header is read, so this runs in O(1).
+  util::Status LoadFromFile(const std::string& filename);
+
+ private:
+  friend class ContractionHierarchyBuilder<DistanceType>;
+
+  // Storage of the arrays when they are not in mapped_file_.
+  struct ArcVectors {
+    std::vector<int32> start;
+    std::vector<int32> head;
+    std::vector<int32> middle;
+    std::vector<DistanceType> length;
+  };
+
+  static void SetArcArrays(const ArcVectors& vectors, ArcArrays* arrays) {
+    arrays->start = vectors.start.data();
+    arrays->head = vectors.head.data();
+    arrays->middle = vectors.middle.data();
+    arrays->length = vectors.length.data();
+  }
+
+  // Called by the builder once the vectors are filled.
+  void SetUpFromVectors() {
+    mapped_file_.Close();
+    num_nodes_ = rank_vector_.size();
+    rank_ = rank_vector_.data();
+    SetArcArrays(upward_vectors_, &upward_);
+    SetArcArrays(downward_vectors_, &downward_);
+  }
+
+  int32 num_nodes_;
+  const int32* rank_;
+  ArcArrays upward_;
+  ArcArrays downward_;
+
+  std::vector<int32> rank_vector_;
+  ArcVectors upward_vectors_;
+  ArcVectors downward_vectors_;
+  MemoryMappedFile mapped_file_;
+
+  DISALLOW_COPY_AND_ASSIGN(ContractionHierarchy);
+};
+
+// Computes the contraction hierarchy of a graph.
+template <typename DistanceType = int64>
+class ContractionHierarchyBuilder {
+ public:
+  ContractionHierarchyBuilder()
+      : max_settled_nodes_in_witness_search_(500), num_shortcuts_(0) {}
+
+  // The witness searches stop after settling that many nodes, in which case
+  // the shortcut is added even if it might not be needed. Larger values give
+  // fewer shortcuts (thus faster queries) but a slower preprocessing.
+  void set_max_settled_nodes_in_witness_search(int value) {
+    max_settled_nodes_in_witness_search_ = value;
+  }
+
+  // Builds the hierarchy of the given graph, which can be any graph of
+  // ./graph.h. arc_lengths is indexed by arc and must be nonnegative. Parallel
+  // arcs and self-loops are allowed.
+  template <class Graph>
+  void Build(const Graph& graph, const std::vector<DistanceType>& arc_lengths,
+             ContractionHierarchy<DistanceType>* hierarchy);
+
+  // The number of shortcuts in the last built hierarchy.
+  int64 num_shortcuts() const { return num_shortcuts_; }
+
+ private:
+  struct Edge {
+    Edge(int32 o, DistanceType l, int32 m) : other(o), length(l), middle(m) {}
+    int32 other;
+    DistanceType length;
+    int32 middle;
+  };
+  struct Shortcut {
+    Shortcut(int32 t, int32 h, DistanceType l) : tail(t), head(h), length(l) {}
+    int32 tail;
+    int32 head;
+    DistanceType length;
+  };
+
+  // Adds the arc tail->head to the remaining graph, or shortens the existing
+  // one if it is longer.
+  void AddOrImproveEdge(int32 tail, int32 head, DistanceType length,
+                        int32 middle);
+
+  // Removes the edge to node from the given list.
+  static void RemoveEdgeTo(int32 node, std::vector<Edge>* edges);
+
+  // Runs a Dijkstra from source in the remaining graph without the node
+  // "excluded", and stops at distance max_distance. The (tentative) distances
+  // are in witness_distance_.
+  void WitnessSearch(int32 source, int32 excluded, DistanceType max_distance);
+
+  // Fills the shortcuts needed to contract node.
+  void ComputeShortcuts(int32 node, std::vector<Shortcut>* shortcuts);
+
+  // Returns the contraction priority of the node, lower is contracted first.
+  int64 Priority(int32 node);
+
+  // Contracts the node and appends its uncontracted neighbors to neighbors.
+  void Contract(int32 node, std::vector<int32>* neighbors);
+
+  // Flattens per-node edge lists into CSR vectors.
+  static void Flatten(const std::vector<std::vector<Edge> >& edges,
+                      typename ContractionHierarchy<DistanceType>::ArcVectors*
+                          vectors);
+
+  int max_settled_nodes_in_witness_search_;
+  int64 num_shortcuts_;
+
+  // The remaining graph: out_[n] and in_[n] are the arcs leaving and entering
+  // n. The contracted nodes and their arcs are removed from these lists.
+  std::vector<std::vector<Edge> > out_;
+  std::vector<std::vector<Edge> > in_;
+  // The arcs of the hierarchy, in the format of ContractionHierarchy.
+  std::vector<std::vector<Edge> > upward_;
+  std::vector<std::vector<Edge> > downward_;
+  std::vector<int32> num_contracted_neighbors_;
+  std::vector<Shortcut> shortcuts_;
+
+  // Witness search workspace.
+  std::vector<DistanceType> witness_distance_;
+  std::vector<int32> witness_touched_;
+  DaryHeap<DistanceType, int32> witness_heap_;
+
+  DISALLOW_COPY_AND_ASSIGN(ContractionHierarchyBuilder);
+};
+
+// Point-to-point shortest path queries on a ContractionHierarchy. The object is
+// a reusable workspace: it is not thread-safe, but several queries can share
+// the same hierarchy. The setup cost of a query is proportional to the size of
+// the previous query search space.
+template <typename DistanceType = int64>
+class ContractionHierarchyQuery {
+ public:
+  static const DistanceType kInfinity;
+
+  explicit ContractionHierarchyQuery(
+      const ContractionHierarchy<DistanceType>* hierarchy);
+
+  // Returns the distance from source to target, or kInfinity if target is not
+  // reachable.
+  DistanceType Distance(int32 source, int32 target);
+
+  // Fills the nodes of the shortest path found by the last Distance() call, in
+  // the original graph, from source to target. The path is empty if the target
+  // was not reachable.
+  void NodePath(std::vector<int32>* nodes) const;
+
+  // The number of nodes settled by the last query, for statistics.
+  int num_settled_nodes() const { return num_settled_nodes_; }
+
+ private:
+  typedef typename ContractionHierarchy<DistanceType>::ArcArrays ArcArrays;
+
+  // An arc of the hierarchy, used for the path unpacking.
+  struct PackedArc {
+    PackedArc(int32 t, int32 h, DistanceType l, int32 m)
+        : tail(t), head(h), length(l), middle(m) {}
+    int32 tail;
+    int32 head;
+    DistanceType length;
+    int32 middle;
+  };
+
+  struct Search {
+    explicit Search(int32 num_nodes)
+        : distance(num_nodes, kInfinity),
+          parent(num_nodes, -1),
+          parent_arc(num_nodes, -1),
+          heap(num_nodes) {}
+    void Reset(int32 root);
+
+    std::vector<DistanceType> distance;
+    std::vector<int32> parent;
+    std::vector<int32> parent_arc;
+    std::vector<int32> touched;
+    DaryHeap<DistanceType, int32> heap;
+  };
+
+  // Settles the next node of search, which follows the arcs "arcs" and whose
+  // node can be stalled using the arcs "opposite_arcs".
+  void Step(const ArcArrays& arcs, const ArcArrays& opposite_arcs,
+            Search* search, const Search& other);
+
+  // Appends the nodes of the original path corresponding to the arc
+  // tail->head of the given length and middle node, head included.
+  void UnpackArc(int32 tail, int32 head, DistanceType length, int32 middle,
+                 std::vector<int32>* nodes) const;
+
+  // Returns the index of the arc node->head in the given arrays.
+  static int32 FindArc(const ArcArrays& arcs, int32 node, int32 head);
+
+  const ContractionHierarchy<DistanceType>* const hierarchy_;
+  Search forward_;
+  Search backward_;
+  DistanceType best_distance_;
+  int32 meeting_node_;
+  int num_settled_nodes_;
+
+  DISALLOW_COPY_AND_ASSIGN(ContractionHierarchyQuery);
+};
+
+// Implementation of the templated methods.
+
+namespace internal {
+
+// Header of the binary file format of ContractionHierarchy. It is followed by
+// the arrays rank, upward start/head/middle/length and downward
+// start/head/middle/length, each padded to a multiple of 8 bytes.
+struct ContractionHierarchyFileHeader {
+  static const uint64 kMagic = 0x3130484354524fULL;  // "ORTCH01" little-endian.
+  static const uint32 kVersion = 1;
+  uint64 magic;
+  uint32 version;
+  uint32 distance_type_size;
+  int64 num_nodes;
+  int64 num_upward_arcs;
+  int64 num_downward_arcs;
+};
+
+inline int64 PaddedSize(int64 num_bytes) { return (num_bytes + 7) & ~7LL; }
+
+// Writes the array followed by its padding. Returns false on error.
+template <typename T>
+bool WritePaddedArray(const T* array, int64 size, FILE* f) {
+  const int64 num_bytes = size * sizeof(T);
+  if (num_bytes > 0 && fwrite(array, 1, num_bytes, f) != num_bytes) {
+    return false;
+  }
+  static const char kZeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  const int64 padding = PaddedSize(num_bytes) - num_bytes;
+  return padding == 0 || fwrite(kZeros, 1, padding, f) == padding;
+}
+
+// Returns the array starting at *offset in data, and advances offset.
+template <typename T>
+const T* ReadPaddedArray(const char* data, int64 size, int64* offset) {
+  const T* const array = reinterpret_cast<const T*>(data + *offset);
+  *offset += PaddedSize(size * sizeof(T));
+  return array;
+}
+
+}  // namespace internal
+
+template <typename DistanceType>
+util::Status ContractionHierarchy<DistanceType>::WriteToFile(
+    const std::string& filename) const {
+  FILE* const f = fopen(filename.c_str(), "wb");
+  if (f == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "Could not open file: '" + filename + "'");
+  }
+  internal::ContractionHierarchyFileHeader header;
+  header.magic = internal::ContractionHierarchyFileHeader::kMagic;
+  header.version = internal::ContractionHierarchyFileHeader::kVersion;
+  header.distance_type_size = sizeof(DistanceType);
+  header.num_nodes = num_nodes_;
+  header.num_upward_arcs = num_upward_arcs();
+  header.num_downward_arcs = num_downward_arcs();
+  const int64 num_starts = num_nodes_ == 0 ? 0 : num_nodes_ + 1;
+  bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+            internal::WritePaddedArray(rank_, num_nodes_, f);
+  const ArcArrays* const all_arcs[] = {&upward_, &downward_};
+  const int64 num_arcs[] = {header.num_upward_arcs, header.num_downward_arcs};
+  for (int i = 0; i < 2; ++i) {
+    ok = ok && internal::WritePaddedArray(all_arcs[i]->start, num_starts, f) &&
+         internal::WritePaddedArray(all_arcs[i]->head, num_arcs[i], f) &&
+         internal::WritePaddedArray(all_arcs[i]->middle, num_arcs[i], f) &&
+         internal::WritePaddedArray(all_arcs[i]->length, num_arcs[i], f);
+  }
+  if (fclose(f) != 0 || !ok) {
+    return util::Status(util::error::INTERNAL,
+                        "Could not write file '" + filename + "'");
+  }
+  return util::Status::OK;
+}
+
+template <typename DistanceType>
+util::Status ContractionHierarchy<DistanceType>::LoadFromFile(
+    const std::string& filename) {
+  typedef internal::ContractionHierarchyFileHeader Header;
+  rank_vector_.clear();
+  upward_vectors_ = ArcVectors();
+  downward_vectors_ = ArcVectors();
+  num_nodes_ = 0;
+  const util::Status status = mapped_file_.Open(filename);
+  if (!status.ok()) return status;
+  const char* const data = mapped_file_.data();
+  Header header;
+  if (mapped_file_.size() < sizeof(header)) {
+    mapped_file_.Close();
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        StrCat("'", filename, "' is too short."));
+  }
+  memcpy(&header, data, sizeof(header));
+  if (header.magic != Header::kMagic || header.version != Header::kVersion ||
+      header.distance_type_size != sizeof(DistanceType)) {
+    mapped_file_.Close();
+    return util::Status(
+        util::error::INVALID_ARGUMENT,
+        StrCat("'", filename, "' is not a contraction hierarchy file of this",
+               " version and distance type."));
+  }
+  const int64 num_nodes = header.num_nodes;
+  const int64 num_starts = num_nodes == 0 ? 0 : num_nodes + 1;
+  int64 expected_size = internal::PaddedSize(sizeof(header)) +
+                        internal::PaddedSize(num_nodes * sizeof(int32));
+  const int64 num_arcs[] = {header.num_upward_arcs, header.num_downward_arcs};
+  for (int i = 0; i < 2; ++i) {
+    expected_size += internal::PaddedSize(num_starts * sizeof(int32)) +
+                     2 * internal::PaddedSize(num_arcs[i] * sizeof(int32)) +
+                     internal::PaddedSize(num_arcs[i] * sizeof(DistanceType));
+  }
+  if (num_nodes < 0 || num_nodes > std::numeric_limits<int32>::max() ||
+      mapped_file_.size() != expected_size) {
+    mapped_file_.Close();
+    return util::Status(
+        util::error::INVALID_ARGUMENT,
+        StrCat("'", filename, "' is truncated or corrupted: its size is ",
+               mapped_file_.size(), " instead of ", expected_size, "."));
+  }
+  int64 offset = internal::PaddedSize(sizeof(header));
+  rank_ = internal::ReadPaddedArray<int32>(data, num_nodes, &offset);
+  ArcArrays* const all_arcs[] = {&upward_, &downward_};
+  for (int i = 0; i < 2; ++i) {
+    all_arcs[i]->start =
+        internal::ReadPaddedArray<int32>(data, num_starts, &offset);
+    all_arcs[i]->head =
+        internal::ReadPaddedArray<int32>(data, num_arcs[i], &offset);
+    all_arcs[i]->middle =
+        internal::ReadPaddedArray<int32>(data, num_arcs[i], &offset);
+    all_arcs[i]->length =
+        internal::ReadPaddedArray<DistanceType>(data, num_arcs[i], &offset);
+    if (num_nodes > 0 && (all_arcs[i]->start[0] != 0 ||
+                          all_arcs[i]->start[num_nodes] != num_arcs[i])) {
+      mapped_file_.Close();
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          StrCat("'", filename, "' is corrupted."));
+    }
+  }
+  num_nodes_ = num_nodes;
+  return util::Status::OK;
+}
+
+template <typename DistanceType>
+void ContractionHierarchyBuilder<DistanceType>::AddOrImproveEdge(
+    int32 tail, int32 head, DistanceType length, int32 middle) {
+  for (Edge& edge : out_[tail]) {
+    if (edge.other != head) continue;
+    if (edge.length <= length) return;
+    edge.length = length;
+    edge.middle = middle;
+    for (Edge& reverse_edge : in_[head]) {
+      if (reverse_edge.other == tail) {
+        reverse_edge.length = length;
+        reverse_edge.middle = middle;
+        return;
+      }
+    }
+    LOG(DFATAL) << "Inconsistent remaining graph.";
+  }
+  out_[tail].push_back(Edge(head, length, middle));
+  in_[head].push_back(Edge(tail, length, middle));
+}
+
+template <typename DistanceType>
+void ContractionHierarchyBuilder<DistanceType>::RemoveEdgeTo(
+    int32 node, std::vector<Edge>* edges) {
+  for (int i = 0; i < edges->size(); ++i) {
+    if ((*edges)[i].other == node) {
+      (*edges)[i] = edges->back();
+      edges->pop_back();
+      return;
+    }
+  }
+}
+
+template <typename DistanceType>
+void ContractionHierarchyBuilder<DistanceType>::WitnessSearch(
+    int32 source, int32 excluded, DistanceType max_distance) {
+  const DistanceType kInfinity = std::numeric_limits<DistanceType>::max();
+  for (const int32 node : witness_touched_) {
+    witness_distance_[node] = kInfinity;
+  }
+  witness_touched_.clear();
+  witness_heap_.Clear();
+  witness_distance_[source] = 0;
+  witness_touched_.push_back(source);
+  witness_heap_.Push(source, 0);
+  int num_settled = 0;
+  while (!witness_heap_.IsEmpty() &&
+         witness_heap_.TopPriority() <= max_distance &&
+         num_settled < max_settled_nodes_in_witness_search_) {
+    const int32 node = witness_heap_.Pop();
+    ++num_settled;
+    const DistanceType node_distance = witness_distance_[node];
+    for (const Edge& edge : out_[node]) {
+      if (edge.other == excluded) continue;
+      const DistanceType distance = node_distance + edge.length;
+      if (distance >= witness_distance_[edge.other]) continue;
+      if (witness_distance_[edge.other] == kInfinity) {
+        witness_touched_.push_back(edge.other);
+      }
+      witness_distance_[edge.other] = distance;
+      witness_heap_.PushOrDecrease(edge.other, distance);
+    }
+  }
+}
+
+template <typename DistanceType>
+void ContractionHierarchyBuilder<DistanceType>::ComputeShortcuts(
+    int32 node, std::vector<Shortcut>* shortcuts) {
+  shortcuts->clear();
+  if (out_[node].empty()) return;
+  DistanceType max_out_length = 0;
+  for (const Edge& out_edge : out_[node]) {
+    max_out_length = std::max(max_out_length, out_edge.length);
+  }
+  for (const Edge& in_edge : in_[node]) {
+    const int32 tail = in_edge.other;
+    WitnessSearch(tail, node, in_edge.length + max_out_length);
+    for (const Edge& out_edge : out_[node]) {
+      const int32 head = out_edge.other;
+      if (head == tail) continue;
+      const DistanceType length = in_edge.length + out_edge.length;
+      if (witness_distance_[head] > length) {
+        shortcuts->push_back(Shortcut(tail, head, length));
+      }
+    }
+  }
+}
+
+template <typename DistanceType>
+int64 ContractionHierarchyBuilder<DistanceType>::Priority(int32 node) {
+  ComputeShortcuts(node, &shortcuts_);
+  const int64 num_removed_arcs = in_[node].size() + out_[node].size();
+  return static_cast<int64>(shortcuts_.size()) - num_removed_arcs +
+         num_contracted_neighbors_[node];
+}
+
+template <typename DistanceType>
+void ContractionHierarchyBuilder<DistanceType>::Contract(
+    int32 node, std::vector<int32>* neighbors) {
+  ComputeShortcuts(node, &shortcuts_);
+  // All the remaining neighbors have a higher rank than node, so its remaining
+  // arcs are exactly its arcs in the hierarchy.
+  upward_[node] = out_[node];
+  downward_[node] = in_[node];
+  neighbors->clear();
+  for (const Edge& edge : out_[node]) {
+    RemoveEdgeTo(node, &in_[edge.other]);
+    neighbors->push_back(edge.other);
+  }
+  for (const Edge& edge : in_[node]) {
+    RemoveEdgeTo(node, &out_[edge.other]);
+    neighbors->push_back(edge.other);
+  }
+  std::vector<Edge>().swap(out_[node]);
+  std::vector<Edge>().swap(in_[node]);
+  for (const Shortcut& shortcut : shortcuts_) {
+    AddOrImproveEdge(shortcut.tail, shortcut.head, shortcut.length, node);
+  }
+  num_shortcuts_ += shortcuts_.size();
+  std::sort(neighbors->begin(), neighbors->end());
+  neighbors->erase(std::unique(neighbors->begin(), neighbors->end()),
+                   neighbors->end());
+}
+
+template <typename DistanceType>
+void ContractionHierarchyBuilder<DistanceType>::Flatten(
+    const std::vector<std::vector<Edge> >& edges,
+    typename ContractionHierarchy<DistanceType>::ArcVectors* vectors) {
+  const int32 num_nodes = edges.size();
+  vectors->start.assign(num_nodes + 1, 0);
+  for (int32 node = 0; node < num_nodes; ++node) {
+    vectors->start[node + 1] = vectors->start[node] + edges[node].size();
+  }
+  const int32 num_arcs = vectors->start[num_nodes];
+  vectors->head.resize(num_arcs);
+  vectors->middle.resize(num_arcs);
+  vectors->length.resize(num_arcs);
+  for (int32 node = 0; node < num_nodes; ++node) {
+    int32 arc = vectors->start[node];
+    for (const Edge& edge : edges[node]) {
+      vectors->head[arc] = edge.other;
+      vectors->middle[arc] = edge.middle;
+      vectors->length[arc] = edge.length;
+      ++arc;
+    }
+  }
+}
+
+template <typename DistanceType>
+template <class Graph>
+void ContractionHierarchyBuilder<DistanceType>::Build(
+    const Graph& graph, const std::vector<DistanceType>& arc_lengths,
+    ContractionHierarchy<DistanceType>* hierarchy) {
+  const int32 num_nodes = graph.num_nodes();
+  out_.assign(num_nodes, std::vector<Edge>());
+  in_.assign(num_nodes, std::vector<Edge>());
+  upward_.assign(num_nodes, std::vector<Edge>());
+  downward_.assign(num_nodes, std::vector<Edge>());
+  num_contracted_neighbors_.assign(num_nodes, 0);
+  witness_distance_.assign(num_nodes, std::numeric_limits<DistanceType>::max());
+  witness_touched_.clear();
+  witness_heap_.Clear();
+  witness_heap_.Reserve(num_nodes);
+  num_shortcuts_ = 0;
+  for (const typename Graph::NodeIndex tail : graph.AllNodes()) {
+    for (const typename Graph::ArcIndex arc : graph.OutgoingArcs(tail)) {
+      const int32 head = graph.Head(arc);
+      DCHECK_GE(arc_lengths[arc], 0);
+      if (head != tail) AddOrImproveEdge(tail, head, arc_lengths[arc], -1);
+    }
+  }
+
+  // Contract the nodes by increasing priority, with lazy updates: the priority
+  // of the top node is recomputed before contracting it, and if it is no longer
+  // the smallest one the node is pushed back.
+  DaryHeap<int64, int32> queue(num_nodes);
+  for (int32 node = 0; node < num_nodes; ++node) {
+    queue.Push(node, Priority(node));
+  }
+  std::vector<int32>& rank = hierarchy->rank_vector_;
+  rank.assign(num_nodes, -1);
+  std::vector<int32> neighbors;
+  int32 next_rank = 0;
+  while (!queue.IsEmpty()) {
+    const int32 node = queue.Pop();
+    const int64 priority = Priority(node);
+    if (!queue.IsEmpty() && priority > queue.TopPriority()) {
+      queue.Push(node, priority);
+      continue;
+    }
+    Contract(node, &neighbors);
+    rank[node] = next_rank++;
+    for (const int32 neighbor : neighbors) {
+      ++num_contracted_neighbors_[neighbor];
+      queue.ChangePriority(neighbor, Priority(neighbor));
+    }
+  }
+  VLOG(1) << "Contraction hierarchy built with " << num_shortcuts_
+          << " shortcuts.";
+
+  Flatten(upward_, &hierarchy->upward_vectors_);
+  Flatten(downward_, &hierarchy->downward_vectors_);
+  hierarchy->SetUpFromVectors();
+  std::vector<std::vector<Edge> >().swap(out_);
+  std::vector<std::vector<Edge> >().swap(in_);
+  std::vector<std::vector<Edge> >().swap(upward_);
+  std::vector<std::vector<Edge> >().swap(downward_);
+}
+
+template <typename DistanceType>
+const DistanceType ContractionHierarchyQuery<DistanceType>::kInfinity =
+    std::numeric_limits<DistanceType>::max();
+
+template <typename DistanceType>
+ContractionHierarchyQuery<DistanceType>::ContractionHierarchyQuery(
+    const ContractionHierarchy<DistanceType>* hierarchy)
+    : hierarchy_(hierarchy),
+      forward_(hierarchy->num_nodes()),
+      backward_(hierarchy->num_nodes()),
+      best_distance_(kInfinity),
+      meeting_node_(-1),
+      num_settled_nodes_(0) {}
+
+template <typename DistanceType>
+void ContractionHierarchyQuery<DistanceType>::Search::Reset(int32 root) {
+  for (const int32 node : touched) distance[node] = kInfinity;
+  touched.clear();
+  heap.Clear();
+  distance[root] = 0;
+  parent[root] = -1;
+  parent_arc[root] = -1;
+  touched.push_back(root);
+  heap.Push(root, 0);
+}
+
+template <typename DistanceType>
+void ContractionHierarchyQuery<DistanceType>::Step(
+    const ArcArrays& arcs, const ArcArrays& opposite_arcs, Search* search,
+    const Search& other) {
+  const int32 node = search->heap.Pop();
+  ++num_settled_nodes_;
+  const DistanceType node_distance = search->distance[node];
+  if (other.distance[node] != kInfinity &&
+      node_distance + other.distance[node] < best_distance_) {
+    best_distance_ = node_distance + other.distance[node];
+    meeting_node_ = node;
+  }
+  // Stall-on-demand: if a higher node reached by this search has an arc to
+  // node that gives a shorter distance, node is not on a shortest up path and
+  // its arcs do not need to be relaxed.
+  for (int32 arc = opposite_arcs.start[node];
+       arc < opposite_arcs.start[node + 1]; ++arc) {
+    const DistanceType higher_distance =
+        search->distance[opposite_arcs.head[arc]];
+    if (higher_distance != kInfinity &&
+        higher_distance + opposite_arcs.length[arc] < node_distance) {
+      return;
+    }
+  }
+  for (int32 arc = arcs.start[node]; arc < arcs.start[node + 1]; ++arc) {
+    const int32 head = arcs.head[arc];
+    const DistanceType distance = node_distance + arcs.length[arc];
+    if (distance >= search->distance[head]) continue;
+    if (search->distance[head] == kInfinity) search->touched.push_back(head);
+    search->distance[head] = distance;
+    search->parent[head] = node;
+    search->parent_arc[head] = arc;
+    search->heap.PushOrDecrease(head, distance);
+  }
+}
+
+template <typename DistanceType>
+DistanceType ContractionHierarchyQuery<DistanceType>::Distance(int32 source,
+                                                               int32 target) {
+  DCHECK_GE(source, 0);
+  DCHECK_LT(source, hierarchy_->num_nodes());
+  DCHECK_GE(target, 0);
+  DCHECK_LT(target, hierarchy_->num_nodes());
+  forward_.Reset(source);
+  backward_.Reset(target);
+  best_distance_ = kInfinity;
+  meeting_node_ = -1;
+  num_settled_nodes_ = 0;
+  // Unlike in a plain bidirectional Dijkstra, the searches do not settle the
+  // nodes by increasing distance from the source, so each search must go on
+  // until its frontier is at least as far as the best distance found.
+  for (;;) {
+    const bool forward_open = !forward_.heap.IsEmpty() &&
+                              forward_.heap.TopPriority() < best_distance_;
+    const bool backward_open = !backward_.heap.IsEmpty() &&
+                               backward_.heap.TopPriority() < best_distance_;
+    if (!forward_open && !backward_open) break;
+    if (forward_open &&
+        (!backward_open ||
+         forward_.heap.TopPriority() <= backward_.heap.TopPriority())) {
+      Step(hierarchy_->upward(), hierarchy_->downward(), &forward_, backward_);
+    } else {
+      Step(hierarchy_->downward(), hierarchy_->upward(), &backward_, forward_);
+    }
+  }
+  return best_distance_;
+}
+
+template <typename DistanceType>
+int32 ContractionHierarchyQuery<DistanceType>::FindArc(const ArcArrays& arcs,
+                                                        int32 node,
+                                                        int32 head) {
+  for (int32 arc = arcs.start[node]; arc < arcs.start[node + 1]; ++arc) {
+    if (arcs.head[arc] == head) return arc;
+  }
+  LOG(DFATAL) << "Missing arc " << node << " -> " << head;
+  return -1;
+}
+
+template <typename DistanceType>
+void ContractionHierarchyQuery<DistanceType>::UnpackArc(
+    int32 tail, int32 head, DistanceType length, int32 middle,
+    std::vector<int32>* nodes) const {
+  // An arc tail->head with middle node m is the concatenation of tail->m,
+  // which is stored in the downward graph of m, and of m->head, which is stored
+  // in its upward graph. We use an explicit stack since the hierarchy can be
+  // deep.
+  const ArcArrays& upward = hierarchy_->upward();
+  const ArcArrays& downward = hierarchy_->downward();
+  std::vector<PackedArc> stack(1, PackedArc(tail, head, length, middle));
+  while (!stack.empty()) {
+    const PackedArc arc = stack.back();
+    stack.pop_back();
+    if (arc.middle == -1) {
+      nodes->push_back(arc.head);
+      continue;
+    }
+    const int32 first = FindArc(downward, arc.middle, arc.tail);
+    const int32 second = FindArc(upward, arc.middle, arc.head);
+    DCHECK_EQ(arc.length, downward.length[first] + upward.length[second]);
+    stack.push_back(PackedArc(arc.middle, arc.head, upward.length[second],
+                              upward.middle[second]));
+    stack.push_back(PackedArc(arc.tail, arc.middle, downward.length[first],
+                              downward.middle[first]));
+  }
+}
+
+template <typename DistanceType>
+void ContractionHierarchyQuery<DistanceType>::NodePath(
+    std::vector<int32>* nodes) const {
+  nodes->clear();
+  if (meeting_node_ == -1) return;
+  const ArcArrays& upward = hierarchy_->upward();
+  const ArcArrays& downward = hierarchy_->downward();
+  // Up part: the forward search tree from the meeting node to the source.
+  std::vector<int32> up_path;
+  for (int32 node = meeting_node_; node != -1; node = forward_.parent[node]) {
+    up_path.push_back(node);
+  }
+  nodes->push_back(up_path.back());
+  for (int i = static_cast<int>(up_path.size()) - 1; i > 0; --i) {
+    const int32 arc = forward_.parent_arc[up_path[i - 1]];
+    UnpackArc(up_path[i], up_path[i - 1], upward.length[arc],
+              upward.middle[arc], nodes);
+  }
+  // Down part: the backward search tree from the meeting node to the target,
+  // whose arcs child->parent are stored in the downward graph of parent.
+  for (int32 node = meeting_node_; backward_.parent[node] != -1;
+       node = backward_.parent[node]) {
+    const int32 arc = backward_.parent_arc[node];
+    UnpackArc(node, backward_.parent[node], downward.length[arc],
+              downward.middle[arc], nodes);
+  }
+}
+
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_GRAPH_CONTRACTION_HIERARCHY_H_
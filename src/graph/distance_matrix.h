@@ -0,0 +1,315 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Many-to-many shortest path distances on the graph classes of ./graph.h.
+//
+// The typical use case is to compute the travel time matrix between the stops
+// of a routing problem, given a road graph:
+//
+//   typedef StaticGraph<> Graph;
+//   Graph road_graph;
+//   std::vector<int64> travel_times;  // Indexed by arc.
+//   ...
+//   std::vector<int> stops;  // Node of each routing node, depot included.
+//   DistanceMatrixBuilder<Graph> builder(&road_graph, &travel_times,
+//                                        /*num_threads=*/8);
+//   builder.set_unreachable_distance(kLargePenalty);
+//   DistanceMatrix<int64> matrix;
+//   builder.Compute(stops, stops, &matrix);
+//   routing.AddMatrixDimension(matrix.row_pointers().data(), horizon, true,
+//                              "time");
+//
+// The rows (sources) are distributed dynamically across a pool of threads.
+// Each thread runs a one-to-all Dijkstra from its sources with its own
+// DijkstraSearch workspace, stopping as soon as all the targets are settled.
+// The workspaces are kept by the builder, so successive Compute() calls do not
+// allocate.
+//
+// For very large numbers of stops, where the full matrix does not fit in
+// memory, ComputeByBlocks() computes the matrix by blocks of consecutive rows
+// of bounded size, and hands each block to a user callback.
+
+#ifndef OR_TOOLS_GRAPH_DISTANCE_MATRIX_H_
+#define OR_TOOLS_GRAPH_DISTANCE_MATRIX_H_
+
+#include <algorithm>
+#include <atomic>
+#include "base/unique_ptr.h"
+#include <vector>
+
+#include "base/callback.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/threadpool.h"
+#include "graph/shortest_path_search.h"
+
+namespace operations_research {
+
+// A dense matrix stored contiguously in row-major order.
+template <typename DistanceType>
+class DistanceMatrix {
+ public:
+  DistanceMatrix() : num_rows_(0), num_cols_(0) {}
+
+  // Resizes the matrix. The content is undefined afterwards.
+  void Resize(int num_rows, int num_cols) {
+    num_rows_ = num_rows;
+    num_cols_ = num_cols;
+    values_.resize(static_cast<size_t>(num_rows) * num_cols);
+    row_pointers_.resize(num_rows);
+    for (int row = 0; row < num_rows; ++row) {
+      row_pointers_[row] = values_.data() + static_cast<size_t>(row) * num_cols;
+    }
+  }
+
+  int num_rows() const { return num_rows_; }
+  int num_cols() const { return num_cols_; }
+
+  DistanceType Value(int row, int col) const {
+    DCHECK_LT(row, num_rows_);
+    DCHECK_LT(col, num_cols_);
+    return values_[static_cast<size_t>(row) * num_cols_ + col];
+  }
+  const DistanceType* row(int row) const { return row_pointers_[row]; }
+  DistanceType* mutable_row(int row) {
+    return values_.data() + static_cast<size_t>(row) * num_cols_;
+  }
+
+  // All the values, row after row.
+  const std::vector<DistanceType>& values() const { return values_; }
+
+  // The pointers to the beginning of each row, in the layout expected by
+  // RoutingModel::AddMatrixDimension(). They are invalidated by Resize().
+  const std::vector<const DistanceType*>& row_pointers() const {
+    return row_pointers_;
+  }
+
+ private:
+  int num_rows_;
+  int num_cols_;
+  std::vector<DistanceType> values_;
+  std::vector<const DistanceType*> row_pointers_;
+
+  DISALLOW_COPY_AND_ASSIGN(DistanceMatrix);
+};
+
+template <class Graph, typename DistanceType = int64>
+class DistanceMatrixBuilder {
+ public:
+  typedef typename Graph::NodeIndex NodeIndex;
+  typedef DijkstraSearch<Graph, DistanceType> Search;
+
+  // Neither the graph nor the arc lengths are owned, and they must not be
+  // modified while the builder is in use. num_threads must be positive; with
+  // one thread, everything runs in the calling thread.
+  DistanceMatrixBuilder(const Graph* graph,
+                        const std::vector<DistanceType>* arc_lengths,
+                        int num_threads);
+
+  // The value stored in the matrix when a target is not reachable from a
+  // source. Defaults to Search::kInfinity, which is not suitable for the
+  // routing library where distances are summed: use a large penalty instead.
+  void set_unreachable_distance(DistanceType value) {
+    unreachable_distance_ = value;
+  }
+
+  // Fills matrix with the distances from each source to each target: the
+  // value at (i, j) is the distance from sources[i] to targets[j]. Duplicate
+  // nodes are allowed.
+  void Compute(const std::vector<NodeIndex>& sources,
+               const std::vector<NodeIndex>& targets,
+               DistanceMatrix<DistanceType>* matrix);
+
+  // Same as Compute(), but without ever storing more than max_block_bytes of
+  // distances (and at least one row). The rows are computed by blocks of
+  // consecutive rows, and block_consumer->Run(first_row, num_rows, values) is
+  // called for each block, in increasing row order, with values pointing to
+  // the num_rows * targets.size() distances of the block in row-major order.
+  // The values are only valid during the call. The callback is not owned and
+  // must be a permanent callback.
+  void ComputeByBlocks(const std::vector<NodeIndex>& sources,
+                       const std::vector<NodeIndex>& targets,
+                       int64 max_block_bytes,
+                       Callback3<int, int, const DistanceType*>* block_consumer);
+
+ private:
+  // Sets up the per-query state (target marks) and the workspaces.
+  void StartQuery(const std::vector<NodeIndex>& sources,
+                  const std::vector<NodeIndex>& targets);
+  void EndQuery();
+
+  // Computes the rows [first_row, first_row + num_rows) into output, using all
+  // the threads.
+  void ComputeRows(int first_row, int num_rows, DistanceType* output);
+
+  // Task run by each thread: computes rows until there is none left.
+  void RunWorker(Search* search);
+
+  // Computes one row of the matrix with the given workspace.
+  void ComputeRow(Search* search, NodeIndex source, DistanceType* output);
+
+  const Graph* const graph_;
+  const std::vector<DistanceType>* const arc_lengths_;
+  const int num_threads_;
+  DistanceType unreachable_distance_;
+  std::vector<std::unique_ptr<Search> > workspaces_;
+
+  // State of the current query, read-only during the parallel part except for
+  // next_row_.
+  const std::vector<NodeIndex>* sources_;
+  const std::vector<NodeIndex>* targets_;
+  std::vector<bool> is_target_;
+  int num_distinct_targets_;
+  std::atomic<int> next_row_;
+  int end_row_;
+  int block_first_row_;
+  DistanceType* block_output_;
+
+  DISALLOW_COPY_AND_ASSIGN(DistanceMatrixBuilder);
+};
+
+// Implementation of the templated methods.
+
+template <class Graph, typename DistanceType>
+DistanceMatrixBuilder<Graph, DistanceType>::DistanceMatrixBuilder(
+    const Graph* graph, const std::vector<DistanceType>* arc_lengths,
+    int num_threads)
+    : graph_(graph),
+      arc_lengths_(arc_lengths),
+      num_threads_(num_threads),
+      unreachable_distance_(Search::kInfinity),
+      sources_(nullptr),
+      targets_(nullptr),
+      is_target_(graph->num_nodes(), false),
+      num_distinct_targets_(0),
+      next_row_(0),
+      end_row_(0),
+      block_first_row_(0),
+      block_output_(nullptr) {
+  CHECK_GT(num_threads, 0);
+}
+
+template <class Graph, typename DistanceType>
+void DistanceMatrixBuilder<Graph, DistanceType>::StartQuery(
+    const std::vector<NodeIndex>& sources,
+    const std::vector<NodeIndex>& targets) {
+  sources_ = &sources;
+  targets_ = &targets;
+  num_distinct_targets_ = 0;
+  for (const NodeIndex target : targets) {
+    DCHECK(graph_->IsNodeValid(target));
+    if (!is_target_[target]) {
+      is_target_[target] = true;
+      ++num_distinct_targets_;
+    }
+  }
+  while (workspaces_.size() < num_threads_) {
+    workspaces_.emplace_back(new Search(graph_, arc_lengths_));
+  }
+}
+
+template <class Graph, typename DistanceType>
+void DistanceMatrixBuilder<Graph, DistanceType>::EndQuery() {
+  for (const NodeIndex target : *targets_) is_target_[target] = false;
+  sources_ = nullptr;
+  targets_ = nullptr;
+}
+
+template <class Graph, typename DistanceType>
+void DistanceMatrixBuilder<Graph, DistanceType>::Compute(
+    const std::vector<NodeIndex>& sources,
+    const std::vector<NodeIndex>& targets,
+    DistanceMatrix<DistanceType>* matrix) {
+  matrix->Resize(sources.size(), targets.size());
+  StartQuery(sources, targets);
+  ComputeRows(0, sources.size(), matrix->mutable_row(0));
+  EndQuery();
+}
+
+template <class Graph, typename DistanceType>
+void DistanceMatrixBuilder<Graph, DistanceType>::ComputeByBlocks(
+    const std::vector<NodeIndex>& sources,
+    const std::vector<NodeIndex>& targets, int64 max_block_bytes,
+    Callback3<int, int, const DistanceType*>* block_consumer) {
+  block_consumer->CheckIsRepeatable();
+  const int64 row_bytes =
+      std::max<int64>(1, targets.size() * sizeof(DistanceType));
+  const int rows_per_block = static_cast<int>(std::max<int64>(
+      1, std::min<int64>(sources.size(), max_block_bytes / row_bytes)));
+  std::vector<DistanceType> block(static_cast<size_t>(rows_per_block) *
+                                  targets.size());
+  StartQuery(sources, targets);
+  for (int first_row = 0; first_row < sources.size();
+       first_row += rows_per_block) {
+    const int num_rows =
+        std::min<int>(rows_per_block, sources.size() - first_row);
+    ComputeRows(first_row, num_rows, block.data());
+    block_consumer->Run(first_row, num_rows, block.data());
+  }
+  EndQuery();
+}
+
+template <class Graph, typename DistanceType>
+void DistanceMatrixBuilder<Graph, DistanceType>::ComputeRows(
+    int first_row, int num_rows, DistanceType* output) {
+  next_row_ = first_row;
+  end_row_ = first_row + num_rows;
+  block_first_row_ = first_row;
+  block_output_ = output;
+  const int num_workers = std::min(num_threads_, num_rows);
+  if (num_workers <= 1) {
+    RunWorker(workspaces_[0].get());
+    return;
+  }
+  // The destructor of the pool waits for all the tasks to finish.
+  ThreadPool pool("DistanceMatrix", num_workers);
+  pool.StartWorkers();
+  for (int w = 0; w < num_workers; ++w) {
+    pool.Add(NewCallback(this, &DistanceMatrixBuilder::RunWorker,
+                         workspaces_[w].get()));
+  }
+}
+
+template <class Graph, typename DistanceType>
+void DistanceMatrixBuilder<Graph, DistanceType>::RunWorker(Search* search) {
+  const size_t num_cols = targets_->size();
+  for (;;) {
+    const int row = next_row_.fetch_add(1);
+    if (row >= end_row_) break;
+    ComputeRow(search, (*sources_)[row],
+               block_output_ + (row - block_first_row_) * num_cols);
+  }
+}
+
+template <class Graph, typename DistanceType>
+void DistanceMatrixBuilder<Graph, DistanceType>::ComputeRow(
+    Search* search, NodeIndex source, DistanceType* output) {
+  search->Init(source);
+  int num_targets_left = num_distinct_targets_;
+  while (num_targets_left > 0 && !search->FrontierIsEmpty()) {
+    if (is_target_[search->SettleNextNode()]) --num_targets_left;
+  }
+  // When the loop stops, either all the targets are settled, or the frontier
+  // is empty and all the reachable nodes are settled.
+  const std::vector<NodeIndex>& targets = *targets_;
+  for (int col = 0; col < targets.size(); ++col) {
+    output[col] = search->IsSettled(targets[col])
+                      ? search->Distance(targets[col])
+                      : unreachable_distance_;
+  }
+}
+
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_GRAPH_DISTANCE_MATRIX_H_
@@ -74,6 +74,34 @@ struct Graphs<operations_research::StarGraph> {
   }
 };
 
+// The graphs of ebert_graph.h without reverse arcs have no OppositeArc().
+template <typename Graph>
+struct ForwardEbertGraphs {
+  typedef typename Graph::ArcIndex ArcIndex;
+  typedef typename Graph::NodeIndex NodeIndex;
+  static bool IsArcValid(const Graph& graph, ArcIndex arc) {
+    return graph.CheckArcValidity(arc);
+  }
+  static NodeIndex NodeReservation(const Graph& graph) {
+    return graph.max_num_nodes();
+  }
+  static ArcIndex ArcReservation(const Graph& graph) {
+    return graph.max_num_arcs();
+  }
+  static void Build(Graph* graph) {}
+  static void Build(Graph* graph, std::vector<ArcIndex>* permutation) {
+    permutation->clear();
+  }
+};
+
+template <>
+struct Graphs<operations_research::ForwardStarGraph>
+    : ForwardEbertGraphs<operations_research::ForwardStarGraph> {};
+
+template <>
+struct Graphs<operations_research::ForwardStarStaticGraph>
+    : ForwardEbertGraphs<operations_research::ForwardStarStaticGraph> {};
+
 }  // namespace operations_research
 
 #endif  // OR_TOOLS_GRAPH_GRAPHS_H_
@@ -76,20 +76,27 @@
 // computing f(S,j) in an array M[Offset(S,j)]. See the comments about
 // LatticeMemoryManager::BaseOffset() to see how this is computed.
 //
+// ParallelHamiltonianPathSolver, at the end of this file, solves the same
+// problems with several threads and much less memory, see below.
+//
 // Keywords: Traveling Salesman, Hamiltonian Path, Dynamic Programming,
 //           Held, Karp.
 
 #include <math.h>
 #include <stddef.h>
 #include <algorithm>
+#include <atomic>
 #include <limits>
 #include "base/unique_ptr.h"
+#include <thread>  // NOLINT
 #include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "base/hash.h"
 #include "base/integral_types.h"
 #include "base/logging.h"
+#include "base/macros.h"
 #include "util/bitset.h"
 #include "util/saturated_arithmetic.h"
 
@@ -825,6 +832,534 @@ void HamiltonianPathSolver<CostType>::TravelingSalesmanPath(
     std::vector<PathNodeIndex>* path) {
   *path = TravelingSalesmanPath();
 }
+
+// ParallelHamiltonianPathSolver computes the same paths and costs as
+// HamiltonianPathSolver (with the same tie-breaking), with the following
+// differences:
+// - Node 0 is only the start of the paths, so the dynamic programming only
+//   considers the sets of nodes in {1 .. n - 1}: this halves the work.
+// - Each layer of the lattice (the sets with a given cardinality) is computed
+//   from the previous one with several threads, which take blocks of
+//   consecutive sets.
+// - Only the two layers used by the iteration are kept in memory, plus
+//   "checkpoint" layers every checkpoint_interval cardinalities. A path is
+//   reconstructed backwards from its last node: the values f(S, j) of the
+//   layers that were freed are recomputed from the checkpoint layer below,
+//   only for the subsets of the remaining nodes, which is cheap since they
+//   have at most checkpoint_interval - 1 nodes less. The paths are only
+//   computed when they are requested.
+// - When CostType is integral and no path can cost more than 2^31 - 1 in
+//   absolute value, the values are stored as int32, which halves the memory
+//   and the memory bandwidth for int64 costs.
+// For 25 nodes and int64 costs, HamiltonianPathSolver needs 3.3 GB, while
+// this class needs about 450 MB with the default checkpoint interval.
+//
+// Example:
+//   ParallelHamiltonianPathSolver<int64> solver(cost_matrix);
+//   solver.set_num_threads(8);
+//   const std::vector<int> tour = solver.TravelingSalesmanPath();
+namespace internal {
+
+// Returns the saturated addition of a and b for int32 and int64, a + b for the
+// other types.
+template <typename T>
+inline T HeldKarpAdd(T a, T b) {
+  return a + b;
+}
+template <>
+inline int64 HeldKarpAdd<int64>(int64 a, int64 b) {
+  return CapAdd(a, b);
+}
+template <>
+inline int32 HeldKarpAdd<int32>(int32 a, int32 b) {
+  const int64 sum = static_cast<int64>(a) + b;
+  return static_cast<int32>(
+      std::max<int64>(std::numeric_limits<int32>::min(),
+                      std::min<int64>(std::numeric_limits<int32>::max(), sum)));
+}
+
+// The dynamic programming lattice of ParallelHamiltonianPathSolver, for the
+// type ValueType used to store the values. Node k >= 1 of the problem is the
+// bit k - 1 of the sets. The sets of a layer are stored in increasing order
+// of their integer value, which is the colexicographic order of Gosper's hack:
+// the rank of the set {s_0 < s_1 < ... < s_(c-1)} is the sum of the binomial
+// coefficients C(s_i, i + 1). f(S, j) is stored at index
+// rank(S) * |S| + (rank of j in S) of its layer.
+template <typename ValueType>
+class HeldKarpLattice {
+ public:
+  typedef uint32 Integer;
+
+  HeldKarpLattice() : num_nodes_(0), num_bits_(0) {}
+
+  // Computes all the layers, from the cost matrix of the problem (which must
+  // have at least two nodes). Keeps layer c if c - 1 is a multiple of
+  // checkpoint_interval, and the last layer.
+  template <typename CostType>
+  void Solve(const std::vector<std::vector<CostType> >& cost_matrix,
+             int num_threads, int checkpoint_interval);
+
+  // Returns f(V, j + 1) where V is {1 .. n - 1}, i.e. the cost of the
+  // shortest Hamiltonian path from 0 to j + 1.
+  ValueType HamiltonianCost(int bit) const {
+    return layers_[num_bits_][bit];
+  }
+
+  // Returns the cost of the arc from node i to node j.
+  ValueType ArcCost(int i, int j) const {
+    return arc_cost_to_[j * num_nodes_ + i];
+  }
+
+  // Returns the shortest path from 0 to the node of bit 'bit' through the
+  // nodes of 'set', starting with 0.
+  std::vector<int> ComputePath(Integer set, int bit);
+
+  // Frees all the memory.
+  void Clear();
+
+ private:
+  // Computes the sets of layer 'card' whose ranks are in [begin, end).
+  void ComputeSets(int card, uint64 begin, uint64 end);
+
+  // Takes blocks of sets of layer 'card' and computes them.
+  void ComputeLayer(int card);
+
+  // Returns the set of cardinality card with the given rank.
+  Integer Unrank(uint64 rank, int card) const;
+
+  // Returns the rank of a set.
+  uint64 Rank(Integer set) const;
+
+  // Returns f(set, bit), from the layers that are kept or from memo_.
+  ValueType Value(Integer set, int bit);
+
+  int num_nodes_;
+  int num_bits_;
+
+  // arc_cost_to_[j * num_nodes_ + i] is the cost of the arc from i to j, so
+  // that the costs of the arcs entering a node are consecutive.
+  std::vector<ValueType> arc_cost_to_;
+
+  // binomial_[n][k] is (n choose k), for k <= n + 1.
+  std::vector<std::vector<uint64> > binomial_;
+
+  // layers_[card] is empty if the layer was freed.
+  std::vector<std::vector<ValueType> > layers_;
+
+  // The values of f(set, bit) recomputed by ComputePath, indexed by
+  // set * 32 + bit.
+  hash_map<uint64, ValueType> memo_;
+
+  // The blocks of sets taken by the threads in ComputeLayer().
+  std::atomic<uint64> next_block_;
+  uint64 block_size_;
+};
+
+template <typename ValueType>
+template <typename CostType>
+void HeldKarpLattice<ValueType>::Solve(
+    const std::vector<std::vector<CostType> >& cost_matrix, int num_threads,
+    int checkpoint_interval) {
+  num_nodes_ = cost_matrix.size();
+  num_bits_ = num_nodes_ - 1;
+  DCHECK_LE(1, num_bits_);
+  DCHECK_GE(Set<Integer>::MaxCardinality, num_bits_);
+  arc_cost_to_.resize(num_nodes_ * num_nodes_);
+  for (int i = 0; i < num_nodes_; ++i) {
+    for (int j = 0; j < num_nodes_; ++j) {
+      arc_cost_to_[j * num_nodes_ + i] =
+          static_cast<ValueType>(cost_matrix[i][j]);
+    }
+  }
+  binomial_.resize(num_bits_ + 1);
+  for (int n = 0; n <= num_bits_; ++n) {
+    binomial_[n].assign(n + 2, 0);
+    binomial_[n][0] = 1;
+    for (int k = 1; k <= n; ++k) {
+      binomial_[n][k] = binomial_[n - 1][k - 1] + binomial_[n - 1][k];
+    }
+  }
+  memo_.clear();
+  layers_.resize(num_bits_ + 1);
+  for (int card = 0; card <= num_bits_; ++card) layers_[card].clear();
+  std::vector<ValueType> free_layer;
+
+  // f({j}, j) = cost(0, j), and the rank of {j} is j.
+  layers_[1].resize(num_bits_);
+  for (int bit = 0; bit < num_bits_; ++bit) layers_[1][bit] = ArcCost(0, bit + 1);
+  for (int card = 2; card <= num_bits_; ++card) {
+    const uint64 num_sets = binomial_[num_bits_][card];
+    layers_[card].swap(free_layer);
+    free_layer.clear();
+    layers_[card].resize(num_sets * card);
+    const int num_used_threads = static_cast<int>(
+        std::max<uint64>(1, std::min<uint64>(num_threads, num_sets / 1024)));
+    block_size_ = std::max<uint64>(1024, num_sets / (16 * num_used_threads));
+    next_block_ = 0;
+    std::vector<std::thread> threads;
+    for (int thread = 1; thread < num_used_threads; ++thread) {
+      threads.push_back(
+          std::thread(&HeldKarpLattice::ComputeLayer, this, card));
+    }
+    ComputeLayer(card);
+    for (int thread = 0; thread < threads.size(); ++thread) {
+      threads[thread].join();
+    }
+    // Frees the previous layer, unless it is a checkpoint.
+    if ((card - 2) % checkpoint_interval != 0) {
+      layers_[card - 1].swap(free_layer);
+    }
+  }
+}
+
+template <typename ValueType>
+void HeldKarpLattice<ValueType>::ComputeLayer(int card) {
+  const uint64 num_sets = binomial_[num_bits_][card];
+  for (;;) {
+    const uint64 begin = block_size_ * next_block_++;
+    if (begin >= num_sets) break;
+    ComputeSets(card, begin, std::min(num_sets, begin + block_size_));
+  }
+}
+
+template <typename ValueType>
+void HeldKarpLattice<ValueType>::ComputeSets(int card, uint64 begin,
+                                             uint64 end) {
+  const std::vector<ValueType>& previous = layers_[card - 1];
+  ValueType* const values = layers_[card].data();
+  int elements[Set<Integer>::MaxCardinality];
+  // prefix_rank[t] is the rank of {s_0, .., s_(t-1)}, and suffix_rank[t] the
+  // contribution of {s_t, ...} to the rank of a set where s_t has rank t - 1.
+  uint64 prefix_rank[Set<Integer>::MaxCardinality + 1];
+  uint64 suffix_rank[Set<Integer>::MaxCardinality + 1];
+  Set<Integer> set(Unrank(begin, card));
+  for (uint64 rank = begin; rank < end; ++rank) {
+    int num_elements = 0;
+    for (const int element : set) elements[num_elements++] = element;
+    prefix_rank[0] = 0;
+    for (int t = 0; t < card; ++t) {
+      prefix_rank[t + 1] = prefix_rank[t] + binomial_[elements[t]][t + 1];
+    }
+    suffix_rank[card] = 0;
+    for (int t = card - 1; t > 0; --t) {
+      suffix_rank[t] = suffix_rank[t + 1] + binomial_[elements[t]][t];
+    }
+    ValueType* const set_values = values + rank * card;
+    for (int t = 0; t < card; ++t) {
+      // f(S, s_t) = min over u != t of f(S \ {s_t}, s_u) + cost(s_u, s_t).
+      const uint64 subset_rank = prefix_rank[t] + suffix_rank[t + 1];
+      const ValueType* const subset_values =
+          previous.data() + subset_rank * (card - 1);
+      const ValueType* const cost_to =
+          arc_cost_to_.data() + (elements[t] + 1) * num_nodes_ + 1;
+      ValueType min_value = std::numeric_limits<ValueType>::max();
+      for (int u = 0; u < t; ++u) {
+        min_value = std::min(
+            min_value, HeldKarpAdd(cost_to[elements[u]], subset_values[u]));
+      }
+      for (int u = t + 1; u < card; ++u) {
+        min_value = std::min(min_value, HeldKarpAdd(cost_to[elements[u]],
+                                                    subset_values[u - 1]));
+      }
+      set_values[t] = min_value;
+    }
+    // Gosper's hack, see SetRangeIterator.
+    const Integer c = set.SmallestSingleton().value();
+    const Integer r = c + set.value();
+    set = Set<Integer>(r == 0 ? 0 : (((r ^ set.value()) >> (
+                                        set.SmallestElement() + 2)) | r));
+  }
+}
+
+template <typename ValueType>
+typename HeldKarpLattice<ValueType>::Integer HeldKarpLattice<ValueType>::Unrank(
+    uint64 rank, int card) const {
+  Integer set = 0;
+  int element = num_bits_ - 1;
+  for (int k = card; k > 0; --k) {
+    while (binomial_[element][k] > rank) --element;
+    set |= static_cast<Integer>(1) << element;
+    rank -= binomial_[element][k];
+    --element;
+  }
+  return set;
+}
+
+template <typename ValueType>
+uint64 HeldKarpLattice<ValueType>::Rank(Integer set) const {
+  uint64 rank = 0;
+  int k = 1;
+  for (const int element : Set<Integer>(set)) {
+    rank += binomial_[element][k];
+    ++k;
+  }
+  return rank;
+}
+
+template <typename ValueType>
+ValueType HeldKarpLattice<ValueType>::Value(Integer set, int bit) {
+  const Set<Integer> node_set(set);
+  const int card = node_set.Cardinality();
+  if (!layers_[card].empty()) {
+    return layers_[card][Rank(set) * card + node_set.ElementRank(bit)];
+  }
+  const uint64 key = static_cast<uint64>(set) * 32 + bit;
+  typename hash_map<uint64, ValueType>::const_iterator it = memo_.find(key);
+  if (it != memo_.end()) return it->second;
+  // The layer 1 is always kept, so the recursion stops there at the latest.
+  const Integer subset = node_set.RemoveElement(bit).value();
+  ValueType min_value = std::numeric_limits<ValueType>::max();
+  for (const int element : Set<Integer>(subset)) {
+    min_value = std::min(min_value, HeldKarpAdd(ArcCost(element + 1, bit + 1),
+                                                Value(subset, element)));
+  }
+  memo_[key] = min_value;
+  return min_value;
+}
+
+template <typename ValueType>
+std::vector<int> HeldKarpLattice<ValueType>::ComputePath(Integer set,
+                                                         int bit) {
+  const int card = Set<Integer>(set).Cardinality();
+  std::vector<int> path(card + 1, 0);
+  path[card] = bit + 1;
+  for (int rank = card - 1; rank >= 1; --rank) {
+    // Takes the first predecessor with the minimum value, as the DP does.
+    set = Set<Integer>(set).RemoveElement(bit).value();
+    ValueType min_value = std::numeric_limits<ValueType>::max();
+    int best_bit = -1;
+    for (const int element : Set<Integer>(set)) {
+      const ValueType value =
+          HeldKarpAdd(ArcCost(element + 1, bit + 1), Value(set, element));
+      if (best_bit == -1 || value < min_value) {
+        min_value = value;
+        best_bit = element;
+      }
+    }
+    bit = best_bit;
+    path[rank] = bit + 1;
+  }
+  memo_.clear();
+  return path;
+}
+
+template <typename ValueType>
+void HeldKarpLattice<ValueType>::Clear() {
+  std::vector<ValueType>().swap(arc_cost_to_);
+  std::vector<std::vector<ValueType> >().swap(layers_);
+  memo_.clear();
+}
+
+}  // namespace internal
+
+template <typename CostType>
+class ParallelHamiltonianPathSolver {
+ public:
+  explicit ParallelHamiltonianPathSolver(
+      const std::vector<std::vector<CostType> >& cost_matrix);
+
+  // Replaces the cost matrix. The memory is reused when possible.
+  void ChangeCostMatrix(
+      const std::vector<std::vector<CostType> >& cost_matrix);
+
+  // Sets the number of threads, including the calling thread. Defaults to 1.
+  void set_num_threads(int num_threads) {
+    CHECK_GE(num_threads, 1);
+    num_threads_ = num_threads;
+  }
+
+  // Sets the distance between two kept layers. With 1, all the layers are
+  // kept, as in HamiltonianPathSolver. Defaults to 4.
+  void set_checkpoint_interval(int checkpoint_interval) {
+    CHECK_GE(checkpoint_interval, 1);
+    checkpoint_interval_ = checkpoint_interval;
+    solved_ = false;
+  }
+
+  // Same as in HamiltonianPathSolver.
+  CostType HamiltonianCost(int end_node);
+  std::vector<int> HamiltonianPath(int end_node);
+  int BestHamiltonianPathEndNode();
+  CostType TravelingSalesmanCost();
+  std::vector<int> TravelingSalesmanPath();
+  void TravelingSalesmanPath(std::vector<PathNodeIndex>* path) {
+    *path = TravelingSalesmanPath();
+  }
+
+  // Returns true if the values were stored as int32 by the last computation.
+  bool UsesInt32Values() {
+    Solve();
+    return use_int32_;
+  }
+
+ private:
+  // Computes the lattice and the costs, but not the paths.
+  void Solve();
+  template <typename ValueType>
+  void SolveWithLattice(internal::HeldKarpLattice<ValueType>* lattice);
+
+  // Returns true if CostType is integral and the cost of any path fits in an
+  // int32.
+  bool CostsFitInInt32() const;
+
+  // Returns the shortest path from 0 to end_node, through all the nodes but 0.
+  std::vector<int> ComputeHamiltonianPath(int end_node);
+
+  std::vector<std::vector<CostType> > cost_matrix_;
+  int num_nodes_;
+  int num_threads_;
+  int checkpoint_interval_;
+  bool solved_;
+  bool use_int32_;
+  CostType tsp_cost_;
+  int tsp_last_node_;
+  std::vector<CostType> hamiltonian_costs_;
+  int best_hamiltonian_path_end_node_;
+  internal::HeldKarpLattice<int32> int32_lattice_;
+  internal::HeldKarpLattice<CostType> lattice_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelHamiltonianPathSolver);
+};
+
+template <typename CostType>
+ParallelHamiltonianPathSolver<CostType>::ParallelHamiltonianPathSolver(
+    const std::vector<std::vector<CostType> >& cost_matrix)
+    : num_nodes_(0),
+      num_threads_(1),
+      checkpoint_interval_(4),
+      solved_(false),
+      use_int32_(false),
+      tsp_cost_(0),
+      tsp_last_node_(0),
+      best_hamiltonian_path_end_node_(0) {
+  ChangeCostMatrix(cost_matrix);
+}
+
+template <typename CostType>
+void ParallelHamiltonianPathSolver<CostType>::ChangeCostMatrix(
+    const std::vector<std::vector<CostType> >& cost_matrix) {
+  cost_matrix_ = cost_matrix;
+  num_nodes_ = cost_matrix_.size();
+  CHECK_GE(HamiltonianPathSolver<CostType>::NodeSet::MaxCardinality,
+           num_nodes_);
+  for (const std::vector<CostType>& row : cost_matrix_) {
+    CHECK_EQ(num_nodes_, row.size()) << "Cost matrix must be square";
+  }
+  solved_ = false;
+}
+
+template <typename CostType>
+bool ParallelHamiltonianPathSolver<CostType>::CostsFitInInt32() const {
+  if (!std::is_integral<CostType>::value) return false;
+  // A path has at most num_nodes_ arcs.
+  const int64 max_abs_cost = std::numeric_limits<int32>::max() / num_nodes_;
+  for (int i = 0; i < num_nodes_; ++i) {
+    for (int j = 0; j < num_nodes_; ++j) {
+      if (i == j) continue;
+      const int64 cost = static_cast<int64>(cost_matrix_[i][j]);
+      if (cost > max_abs_cost || cost < -max_abs_cost) return false;
+    }
+  }
+  return true;
+}
+
+template <typename CostType>
+void ParallelHamiltonianPathSolver<CostType>::Solve() {
+  if (solved_) return;
+  solved_ = true;
+  hamiltonian_costs_.assign(std::max(1, num_nodes_), 0);
+  best_hamiltonian_path_end_node_ = 0;
+  tsp_last_node_ = 0;
+  if (num_nodes_ <= 1) {
+    // Same results as HamiltonianPathSolver.
+    use_int32_ = false;
+    tsp_cost_ = num_nodes_ == 0 ? 0 : cost_matrix_[0][0];
+    return;
+  }
+  use_int32_ = CostsFitInInt32();
+  if (use_int32_) {
+    lattice_.Clear();
+    SolveWithLattice(&int32_lattice_);
+  } else {
+    int32_lattice_.Clear();
+    SolveWithLattice(&lattice_);
+  }
+}
+
+template <typename CostType>
+template <typename ValueType>
+void ParallelHamiltonianPathSolver<CostType>::SolveWithLattice(
+    internal::HeldKarpLattice<ValueType>* lattice) {
+  lattice->Solve(cost_matrix_, num_threads_, checkpoint_interval_);
+  // As in HamiltonianPathSolver, the TSP cost is the minimum of
+  // f(V, j) + cost(j, 0), taking the first j in case of ties.
+  ValueType tsp_cost = std::numeric_limits<ValueType>::max();
+  ValueType min_hamiltonian_cost = std::numeric_limits<ValueType>::max();
+  for (int bit = 0; bit < num_nodes_ - 1; ++bit) {
+    const ValueType cost = lattice->HamiltonianCost(bit);
+    hamiltonian_costs_[bit + 1] = static_cast<CostType>(cost);
+    if (cost < min_hamiltonian_cost) {
+      min_hamiltonian_cost = cost;
+      best_hamiltonian_path_end_node_ = bit + 1;
+    }
+    const ValueType tour_cost =
+        internal::HeldKarpAdd(lattice->ArcCost(bit + 1, 0), cost);
+    if (bit == 0 || tour_cost < tsp_cost) {
+      tsp_cost = tour_cost;
+      tsp_last_node_ = bit + 1;
+    }
+  }
+  tsp_cost_ = static_cast<CostType>(tsp_cost);
+}
+
+template <typename CostType>
+std::vector<int> ParallelHamiltonianPathSolver<CostType>::ComputeHamiltonianPath(
+    int end_node) {
+  DCHECK_LE(2, num_nodes_);
+  DCHECK_LT(0, end_node);
+  const uint32 all_nodes = Set<uint32>::FullSet(num_nodes_ - 1).value();
+  return use_int32_ ? int32_lattice_.ComputePath(all_nodes, end_node - 1)
+                    : lattice_.ComputePath(all_nodes, end_node - 1);
+}
+
+template <typename CostType>
+CostType ParallelHamiltonianPathSolver<CostType>::HamiltonianCost(
+    int end_node) {
+  Solve();
+  return hamiltonian_costs_[end_node];
+}
+
+template <typename CostType>
+std::vector<int> ParallelHamiltonianPathSolver<CostType>::HamiltonianPath(
+    int end_node) {
+  Solve();
+  // Same results as HamiltonianPathSolver for end_node == 0.
+  if (num_nodes_ == 0) return std::vector<int>(1, 0);
+  if (end_node == 0) return std::vector<int>();
+  return ComputeHamiltonianPath(end_node);
+}
+
+template <typename CostType>
+int ParallelHamiltonianPathSolver<CostType>::BestHamiltonianPathEndNode() {
+  Solve();
+  return best_hamiltonian_path_end_node_;
+}
+
+template <typename CostType>
+CostType ParallelHamiltonianPathSolver<CostType>::TravelingSalesmanCost() {
+  Solve();
+  return tsp_cost_;
+}
+
+template <typename CostType>
+std::vector<int> ParallelHamiltonianPathSolver<CostType>::TravelingSalesmanPath() {
+  Solve();
+  if (num_nodes_ <= 1) return std::vector<int>(num_nodes_ + 1, 0);
+  std::vector<int> path = ComputeHamiltonianPath(tsp_last_node_);
+  path.push_back(0);
+  return path;
+}
+
 }  // namespace operations_research
 
 #endif  // OR_TOOLS_GRAPH_HAMILTONIAN_PATH_H_
@@ -24,3 +24,14 @@ DEFINE_int32(assignment_progress_logging_period, 5000,
              "when verbose level is 4 or more.");
 DEFINE_bool(assignment_stack_order, true,
             "Process active nodes in stack (as opposed to queue) order.");
+
+namespace operations_research {
+
+// Explicit instantiations, that check that LinearSumAssignment compiles with
+// both the ebert_graph.h and the graph.h graph classes.
+template class LinearSumAssignment<ForwardStarGraph>;
+template class LinearSumAssignment<ForwardStarStaticGraph>;
+template class LinearSumAssignment<ListGraph<> >;
+template class LinearSumAssignment<StaticGraph<> >;
+
+}  // namespace operations_research
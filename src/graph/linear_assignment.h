@@ -58,6 +58,12 @@
 //    ...
 //  }
 //
+// The graph classes of graph.h can be used too, e.g. StaticGraph<>. Their
+// arcs must be added and the graph built (see StaticGraph::Build()) before
+// the LinearSumAssignment is constructed, and the arc costs are set with the
+// arc indices given by the permutation returned by Build(). See the end of
+// linear_assignment.cc for the graph types that are compiled in the library.
+//
 // In the following, we consider a bipartite graph
 //   G = (V = X union Y, E subset XxY),
 // where V denodes the set of nodes (vertices) in the graph, E denotes
@@ -186,6 +192,7 @@
 #include "base/macros.h"
 #include "base/stringprintf.h"
 #include "graph/ebert_graph.h"
+#include "graph/graphs.h"
 #include "util/permutation.h"
 
 #ifndef SWIG
@@ -237,17 +244,21 @@ class LinearSumAssignment {
   // Optimizes the layout of the graph for the access pattern our
   // implementation will use.
   //
-  // REQUIRES for LinearSumAssignment template instantiation if a call
-  // to the OptimizeGraphLayout() method is compiled: GraphType is a
-  // dynamic graph, i.e., one that implements the
-  // GroupForwardArcsByFunctor() member template method.
+  // REQUIRES if a call to the OptimizeGraphLayout() method is
+  // compiled: GraphType is a dynamic graph of ebert_graph.h, i.e., one
+  // that implements the GroupForwardArcsByFunctor() member template
+  // method. This is a member template so that the explicit
+  // instantiations for the other graph types do not compile it.
   //
   // If analogous optimization is needed for LinearSumAssignment
   // instances based on static graphs, the graph layout should be
   // constructed such that each node's outgoing arcs are sorted by
   // head node index before the
-  // LinearSumAssignment<GraphType>::SetGraph() method is called.
-  void OptimizeGraphLayout(GraphType* graph);
+  // LinearSumAssignment<GraphType>::SetGraph() method is called. The
+  // Build() method of the graph.h graphs already groups the arcs by
+  // tail node.
+  template <typename LayoutGraphType>
+  void OptimizeGraphLayout(LayoutGraphType* graph);
 
   // Allows tests, iterators, etc., to inspect our underlying graph.
   inline const GraphType& Graph() const { return *graph_; }
@@ -331,23 +342,23 @@ class LinearSumAssignment {
   class BipartiteLeftNodeIterator {
    public:
     BipartiteLeftNodeIterator(const GraphType& graph, NodeIndex num_left_nodes)
-        : num_left_nodes_(num_left_nodes), node_iterator_(graph) {}
+        : end_node_(std::min<NodeIndex>(num_left_nodes, graph.num_nodes())),
+          node_(0) {}
 
     explicit BipartiteLeftNodeIterator(const LinearSumAssignment& assignment)
-        : num_left_nodes_(assignment.NumLeftNodes()),
-          node_iterator_(assignment.Graph()) {}
+        : end_node_(std::min<NodeIndex>(assignment.NumLeftNodes(),
+                                        assignment.Graph().num_nodes())),
+          node_(0) {}
 
-    NodeIndex Index() const { return node_iterator_.Index(); }
+    NodeIndex Index() const { return node_; }
 
-    bool Ok() const {
-      return node_iterator_.Ok() && (node_iterator_.Index() < num_left_nodes_);
-    }
+    bool Ok() const { return node_ < end_node_; }
 
-    void Next() { node_iterator_.Next(); }
+    void Next() { ++node_; }
 
    private:
-    const NodeIndex num_left_nodes_;
-    typename GraphType::NodeIterator node_iterator_;
+    const NodeIndex end_node_;
+    NodeIndex node_;
   };
 
  private:
@@ -947,10 +958,10 @@ LinearSumAssignment<GraphType>::LinearSumAssignment(
       slack_relabeling_price_(0),
       largest_scaled_cost_magnitude_(0),
       total_excess_(0),
-      price_(num_left_nodes + GraphType::kFirstNode, 2 * num_left_nodes - 1),
-      matched_arc_(GraphType::kFirstNode, num_left_nodes - 1),
+      price_(num_left_nodes, 2 * num_left_nodes - 1),
+      matched_arc_(0, num_left_nodes - 1),
       matched_node_(num_left_nodes, 2 * num_left_nodes - 1),
-      scaled_arc_cost_(GraphType::kFirstArc, graph.max_end_arc_index() - 1),
+      scaled_arc_cost_(0, Graphs<GraphType>::ArcReservation(graph) - 1),
       active_nodes_(FLAGS_assignment_stack_order
                         ? static_cast<ActiveNodeContainerInterface*>(
                               new ActiveNodeStack())
@@ -970,12 +981,10 @@ LinearSumAssignment<GraphType>::LinearSumAssignment(
       slack_relabeling_price_(0),
       largest_scaled_cost_magnitude_(0),
       total_excess_(0),
-      price_(num_left_nodes + GraphType::kFirstNode, 2 * num_left_nodes - 1),
-      matched_arc_(GraphType::kFirstNode,
-                   GraphType::kFirstNode + num_left_nodes - 1),
+      price_(num_left_nodes, 2 * num_left_nodes - 1),
+      matched_arc_(0, num_left_nodes - 1),
       matched_node_(num_left_nodes, 2 * num_left_nodes - 1),
-      scaled_arc_cost_(GraphType::kFirstArc,
-                       GraphType::kFirstArc + num_arcs - 1),
+      scaled_arc_cost_(0, num_arcs - 1),
       active_nodes_(FLAGS_assignment_stack_order
                         ? static_cast<ActiveNodeContainerInterface*>(
                               new ActiveNodeStack())
@@ -984,7 +993,7 @@ LinearSumAssignment<GraphType>::LinearSumAssignment(
 
 template <typename GraphType>
 void LinearSumAssignment<GraphType>::SetArcCost(ArcIndex arc, CostValue cost) {
-  DCHECK(graph_ == NULL || graph_->CheckArcValidity(arc));
+  DCHECK(graph_ == NULL || Graphs<GraphType>::IsArcValid(*graph_, arc));
   if (graph_ != NULL) {
     NodeIndex head = Head(arc);
     DCHECK_LE(num_left_nodes_, head);
@@ -1060,7 +1069,9 @@ LinearSumAssignment<GraphType>::ArcAnnotationCycleHandler() {
 }
 
 template <typename GraphType>
-void LinearSumAssignment<GraphType>::OptimizeGraphLayout(GraphType* graph) {
+template <typename LayoutGraphType>
+void LinearSumAssignment<GraphType>::OptimizeGraphLayout(
+    LayoutGraphType* graph) {
   // The graph argument is only to give us a non-const-qualified
   // handle on the graph we already have. Any different graph is
   // nonsense.
@@ -1305,9 +1316,9 @@ inline CostValue LinearSumAssignment<GraphType>::ImplicitPrice(
 // Only for debugging.
 template <typename GraphType>
 bool LinearSumAssignment<GraphType>::AllMatched() const {
-  for (typename GraphType::NodeIterator node_it(*graph_); node_it.Ok();
-       node_it.Next()) {
-    if (IsActiveForDebugging(node_it.Index())) {
+  const NodeIndex num_nodes = graph_->num_nodes();
+  for (NodeIndex node = 0; node < num_nodes; ++node) {
+    if (IsActiveForDebugging(node)) {
       return false;
     }
   }
@@ -1361,12 +1372,9 @@ bool LinearSumAssignment<GraphType>::FinalizeSetup() {
           << largest_scaled_cost_magnitude_ / cost_scaling_factor_;
   // Initialize left-side node-indexed arrays and check incidence
   // precondition.
-  typename GraphType::NodeIterator node_it(*graph_);
-  for (; node_it.Ok(); node_it.Next()) {
-    const NodeIndex node = node_it.Index();
-    if (node >= num_left_nodes_) {
-      break;
-    }
+  const NodeIndex num_nodes = graph_->num_nodes();
+  NodeIndex node = 0;
+  for (; node < std::min(num_left_nodes_, num_nodes); ++node) {
     matched_arc_.Set(node, GraphType::kNilArc);
     typename GraphType::OutgoingArcIterator arc_it(*graph_, node);
     if (!arc_it.Ok()) {
@@ -1375,8 +1383,7 @@ bool LinearSumAssignment<GraphType>::FinalizeSetup() {
   }
   // Initialize right-side node-indexed arrays. Example: prices are
   // stored only for right-side nodes.
-  for (; node_it.Ok(); node_it.Next()) {
-    const NodeIndex node = node_it.Index();
+  for (; node < num_nodes; ++node) {
     price_.Set(node, 0);
     matched_node_.Set(node, GraphType::kNilNode);
   }
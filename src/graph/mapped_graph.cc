@@ -0,0 +1,158 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "graph/mapped_graph.h"
+
+#include "base/fingerprint2011.h"
+
+namespace operations_research {
+namespace internal {
+
+uint64 GraphFileChecksum(const char* data, int64 size) {
+  DCHECK_EQ(0, size % sizeof(uint64));
+  uint64 checksum = GraphFileHeader::kMagic;
+  const uint64* const words = reinterpret_cast<const uint64*>(data);
+  const int64 num_words = size / sizeof(uint64);
+  for (int64 i = 0; i < num_words; ++i) {
+    checksum = FingerprintCat2011(checksum, words[i]);
+  }
+  return checksum;
+}
+
+GraphFileWriter::GraphFileWriter(const std::string& filename)
+    : filename_(filename),
+      file_(fopen(filename.c_str(), "wb")),
+      ok_(file_ != nullptr),
+      checksum_(GraphFileHeader::kMagic),
+      buffer_size_(0) {}
+
+GraphFileWriter::~GraphFileWriter() {
+  if (file_ != nullptr) fclose(file_);
+}
+
+void GraphFileWriter::BeginFile() {
+  GraphFileHeader header;
+  memset(&header, 0, sizeof(header));
+  ok_ = ok_ && fwrite(&header, sizeof(header), 1, file_) == 1;
+}
+
+void GraphFileWriter::Flush() {
+  DCHECK_EQ(0, buffer_size_ % sizeof(uint64));
+  // The buffer is not aligned for uint64, its words are copied out.
+  for (int offset = 0; offset < buffer_size_; offset += sizeof(uint64)) {
+    uint64 word;
+    memcpy(&word, buffer_ + offset, sizeof(word));
+    checksum_ = FingerprintCat2011(checksum_, word);
+  }
+  ok_ = ok_ && (buffer_size_ == 0 ||
+                fwrite(buffer_, 1, buffer_size_, file_) == buffer_size_);
+  buffer_size_ = 0;
+}
+
+void GraphFileWriter::AppendInt64Array(const int64* values, int64 size) {
+  for (int64 i = 0; i < size; ++i) Append<int64>(values[i]);
+  EndArray();
+}
+
+void GraphFileWriter::EndArray() {
+  while (buffer_size_ % sizeof(uint64) != 0) Append<char>(0);
+}
+
+util::Status GraphFileWriter::EndFile(GraphFileHeader* header) {
+  Flush();
+  header->magic = GraphFileHeader::kMagic;
+  header->version = GraphFileHeader::kVersion;
+  header->checksum = checksum_;
+  ok_ = ok_ && fseek(file_, 0, SEEK_SET) == 0 &&
+        fwrite(header, sizeof(*header), 1, file_) == 1;
+  if (file_ == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "Could not open file: '" + filename_ + "'");
+  }
+  const bool closed = fclose(file_) == 0;
+  file_ = nullptr;
+  if (!ok_ || !closed) {
+    return util::Status(util::error::INTERNAL,
+                        "Could not write file '" + filename_ + "'");
+  }
+  return util::Status::OK;
+}
+
+namespace {
+int64 PaddedSize(int64 num_bytes) { return (num_bytes + 7) & ~7LL; }
+
+// The largest index that fits in a signed integer of the given size.
+int64 MaxIndex(int index_size) {
+  if (index_size >= sizeof(int64)) return kint64max;
+  return (static_cast<int64>(1) << (8 * index_size - 1)) - 1;
+}
+}  // namespace
+
+util::Status CheckGraphFile(const MemoryMappedFile& file,
+                            const std::string& filename,
+                            int node_index_size, int arc_index_size,
+                            bool has_reverse_arcs, bool verify,
+                            GraphFileHeader* header, int64* offset) {
+  if (file.size() < sizeof(*header)) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        StrCat("'", filename, "' is too short."));
+  }
+  memcpy(header, file.data(), sizeof(*header));
+  if (header->magic != GraphFileHeader::kMagic ||
+      header->version != GraphFileHeader::kVersion ||
+      header->node_index_size != node_index_size ||
+      header->arc_index_size != arc_index_size ||
+      header->has_reverse_arcs != has_reverse_arcs) {
+    return util::Status(
+        util::error::INVALID_ARGUMENT,
+        StrCat("'", filename, "' is not a graph file of this version, with",
+               " these index types and ", has_reverse_arcs ? "with" : "without",
+               " reverse arcs."));
+  }
+  const int64 num_nodes = header->num_nodes;
+  const int64 num_arcs = header->num_arcs;
+  if (num_nodes < 0 || num_nodes > MaxIndex(node_index_size) ||
+      num_arcs < 0 || num_arcs > MaxIndex(arc_index_size) ||
+      header->num_arc_annotations < 0 ||
+      (num_arcs > 0 && header->num_arc_annotations >
+                           file.size() / (num_arcs * sizeof(int64)))) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        StrCat("'", filename, "' is corrupted."));
+  }
+  int64 expected_size = sizeof(*header);
+  if (has_reverse_arcs) {
+    expected_size += 2 * PaddedSize(num_nodes * arc_index_size) +
+                     PaddedSize(2 * num_arcs * node_index_size) +
+                     PaddedSize(2 * num_arcs * arc_index_size);
+  } else {
+    expected_size += PaddedSize(num_nodes * arc_index_size) +
+                     PaddedSize(num_arcs * node_index_size);
+  }
+  expected_size += header->num_arc_annotations * num_arcs * sizeof(int64);
+  if (file.size() != expected_size) {
+    return util::Status(
+        util::error::INVALID_ARGUMENT,
+        StrCat("'", filename, "' is truncated or corrupted: its size is ",
+               file.size(), " instead of ", expected_size, "."));
+  }
+  *offset = sizeof(*header);
+  if (verify && GraphFileChecksum(file.data() + *offset,
+                                  file.size() - *offset) != header->checksum) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        StrCat("'", filename, "' has a wrong checksum."));
+  }
+  return util::Status::OK;
+}
+
+}  // namespace internal
+}  // namespace operations_research
@@ -0,0 +1,667 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A binary file format for the static graphs of graph.h, and read-only graph
+// classes that use such a file in place.
+//
+// WriteGraphToBinaryFile() writes the arrays of a StaticGraph or of a
+// ReverseArcStaticGraph (see graph.h), plus some optional int64 arc
+// annotations (lengths, capacities, ...), as they are in memory.
+// MappedStaticGraph and MappedReverseArcStaticGraph map such a file in memory
+// (see util/memory_mapped_file.h) and implement the read-only part of the
+// interface of StaticGraph and ReverseArcStaticGraph on top of it, so that
+// they can be used by the graph algorithms templated on the graph type.
+//
+// Loading a graph this way runs in O(1) and needs no memory besides the pages
+// of the file, which are read from disk when first accessed, and which are
+// shared by all the processes that map the same file. This is much faster
+// than reading a text file with ReadGraphFile() (see util.h) and building the
+// graph, which needs twice the memory of the graph.
+//
+// The file starts with a header (see internal::GraphFileHeader) that holds a
+// version, the sizes of the index types, and a checksum of the rest of the
+// file. It is followed by the arrays below, each padded to a multiple of 8
+// bytes:
+//   - StaticGraph: start[num_nodes], head[num_arcs].
+//   - ReverseArcStaticGraph: start[num_nodes], reverse_start[num_nodes],
+//     head[2 * num_arcs] and opposite[2 * num_arcs]. The two last arrays are
+//     indexed by num_arcs + arc for the arcs in [-num_arcs, num_arcs).
+//   - num_arc_annotations times annotation[num_arcs].
+// The file can only be read on a machine with the same endianness.
+//
+// Example usage:
+//   StaticGraph<> graph;
+//   ... add the arcs, call graph.Build(&permutation) ...
+//   std::vector<std::vector<int64> > lengths(1);
+//   ... fill lengths[0], indexed by the arcs of graph ...
+//   CHECK_OK(WriteGraphToBinaryFile(graph, lengths, "roads.graph"));
+//
+//   // Possibly in another process.
+//   MappedStaticGraph<> mapped_graph;
+//   CHECK_OK(mapped_graph.LoadFromFile("roads.graph", /*verify=*/false));
+//   const int64* const length = mapped_graph.ArcAnnotation(0);
+//   for (const int arc : mapped_graph.OutgoingArcs(node)) {
+//     ... mapped_graph.Head(arc) ... length[arc] ...
+//   }
+
+#ifndef OR_TOOLS_GRAPH_MAPPED_GRAPH_H_
+#define OR_TOOLS_GRAPH_MAPPED_GRAPH_H_
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/integral_types.h"
+#include "base/join.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/status.h"
+#include "graph/graph.h"
+#include "util/iterators.h"
+#include "util/memory_mapped_file.h"
+
+namespace operations_research {
+
+// Writes the graph and the given arc annotations, which must all have
+// graph.num_arcs() elements, to a binary file. The graph must be built.
+template <typename NodeIndexType, typename ArcIndexType>
+util::Status WriteGraphToBinaryFile(
+    const StaticGraph<NodeIndexType, ArcIndexType>& graph,
+    const std::vector<std::vector<int64> >& arc_annotations,
+    const std::string& filename);
+template <typename NodeIndexType, typename ArcIndexType>
+util::Status WriteGraphToBinaryFile(
+    const ReverseArcStaticGraph<NodeIndexType, ArcIndexType>& graph,
+    const std::vector<std::vector<int64> >& arc_annotations,
+    const std::string& filename);
+
+// A read-only StaticGraph whose arrays are in a file written by
+// WriteGraphToBinaryFile().
+template <typename NodeIndexType = int32, typename ArcIndexType = int32>
+class MappedStaticGraph : public BaseGraph<NodeIndexType, ArcIndexType, false> {
+  typedef BaseGraph<NodeIndexType, ArcIndexType, false> Base;
+  using Base::num_arcs_;
+  using Base::num_nodes_;
+
+ public:
+  using Base::IsArcValid;
+  MappedStaticGraph()
+      : start_(nullptr), head_(nullptr), annotations_(nullptr),
+        num_arc_annotations_(0) {}
+
+  // Replaces the graph by the one stored in the given file. Only the header
+  // is read, so this runs in O(1), unless verify is true: then the checksum
+  // and the validity of the arrays are checked too, in O(file size).
+  util::Status LoadFromFile(const std::string& filename, bool verify);
+
+  NodeIndexType Head(ArcIndexType arc) const {
+    DCHECK(IsArcValid(arc));
+    return head_[arc];
+  }
+  // This runs in O(log(num_nodes)), since there is no tail array.
+  NodeIndexType Tail(ArcIndexType arc) const {
+    DCHECK(IsArcValid(arc));
+    return std::upper_bound(start_, start_ + num_nodes_, arc) - start_ - 1;
+  }
+  IntegerRange<ArcIndexType> OutgoingArcs(NodeIndexType node) const {
+    return IntegerRange<ArcIndexType>(start_[node], DirectArcLimit(node));
+  }
+  IntegerRange<ArcIndexType> OutgoingArcsStartingFrom(NodeIndexType node,
+                                                      ArcIndexType from) const {
+    return IntegerRange<ArcIndexType>(from, DirectArcLimit(node));
+  }
+  BeginEndWrapper<NodeIndexType const*> operator[](NodeIndexType node) const {
+    return BeginEndWrapper<NodeIndexType const*>(head_ + start_[node],
+                                                 head_ + DirectArcLimit(node));
+  }
+
+  // Returns the index-th arc annotation array, indexed by arc.
+  int num_arc_annotations() const { return num_arc_annotations_; }
+  const int64* ArcAnnotation(int index) const {
+    DCHECK_GE(index, 0);
+    DCHECK_LT(index, num_arc_annotations_);
+    return annotations_ + static_cast<int64>(index) * num_arcs_;
+  }
+
+  // The graph cannot be modified.
+  virtual void ReserveNodes(NodeIndexType bound) {
+    LOG(DFATAL) << "MappedStaticGraph cannot be modified.";
+  }
+  virtual void ReserveArcs(ArcIndexType bound) {
+    LOG(DFATAL) << "MappedStaticGraph cannot be modified.";
+  }
+
+  // Deprecated.
+  class OutgoingArcIterator;
+
+ private:
+  ArcIndexType DirectArcLimit(NodeIndexType node) const {
+    return node + 1 < num_nodes_ ? start_[node + 1] : num_arcs_;
+  }
+
+  MemoryMappedFile mapped_file_;
+  const ArcIndexType* start_;
+  const NodeIndexType* head_;
+  const int64* annotations_;
+  int num_arc_annotations_;
+  DISALLOW_COPY_AND_ASSIGN(MappedStaticGraph);
+};
+
+// A read-only ReverseArcStaticGraph whose arrays are in a file written by
+// WriteGraphToBinaryFile().
+template <typename NodeIndexType = int32, typename ArcIndexType = int32>
+class MappedReverseArcStaticGraph
+    : public BaseGraph<NodeIndexType, ArcIndexType, true> {
+  typedef BaseGraph<NodeIndexType, ArcIndexType, true> Base;
+  using Base::num_arcs_;
+  using Base::num_nodes_;
+
+ public:
+  using Base::IsArcValid;
+  MappedReverseArcStaticGraph()
+      : start_(nullptr), reverse_start_(nullptr), head_(nullptr),
+        opposite_(nullptr), annotations_(nullptr), num_arc_annotations_(0) {}
+
+  // See MappedStaticGraph::LoadFromFile().
+  util::Status LoadFromFile(const std::string& filename, bool verify);
+
+  // Deprecated.
+  class IncidentArcIterator;
+  class IncomingArcIterator;
+  class OutgoingArcIterator;
+
+  IntegerRange<ArcIndexType> OutgoingArcs(NodeIndexType node) const {
+    return IntegerRange<ArcIndexType>(start_[node], DirectArcLimit(node));
+  }
+  IntegerRange<ArcIndexType> IncomingArcs(NodeIndexType node) const {
+    return IntegerRange<ArcIndexType>(reverse_start_[node],
+                                      ReverseArcLimit(node));
+  }
+  BeginEndWrapper<IncidentArcIterator> IncidentArcs(NodeIndexType node) const;
+  IntegerRange<ArcIndexType> OutgoingArcsStartingFrom(NodeIndexType node,
+                                                      ArcIndexType from) const {
+    return IntegerRange<ArcIndexType>(from, DirectArcLimit(node));
+  }
+  IntegerRange<ArcIndexType> IncomingArcsStartingFrom(NodeIndexType node,
+                                                      ArcIndexType from) const {
+    return IntegerRange<ArcIndexType>(from, ReverseArcLimit(node));
+  }
+  BeginEndWrapper<IncidentArcIterator> IncidentArcsStartingFrom(
+      NodeIndexType node, ArcIndexType from) const;
+  BeginEndWrapper<NodeIndexType const*> operator[](NodeIndexType node) const {
+    return BeginEndWrapper<NodeIndexType const*>(head_ + start_[node],
+                                                 head_ + DirectArcLimit(node));
+  }
+
+  ArcIndexType OppositeArc(ArcIndexType arc) const {
+    DCHECK(IsArcValid(arc));
+    return opposite_[arc];
+  }
+  NodeIndexType Head(ArcIndexType arc) const {
+    DCHECK(IsArcValid(arc));
+    return head_[arc];
+  }
+  NodeIndexType Tail(ArcIndexType arc) const {
+    return head_[OppositeArc(arc)];
+  }
+
+  // See MappedStaticGraph.
+  int num_arc_annotations() const { return num_arc_annotations_; }
+  const int64* ArcAnnotation(int index) const {
+    DCHECK_GE(index, 0);
+    DCHECK_LT(index, num_arc_annotations_);
+    return annotations_ + static_cast<int64>(index) * num_arcs_;
+  }
+  virtual void ReserveNodes(NodeIndexType bound) {
+    LOG(DFATAL) << "MappedReverseArcStaticGraph cannot be modified.";
+  }
+  virtual void ReserveArcs(ArcIndexType bound) {
+    LOG(DFATAL) << "MappedReverseArcStaticGraph cannot be modified.";
+  }
+
+ private:
+  ArcIndexType DirectArcLimit(NodeIndexType node) const {
+    return node + 1 < num_nodes_ ? start_[node + 1] : num_arcs_;
+  }
+  ArcIndexType ReverseArcLimit(NodeIndexType node) const {
+    return node + 1 < num_nodes_ ? reverse_start_[node + 1] : 0;
+  }
+
+  MemoryMappedFile mapped_file_;
+  const ArcIndexType* start_;
+  const ArcIndexType* reverse_start_;
+  // These point to the middle of their arrays, so that they can be indexed by
+  // the arcs in [-num_arcs_, num_arcs_).
+  const NodeIndexType* head_;
+  const ArcIndexType* opposite_;
+  const int64* annotations_;
+  int num_arc_annotations_;
+  DISALLOW_COPY_AND_ASSIGN(MappedReverseArcStaticGraph);
+};
+
+// Implementation of the templated methods.
+
+namespace internal {
+
+// Header of the binary graph file format. See the top of this file. Its size
+// is a multiple of 8 bytes, so that the arrays that follow are aligned.
+struct GraphFileHeader {
+  static const uint64 kMagic = 0x485041524754524fULL;  // "ORTGRAPH".
+  static const uint32 kVersion = 1;
+  uint64 magic;
+  uint32 version;
+  uint32 node_index_size;
+  uint32 arc_index_size;
+  uint32 has_reverse_arcs;
+  int64 num_nodes;
+  int64 num_arcs;
+  int64 num_arc_annotations;
+  // The checksum of everything after the header, see GraphFileChecksum().
+  uint64 checksum;
+};
+
+// Returns the checksum of the given data, whose size must be a multiple of
+// 8 bytes.
+uint64 GraphFileChecksum(const char* data, int64 size);
+
+// Writes a graph file, computing its checksum on the fly. The arrays are
+// written element by element through a buffer, so that the graph does not
+// have to be copied.
+class GraphFileWriter {
+ public:
+  explicit GraphFileWriter(const std::string& filename);
+  ~GraphFileWriter();
+
+  // Writes a placeholder for the header. Must be called first.
+  void BeginFile();
+
+  template <typename T>
+  void Append(T value) {
+    if (buffer_size_ + sizeof(value) > sizeof(buffer_)) Flush();
+    memcpy(buffer_ + buffer_size_, &value, sizeof(value));
+    buffer_size_ += sizeof(value);
+  }
+  void AppendInt64Array(const int64* values, int64 size);
+
+  // Pads the current array to a multiple of 8 bytes.
+  void EndArray();
+
+  // Writes the header, with the checksum of everything written after it, and
+  // closes the file.
+  util::Status EndFile(GraphFileHeader* header);
+
+ private:
+  void Flush();
+
+  const std::string filename_;
+  FILE* file_;
+  bool ok_;
+  uint64 checksum_;
+  int buffer_size_;
+  // A multiple of 8 bytes, so that only whole words are checksummed.
+  char buffer_[1 << 16];
+
+  DISALLOW_COPY_AND_ASSIGN(GraphFileWriter);
+};
+
+// Checks the header of a mapped graph file and its size, and its checksum if
+// verify is true. Returns the offset of the first array in *offset.
+util::Status CheckGraphFile(const MemoryMappedFile& file,
+                            const std::string& filename,
+                            int node_index_size, int arc_index_size,
+                            bool has_reverse_arcs, bool verify,
+                            GraphFileHeader* header, int64* offset);
+
+// Returns the array starting at *offset in data, and advances offset.
+template <typename T>
+const T* GraphFileArray(const char* data, int64 size, int64* offset) {
+  const T* const array = reinterpret_cast<const T*>(data + *offset);
+  *offset += (size * sizeof(T) + 7) & ~7LL;
+  return array;
+}
+
+// Returns true if start[0, num_nodes) is non-decreasing, between begin and
+// end, and starts at begin.
+template <typename ArcIndexType>
+bool IsValidStartArray(const ArcIndexType* start, int64 num_nodes,
+                       ArcIndexType begin, ArcIndexType end) {
+  if (num_nodes > 0 && start[0] != begin) return false;
+  for (int64 node = 1; node < num_nodes; ++node) {
+    if (start[node] < start[node - 1]) return false;
+  }
+  return num_nodes == 0 || start[num_nodes - 1] <= end;
+}
+
+template <typename NodeIndexType>
+bool IsValidNodeArray(const NodeIndexType* nodes, int64 size,
+                      int64 num_nodes) {
+  for (int64 i = 0; i < size; ++i) {
+    if (nodes[i] < 0 || nodes[i] >= num_nodes) return false;
+  }
+  return true;
+}
+
+// Writes the annotations and the header of a graph file.
+template <typename ArcIndexType>
+util::Status EndGraphFile(
+    int64 num_nodes, ArcIndexType num_arcs, int node_index_size,
+    bool has_reverse_arcs,
+    const std::vector<std::vector<int64> >& arc_annotations,
+    GraphFileWriter* writer) {
+  for (int i = 0; i < arc_annotations.size(); ++i) {
+    writer->AppendInt64Array(arc_annotations[i].data(), num_arcs);
+  }
+  GraphFileHeader header;
+  header.node_index_size = node_index_size;
+  header.arc_index_size = sizeof(ArcIndexType);
+  header.has_reverse_arcs = has_reverse_arcs;
+  header.num_nodes = num_nodes;
+  header.num_arcs = num_arcs;
+  header.num_arc_annotations = arc_annotations.size();
+  return writer->EndFile(&header);
+}
+
+template <typename ArcIndexType>
+util::Status CheckArcAnnotations(
+    ArcIndexType num_arcs,
+    const std::vector<std::vector<int64> >& arc_annotations) {
+  for (int i = 0; i < arc_annotations.size(); ++i) {
+    if (arc_annotations[i].size() != num_arcs) {
+      return util::Status(
+          util::error::INVALID_ARGUMENT,
+          StrCat("Arc annotation #", i, " has ", arc_annotations[i].size(),
+                 " elements instead of ", num_arcs, "."));
+    }
+  }
+  return util::Status::OK;
+}
+
+}  // namespace internal
+
+template <typename NodeIndexType, typename ArcIndexType>
+util::Status WriteGraphToBinaryFile(
+    const StaticGraph<NodeIndexType, ArcIndexType>& graph,
+    const std::vector<std::vector<int64> >& arc_annotations,
+    const std::string& filename) {
+  const util::Status status =
+      internal::CheckArcAnnotations(graph.num_arcs(), arc_annotations);
+  if (!status.ok()) return status;
+  internal::GraphFileWriter writer(filename);
+  writer.BeginFile();
+  for (const NodeIndexType node : graph.AllNodes()) {
+    writer.Append<ArcIndexType>(*graph.OutgoingArcs(node).begin());
+  }
+  writer.EndArray();
+  for (const ArcIndexType arc : graph.AllForwardArcs()) {
+    writer.Append<NodeIndexType>(graph.Head(arc));
+  }
+  writer.EndArray();
+  return internal::EndGraphFile(graph.num_nodes(), graph.num_arcs(),
+                                sizeof(NodeIndexType), false, arc_annotations,
+                                &writer);
+}
+
+template <typename NodeIndexType, typename ArcIndexType>
+util::Status WriteGraphToBinaryFile(
+    const ReverseArcStaticGraph<NodeIndexType, ArcIndexType>& graph,
+    const std::vector<std::vector<int64> >& arc_annotations,
+    const std::string& filename) {
+  const util::Status status =
+      internal::CheckArcAnnotations(graph.num_arcs(), arc_annotations);
+  if (!status.ok()) return status;
+  internal::GraphFileWriter writer(filename);
+  writer.BeginFile();
+  for (const NodeIndexType node : graph.AllNodes()) {
+    writer.Append<ArcIndexType>(*graph.OutgoingArcs(node).begin());
+  }
+  writer.EndArray();
+  for (const NodeIndexType node : graph.AllNodes()) {
+    writer.Append<ArcIndexType>(*graph.IncomingArcs(node).begin());
+  }
+  writer.EndArray();
+  const ArcIndexType num_arcs = graph.num_arcs();
+  for (ArcIndexType arc = -num_arcs; arc < num_arcs; ++arc) {
+    writer.Append<NodeIndexType>(graph.Head(arc));
+  }
+  writer.EndArray();
+  for (ArcIndexType arc = -num_arcs; arc < num_arcs; ++arc) {
+    writer.Append<ArcIndexType>(graph.OppositeArc(arc));
+  }
+  writer.EndArray();
+  return internal::EndGraphFile(graph.num_nodes(), num_arcs,
+                                sizeof(NodeIndexType), true, arc_annotations,
+                                &writer);
+}
+
+template <typename NodeIndexType, typename ArcIndexType>
+util::Status MappedStaticGraph<NodeIndexType, ArcIndexType>::LoadFromFile(
+    const std::string& filename, bool verify) {
+  num_nodes_ = 0;
+  num_arcs_ = 0;
+  num_arc_annotations_ = 0;
+  util::Status status = mapped_file_.Open(filename);
+  if (!status.ok()) return status;
+  internal::GraphFileHeader header;
+  int64 offset = 0;
+  status = internal::CheckGraphFile(mapped_file_, filename,
+                                    sizeof(NodeIndexType), sizeof(ArcIndexType),
+                                    false, verify, &header, &offset);
+  const char* const data = mapped_file_.data();
+  if (status.ok()) {
+    start_ = internal::GraphFileArray<ArcIndexType>(data, header.num_nodes,
+                                                    &offset);
+    head_ = internal::GraphFileArray<NodeIndexType>(data, header.num_arcs,
+                                                    &offset);
+    annotations_ = reinterpret_cast<const int64*>(data + offset);
+    if (verify &&
+        (!internal::IsValidStartArray<ArcIndexType>(
+             start_, header.num_nodes, 0, header.num_arcs) ||
+         !internal::IsValidNodeArray(head_, header.num_arcs,
+                                     header.num_nodes))) {
+      status = util::Status(util::error::INVALID_ARGUMENT,
+                            StrCat("'", filename, "' is corrupted."));
+    }
+  }
+  if (!status.ok()) {
+    mapped_file_.Close();
+    return status;
+  }
+  num_nodes_ = header.num_nodes;
+  num_arcs_ = header.num_arcs;
+  num_arc_annotations_ = header.num_arc_annotations;
+  return util::Status::OK;
+}
+
+template <typename NodeIndexType, typename ArcIndexType>
+class MappedStaticGraph<NodeIndexType, ArcIndexType>::OutgoingArcIterator
+    : public Base::BaseStaticArcIterator {
+ public:
+  OutgoingArcIterator(const MappedStaticGraph& graph, NodeIndexType node)
+      : Base::BaseStaticArcIterator(graph.start_[node],
+                                    graph.DirectArcLimit(node)) {
+    DCHECK(graph.IsNodeValid(node));
+  }
+  OutgoingArcIterator(const MappedStaticGraph& graph, NodeIndexType node,
+                      ArcIndexType arc)
+      : Base::BaseStaticArcIterator(arc, graph.DirectArcLimit(node)) {
+    DCHECK(graph.IsNodeValid(node));
+    DCHECK_GE(arc, graph.start_[node]);
+  }
+};
+
+template <typename NodeIndexType, typename ArcIndexType>
+util::Status
+MappedReverseArcStaticGraph<NodeIndexType, ArcIndexType>::LoadFromFile(
+    const std::string& filename, bool verify) {
+  num_nodes_ = 0;
+  num_arcs_ = 0;
+  num_arc_annotations_ = 0;
+  util::Status status = mapped_file_.Open(filename);
+  if (!status.ok()) return status;
+  internal::GraphFileHeader header;
+  int64 offset = 0;
+  status = internal::CheckGraphFile(mapped_file_, filename,
+                                    sizeof(NodeIndexType), sizeof(ArcIndexType),
+                                    true, verify, &header, &offset);
+  const char* const data = mapped_file_.data();
+  if (status.ok()) {
+    const ArcIndexType num_arcs = header.num_arcs;
+    start_ = internal::GraphFileArray<ArcIndexType>(data, header.num_nodes,
+                                                    &offset);
+    reverse_start_ = internal::GraphFileArray<ArcIndexType>(
+        data, header.num_nodes, &offset);
+    head_ = internal::GraphFileArray<NodeIndexType>(data, 2 * header.num_arcs,
+                                                    &offset) +
+            num_arcs;
+    opposite_ = internal::GraphFileArray<ArcIndexType>(
+                    data, 2 * header.num_arcs, &offset) +
+                num_arcs;
+    annotations_ = reinterpret_cast<const int64*>(data + offset);
+    bool valid = !verify ||
+                 (internal::IsValidStartArray<ArcIndexType>(
+                      start_, header.num_nodes, 0, num_arcs) &&
+                  internal::IsValidStartArray<ArcIndexType>(
+                      reverse_start_, header.num_nodes, -num_arcs, 0) &&
+                  internal::IsValidNodeArray(head_ - num_arcs,
+                                             2 * header.num_arcs,
+                                             header.num_nodes));
+    for (ArcIndexType arc = -num_arcs; verify && valid && arc < num_arcs;
+         ++arc) {
+      const ArcIndexType opposite = opposite_[arc];
+      valid = opposite >= -num_arcs && opposite < num_arcs &&
+              (opposite < 0) != (arc < 0) && opposite_[opposite] == arc;
+    }
+    if (!valid) {
+      status = util::Status(util::error::INVALID_ARGUMENT,
+                            StrCat("'", filename, "' is corrupted."));
+    }
+  }
+  if (!status.ok()) {
+    mapped_file_.Close();
+    return status;
+  }
+  num_nodes_ = header.num_nodes;
+  num_arcs_ = header.num_arcs;
+  num_arc_annotations_ = header.num_arc_annotations;
+  return util::Status::OK;
+}
+
+template <typename NodeIndexType, typename ArcIndexType>
+class MappedReverseArcStaticGraph<NodeIndexType,
+                                  ArcIndexType>::OutgoingArcIterator
+    : public Base::BaseStaticArcIterator {
+ public:
+  OutgoingArcIterator(const MappedReverseArcStaticGraph& graph,
+                      NodeIndexType node)
+      : Base::BaseStaticArcIterator(graph.start_[node],
+                                    graph.DirectArcLimit(node)) {
+    DCHECK(graph.IsNodeValid(node));
+  }
+  OutgoingArcIterator(const MappedReverseArcStaticGraph& graph,
+                      NodeIndexType node, ArcIndexType arc)
+      : Base::BaseStaticArcIterator(arc, graph.DirectArcLimit(node)) {
+    DCHECK(graph.IsNodeValid(node));
+    DCHECK_GE(arc, graph.start_[node]);
+  }
+};
+
+template <typename NodeIndexType, typename ArcIndexType>
+class MappedReverseArcStaticGraph<NodeIndexType,
+                                  ArcIndexType>::IncomingArcIterator
+    : public Base::BaseStaticArcIterator {
+ public:
+  IncomingArcIterator(const MappedReverseArcStaticGraph& graph,
+                      NodeIndexType node)
+      : Base::BaseStaticArcIterator(graph.reverse_start_[node],
+                                    graph.ReverseArcLimit(node)) {
+    DCHECK(graph.IsNodeValid(node));
+  }
+  IncomingArcIterator(const MappedReverseArcStaticGraph& graph,
+                      NodeIndexType node, ArcIndexType arc)
+      : Base::BaseStaticArcIterator(arc, graph.ReverseArcLimit(node)) {
+    DCHECK(graph.IsNodeValid(node));
+    DCHECK_GE(arc, graph.reverse_start_[node]);
+  }
+};
+
+// Same as ReverseArcStaticGraph::IncidentArcIterator: the incoming arcs of
+// the node, then its outgoing arcs.
+template <typename NodeIndexType, typename ArcIndexType>
+class MappedReverseArcStaticGraph<NodeIndexType,
+                                  ArcIndexType>::IncidentArcIterator
+    : public Base::BaseStaticArcIterator {
+  using Base::BaseStaticArcIterator::index_;
+
+ public:
+  IncidentArcIterator(const MappedReverseArcStaticGraph& graph,
+                      NodeIndexType node)
+      : Base::BaseStaticArcIterator(graph.reverse_start_[node],
+                                    graph.DirectArcLimit(node)),
+        next_start_(graph.start_[node]),
+        first_limit_(graph.ReverseArcLimit(node)) {
+    if (index_ == first_limit_) index_ = next_start_;
+    DCHECK(graph.IsNodeValid(node));
+  }
+  IncidentArcIterator(const MappedReverseArcStaticGraph& graph,
+                      NodeIndexType node, ArcIndexType arc)
+      : Base::BaseStaticArcIterator(arc, graph.DirectArcLimit(node)),
+        next_start_(graph.start_[node]),
+        first_limit_(graph.ReverseArcLimit(node)) {
+    DCHECK(graph.IsNodeValid(node));
+    DCHECK((index_ >= graph.reverse_start_[node] && index_ < first_limit_) ||
+           (index_ >= next_start_));
+  }
+  void Next() {
+    DCHECK(Base::BaseStaticArcIterator::Ok());
+    index_++;
+    if (index_ == first_limit_) {
+      index_ = next_start_;
+    }
+  }
+
+  bool operator!=(const IncidentArcIterator& other) const {
+    return index_ != other.index_;
+  }
+  ArcIndexType operator*() const { return index_; }
+  void operator++() { Next(); }
+
+ private:
+  ArcIndexType next_start_;
+  ArcIndexType first_limit_;
+};
+
+template <typename NodeIndexType, typename ArcIndexType>
+BeginEndWrapper<typename MappedReverseArcStaticGraph<
+    NodeIndexType, ArcIndexType>::IncidentArcIterator>
+MappedReverseArcStaticGraph<NodeIndexType, ArcIndexType>::IncidentArcs(
+    NodeIndexType node) const {
+  return BeginEndWrapper<IncidentArcIterator>(
+      IncidentArcIterator(*this, node),
+      IncidentArcIterator(*this, node, DirectArcLimit(node)));
+}
+
+template <typename NodeIndexType, typename ArcIndexType>
+BeginEndWrapper<typename MappedReverseArcStaticGraph<
+    NodeIndexType, ArcIndexType>::IncidentArcIterator>
+MappedReverseArcStaticGraph<NodeIndexType, ArcIndexType>::
+    IncidentArcsStartingFrom(NodeIndexType node, ArcIndexType from) const {
+  return BeginEndWrapper<IncidentArcIterator>(
+      IncidentArcIterator(*this, node, from),
+      IncidentArcIterator(*this, node, DirectArcLimit(node)));
+}
+
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_GRAPH_MAPPED_GRAPH_H_
@@ -18,6 +18,7 @@
 
 #include "base/stringprintf.h"
 #include "graph/graphs.h"
+#include "graph/mapped_graph.h"
 
 namespace operations_research {
 
@@ -46,12 +47,30 @@ FlowQuantity SimpleMaxFlow::Capacity(ArcIndex arc) const {
   return arc_capacity_[arc];
 }
 
+void SimpleMaxFlow::SetArcCapacity(ArcIndex arc, FlowQuantity capacity) {
+  arc_capacity_[arc] = capacity;
+  if (underlying_max_flow_.get() != NULL &&
+      arc < underlying_graph_->num_arcs()) {
+    const ArcIndex permuted_arc =
+        arc < arc_permutation_.size() ? arc_permutation_[arc] : arc;
+    underlying_max_flow_->SetArcCapacity(permuted_arc, capacity);
+  }
+}
+
 SimpleMaxFlow::Status SimpleMaxFlow::Solve(NodeIndex source, NodeIndex sink) {
   const ArcIndex num_arcs = arc_capacity_.size();
-  arc_flow_.assign(num_arcs, 0);
+  optimal_flow_ = 0;
+  if (underlying_max_flow_.get() != NULL &&
+      underlying_max_flow_->GetSourceNodeIndex() == source &&
+      underlying_max_flow_->GetSinkNodeIndex() == sink &&
+      underlying_graph_->num_arcs() == num_arcs) {
+    // Same problem up to some capacity changes, the capacities of the
+    // underlying max flow are already up to date.
+    underlying_max_flow_->SolveIncrementally();
+    return TranslateUnderlyingStatus();
+  }
   underlying_max_flow_.reset();
   underlying_graph_.reset();
-  optimal_flow_ = 0;
   if (source == sink || source < 0 || sink < 0) {
     return BAD_INPUT;
   }
@@ -72,13 +91,14 @@ SimpleMaxFlow::Status SimpleMaxFlow::Solve(NodeIndex source, NodeIndex sink) {
         arc < arc_permutation_.size() ? arc_permutation_[arc] : arc;
     underlying_max_flow_->SetArcCapacity(permuted_arc, arc_capacity_[arc]);
   }
-  if (underlying_max_flow_->Solve()) {
+  underlying_max_flow_->Solve();
+  return TranslateUnderlyingStatus();
+}
+
+SimpleMaxFlow::Status SimpleMaxFlow::TranslateUnderlyingStatus() {
+  if (underlying_max_flow_->status() == GenericMaxFlow<Graph>::OPTIMAL ||
+      underlying_max_flow_->status() == GenericMaxFlow<Graph>::INT_OVERFLOW) {
     optimal_flow_ = underlying_max_flow_->GetOptimalFlow();
-    for (ArcIndex arc = 0; arc < num_arcs; ++arc) {
-      ArcIndex permuted_arc =
-          arc < arc_permutation_.size() ? arc_permutation_[arc] : arc;
-      arc_flow_[arc] = underlying_max_flow_->Flow(permuted_arc);
-    }
   }
   // Translate the GenericMaxFlow::Status. It is different because NOT_SOLVED
   // does not make sense in the simple api.
@@ -99,7 +119,19 @@ SimpleMaxFlow::Status SimpleMaxFlow::Solve(NodeIndex source, NodeIndex sink) {
 
 FlowQuantity SimpleMaxFlow::OptimalFlow() const { return optimal_flow_; }
 
-FlowQuantity SimpleMaxFlow::Flow(ArcIndex arc) const { return arc_flow_[arc]; }
+FlowQuantity SimpleMaxFlow::Flow(ArcIndex arc) const {
+  if (underlying_max_flow_.get() == NULL ||
+      arc >= underlying_graph_->num_arcs()) {
+    return 0;
+  }
+  if (underlying_max_flow_->status() != GenericMaxFlow<Graph>::OPTIMAL &&
+      underlying_max_flow_->status() != GenericMaxFlow<Graph>::INT_OVERFLOW) {
+    return 0;
+  }
+  const ArcIndex permuted_arc =
+      arc < arc_permutation_.size() ? arc_permutation_[arc] : arc;
+  return underlying_max_flow_->Flow(permuted_arc);
+}
 
 void SimpleMaxFlow::GetSourceSideMinCut(std::vector<NodeIndex>* result) {
   if (underlying_max_flow_.get() == NULL) return;
@@ -132,6 +164,8 @@ GenericMaxFlow<Graph>::GenericMaxFlow(const Graph* graph, NodeIndex source,
       process_node_by_height_(true),
       check_input_(true),
       check_result_(true),
+      can_repair_flow_(false),
+      potentials_are_valid_(false),
       stats_("MaxFlow") {
   SCOPED_TIME_STAT(&stats_);
   DCHECK(graph->IsNodeValid(source));
@@ -188,16 +222,21 @@ void GenericMaxFlow<Graph>::SetArcCapacity(ArcIndex arc,
            (capacity_delta < 0 && free_capacity + capacity_delta >= 0));
     residual_arc_capacity_.Set(arc, free_capacity + capacity_delta);
     DCHECK_LE(0, residual_arc_capacity_[arc]);
+  } else if (can_repair_flow_) {
+    // Only remove the flow in excess. This creates a deficit at the head of
+    // the arc and an excess at its tail, that SolveIncrementally() deals with.
+    const FlowQuantity flow_delta = Flow(arc) - new_capacity;
+    residual_arc_capacity_.Set(arc, 0);
+    residual_arc_capacity_.Set(Opposite(arc), new_capacity);
+    node_excess_[Tail(arc)] += flow_delta;
+    node_excess_[Head(arc)] -= flow_delta;
   } else {
     // Note that this breaks the preflow invariants but it is currently not an
     // issue since we restart from scratch on each Solve() and we set the status
     // to NOT_SOLVED.
-    //
-    // TODO(user): The easiest is probably to allow negative node excess in
-    // other places than the source, but the current implementation does not
-    // deal with this.
     SetCapacityAndClearFlow(arc, new_capacity);
   }
+  if (can_repair_flow_) modified_arcs_.push_back(arc);
 }
 
 template <typename Graph>
@@ -214,6 +253,7 @@ void GenericMaxFlow<Graph>::SetArcFlow(ArcIndex arc, FlowQuantity new_flow) {
   residual_arc_capacity_.Set(Opposite(arc), -new_flow);
   residual_arc_capacity_.Set(arc, capacity - new_flow);
   status_ = NOT_SOLVED;
+  can_repair_flow_ = false;
 }
 
 template <typename Graph>
@@ -325,6 +365,9 @@ std::string GenericMaxFlow<Graph>::DebugString(const std::string& context,
 template <typename Graph>
 bool GenericMaxFlow<Graph>::Solve() {
   status_ = NOT_SOLVED;
+  can_repair_flow_ = false;
+  potentials_are_valid_ = false;
+  modified_arcs_.clear();
   if (check_input_ && !CheckInputConsistency()) {
     status_ = BAD_INPUT;
     return false;
@@ -363,17 +406,347 @@ bool GenericMaxFlow<Graph>::Solve() {
     // In this case, we are sure that the flow is > kMaxFlowQuantity.
     status_ = INT_OVERFLOW;
   }
+  can_repair_flow_ = status_ == OPTIMAL;
   IF_STATS_ENABLED(VLOG(1) << stats_.StatString());
   return true;
 }
 
+template <typename Graph>
+bool GenericMaxFlow<Graph>::SolveIncrementally() {
+  if (!can_repair_flow_) return Solve();
+  SCOPED_TIME_STAT(&stats_);
+  status_ = NOT_SOLVED;
+  can_repair_flow_ = false;
+  if (check_input_) {
+    for (const ArcIndex arc : modified_arcs_) {
+      if (residual_arc_capacity_[arc] < 0 ||
+          residual_arc_capacity_[Opposite(arc)] < 0) {
+        status_ = BAD_INPUT;
+        return false;
+      }
+    }
+  }
+  if (!potentials_are_valid_) ComputeValidPotentials();
+
+  // The repair relies on the second phase that returns the excess to the
+  // source, see RepairFlow().
+  const bool use_two_phase_algorithm = use_two_phase_algorithm_;
+  use_two_phase_algorithm_ = true;
+  RepairFlow();
+  use_two_phase_algorithm_ = use_two_phase_algorithm;
+  modified_arcs_.clear();
+
+  if (check_result_) {
+    if (!CheckResult()) {
+      status_ = BAD_RESULT;
+      return false;
+    }
+    if (GetOptimalFlow() < kMaxFlowQuantity && AugmentingPathExists()) {
+      LOG(ERROR) << "The algorithm terminated, but the flow is not maximal!";
+      status_ = BAD_RESULT;
+      return false;
+    }
+  }
+  DCHECK_EQ(node_excess_[sink_], -node_excess_[source_]);
+  status_ = OPTIMAL;
+  if (GetOptimalFlow() == kMaxFlowQuantity && AugmentingPathExists()) {
+    status_ = INT_OVERFLOW;
+  }
+  can_repair_flow_ = status_ == OPTIMAL;
+  return true;
+}
+
+template <typename Graph>
+void GenericMaxFlow<Graph>::ComputeValidPotentials() {
+  SCOPED_TIME_STAT(&stats_);
+  const NodeIndex num_nodes = graph_->num_nodes();
+  bfs_queue_.clear();
+  node_in_bfs_queue_.assign(num_nodes, false);
+  node_in_bfs_queue_[sink_] = true;
+  node_in_bfs_queue_[source_] = true;
+
+  // Same as in GlobalUpdate(), but we do not steal any excess, and we always
+  // do the second pass from the source.
+  int queue_index = 0;
+  for (int pass = 0; pass < 2; ++pass) {
+    const NodeIndex root = pass == 0 ? sink_ : source_;
+    node_potential_[root] = pass == 0 ? 0 : num_nodes;
+    bfs_queue_.push_back(root);
+    while (queue_index != bfs_queue_.size()) {
+      const NodeIndex node = bfs_queue_[queue_index];
+      ++queue_index;
+      const NodeIndex candidate_distance = node_potential_[node] + 1;
+      for (IncidentArcIterator it(*graph_, node); it.Ok(); it.Next()) {
+        const ArcIndex arc = it.Index();
+        const NodeIndex head = Head(arc);
+        if (node_in_bfs_queue_[head]) continue;
+        if (residual_arc_capacity_[Opposite(arc)] > 0) {
+          node_potential_[head] = candidate_distance;
+          node_in_bfs_queue_[head] = true;
+          bfs_queue_.push_back(head);
+        }
+      }
+    }
+  }
+  for (NodeIndex node = 0; node < num_nodes; ++node) {
+    if (!node_in_bfs_queue_[node]) {
+      node_potential_[node] = 2 * num_nodes - 1;
+    }
+    first_admissible_arc_[node] = Graph::kNilArc;
+  }
+
+  // The arcs out of the source are the only ones that can break the validity
+  // of these potentials.
+  source_arcs_to_saturate_.clear();
+  for (OutgoingArcIterator it(*graph_, source_); it.Ok(); it.Next()) {
+    const ArcIndex arc = it.Index();
+    if (residual_arc_capacity_[arc] > 0 &&
+        node_potential_[Head(arc)] < num_nodes) {
+      source_arcs_to_saturate_.push_back(arc);
+    }
+  }
+  node_in_repair_queue_.assign(num_nodes, false);
+  repair_parent_arc_.assign(num_nodes, Graph::kNilArc);
+  potentials_are_valid_ = true;
+}
+
+template <typename Graph>
+void GenericMaxFlow<Graph>::RepairFlow() {
+  SCOPED_TIME_STAT(&stats_);
+  const NodeIndex num_nodes = graph_->num_nodes();
+  touched_nodes_.clear();
+
+  // An arc whose residual capacity increased may now break the validity of the
+  // potentials.
+  for (const ArcIndex arc : modified_arcs_) {
+    const NodeIndex tail = Tail(arc);
+    touched_nodes_.push_back(tail);
+    if (residual_arc_capacity_[arc] == 0) continue;
+    if (tail == source_) {
+      source_arcs_to_saturate_.push_back(arc);
+    } else {
+      first_admissible_arc_[tail] = Graph::kNilArc;
+      LowerPotential(tail, node_potential_[Head(arc)] + 1);
+    }
+  }
+
+  // Cancel the deficits created by the capacity decreases. The pulled flow
+  // comes from the sink, the source, or a node with some excess.
+  for (const ArcIndex arc : modified_arcs_) {
+    const NodeIndex head = Head(arc);
+    if (head != source_ && head != sink_ && node_excess_[head] < 0) {
+      CancelDeficit(head);
+    }
+  }
+
+  // Saturate the arcs out of the source whose head may reach the sink.
+  for (const ArcIndex arc : source_arcs_to_saturate_) {
+    const NodeIndex head = Head(arc);
+    if (residual_arc_capacity_[arc] == 0 || node_potential_[head] >= num_nodes) {
+      continue;
+    }
+    // Same overflow protection as in SaturateOutgoingArcsFromSource().
+    const FlowQuantity flow = std::min(residual_arc_capacity_[arc],
+                                       kMaxFlowQuantity + node_excess_[source_]);
+    if (flow == 0) break;
+    PushFlow(flow, arc);
+    touched_nodes_.push_back(head);
+  }
+  source_arcs_to_saturate_.clear();
+
+  // First phase: discharge the active nodes that may still reach the sink. The
+  // heights of the nodes are not the exact distances, so we use a simple stack
+  // of active nodes instead of the queue by height that requires the push
+  // order of a global update.
+  const bool process_node_by_height = process_node_by_height_;
+  process_node_by_height_ = false;
+  DCHECK(IsEmptyActiveNodeContainer());
+  for (const NodeIndex node : touched_nodes_) {
+    if (node == source_ || node == sink_ || node_in_repair_queue_[node]) {
+      continue;
+    }
+    if (IsActive(node) && node_potential_[node] < num_nodes) {
+      node_in_repair_queue_[node] = true;
+      PushActiveNode(node);
+    }
+  }
+  for (const NodeIndex node : touched_nodes_) {
+    node_in_repair_queue_[node] = false;
+  }
+
+  // When the number of discharges becomes too large, the repair is clearly not
+  // local, and it may be running into the costly loops described in
+  // RefineWithGlobalUpdate(). We then finish like Solve(), with global updates.
+  NodeIndex num_discharges = 0;
+  while (!IsEmptyActiveNodeContainer() && num_discharges < num_nodes) {
+    const NodeIndex node = GetAndRemoveFirstActiveNode();
+    if (node == source_ || node == sink_) continue;
+    touched_nodes_.push_back(node);
+    Discharge(node);
+    ++num_discharges;
+  }
+  if (!IsEmptyActiveNodeContainer()) {
+    active_nodes_.clear();
+    process_node_by_height_ = process_node_by_height;
+    DischargeWithGlobalUpdate();
+    PushFlowExcessBackToSource();
+    potentials_are_valid_ = false;
+    return;
+  }
+  process_node_by_height_ = process_node_by_height;
+
+  // Second phase: return the remaining excess to the source.
+  for (const NodeIndex node : touched_nodes_) {
+    if (node != source_ && node != sink_ && node_excess_[node] > 0) {
+      ReturnExcessToSource(node);
+    }
+  }
+}
+
+template <typename Graph>
+void GenericMaxFlow<Graph>::LowerPotential(NodeIndex node, NodeHeight height) {
+  if (node == source_ || node == sink_ || node_potential_[node] <= height) {
+    return;
+  }
+  node_potential_[node] = height;
+  first_admissible_arc_[node] = Graph::kNilArc;
+
+  // Since the new potentials are one more than the potential of the lowered
+  // node, processing the nodes in breadth-first order lowers each of them at
+  // most once.
+  lowered_nodes_.clear();
+  lowered_nodes_.push_back(node);
+  for (int queue_index = 0; queue_index != lowered_nodes_.size();
+       ++queue_index) {
+    const NodeIndex lowered = lowered_nodes_[queue_index];
+    const NodeHeight candidate_height = node_potential_[lowered] + 1;
+    for (IncidentArcIterator it(*graph_, lowered); it.Ok(); it.Next()) {
+      const ArcIndex arc = it.Index();
+      const ArcIndex opposite_arc = Opposite(arc);
+      if (residual_arc_capacity_[opposite_arc] == 0) continue;
+      const NodeIndex head = Head(arc);
+      if (node_potential_[head] <= candidate_height) {
+        // The arc may have become admissible.
+        if (node_potential_[head] == candidate_height) {
+          first_admissible_arc_[head] = Graph::kNilArc;
+        }
+        continue;
+      }
+      if (head == source_) {
+        source_arcs_to_saturate_.push_back(opposite_arc);
+        continue;
+      }
+      DCHECK_NE(head, sink_);
+      node_potential_[head] = candidate_height;
+      first_admissible_arc_[head] = Graph::kNilArc;
+      lowered_nodes_.push_back(head);
+    }
+  }
+}
+
+template <typename Graph>
+void GenericMaxFlow<Graph>::PushFlowAndRepairPotentials(FlowQuantity flow,
+                                                        ArcIndex arc) {
+  PushFlow(flow, arc);
+  const NodeIndex head = Head(arc);
+  first_admissible_arc_[head] = Graph::kNilArc;
+  LowerPotential(head, node_potential_[Tail(arc)] + 1);
+}
+
+template <typename Graph>
+template <bool reverse>
+typename Graph::NodeIndex GenericMaxFlow<Graph>::FindRepairPath(
+    NodeIndex start) {
+  repair_queue_.clear();
+  repair_queue_.push_back(start);
+  node_in_repair_queue_[start] = true;
+  NodeIndex found = -1;
+  for (int queue_index = 0;
+       found == -1 && queue_index != repair_queue_.size(); ++queue_index) {
+    const NodeIndex node = repair_queue_[queue_index];
+    for (IncidentArcIterator it(*graph_, node); it.Ok(); it.Next()) {
+      const ArcIndex arc = it.Index();
+      const ArcIndex residual_arc = reverse ? Opposite(arc) : arc;
+      if (residual_arc_capacity_[residual_arc] == 0) continue;
+      const NodeIndex head = Head(arc);
+      if (node_in_repair_queue_[head]) continue;
+      // Like the rest of the algorithm, never create some flow out of the sink
+      // or into the source.
+      if (IsArcDirect(residual_arc) && head == (reverse ? sink_ : source_)) {
+        continue;
+      }
+      node_in_repair_queue_[head] = true;
+      repair_parent_arc_[head] = residual_arc;
+      repair_queue_.push_back(head);
+      if (head == source_ ||
+          (reverse && (head == sink_ || node_excess_[head] > 0))) {
+        found = head;
+        break;
+      }
+    }
+  }
+  for (const NodeIndex node : repair_queue_) {
+    node_in_repair_queue_[node] = false;
+  }
+  return found;
+}
+
+template <typename Graph>
+void GenericMaxFlow<Graph>::CancelDeficit(NodeIndex node) {
+  SCOPED_TIME_STAT(&stats_);
+  while (node_excess_[node] < 0) {
+    const NodeIndex supply = FindRepairPath<true>(node);
+    if (supply == -1) {
+      LOG(DFATAL) << "No flow to cancel the deficit of node " << node;
+      return;
+    }
+    // repair_parent_arc_ gives the path from supply to node.
+    FlowQuantity flow = -node_excess_[node];
+    if (supply != source_ && supply != sink_) {
+      flow = std::min(flow, node_excess_[supply]);
+    }
+    for (NodeIndex current = supply; current != node;) {
+      const ArcIndex arc = repair_parent_arc_[current];
+      flow = std::min(flow, residual_arc_capacity_[arc]);
+      current = Head(arc);
+    }
+    for (NodeIndex current = supply; current != node;) {
+      const ArcIndex arc = repair_parent_arc_[current];
+      current = Head(arc);
+      PushFlowAndRepairPotentials(flow, arc);
+    }
+  }
+}
+
+template <typename Graph>
+void GenericMaxFlow<Graph>::ReturnExcessToSource(NodeIndex node) {
+  SCOPED_TIME_STAT(&stats_);
+  while (node_excess_[node] > 0) {
+    if (FindRepairPath<false>(node) == -1) {
+      LOG(DFATAL) << "No path to return the excess of node " << node;
+      return;
+    }
+    // repair_parent_arc_ gives the path from node to the source, backward.
+    FlowQuantity flow = node_excess_[node];
+    for (NodeIndex current = source_; current != node;) {
+      const ArcIndex arc = repair_parent_arc_[current];
+      flow = std::min(flow, residual_arc_capacity_[arc]);
+      current = Tail(arc);
+    }
+    for (NodeIndex current = source_; current != node;) {
+      const ArcIndex arc = repair_parent_arc_[current];
+      current = Tail(arc);
+      PushFlowAndRepairPotentials(flow, arc);
+    }
+  }
+}
+
 template <typename Graph>
 void GenericMaxFlow<Graph>::InitializePreflow() {
   SCOPED_TIME_STAT(&stats_);
   // InitializePreflow() clears the whole flow that could have been computed
-  // by a previous Solve(). This is not optimal in terms of complexity.
-  // TODO(user): find a way to make the re-solving incremental (not an obvious
-  // task, and there has not been a lot of literature on the subject.)
+  // by a previous Solve(). This is not optimal in terms of complexity, use
+  // SolveIncrementally() to re-solve after some capacity changes.
   node_excess_.SetAll(0);
   const ArcIndex num_arcs = graph_->num_arcs();
   for (ArcIndex arc = 0; arc < num_arcs; ++arc) {
@@ -783,54 +1156,59 @@ void GenericMaxFlow<Graph>::Refine() {
 template <typename Graph>
 void GenericMaxFlow<Graph>::RefineWithGlobalUpdate() {
   SCOPED_TIME_STAT(&stats_);
+  while (SaturateOutgoingArcsFromSource()) {
+    DischargeWithGlobalUpdate();
+    if (use_two_phase_algorithm_) {
+      PushFlowExcessBackToSource();
+    }
+  }
+}
+
+template <typename Graph>
+void GenericMaxFlow<Graph>::DischargeWithGlobalUpdate() {
+  SCOPED_TIME_STAT(&stats_);
 
   // TODO(user): This should be graph_->num_nodes(), but ebert graph does not
   // have a correct size if the highest index nodes have no arcs.
   const NodeIndex num_nodes = Graphs<Graph>::NodeReservation(*graph_);
   std::vector<int> skip_active_node;
+  int num_skipped;
+  do {
+    num_skipped = 0;
+    skip_active_node.assign(num_nodes, 0);
+    skip_active_node[sink_] = 2;
+    skip_active_node[source_] = 2;
+    GlobalUpdate();
+    while (!IsEmptyActiveNodeContainer()) {
+      const NodeIndex node = GetAndRemoveFirstActiveNode();
+      if (skip_active_node[node] > 1) {
+        if (node != sink_ && node != source_) ++num_skipped;
+        continue;
+      }
+      const NodeIndex old_height = node_potential_[node];
+      Discharge(node);
 
-  while (SaturateOutgoingArcsFromSource()) {
-    int num_skipped;
-    do {
-      num_skipped = 0;
-      skip_active_node.assign(num_nodes, 0);
-      skip_active_node[sink_] = 2;
-      skip_active_node[source_] = 2;
-      GlobalUpdate();
-      while (!IsEmptyActiveNodeContainer()) {
-        const NodeIndex node = GetAndRemoveFirstActiveNode();
-        if (skip_active_node[node] > 1) {
-          if (node != sink_ && node != source_) ++num_skipped;
-          continue;
-        }
-        const NodeIndex old_height = node_potential_[node];
-        Discharge(node);
-
-        // The idea behind this is that if a node height augments by more than
-        // one, then it is likely to push flow back the way it came. This can
-        // lead to very costly loops. A bad case is: source -> n1 -> n2 and n2
-        // just recently isolated from the sink. Then n2 will push flow back to
-        // n1, and n1 to n2 and so on. The height of each node will increase by
-        // steps of two until the height of the source is reached, which can
-        // take a long time. If the chain is longer, the situation is even
-        // worse. The behavior of this heuristic is related to the Gap
-        // heuristic.
-        //
-        // Note that the global update will fix all such cases efficently. So
-        // the idea is to discharge the active node as much as possible, and
-        // then do a global update.
-        //
-        // We skip a node when this condition was true 2 times to avoid doing a
-        // global update too frequently.
-        if (node_potential_[node] > old_height + 1) {
-          ++skip_active_node[node];
-        }
+      // The idea behind this is that if a node height augments by more than
+      // one, then it is likely to push flow back the way it came. This can
+      // lead to very costly loops. A bad case is: source -> n1 -> n2 and n2
+      // just recently isolated from the sink. Then n2 will push flow back to
+      // n1, and n1 to n2 and so on. The height of each node will increase by
+      // steps of two until the height of the source is reached, which can
+      // take a long time. If the chain is longer, the situation is even
+      // worse. The behavior of this heuristic is related to the Gap
+      // heuristic.
+      //
+      // Note that the global update will fix all such cases efficently. So
+      // the idea is to discharge the active node as much as possible, and
+      // then do a global update.
+      //
+      // We skip a node when this condition was true 2 times to avoid doing a
+      // global update too frequently.
+      if (node_potential_[node] > old_height + 1) {
+        ++skip_active_node[node];
       }
-    } while (num_skipped > 0);
-    if (use_two_phase_algorithm_) {
-      PushFlowExcessBackToSource();
     }
-  }
+  } while (num_skipped > 0);
 }
 
 template <typename Graph>
@@ -976,5 +1354,6 @@ template class GenericMaxFlow<StarGraph>;
 template class GenericMaxFlow<ReverseArcListGraph<> >;
 template class GenericMaxFlow<ReverseArcStaticGraph<> >;
 template class GenericMaxFlow<ReverseArcMixedGraph<> >;
+template class GenericMaxFlow<MappedReverseArcStaticGraph<> >;
 
 }  // namespace operations_research
@@ -167,6 +167,12 @@ class SimpleMaxFlow {
   NodeIndex Head(ArcIndex arc) const;
   FlowQuantity Capacity(ArcIndex arc) const;
 
+  // Changes the capacity of an existing arc. If the next Solve() uses the same
+  // source and sink as the last one and no arc was added since, the last flow
+  // is repaired with GenericMaxFlow::SolveIncrementally() instead of being
+  // recomputed from scratch.
+  void SetArcCapacity(ArcIndex arc, FlowQuantity capacity);
+
   // Solves the problem (finds the maximum flow from the given source to the
   // given sink), and returns the problem status.
   enum Status {
@@ -192,6 +198,7 @@ class SimpleMaxFlow {
   FlowQuantity OptimalFlow() const;
 
   // Returns the flow on the given arc in the last OPTIMAL Solve() context.
+  // Note that this returns 0 after a SetArcCapacity(), until the next Solve().
   //
   // Note: It is possible that there is more than one optimal solution. The
   // algorithm is deterministic so it will always return the same solution for
@@ -215,12 +222,14 @@ class SimpleMaxFlow {
   FlowModel CreateFlowModelOfLastSolve();
 
  private:
+  // Sets optimal_flow_ and translates the status of underlying_max_flow_.
+  Status TranslateUnderlyingStatus();
+
   NodeIndex num_nodes_;
   std::vector<NodeIndex> arc_tail_;
   std::vector<NodeIndex> arc_head_;
   std::vector<FlowQuantity> arc_capacity_;
   std::vector<ArcIndex> arc_permutation_;
-  std::vector<FlowQuantity> arc_flow_;
   FlowQuantity optimal_flow_;
 
   // Note that we cannot free the graph before we stop using the max-flow
@@ -342,6 +351,28 @@ class GenericMaxFlow : public MaxFlowStatusClass {
   // Returns true if a maximum flow was solved.
   bool Solve();
 
+  // Re-solves the problem after some SetArcCapacity() calls on a solved
+  // instance. Instead of restarting from a zero flow like Solve(), the previous
+  // maximum flow is repaired: the flow on the arcs whose capacity went below
+  // their flow is reduced, the resulting deficits are cancelled along residual
+  // paths, and the excesses are pushed from the affected nodes with the node
+  // potentials of the previous solve, which are only lowered locally where the
+  // new residual arcs require it. A typical re-solve thus only touches the part
+  // of the graph around the modified arcs. GetSourceSideMinCut() and
+  // GetSinkSideMinCut() are valid afterwards.
+  //
+  // The first call after a Solve() costs one breadth-first search on the whole
+  // graph to compute the node potentials. If the local repair does too much
+  // work, a global update is done like in Solve().
+  //
+  // Note that the result checks enabled by SetCheckResult() look at the whole
+  // graph, so they should be disabled to benefit from the incrementality.
+  //
+  // If there is no previous maximum flow to repair (Solve() was not called or
+  // did not return an OPTIMAL solution, or SetArcFlow() was called since), this
+  // is the same as Solve().
+  bool SolveIncrementally();
+
   // Returns the total flow found by the algorithm.
   FlowQuantity GetOptimalFlow() const { return node_excess_[sink_]; }
 
@@ -471,6 +502,11 @@ class GenericMaxFlow : public MaxFlowStatusClass {
   void Refine();
   void RefineWithGlobalUpdate();
 
+  // Discharges the active nodes found by a GlobalUpdate(), and repeats with a
+  // new GlobalUpdate() while some nodes were skipped because of their height
+  // increases. Used by RefineWithGlobalUpdate() and RepairFlow().
+  void DischargeWithGlobalUpdate();
+
   // Discharges an active node node by saturating its admissible adjacent arcs,
   // if any, and by relabelling it when it becomes inactive.
   void Discharge(NodeIndex node);
@@ -525,6 +561,43 @@ class GenericMaxFlow : public MaxFlowStatusClass {
   template <bool reverse>
   void ComputeReachableNodes(NodeIndex start, std::vector<NodeIndex>* result);
 
+  // Functions used by SolveIncrementally().
+  //
+  // Computes valid node potentials for the current residual graph: the
+  // distance to the sink for the nodes that can reach it, num_nodes + the
+  // distance to the source for the nodes that can only reach the source, and
+  // 2 * num_nodes - 1 for the other nodes.
+  void ComputeValidPotentials();
+
+  // Repairs the flow after the capacity changes of modified_arcs_.
+  void RepairFlow();
+
+  // Lowers the potential of node to height if it is larger, and lowers the
+  // potentials of its predecessors in the residual graph as needed to keep the
+  // potentials valid. The source and the sink are never lowered, but the
+  // outgoing arcs of the source that break the validity are recorded in
+  // source_arcs_to_saturate_.
+  void LowerPotential(NodeIndex node, NodeHeight height);
+
+  // Same as PushFlow(), but also keeps the node potentials valid for the
+  // opposite arc that may have just entered the residual graph.
+  void PushFlowAndRepairPotentials(FlowQuantity flow, ArcIndex arc);
+
+  // Breadth-first search from start in the residual graph that stops at the
+  // source, or in the reverse residual graph (if reverse is true) that stops at
+  // the source, the sink, or a node with a positive excess. Returns the node
+  // found, or -1, and fills repair_parent_arc_ along the path.
+  template <bool reverse>
+  NodeIndex FindRepairPath(NodeIndex start);
+
+  // Cancels the negative excess of node by pulling flow along paths of the
+  // reverse residual graph.
+  void CancelDeficit(NodeIndex node);
+
+  // Returns the excess of a node that cannot reach the sink to the source,
+  // along paths of the residual graph.
+  void ReturnExcessToSource(NodeIndex node);
+
   // Maximum manageable flow.
   static const FlowQuantity kMaxFlowQuantity;
 
@@ -622,6 +695,22 @@ class GenericMaxFlow : public MaxFlowStatusClass {
   // TODO(user): Make the check more exhaustive by checking the optimality?
   bool check_result_;
 
+  // The state used by SolveIncrementally(). can_repair_flow_ is true if the
+  // residual capacities contain a maximum flow of the problem before the
+  // capacity changes of modified_arcs_. The excesses at the ends of these arcs
+  // are kept up to date by SetArcCapacity(), and may be negative.
+  // potentials_are_valid_ is true if node_potential_ is a valid potential for
+  // the residual graph before these changes.
+  bool can_repair_flow_;
+  bool potentials_are_valid_;
+  std::vector<ArcIndex> modified_arcs_;
+  std::vector<ArcIndex> source_arcs_to_saturate_;
+  std::vector<NodeIndex> lowered_nodes_;
+  std::vector<NodeIndex> touched_nodes_;
+  std::vector<bool> node_in_repair_queue_;
+  std::vector<NodeIndex> repair_queue_;
+  std::vector<ArcIndex> repair_parent_arc_;
+
   // Statistics about this class.
   mutable StatsGroup stats_;
 
@@ -22,7 +22,9 @@
 #include "base/stringprintf.h"
 #include "base/mathutil.h"
 #include "graph/graphs.h"
+#include "graph/mapped_graph.h"
 #include "graph/max_flow.h"
+#include "graph/network_simplex.h"
 
 // TODO(user): Remove these flags and expose the parameters in the API.
 // New clients, please do not use these flags!
@@ -969,6 +971,7 @@ template class GenericMinCostFlow<StarGraph>;
 template class GenericMinCostFlow<ReverseArcListGraph<> >;
 template class GenericMinCostFlow<ReverseArcStaticGraph<> >;
 template class GenericMinCostFlow<ReverseArcMixedGraph<> >;
+template class GenericMinCostFlow<MappedReverseArcStaticGraph<> >;
 template class GenericMinCostFlow<ReverseArcStaticGraph<uint16, int32> >;
 
 // A more memory-efficient version for large graphs.
@@ -976,7 +979,7 @@ template class GenericMinCostFlow<ReverseArcStaticGraph<uint16, int32>,
                                   /*ArcFlowType=*/int16,
                                   /*ArcScaledCostType=*/int32>;
 
-SimpleMinCostFlow::SimpleMinCostFlow() {}
+SimpleMinCostFlow::SimpleMinCostFlow() : algorithm_(COST_SCALING) {}
 
 void SimpleMinCostFlow::SetNodeSupply(NodeIndex node, FlowQuantity supply) {
   ResizeNodeVectors(node);
@@ -1089,33 +1092,46 @@ SimpleMinCostFlow::Status SimpleMinCostFlow::SolveWithPossibleAdjustment(
     return INFEASIBLE;
   }
 
+  if (algorithm_ == NETWORK_SIMPLEX) {
+    NetworkSimplex<Graph> network_simplex(&graph);
+    return SolveAugmentedProblem(num_nodes, num_arcs, source, sink,
+                                 &network_simplex);
+  }
   GenericMinCostFlow<Graph> min_cost_flow(&graph);
+  min_cost_flow.SetCheckFeasibility(false);
+  return SolveAugmentedProblem(num_nodes, num_arcs, source, sink,
+                               &min_cost_flow);
+}
+
+template <typename MinCostFlowType>
+SimpleMinCostFlow::Status SimpleMinCostFlow::SolveAugmentedProblem(
+    NodeIndex num_nodes, ArcIndex num_arcs, NodeIndex source, NodeIndex sink,
+    MinCostFlowType* min_cost_flow) {
   ArcIndex arc;
   for (arc = 0; arc < num_arcs; ++arc) {
     ArcIndex permuted_arc = PermutedArc(arc);
-    min_cost_flow.SetArcUnitCost(permuted_arc, arc_cost_[arc]);
-    min_cost_flow.SetArcCapacity(permuted_arc, arc_capacity_[arc]);
+    min_cost_flow->SetArcUnitCost(permuted_arc, arc_cost_[arc]);
+    min_cost_flow->SetArcCapacity(permuted_arc, arc_capacity_[arc]);
   }
   for (NodeIndex node = 0; node < num_nodes; ++node) {
     if (node_supply_[node] != 0) {
       ArcIndex permuted_arc = PermutedArc(arc);
-      min_cost_flow.SetArcCapacity(permuted_arc, std::abs(node_supply_[node]));
-      min_cost_flow.SetArcUnitCost(permuted_arc, 0);
+      min_cost_flow->SetArcCapacity(permuted_arc, std::abs(node_supply_[node]));
+      min_cost_flow->SetArcUnitCost(permuted_arc, 0);
       ++arc;
     }
   }
-  min_cost_flow.SetNodeSupply(source, maximum_flow_);
-  min_cost_flow.SetNodeSupply(sink, -maximum_flow_);
-  min_cost_flow.SetCheckFeasibility(false);
+  min_cost_flow->SetNodeSupply(source, maximum_flow_);
+  min_cost_flow->SetNodeSupply(sink, -maximum_flow_);
 
   arc_flow_.resize(num_arcs);
-  if (min_cost_flow.Solve()) {
-    optimal_cost_ = min_cost_flow.GetOptimalCost();
+  if (min_cost_flow->Solve()) {
+    optimal_cost_ = min_cost_flow->GetOptimalCost();
     for (arc = 0; arc < num_arcs; ++arc) {
-      arc_flow_[arc] = min_cost_flow.Flow(PermutedArc(arc));
+      arc_flow_[arc] = min_cost_flow->Flow(PermutedArc(arc));
     }
   }
-  return min_cost_flow.status();
+  return min_cost_flow->status();
 }
 
 CostValue SimpleMinCostFlow::OptimalCost() const { return optimal_cost_; }
@@ -208,9 +208,13 @@ class MinCostFlowBase {
 // more memory in order to hide the somewhat involved construction of the
 // static graph.
 //
+// The problem can be solved either by the cost-scaling algorithm of
+// GenericMinCostFlow (the default) or by the network simplex of
+// network_simplex.h, see SetAlgorithm().
+//
 // TODO(user): If the need arises, extend this interface to support warm start
 // and incrementality between solves. Note that this is already supported by the
-// GenericMinCostFlow<> interface.
+// GenericMinCostFlow<> and NetworkSimplex<> interfaces.
 class SimpleMinCostFlow : public MinCostFlowBase {
  public:
   // The constructor takes no size. New node indices will be created lazily by
@@ -218,6 +222,16 @@ class SimpleMinCostFlow : public MinCostFlowBase {
   // valid nodes will always be [0, NumNodes()).
   SimpleMinCostFlow();
 
+  // The algorithm used by Solve() and SolveMaxFlowWithMinCost(). The network
+  // simplex is often faster on problems with small costs and few supply
+  // nodes, e.g. transportation problems.
+  enum Algorithm {
+    COST_SCALING,
+    NETWORK_SIMPLEX
+  };
+  void SetAlgorithm(Algorithm algorithm) { algorithm_ = algorithm; }
+  Algorithm algorithm() const { return algorithm_; }
+
   // Adds a directed arc from tail to head to the underlying graph with
   // a given capacity and cost per unit of flow.
   // * Node indices and the capacity must be non-negative (>= 0).
@@ -288,6 +302,12 @@ class SimpleMinCostFlow : public MinCostFlowBase {
   // Solves the problem, potentially applying supply and demand adjustment,
   // and returns the problem status.
   Status SolveWithPossibleAdjustment(SupplyAdjustment adjustment);
+  // Solves the min-cost flow problem on the augmented graph built by
+  // SolveWithPossibleAdjustment(), with one of the algorithms above.
+  template <typename MinCostFlowType>
+  Status SolveAugmentedProblem(NodeIndex num_nodes, ArcIndex num_arcs,
+                               NodeIndex source, NodeIndex sink,
+                               MinCostFlowType* min_cost_flow);
   void ResizeNodeVectors(NodeIndex node);
 
   std::vector<NodeIndex> arc_tail_;
@@ -299,6 +319,7 @@ class SimpleMinCostFlow : public MinCostFlowBase {
   std::vector<FlowQuantity> arc_flow_;
   CostValue optimal_cost_;
   FlowQuantity maximum_flow_;
+  Algorithm algorithm_;
 
   DISALLOW_COPY_AND_ASSIGN(SimpleMinCostFlow);
 };
@@ -0,0 +1,388 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Minimum spanning trees (or forests, if the graph is not connected) of
+// undirected graphs with costs on edges:
+// - on the graph classes of graph.h, with the algorithm of Kruskal, in
+//   O(m log m) time, or with the algorithm of Prim and a binary heap, in
+//   O(m log n) time (n nodes, m arcs). Kruskal is usually faster on sparse
+//   graphs, and can sort the arcs with several threads;
+// - on complete graphs given by a cost function or a matrix, with the dense
+//   version of the algorithm of Prim, in O(n^2) time and O(n) memory, which is
+//   optimal for such graphs. The nodes are scanned by several threads on large
+//   graphs.
+//
+// The edges of the tree are returned as arcs of the graph, or as the parent of
+// each node in the tree for complete graphs.
+//
+// References:
+// - J. B. Kruskal, "On the shortest spanning subtree of a graph and the
+//   traveling salesman problem", Proceedings of the American Mathematical
+//   Society 7 (1): 48-50, 1956.
+// - R. C. Prim, "Shortest connection networks and some generalizations", Bell
+//   System Technical Journal 36 (6): 1389-1401, 1957.
+//
+// Example usage, with the arc costs in a std::vector<int64> costs:
+//   struct ArcCostLess {
+//     explicit ArcCostLess(const std::vector<int64>& costs) : costs(costs) {}
+//     bool operator()(int a, int b) const { return costs[a] < costs[b]; }
+//     const std::vector<int64>& costs;
+//   };
+//   const std::vector<int> tree_arcs = BuildKruskalMinimumSpanningTree(
+//       graph, ArcCostLess(costs), /*num_threads=*/4);
+//
+// See one_tree_lower_bound.h for an application to traveling salesman
+// problems.
+//
+// Keywords: graph, minimum spanning tree, MST, Kruskal, Prim.
+
+#ifndef OR_TOOLS_GRAPH_MINIMUM_SPANNING_TREE_H_
+#define OR_TOOLS_GRAPH_MINIMUM_SPANNING_TREE_H_
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/synchronization.h"
+#include "graph/connectivity.h"
+
+namespace operations_research {
+
+// Returns the arcs of a minimum spanning forest of the graph, using the
+// algorithm of Kruskal on arcs already sorted by increasing cost. The arcs
+// are considered as undirected edges, so sorted_arcs only needs to contain one
+// arc per edge; sorted_arcs may also be a subset of the arcs, to compute the
+// forest of a subgraph. The graph must support Tail(). The arcs are returned in
+// the order of sorted_arcs.
+template <typename Graph>
+std::vector<typename Graph::ArcIndex>
+BuildKruskalMinimumSpanningTreeFromSortedArcs(
+    const Graph& graph,
+    const std::vector<typename Graph::ArcIndex>& sorted_arcs);
+
+// Same as above, but sorts the arcs of the graph first, with
+// arc_comparator(a, b) returning true when the cost of the arc a is smaller
+// than the cost of the arc b. The sort is done with num_threads threads, which
+// pays off from a few hundred thousand arcs. For the graph classes with reverse
+// arcs, only the forward arcs are considered.
+template <typename Graph, typename ArcComparator>
+std::vector<typename Graph::ArcIndex> BuildKruskalMinimumSpanningTree(
+    const Graph& graph, const ArcComparator& arc_comparator,
+    int num_threads = 1);
+
+// Returns the arcs of a minimum spanning forest of the graph, using the
+// algorithm of Prim with a binary heap, arc_value(arc) being the cost of the
+// arc. The graph must be symmetric, i.e. each edge must be given as two arcs,
+// one in each direction, with the same cost, so that the edges of a node can
+// be found among its outgoing arcs. Each tree is grown from its smallest node,
+// and the arcs are returned in the order in which they are added to the trees,
+// oriented from the tree to the new node.
+template <typename Graph, typename ArcValue>
+std::vector<typename Graph::ArcIndex> BuildPrimMinimumSpanningTree(
+    const Graph& graph, const ArcValue& arc_value);
+
+// Computes a minimum spanning tree of the complete graph on the nodes
+// [0, num_nodes), where cost(i, j) is the cost of the edge {i, j}; it must be
+// symmetric, and cost(i, i) is never called. On return, the edges of the tree
+// are {node, (*parent)[node]} for all the nodes but 0, the root of the tree,
+// and (*parent)[0] is -1. Returns the cost of the tree. The costs are summed
+// as doubles, so the result is exact for integer costs as long as it is below
+// 2^53. The ties are broken by node index, so the result does not depend on
+// num_threads.
+template <typename CostFunction>
+double BuildDenseMinimumSpanningTree(int num_nodes, const CostFunction& cost,
+                                     int num_threads, std::vector<int>* parent);
+
+// The cost function of a complete graph whose costs are in a dense matrix,
+// e.g. a std::vector<std::vector<int64> >, for BuildDenseMinimumSpanningTree()
+// and ComputeOneTreeLowerBound().
+template <typename Matrix>
+class MatrixCostFunction {
+ public:
+  explicit MatrixCostFunction(const Matrix& matrix) : matrix_(matrix) {}
+  double operator()(int i, int j) const { return matrix_[i][j]; }
+
+ private:
+  const Matrix& matrix_;
+};
+
+template <typename Matrix>
+MatrixCostFunction<Matrix> MakeMatrixCostFunction(const Matrix& matrix) {
+  return MatrixCostFunction<Matrix>(matrix);
+}
+
+// Implementation.
+
+namespace internal {
+
+template <typename T, typename Comparator>
+void SortRange(T* begin, T* end, const Comparator* comparator) {
+  std::sort(begin, end, *comparator);
+}
+
+template <typename T, typename Comparator>
+void MergeRanges(T* begin, T* middle, T* end, const Comparator* comparator) {
+  std::inplace_merge(begin, middle, end, *comparator);
+}
+
+// Sorts values with num_threads threads: each thread sorts a chunk of the
+// values, and then the sorted chunks are merged by pairs, in parallel, until
+// a single chunk remains. The sort is not stable.
+template <typename T, typename Comparator>
+void ParallelSort(std::vector<T>* values, const Comparator& comparator,
+                  int num_threads) {
+  // Below this number of values per thread, starting a thread costs more than
+  // it saves.
+  const size_t kMinChunkSize = 1 << 15;
+  const int num_chunks =
+      std::min<size_t>(num_threads, values->size() / kMinChunkSize);
+  T* const data = values->data();
+  if (num_chunks <= 1) {
+    std::sort(data, data + values->size(), comparator);
+    return;
+  }
+  std::vector<size_t> chunk_start(num_chunks + 1);
+  for (int chunk = 0; chunk <= num_chunks; ++chunk) {
+    chunk_start[chunk] = values->size() * chunk / num_chunks;
+  }
+  std::vector<std::thread> threads;
+  for (int chunk = 1; chunk < num_chunks; ++chunk) {
+    threads.push_back(std::thread(&SortRange<T, Comparator>,
+                                  data + chunk_start[chunk],
+                                  data + chunk_start[chunk + 1], &comparator));
+  }
+  SortRange(data, data + chunk_start[1], &comparator);
+  for (int i = 0; i < threads.size(); ++i) threads[i].join();
+  for (int width = 1; width < num_chunks; width *= 2) {
+    threads.clear();
+    for (int chunk = 2 * width; chunk + width < num_chunks;
+         chunk += 2 * width) {
+      threads.push_back(std::thread(
+          &MergeRanges<T, Comparator>, data + chunk_start[chunk],
+          data + chunk_start[chunk + width],
+          data + chunk_start[std::min(chunk + 2 * width, num_chunks)],
+          &comparator));
+    }
+    MergeRanges(data, data + chunk_start[width],
+                data + chunk_start[std::min(2 * width, num_chunks)],
+                &comparator);
+    for (int i = 0; i < threads.size(); ++i) threads[i].join();
+  }
+}
+
+// The dense version of the algorithm of Prim. Each thread owns a contiguous
+// block of nodes. At each step, all the threads update the keys of their nodes
+// (the cost of their cheapest edge to the tree) with the node added last, and
+// compute their best node. After a barrier, each thread reads the best nodes of
+// all the threads and finds the same next node to add to the tree, so that
+// there is only one barrier per step. The best nodes are written alternately
+// in two arrays, so that a thread can write its best node for the next step
+// while the slower threads are still reading the best nodes of this step.
+template <typename CostFunction>
+class DensePrimMinimumSpanningTree {
+ public:
+  DensePrimMinimumSpanningTree(int num_nodes, const CostFunction& cost,
+                               int num_threads, std::vector<int>* parent)
+      : num_nodes_(num_nodes),
+        cost_(cost),
+        num_threads_(num_threads),
+        parent_(parent),
+        key_(num_nodes),
+        in_tree_(num_nodes, false),
+        best_node_(2 * num_threads),
+        barrier_(num_threads) {}
+
+  double Run() {
+    parent_->assign(num_nodes_, 0);
+    if (num_nodes_ == 0) return 0.0;
+    (*parent_)[0] = -1;
+    in_tree_[0] = true;
+    std::vector<std::thread> threads;
+    for (int thread = 1; thread < num_threads_; ++thread) {
+      threads.push_back(
+          std::thread(&DensePrimMinimumSpanningTree::AddNodes, this, thread));
+    }
+    AddNodes(0);
+    for (int i = 0; i < threads.size(); ++i) threads[i].join();
+    double tree_cost = 0.0;
+    for (int node = 1; node < num_nodes_; ++node) tree_cost += key_[node];
+    return tree_cost;
+  }
+
+ private:
+  // The best node of a thread, padded to avoid false sharing.
+  struct BestNode {
+    double key;
+    int node;
+    char padding[64];
+  };
+
+  void AddNodes(int thread) {
+    const int begin = 1 + (num_nodes_ - 1) * static_cast<int64>(thread) /
+                              num_threads_;
+    const int end = 1 + (num_nodes_ - 1) * static_cast<int64>(thread + 1) /
+                            num_threads_;
+    std::vector<int>& parent = *parent_;
+    int last_node = 0;
+    for (int step = 1; step < num_nodes_; ++step) {
+      double best_key = 0.0;
+      int best_node = -1;
+      for (int node = begin; node < end; ++node) {
+        if (in_tree_[node]) continue;
+        const double cost = cost_(last_node, node);
+        if (step == 1 || cost < key_[node]) {
+          key_[node] = cost;
+          parent[node] = last_node;
+        }
+        if (best_node == -1 || key_[node] < best_key) {
+          best_key = key_[node];
+          best_node = node;
+        }
+      }
+      BestNode* const best = &best_node_[(step & 1) * num_threads_];
+      best[thread].key = best_key;
+      best[thread].node = best_node;
+      if (num_threads_ > 1) barrier_.Wait();
+      last_node = -1;
+      for (int i = 0; i < num_threads_; ++i) {
+        if (best[i].node == -1) continue;
+        if (last_node == -1 || best[i].key < best_key) {
+          best_key = best[i].key;
+          last_node = best[i].node;
+        }
+      }
+      DCHECK_NE(-1, last_node);
+      if (last_node >= begin && last_node < end) in_tree_[last_node] = true;
+    }
+  }
+
+  const int num_nodes_;
+  const CostFunction& cost_;
+  const int num_threads_;
+  std::vector<int>* const parent_;
+  // The cost of the cheapest edge from each node to the tree. Each entry is
+  // only accessed by the thread that owns the node, as in_tree_.
+  std::vector<double> key_;
+  std::vector<char> in_tree_;
+  std::vector<BestNode> best_node_;
+  SpinningBarrier barrier_;
+
+  DISALLOW_COPY_AND_ASSIGN(DensePrimMinimumSpanningTree);
+};
+
+}  // namespace internal
+
+template <typename Graph>
+std::vector<typename Graph::ArcIndex>
+BuildKruskalMinimumSpanningTreeFromSortedArcs(
+    const Graph& graph,
+    const std::vector<typename Graph::ArcIndex>& sorted_arcs) {
+  typedef typename Graph::ArcIndex ArcIndex;
+  const int num_nodes = graph.num_nodes();
+  std::vector<ArcIndex> tree_arcs;
+  if (num_nodes < 2) return tree_arcs;
+  // ConnectedComponents needs at least 3 nodes.
+  ConnectedComponents components;
+  components.Init(std::max(num_nodes, 3));
+  const int max_tree_size = num_nodes - 1;
+  for (int i = 0; i < sorted_arcs.size(); ++i) {
+    const ArcIndex arc = sorted_arcs[i];
+    const int tail_class =
+        components.GetClassRepresentative(graph.Tail(arc));
+    const int head_class =
+        components.GetClassRepresentative(graph.Head(arc));
+    if (tail_class == head_class) continue;
+    components.MergeClasses(tail_class, head_class);
+    tree_arcs.push_back(arc);
+    if (tree_arcs.size() == max_tree_size) break;
+  }
+  return tree_arcs;
+}
+
+template <typename Graph, typename ArcComparator>
+std::vector<typename Graph::ArcIndex> BuildKruskalMinimumSpanningTree(
+    const Graph& graph, const ArcComparator& arc_comparator,
+    int num_threads) {
+  typedef typename Graph::ArcIndex ArcIndex;
+  CHECK_GE(num_threads, 1);
+  std::vector<ArcIndex> sorted_arcs;
+  sorted_arcs.reserve(graph.num_arcs());
+  for (const ArcIndex arc : graph.AllForwardArcs()) {
+    // Self-loops are never part of the tree.
+    if (graph.Head(arc) != graph.Tail(arc)) sorted_arcs.push_back(arc);
+  }
+  internal::ParallelSort(&sorted_arcs, arc_comparator, num_threads);
+  return BuildKruskalMinimumSpanningTreeFromSortedArcs(graph, sorted_arcs);
+}
+
+template <typename Graph, typename ArcValue>
+std::vector<typename Graph::ArcIndex> BuildPrimMinimumSpanningTree(
+    const Graph& graph, const ArcValue& arc_value) {
+  typedef typename Graph::NodeIndex NodeIndex;
+  typedef typename Graph::ArcIndex ArcIndex;
+  typedef typename std::decay<decltype(arc_value(ArcIndex()))>::type Value;
+  // The heap contains the arcs leaving the trees, with lazy deletion: an arc
+  // is skipped when it is popped if its head is already in a tree.
+  typedef std::pair<Value, ArcIndex> Entry;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > heap;
+  const NodeIndex num_nodes = graph.num_nodes();
+  std::vector<bool> in_tree(num_nodes, false);
+  std::vector<ArcIndex> tree_arcs;
+  for (NodeIndex root = 0; root < num_nodes; ++root) {
+    if (in_tree[root]) continue;
+    NodeIndex node = root;
+    while (true) {
+      in_tree[node] = true;
+      for (const ArcIndex arc : graph.OutgoingArcs(node)) {
+        if (!in_tree[graph.Head(arc)]) {
+          heap.push(Entry(arc_value(arc), arc));
+        }
+      }
+      while (!heap.empty() && in_tree[graph.Head(heap.top().second)]) {
+        heap.pop();
+      }
+      if (heap.empty()) break;
+      const ArcIndex arc = heap.top().second;
+      heap.pop();
+      tree_arcs.push_back(arc);
+      node = graph.Head(arc);
+    }
+  }
+  return tree_arcs;
+}
+
+template <typename CostFunction>
+double BuildDenseMinimumSpanningTree(int num_nodes, const CostFunction& cost,
+                                     int num_threads,
+                                     std::vector<int>* parent) {
+  CHECK_GE(num_threads, 1);
+  // Below this number of nodes per thread, the synchronization of the threads
+  // at each step costs more than it saves.
+  const int kMinNodesPerThread = 1000;
+  const int used_threads =
+      std::max(1, std::min(num_threads, num_nodes / kMinNodesPerThread));
+  internal::DensePrimMinimumSpanningTree<CostFunction> prim(
+      num_nodes, cost, used_threads, parent);
+  return prim.Run();
+}
+
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_GRAPH_MINIMUM_SPANNING_TREE_H_
@@ -0,0 +1,575 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "graph/network_simplex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "base/commandlineflags.h"
+
+DECLARE_bool(min_cost_flow_check_result);
+
+namespace operations_research {
+
+namespace {
+// The capacity of the artificial arcs.
+const FlowQuantity kInfiniteCapacity = std::numeric_limits<FlowQuantity>::max();
+}  // namespace
+
+template <typename Graph>
+NetworkSimplex<Graph>::NetworkSimplex(const Graph* graph)
+    : graph_(graph),
+      num_nodes_(graph->num_nodes()),
+      num_arcs_(graph->num_arcs()),
+      status_(NOT_SOLVED),
+      root_(graph->num_nodes()),
+      artificial_cost_(0),
+      tail_(num_arcs_ + num_nodes_),
+      head_(num_arcs_ + num_nodes_),
+      capacity_(num_arcs_ + num_nodes_, 0),
+      cost_(num_arcs_ + num_nodes_, 0),
+      flow_(num_arcs_ + num_nodes_, 0),
+      state_(num_arcs_ + num_nodes_, STATE_LOWER),
+      supply_(num_nodes_ + 1, 0),
+      potential_(num_nodes_ + 1, 0),
+      parent_(num_nodes_ + 1),
+      pred_arc_(num_nodes_ + 1),
+      pred_direction_(num_nodes_ + 1),
+      thread_(num_nodes_ + 1),
+      rev_thread_(num_nodes_ + 1),
+      subtree_size_(num_nodes_ + 1),
+      last_successor_(num_nodes_ + 1),
+      has_basis_(false),
+      block_size_(0),
+      pivot_block_size_(0),
+      next_arc_(0),
+      in_arc_(-1),
+      join_(-1),
+      delta_(0),
+      u_in_(-1),
+      v_in_(-1),
+      u_out_(-1),
+      v_out_(-1),
+      total_flow_cost_(0),
+      num_pivots_(0),
+      was_warm_started_(false) {
+  for (ArcIndex arc = 0; arc < num_arcs_; ++arc) {
+    tail_[arc] = graph_->Tail(arc);
+    head_[arc] = graph_->Head(arc);
+  }
+}
+
+template <typename Graph>
+void NetworkSimplex<Graph>::SetNodeSupply(NodeIndex node, FlowQuantity supply) {
+  DCHECK(graph_->IsNodeValid(node));
+  supply_[node] = supply;
+  status_ = NOT_SOLVED;
+}
+
+template <typename Graph>
+void NetworkSimplex<Graph>::SetArcUnitCost(ArcIndex arc, CostValue unit_cost) {
+  DCHECK(graph_->IsArcValid(arc));
+  DCHECK_GE(arc, 0);
+  cost_[arc] = unit_cost;
+  status_ = NOT_SOLVED;
+}
+
+template <typename Graph>
+void NetworkSimplex<Graph>::SetArcCapacity(ArcIndex arc,
+                                           FlowQuantity capacity) {
+  DCHECK(graph_->IsArcValid(arc));
+  DCHECK_GE(arc, 0);
+  DCHECK_LE(0, capacity);
+  capacity_[arc] = capacity;
+  status_ = NOT_SOLVED;
+}
+
+template <typename Graph>
+bool NetworkSimplex<Graph>::Solve() {
+  status_ = NOT_SOLVED;
+  total_flow_cost_ = 0;
+  num_pivots_ = 0;
+  was_warm_started_ = false;
+  FlowQuantity total_supply = 0;
+  for (NodeIndex node = 0; node < num_nodes_; ++node) {
+    total_supply += supply_[node];
+  }
+  if (total_supply != 0) {
+    status_ = UNBALANCED;
+    return false;
+  }
+  if (num_nodes_ == 0) {
+    status_ = OPTIMAL;
+    return true;
+  }
+  if (!ComputeArtificialCost()) {
+    status_ = BAD_COST_RANGE;
+    return false;
+  }
+  was_warm_started_ = has_basis_ && InitializeFromPreviousBasis();
+  if (!was_warm_started_) InitializeArtificialBasis();
+  has_basis_ = true;
+  ComputePotentials();
+
+  pivot_block_size_ = block_size_;
+  if (pivot_block_size_ <= 0) {
+    pivot_block_size_ = std::max(
+        static_cast<ArcIndex>(10),
+        static_cast<ArcIndex>(std::ceil(std::sqrt(static_cast<double>(num_arcs_)))));
+  }
+  next_arc_ = 0;
+  while (FindEnteringArc()) {
+    ++num_pivots_;
+    FindJoinNode();
+    const bool change_tree = FindLeavingArc();
+    ChangeFlow(change_tree);
+    if (change_tree) {
+      UpdateTreeStructure();
+      UpdatePotentials();
+    }
+  }
+  VLOG(1) << "Network simplex: " << num_pivots_ << " pivots"
+          << (was_warm_started_ ? " (warm start)." : ".");
+
+  // With a large enough artificial cost, the artificial arcs only carry some
+  // flow if the supplies cannot be routed through the network.
+  for (NodeIndex node = 0; node < num_nodes_; ++node) {
+    if (flow_[num_arcs_ + node] != 0) {
+      status_ = INFEASIBLE;
+      return false;
+    }
+  }
+  if (FLAGS_min_cost_flow_check_result && !CheckResult()) {
+    status_ = BAD_RESULT;
+    return false;
+  }
+  for (ArcIndex arc = 0; arc < num_arcs_; ++arc) {
+    total_flow_cost_ += flow_[arc] * cost_[arc];
+  }
+  status_ = OPTIMAL;
+  return true;
+}
+
+template <typename Graph>
+bool NetworkSimplex<Graph>::ComputeArtificialCost() {
+  CostValue max_cost = 0;
+  for (ArcIndex arc = 0; arc < num_arcs_; ++arc) {
+    max_cost = std::max(max_cost, std::abs(cost_[arc]));
+  }
+  // A path of real arcs costs at most (num_nodes - 1) * max_cost, so routing
+  // a unit of flow through the root is always more expensive. The potentials
+  // are bounded by artificial_cost_ + num_nodes * max_cost, and the reduced
+  // costs by about twice that, which must not overflow.
+  const CostValue kMaxArtificialCost = std::numeric_limits<CostValue>::max() / 4;
+  if (max_cost + 1 > kMaxArtificialCost / (num_nodes_ + 1)) {
+    LOG(ERROR) << "The costs are too large for the network simplex, the largest"
+               << " absolute unit cost is " << max_cost;
+    return false;
+  }
+  artificial_cost_ = (max_cost + 1) * (num_nodes_ + 1);
+  return true;
+}
+
+template <typename Graph>
+bool NetworkSimplex<Graph>::InitializeFromPreviousBasis() {
+  // The non-tree arcs are at their (possibly new) bounds.
+  std::vector<FlowQuantity> excess(supply_);
+  excess[root_] = 0;
+  for (ArcIndex arc = 0; arc < num_arcs_ + num_nodes_; ++arc) {
+    if (arc >= num_arcs_) {
+      cost_[arc] = tail_[arc] == root_ ? artificial_cost_ : 0;
+    }
+    if (state_[arc] == STATE_TREE) continue;
+    flow_[arc] = state_[arc] == STATE_UPPER ? capacity_[arc] : 0;
+    excess[tail_[arc]] -= flow_[arc];
+    excess[head_[arc]] += flow_[arc];
+  }
+
+  // The tree arcs carry the excess of the subtree below them. The nodes are
+  // processed in reverse preorder, i.e. after all the nodes of their subtree.
+  for (NodeIndex node = rev_thread_[root_]; node != root_;
+       node = rev_thread_[node]) {
+    const ArcIndex arc = pred_arc_[node];
+    const FlowQuantity flow =
+        pred_direction_[node] == DIRECTION_UP ? excess[node] : -excess[node];
+    if (flow < 0 || flow > capacity_[arc]) return false;
+
+    // The basis must stay strongly feasible: some flow can be sent from node
+    // to its parent.
+    if (pred_direction_[node] == DIRECTION_UP ? flow == capacity_[arc]
+                                              : flow == 0) {
+      return false;
+    }
+    flow_[arc] = flow;
+    excess[parent_[node]] += excess[node];
+  }
+  return true;
+}
+
+template <typename Graph>
+void NetworkSimplex<Graph>::InitializeArtificialBasis() {
+  std::vector<FlowQuantity> excess(supply_);
+  for (ArcIndex arc = 0; arc < num_arcs_; ++arc) {
+    if (state_[arc] == STATE_UPPER) {
+      flow_[arc] = capacity_[arc];
+      excess[tail_[arc]] -= flow_[arc];
+      excess[head_[arc]] += flow_[arc];
+    } else {
+      state_[arc] = STATE_LOWER;
+      flow_[arc] = 0;
+    }
+  }
+
+  // All the nodes are children of the root, in the order of their indices.
+  parent_[root_] = -1;
+  pred_arc_[root_] = -1;
+  thread_[root_] = 0;
+  rev_thread_[0] = root_;
+  subtree_size_[root_] = num_nodes_ + 1;
+  last_successor_[root_] = num_nodes_ - 1;
+  potential_[root_] = 0;
+  for (NodeIndex node = 0; node < num_nodes_; ++node) {
+    const ArcIndex arc = num_arcs_ + node;
+    parent_[node] = root_;
+    pred_arc_[node] = arc;
+    thread_[node] = node + 1;
+    rev_thread_[node + 1] = node;
+    subtree_size_[node] = 1;
+    last_successor_[node] = node;
+    state_[arc] = STATE_TREE;
+    capacity_[arc] = kInfiniteCapacity;
+    if (excess[node] >= 0) {
+      pred_direction_[node] = DIRECTION_UP;
+      tail_[arc] = node;
+      head_[arc] = root_;
+      flow_[arc] = excess[node];
+      cost_[arc] = 0;
+    } else {
+      pred_direction_[node] = DIRECTION_DOWN;
+      tail_[arc] = root_;
+      head_[arc] = node;
+      flow_[arc] = -excess[node];
+      cost_[arc] = artificial_cost_;
+    }
+  }
+}
+
+template <typename Graph>
+void NetworkSimplex<Graph>::ComputePotentials() {
+  potential_[root_] = 0;
+  for (NodeIndex node = thread_[root_]; node != root_; node = thread_[node]) {
+    potential_[node] = potential_[parent_[node]] -
+                       pred_direction_[node] * cost_[pred_arc_[node]];
+  }
+}
+
+// Block search: scans the arcs circularly from next_arc_ by blocks of
+// pivot_block_size_ arcs, and stops at the end of the first block in which
+// an arc can enter the basis. The artificial arcs are never considered.
+template <typename Graph>
+bool NetworkSimplex<Graph>::FindEnteringArc() {
+  CostValue min_value = 0;
+  ArcIndex count = pivot_block_size_;
+  ArcIndex arc = next_arc_;
+  for (ArcIndex num_scanned = 0; num_scanned < num_arcs_; ++num_scanned) {
+    const CostValue value = state_[arc] * ReducedCost(arc);
+    if (value < min_value) {
+      min_value = value;
+      in_arc_ = arc;
+    }
+    if (++arc == num_arcs_) arc = 0;
+    if (--count == 0) {
+      if (min_value < 0) break;
+      count = pivot_block_size_;
+    }
+  }
+  if (min_value >= 0) return false;
+  next_arc_ = arc;
+  return true;
+}
+
+// The join node is the first common ancestor of the ends of in_arc_.
+template <typename Graph>
+void NetworkSimplex<Graph>::FindJoinNode() {
+  NodeIndex u = tail_[in_arc_];
+  NodeIndex v = head_[in_arc_];
+  while (u != v) {
+    if (subtree_size_[u] < subtree_size_[v]) {
+      u = parent_[u];
+    } else {
+      v = parent_[v];
+    }
+  }
+  join_ = u;
+}
+
+// Computes delta_, the amount of flow that can be pushed around the cycle in
+// the direction of in_arc_ (forward if it is at its lower bound, backward
+// otherwise), and the blocking arc that leaves the basis. Returns false if
+// in_arc_ itself is blocking, i.e. it only changes bound.
+//
+// The cycle is oriented from first to second along in_arc_. To keep the tree
+// strongly feasible, the leaving arc is the last blocking arc when going
+// around the cycle from the join node in this orientation, hence the strict
+// and non-strict comparisons below.
+template <typename Graph>
+bool NetworkSimplex<Graph>::FindLeavingArc() {
+  NodeIndex first;
+  NodeIndex second;
+  if (state_[in_arc_] == STATE_LOWER) {
+    first = tail_[in_arc_];
+    second = head_[in_arc_];
+  } else {
+    first = head_[in_arc_];
+    second = tail_[in_arc_];
+  }
+  delta_ = capacity_[in_arc_];
+  int result = 0;
+  for (NodeIndex u = first; u != join_; u = parent_[u]) {
+    const ArcIndex arc = pred_arc_[u];
+    const FlowQuantity residual = pred_direction_[u] == DIRECTION_DOWN
+                                      ? capacity_[arc] - flow_[arc]
+                                      : flow_[arc];
+    if (residual < delta_) {
+      delta_ = residual;
+      u_out_ = u;
+      result = 1;
+    }
+  }
+  for (NodeIndex u = second; u != join_; u = parent_[u]) {
+    const ArcIndex arc = pred_arc_[u];
+    const FlowQuantity residual = pred_direction_[u] == DIRECTION_UP
+                                      ? capacity_[arc] - flow_[arc]
+                                      : flow_[arc];
+    if (residual <= delta_) {
+      delta_ = residual;
+      u_out_ = u;
+      result = 2;
+    }
+  }
+  if (result == 1) {
+    u_in_ = first;
+    v_in_ = second;
+  } else {
+    u_in_ = second;
+    v_in_ = first;
+  }
+  return result != 0;
+}
+
+template <typename Graph>
+void NetworkSimplex<Graph>::ChangeFlow(bool change_tree) {
+  if (delta_ > 0) {
+    const FlowQuantity value = state_[in_arc_] * delta_;
+    flow_[in_arc_] += value;
+    for (NodeIndex u = tail_[in_arc_]; u != join_; u = parent_[u]) {
+      flow_[pred_arc_[u]] -= pred_direction_[u] * value;
+    }
+    for (NodeIndex u = head_[in_arc_]; u != join_; u = parent_[u]) {
+      flow_[pred_arc_[u]] += pred_direction_[u] * value;
+    }
+  }
+  if (change_tree) {
+    state_[in_arc_] = STATE_TREE;
+    const ArcIndex out_arc = pred_arc_[u_out_];
+    state_[out_arc] = flow_[out_arc] == 0 ? STATE_LOWER : STATE_UPPER;
+  } else {
+    state_[in_arc_] = -state_[in_arc_];
+  }
+}
+
+// Removes the arc from u_out_ to its parent v_out_, and hangs the subtree of
+// u_out_ under v_in_ through in_arc_. The nodes on the tree path from u_in_ to
+// u_out_ (the "stem") are reversed: each one becomes the parent of its former
+// parent. The thread is updated by moving the subtrees of the stem nodes just
+// after v_in_, and the subtree sizes and last successors are updated along the
+// paths to the join node.
+template <typename Graph>
+void NetworkSimplex<Graph>::UpdateTreeStructure() {
+  const NodeIndex old_rev_thread = rev_thread_[u_out_];
+  const NodeIndex old_subtree_size = subtree_size_[u_out_];
+  const NodeIndex old_last_successor = last_successor_[u_out_];
+  v_out_ = parent_[u_out_];
+
+  if (u_in_ == u_out_) {
+    // Only the parent of u_in_ changes.
+    parent_[u_in_] = v_in_;
+    pred_arc_[u_in_] = in_arc_;
+    pred_direction_[u_in_] =
+        u_in_ == tail_[in_arc_] ? DIRECTION_UP : DIRECTION_DOWN;
+
+    // Move the subtree of u_in_ just after v_in_ in the thread.
+    if (thread_[v_in_] != u_out_) {
+      NodeIndex after = thread_[old_last_successor];
+      thread_[old_rev_thread] = after;
+      rev_thread_[after] = old_rev_thread;
+      after = thread_[v_in_];
+      thread_[v_in_] = u_out_;
+      rev_thread_[u_out_] = v_in_;
+      thread_[old_last_successor] = after;
+      rev_thread_[after] = old_last_successor;
+    }
+  } else {
+    // If old_rev_thread is v_in_ (then join_ is v_out_), the thread after the
+    // moved subtrees continues after the old subtree of u_out_.
+    const NodeIndex thread_continue = old_rev_thread == v_in_
+                                          ? thread_[old_last_successor]
+                                          : thread_[v_in_];
+
+    // Update the thread and the parents along the stem.
+    NodeIndex stem = u_in_;
+    NodeIndex parent_stem = v_in_;
+    NodeIndex last = last_successor_[u_in_];
+    NodeIndex after = thread_[last];
+    thread_[v_in_] = u_in_;
+    dirty_rev_threads_.clear();
+    dirty_rev_threads_.push_back(v_in_);
+    while (stem != u_out_) {
+      // Insert the next stem node in the thread.
+      const NodeIndex next_stem = parent_[stem];
+      thread_[last] = next_stem;
+      dirty_rev_threads_.push_back(last);
+
+      // Remove the subtree of stem from the thread.
+      const NodeIndex before = rev_thread_[stem];
+      thread_[before] = after;
+      rev_thread_[after] = before;
+
+      // Change the parent and move to the next stem node.
+      parent_[stem] = parent_stem;
+      parent_stem = stem;
+      stem = next_stem;
+
+      // The last node of the remaining subtree of stem.
+      last = last_successor_[stem] == last_successor_[parent_stem]
+                 ? rev_thread_[parent_stem]
+                 : last_successor_[stem];
+      after = thread_[last];
+    }
+    parent_[u_out_] = parent_stem;
+    thread_[last] = thread_continue;
+    rev_thread_[thread_continue] = last;
+    last_successor_[u_out_] = last;
+
+    // Remove the subtree of u_out_ from its old position in the thread, except
+    // if it was just after v_in_.
+    if (old_rev_thread != v_in_) {
+      thread_[old_rev_thread] = after;
+      rev_thread_[after] = old_rev_thread;
+    }
+    for (const NodeIndex node : dirty_rev_threads_) {
+      rev_thread_[thread_[node]] = node;
+    }
+
+    // Update the tree arcs, the subtree sizes and the last successors along
+    // the stem, from u_out_ to u_in_.
+    NodeIndex stem_subtree_size = 0;
+    const NodeIndex stem_last_successor = last_successor_[u_out_];
+    for (NodeIndex u = u_out_, p = parent_[u]; u != u_in_;
+         u = p, p = parent_[u]) {
+      pred_arc_[u] = pred_arc_[p];
+      pred_direction_[u] = -pred_direction_[p];
+      stem_subtree_size += subtree_size_[u] - subtree_size_[p];
+      subtree_size_[u] = stem_subtree_size;
+      last_successor_[p] = stem_last_successor;
+    }
+    pred_arc_[u_in_] = in_arc_;
+    pred_direction_[u_in_] =
+        u_in_ == tail_[in_arc_] ? DIRECTION_UP : DIRECTION_DOWN;
+    subtree_size_[u_in_] = old_subtree_size;
+  }
+
+  // Update the last successors from v_in_ towards the root.
+  const NodeIndex up_limit_out = last_successor_[join_] == v_in_ ? join_ : -1;
+  const NodeIndex last_successor_out = last_successor_[u_out_];
+  for (NodeIndex u = v_in_; u != -1 && last_successor_[u] == v_in_;
+       u = parent_[u]) {
+    last_successor_[u] = last_successor_out;
+  }
+
+  // Update the last successors from v_out_ towards the root.
+  if (join_ != old_rev_thread && v_in_ != old_rev_thread) {
+    for (NodeIndex u = v_out_;
+         u != up_limit_out && last_successor_[u] == old_last_successor;
+         u = parent_[u]) {
+      last_successor_[u] = old_rev_thread;
+    }
+  } else if (last_successor_out != old_last_successor) {
+    for (NodeIndex u = v_out_;
+         u != up_limit_out && last_successor_[u] == old_last_successor;
+         u = parent_[u]) {
+      last_successor_[u] = last_successor_out;
+    }
+  }
+
+  // Update the subtree sizes on the paths from v_in_ and v_out_ to join_.
+  for (NodeIndex u = v_in_; u != join_; u = parent_[u]) {
+    subtree_size_[u] += old_subtree_size;
+  }
+  for (NodeIndex u = v_out_; u != join_; u = parent_[u]) {
+    subtree_size_[u] -= old_subtree_size;
+  }
+}
+
+// Only the potentials of the subtree of u_in_ change, by the same amount.
+template <typename Graph>
+void NetworkSimplex<Graph>::UpdatePotentials() {
+  const CostValue sigma = potential_[v_in_] - potential_[u_in_] -
+                          pred_direction_[u_in_] * cost_[in_arc_];
+  const NodeIndex end = thread_[last_successor_[u_in_]];
+  for (NodeIndex u = u_in_; u != end; u = thread_[u]) {
+    potential_[u] += sigma;
+  }
+}
+
+template <typename Graph>
+bool NetworkSimplex<Graph>::CheckResult() const {
+  bool ok = true;
+  std::vector<FlowQuantity> excess(supply_);
+  for (ArcIndex arc = 0; arc < num_arcs_; ++arc) {
+    const FlowQuantity flow = flow_[arc];
+    if (flow < 0 || flow > capacity_[arc]) {
+      LOG(DFATAL) << "Flow(" << arc << ") = " << flow << " is not in [0, "
+                  << capacity_[arc] << "]";
+      ok = false;
+    }
+    const CostValue reduced_cost = ReducedCost(arc);
+    if ((reduced_cost > 0 && flow != 0) ||
+        (reduced_cost < 0 && flow != capacity_[arc])) {
+      LOG(DFATAL) << "Arc " << arc << " with reduced cost " << reduced_cost
+                  << " has a flow of " << flow << " and a capacity of "
+                  << capacity_[arc];
+      ok = false;
+    }
+    excess[tail_[arc]] -= flow;
+    excess[head_[arc]] += flow;
+  }
+  for (NodeIndex node = 0; node < num_nodes_; ++node) {
+    if (excess[node] != 0) {
+      LOG(DFATAL) << "The flow is not conserved at node " << node
+                  << ", excess = " << excess[node];
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+// Explicit instantiations that can be used by a client.
+template class NetworkSimplex<StaticGraph<> >;
+template class NetworkSimplex<ReverseArcListGraph<> >;
+template class NetworkSimplex<ReverseArcStaticGraph<> >;
+template class NetworkSimplex<ReverseArcMixedGraph<> >;
+
+}  // namespace operations_research
@@ -0,0 +1,256 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A primal network simplex algorithm for the min-cost flow problem, on the
+// graph classes of graph.h. See min_cost_flow.h for the definitions (supply,
+// flow, unit cost, ...); the problem solved is the same as the one solved by
+// GenericMinCostFlow, with the additional restriction that the supplies must
+// be balanced.
+//
+// The algorithm maintains a spanning tree basis of the network: the flow on
+// each non-tree arc is either zero (the arc is at its lower bound) or equal to
+// its capacity (upper bound), and the tree arcs carry the flow that satisfies
+// the supplies. The node potentials are the dual values of the basis, i.e.
+// the reduced cost
+//    c_p(v,w) = c(v,w) + p(v) - p(w)
+// is zero on all the tree arcs. Each iteration (pivot):
+// - finds an entering non-tree arc whose reduced cost shows that changing its
+//   flow decreases the total cost,
+// - pushes as much flow as possible around the cycle formed by this arc and
+//   the tree, which saturates or empties a leaving arc,
+// - replaces the leaving arc by the entering one in the tree, and updates the
+//   potentials of the subtree that moved.
+// The basis is optimal when no non-tree arc can enter.
+//
+// The initial basis is an artificial tree: a root node connected to all the
+// nodes by artificial arcs with a large cost, that carry the supplies. It is
+// kept "strongly feasible" (a positive amount of flow can be sent from any
+// node to the root along the tree), which prevents cycling in degenerate
+// pivots.
+//
+// The tree is stored with the parent, thread (preorder successor) and
+// subtree size of each node, so that finding the cycle, updating the tree
+// and updating the potentials of a subtree only touch the nodes involved.
+//
+// The entering arc is chosen by block search: the arcs are scanned in blocks
+// of about sqrt(num_arcs), starting after the last entering arc, and the arc
+// with the most negative reduced cost in the first block that contains a
+// candidate enters the basis. This is much faster than scanning all the arcs,
+// and is the pivot rule recommended by the references below.
+//
+// Compared to the cost-scaling algorithm of GenericMinCostFlow, the network
+// simplex is often several times faster on problems with small costs and few
+// supply nodes (e.g. transportation problems), and it can be warm-started:
+// after some SetArcUnitCost(), SetArcCapacity() or SetNodeSupply() calls,
+// Solve() starts from the basis of the previous solve. If this basis is no
+// longer strongly feasible, the states (lower or upper bound) of the non-tree
+// arcs are kept and a new artificial tree is built.
+//
+// References:
+// - R. K. Ahuja, T. L. Magnanti, J. B. Orlin, "Network Flows: Theory,
+//   Algorithms, and Applications," Prentice Hall, 1993, chapter 11.
+// - W. H. Cunningham, "A Network Simplex Method," Mathematical Programming,
+//   (1976) 11:105-116.
+// - P. Kovacs, "Minimum-cost flow algorithms: an experimental evaluation,"
+//   Optimization Methods and Software, (2015) 30:94-127.
+//
+// Example usage:
+//   ReverseArcStaticGraph<> graph(num_nodes, num_arcs);
+//   ... add the arcs, call graph.Build(&permutation) ...
+//   NetworkSimplex<ReverseArcStaticGraph<> > network_simplex(&graph);
+//   for (...) network_simplex.SetArcCapacity(arc, capacity);
+//   for (...) network_simplex.SetArcUnitCost(arc, unit_cost);
+//   for (...) network_simplex.SetNodeSupply(node, supply);
+//   if (network_simplex.Solve()) {
+//     ... use network_simplex.GetOptimalCost() and network_simplex.Flow(arc).
+//   }
+//
+// See the end of network_simplex.cc for the graph types this class is compiled
+// for. SimpleMinCostFlow can also use this algorithm, see
+// SimpleMinCostFlow::SetAlgorithm().
+
+#ifndef OR_TOOLS_GRAPH_NETWORK_SIMPLEX_H_
+#define OR_TOOLS_GRAPH_NETWORK_SIMPLEX_H_
+
+#include <vector>
+
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "graph/ebert_graph.h"
+#include "graph/graph.h"
+#include "graph/min_cost_flow.h"
+
+namespace operations_research {
+
+template <typename Graph>
+class NetworkSimplex : public MinCostFlowBase {
+ public:
+  typedef typename Graph::NodeIndex NodeIndex;
+  typedef typename Graph::ArcIndex ArcIndex;
+
+  // The graph must be fully built and must not change while this object is
+  // in use. All the capacities, costs and supplies are initially zero.
+  explicit NetworkSimplex(const Graph* graph);
+
+  const Graph* graph() const { return graph_; }
+
+  // Returns the status of the last call to Solve(). NOT_SOLVED is returned if
+  // Solve() has never been called or if the problem was modified since.
+  Status status() const { return status_; }
+
+  // Sets the supply of node. A demand is modeled as a negative supply.
+  void SetNodeSupply(NodeIndex node, FlowQuantity supply);
+
+  // Sets the unit cost of a direct arc.
+  void SetArcUnitCost(ArcIndex arc, CostValue unit_cost);
+
+  // Sets the capacity of a direct arc. It must be non-negative.
+  void SetArcCapacity(ArcIndex arc, FlowQuantity capacity);
+
+  // Sets the number of arcs scanned per block by the pivot rule. The default,
+  // 0, uses max(10, sqrt(num_arcs)).
+  void SetPivotBlockSize(ArcIndex block_size) { block_size_ = block_size; }
+
+  // Solves the problem, starting from the basis of the previous Solve() if
+  // any. Returns true if an optimal flow was found. Otherwise, status() is:
+  // - UNBALANCED if the sum of the supplies is not zero,
+  // - INFEASIBLE if the supplies cannot be routed within the capacities,
+  // - BAD_COST_RANGE if the costs are too large for the artificial arcs,
+  // - BAD_RESULT if the final checks failed (this is a bug).
+  bool Solve();
+
+  // Returns the cost of the flow found by the last successful Solve().
+  CostValue GetOptimalCost() const { return total_flow_cost_; }
+
+  // Returns the flow on a direct arc.
+  FlowQuantity Flow(ArcIndex arc) const { return flow_[arc]; }
+
+  // Returns the user given data.
+  FlowQuantity Capacity(ArcIndex arc) const { return capacity_[arc]; }
+  CostValue UnitCost(ArcIndex arc) const { return cost_[arc]; }
+  FlowQuantity Supply(NodeIndex node) const { return supply_[node]; }
+
+  // Returns the potential (dual value) of node in the optimal basis: the
+  // reduced costs c(v,w) + Potential(v) - Potential(w) are non-negative on
+  // the arcs with a zero flow, non-positive on the saturated arcs, and zero on
+  // the arcs with a flow strictly between 0 and their capacity.
+  CostValue Potential(NodeIndex node) const { return potential_[node]; }
+
+  // Returns the number of pivots of the last Solve(), and whether it started
+  // from the previous basis.
+  int64 num_pivots() const { return num_pivots_; }
+  bool was_warm_started() const { return was_warm_started_; }
+
+ private:
+  // The state of an arc. The values are chosen so that state * reduced cost
+  // is negative for the arcs that can enter the basis.
+  enum ArcState { STATE_UPPER = -1, STATE_TREE = 0, STATE_LOWER = 1 };
+
+  // The direction of the arc from a node to its parent: UP if the node is the
+  // tail of the arc, DOWN if it is its head.
+  enum Direction { DIRECTION_UP = 1, DIRECTION_DOWN = -1 };
+
+  // Returns the reduced cost of an arc for the current potentials.
+  CostValue ReducedCost(ArcIndex arc) const {
+    return cost_[arc] + potential_[tail_[arc]] - potential_[head_[arc]];
+  }
+
+  // Computes the cost of the artificial arcs, or returns false if the costs
+  // are too large.
+  bool ComputeArtificialCost();
+
+  // Recomputes the flows of the tree arcs of the previous basis for the
+  // current capacities and supplies. Returns false if the basis is not
+  // strongly feasible anymore.
+  bool InitializeFromPreviousBasis();
+
+  // Builds the artificial tree, keeping the states of the non-tree arcs.
+  void InitializeArtificialBasis();
+
+  // Computes the potentials from the tree, in thread order.
+  void ComputePotentials();
+
+  // The steps of a pivot, see the .cc for the details.
+  bool FindEnteringArc();
+  void FindJoinNode();
+  bool FindLeavingArc();
+  void ChangeFlow(bool change_tree);
+  void UpdateTreeStructure();
+  void UpdatePotentials();
+
+  // Checks the flow conservation, the capacities and the optimality of the
+  // reduced costs.
+  bool CheckResult() const;
+
+  const Graph* const graph_;
+  const NodeIndex num_nodes_;
+  const ArcIndex num_arcs_;
+  Status status_;
+
+  // The artificial root is num_nodes_, and the artificial arc of node is
+  // num_arcs_ + node. The arrays below are indexed accordingly.
+  const NodeIndex root_;
+  CostValue artificial_cost_;
+
+  // Per arc data.
+  std::vector<NodeIndex> tail_;
+  std::vector<NodeIndex> head_;
+  std::vector<FlowQuantity> capacity_;
+  std::vector<CostValue> cost_;
+  std::vector<FlowQuantity> flow_;
+  std::vector<int8> state_;
+
+  // Per node data. The tree is represented by the parent of each node, the arc
+  // to its parent (pred_arc_) and its direction, the preorder traversal of the
+  // tree as a circular list (thread_ and rev_thread_), the size of the subtree
+  // of each node, and the last node of this subtree in preorder.
+  std::vector<FlowQuantity> supply_;
+  std::vector<CostValue> potential_;
+  std::vector<NodeIndex> parent_;
+  std::vector<ArcIndex> pred_arc_;
+  std::vector<int8> pred_direction_;
+  std::vector<NodeIndex> thread_;
+  std::vector<NodeIndex> rev_thread_;
+  std::vector<NodeIndex> subtree_size_;
+  std::vector<NodeIndex> last_successor_;
+  std::vector<NodeIndex> dirty_rev_threads_;
+  bool has_basis_;
+
+  // The pivot rule state: the user given block size, the one used by the
+  // current Solve(), and the arc where the next block search starts.
+  ArcIndex block_size_;
+  ArcIndex pivot_block_size_;
+  ArcIndex next_arc_;
+
+  // The current pivot: the entering arc, the join node of the cycle, the
+  // amount of flow pushed, and the tree arc from u_out_ to its parent v_out_
+  // that leaves the basis, replaced by the arc between u_in_ and v_in_.
+  ArcIndex in_arc_;
+  NodeIndex join_;
+  FlowQuantity delta_;
+  NodeIndex u_in_;
+  NodeIndex v_in_;
+  NodeIndex u_out_;
+  NodeIndex v_out_;
+
+  CostValue total_flow_cost_;
+  int64 num_pivots_;
+  bool was_warm_started_;
+
+  DISALLOW_COPY_AND_ASSIGN(NetworkSimplex);
+};
+
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_GRAPH_NETWORK_SIMPLEX_H_
@@ -0,0 +1,273 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// The Held-Karp lower bound of a symmetric traveling salesman problem,
+// computed by subgradient optimization over 1-trees.
+//
+// A 1-tree of the complete graph on the nodes [0, n) is a spanning tree of the
+// nodes [1, n) plus two edges from node 0. Every tour is a 1-tree, so the cost
+// of a minimum 1-tree is a lower bound of the cost of the tours. Adding a
+// penalty pi[i] to the cost of all the edges of each node i adds 2 * sum(pi)
+// to the cost of every tour, but changes the minimum 1-tree, so
+//   w(pi) = cost of the minimum 1-tree with the penalties - 2 * sum(pi)
+// is a lower bound for all pi. The bound of Held and Karp is the maximum of
+// w(pi), which is usually within 1% of the optimum on random and geometric
+// instances. When the minimum 1-tree is a tour, i.e. when all the nodes have
+// degree 2, it is an optimal tour and the bound is its cost.
+//
+// w is maximized with the subgradient method: the nodes of degree d != 2 in
+// the minimum 1-tree get their penalty changed by t * (d - 2), with the step t
+// of Volgenant and Jonker, which decreases to 0 over a fixed number of
+// iterations. Each iteration computes a minimum spanning tree of the complete
+// graph, in O(n^2) time, with several threads on large graphs (see
+// BuildDenseMinimumSpanningTree() in minimum_spanning_tree.h).
+//
+// Together with the cost of a tour found by a heuristic (e.g. the routing
+// library) or, on small instances, by HamiltonianPathSolver, the bound gives a
+// guarantee on the quality of the tour. The penalties can be kept from one
+// computation to the next, e.g. to compute the bounds of similar instances
+// quickly.
+//
+// References:
+// - M. Held, R. M. Karp, "The traveling-salesman problem and minimum spanning
+//   trees", Operations Research 18 (6): 1138-1162, 1970.
+// - M. Held, R. M. Karp, "The traveling-salesman problem and minimum spanning
+//   trees: Part II", Mathematical Programming 1: 6-25, 1971.
+// - T. Volgenant, R. Jonker, "A branch and bound algorithm for the symmetric
+//   traveling salesman problem based on the 1-tree relaxation", European
+//   Journal of Operational Research 9 (1): 83-89, 1982.
+//
+// Example usage, with the costs in a std::vector<std::vector<int64> > costs:
+//   const double bound = ComputeOneTreeLowerBound(
+//       num_nodes, MakeMatrixCostFunction(costs), /*num_threads=*/4);
+//   LOG(INFO) << "Gap: " << 100.0 * (tour_cost - bound) / bound << "%";
+//
+// Keywords: traveling salesman, TSP, lower bound, Held-Karp, 1-tree,
+// subgradient.
+
+#ifndef OR_TOOLS_GRAPH_ONE_TREE_LOWER_BOUND_H_
+#define OR_TOOLS_GRAPH_ONE_TREE_LOWER_BOUND_H_
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/macros.h"
+#include "graph/minimum_spanning_tree.h"
+
+namespace operations_research {
+
+// CostFunction is a functor where cost(i, j) is the cost of the edge {i, j},
+// see MatrixCostFunction in minimum_spanning_tree.h. It must be symmetric, and
+// cost(i, i) is never called. It is copied, so it should be cheap to copy.
+template <typename CostFunction>
+class OneTreeLowerBound {
+ public:
+  OneTreeLowerBound(int num_nodes, const CostFunction& cost);
+
+  // Sets the number of subgradient iterations of Compute(). The default, 0,
+  // means 28 * num_nodes^0.62 iterations, as suggested by Volgenant and
+  // Jonker.
+  void set_max_iterations(int max_iterations) {
+    CHECK_GE(max_iterations, 0);
+    max_iterations_ = max_iterations;
+  }
+
+  // Sets the number of threads used for the minimum spanning trees, including
+  // the calling thread. Defaults to 1.
+  void set_num_threads(int num_threads) {
+    CHECK_GE(num_threads, 1);
+    num_threads_ = num_threads;
+  }
+
+  // Sets the penalties that Compute() starts from. They are initially zero.
+  void SetPenalties(const std::vector<double>& penalties) {
+    CHECK_EQ(num_nodes_, penalties.size());
+    penalties_ = penalties;
+  }
+
+  // Runs the subgradient optimization from the current penalties and returns
+  // the best lower bound found. The penalties of this bound become the current
+  // penalties.
+  double Compute();
+
+  // Returns the penalties of the best bound found by the last Compute().
+  const std::vector<double>& penalties() const { return penalties_; }
+
+  // Returns true if the last Compute() found a 1-tree that is a tour. The
+  // bound is then the cost of an optimal tour.
+  bool found_tour() const { return found_tour_; }
+
+  // Returns the number of minimum 1-trees computed by the last Compute().
+  int num_iterations() const { return num_iterations_; }
+
+ private:
+  // The cost function of the minimum spanning trees on the nodes [1, n), with
+  // the penalties. The node i of the tree is the node i + 1 of the problem.
+  class PenalizedCost {
+   public:
+    PenalizedCost(const CostFunction& cost, const std::vector<double>& penalty)
+        : cost_(cost), penalty_(penalty) {}
+    double operator()(int i, int j) const {
+      return cost_(i + 1, j + 1) + penalty_[i + 1] + penalty_[j + 1];
+    }
+
+   private:
+    const CostFunction& cost_;
+    const std::vector<double>& penalty_;
+  };
+
+  // Computes a minimum 1-tree with the given penalties, fills degree_ with the
+  // degrees of its nodes, and returns w(penalty).
+  double ComputeOneTree(const std::vector<double>& penalty);
+
+  const int num_nodes_;
+  const CostFunction cost_;
+  int max_iterations_;
+  int num_threads_;
+  std::vector<double> penalties_;
+  bool found_tour_;
+  int num_iterations_;
+
+  // The minimum spanning tree of the last 1-tree and the degrees of its nodes.
+  std::vector<int> parent_;
+  std::vector<int> degree_;
+
+  DISALLOW_COPY_AND_ASSIGN(OneTreeLowerBound);
+};
+
+// Simple wrapper function for most usage.
+template <typename CostFunction>
+double ComputeOneTreeLowerBound(int num_nodes, const CostFunction& cost,
+                                int num_threads = 1) {
+  OneTreeLowerBound<CostFunction> bound(num_nodes, cost);
+  bound.set_num_threads(num_threads);
+  return bound.Compute();
+}
+
+template <typename CostFunction>
+OneTreeLowerBound<CostFunction>::OneTreeLowerBound(int num_nodes,
+                                                   const CostFunction& cost)
+    : num_nodes_(num_nodes),
+      cost_(cost),
+      max_iterations_(0),
+      num_threads_(1),
+      penalties_(num_nodes, 0.0),
+      found_tour_(false),
+      num_iterations_(0) {
+  CHECK_GE(num_nodes, 0);
+}
+
+template <typename CostFunction>
+double OneTreeLowerBound<CostFunction>::ComputeOneTree(
+    const std::vector<double>& penalty) {
+  const PenalizedCost penalized_cost(cost_, penalty);
+  double one_tree_cost = BuildDenseMinimumSpanningTree(
+      num_nodes_ - 1, penalized_cost, num_threads_, &parent_);
+  degree_.assign(num_nodes_, 0);
+  for (int node = 1; node < num_nodes_ - 1; ++node) {
+    ++degree_[node + 1];
+    ++degree_[parent_[node] + 1];
+  }
+  // The two cheapest edges of node 0.
+  int first = -1;
+  int second = -1;
+  double first_cost = std::numeric_limits<double>::infinity();
+  double second_cost = std::numeric_limits<double>::infinity();
+  for (int node = 1; node < num_nodes_; ++node) {
+    const double cost = cost_(0, node) + penalty[node];
+    if (first == -1 || cost < first_cost) {
+      second = first;
+      second_cost = first_cost;
+      first = node;
+      first_cost = cost;
+    } else if (second == -1 || cost < second_cost) {
+      second = node;
+      second_cost = cost;
+    }
+  }
+  degree_[0] = 2;
+  ++degree_[first];
+  ++degree_[second];
+  one_tree_cost += first_cost + second_cost + 2 * penalty[0];
+  double penalty_sum = 0.0;
+  for (int node = 0; node < num_nodes_; ++node) penalty_sum += penalty[node];
+  return one_tree_cost - 2 * penalty_sum;
+}
+
+template <typename CostFunction>
+double OneTreeLowerBound<CostFunction>::Compute() {
+  found_tour_ = false;
+  num_iterations_ = 0;
+  if (num_nodes_ <= 2) {
+    // There is only one tour.
+    found_tour_ = true;
+    return num_nodes_ == 2 ? cost_(0, 1) + cost_(1, 0) : 0.0;
+  }
+  // The step formula needs at least 3 iterations.
+  const int max_iterations =
+      std::max(3, max_iterations_ > 0
+                      ? max_iterations_
+                      : static_cast<int>(28 * std::pow(num_nodes_, 0.62)));
+  std::vector<double> penalty = penalties_;
+  std::vector<int> previous_subgradient(num_nodes_, 0);
+  double best_bound = -std::numeric_limits<double>::infinity();
+  double initial_step = 0.0;
+  const double m = max_iterations;
+  for (int iteration = 1; iteration <= max_iterations; ++iteration) {
+    ++num_iterations_;
+    const double bound = ComputeOneTree(penalty);
+    if (bound > best_bound) {
+      best_bound = bound;
+      penalties_ = penalty;
+      // As in Volgenant and Jonker, the first step is proportional to the
+      // average cost of an edge of the best 1-tree. The factor 0.1 gave the
+      // best bounds on random and Euclidean instances of 5 to 500 nodes.
+      double one_tree_cost = bound;
+      for (int node = 0; node < num_nodes_; ++node) {
+        one_tree_cost += 2 * penalty[node];
+      }
+      initial_step = 0.1 * std::abs(one_tree_cost) / num_nodes_;
+    }
+    bool is_tour = true;
+    for (int node = 0; node < num_nodes_; ++node) {
+      if (degree_[node] != 2) {
+        is_tour = false;
+        break;
+      }
+    }
+    if (is_tour) {
+      found_tour_ = true;
+      break;
+    }
+    // The step decreases from initial_step to 0, with a decreasing slope.
+    const double k = iteration;
+    const double step =
+        initial_step *
+        ((k - 1) * (2 * m - 5) / (2 * (m - 1)) - (k - 2) +
+         (k - 1) * (k - 2) / (2 * (m - 1) * (m - 2)));
+    for (int node = 0; node < num_nodes_; ++node) {
+      const int subgradient = degree_[node] - 2;
+      penalty[node] +=
+          step * (0.6 * subgradient + 0.4 * previous_subgradient[node]);
+      previous_subgradient[node] = subgradient;
+    }
+  }
+  return best_bound;
+}
+
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_GRAPH_ONE_TREE_LOWER_BOUND_H_
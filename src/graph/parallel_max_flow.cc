@@ -0,0 +1,464 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "graph/parallel_max_flow.h"
+
+#include <algorithm>
+#include <limits>
+#include <thread>  // NOLINT
+
+namespace operations_research {
+
+namespace {
+// Number of consecutive active nodes a thread takes at once.
+const int kChunkSize = 64;
+
+// A round is run by all the threads only if there are at least this number of
+// active nodes per thread.
+const int kMinActiveNodesPerThread = 256;
+
+// Work accounted for each relabel on top of the scanned arcs, as in the
+// reference paper.
+const int64 kRelabelWork = 12;
+}  // namespace
+
+template <typename Graph>
+ParallelMaxFlow<Graph>::ParallelMaxFlow(const Graph* graph, NodeIndex source,
+                                        NodeIndex sink)
+    : graph_(graph),
+      source_(source),
+      sink_(sink),
+      num_threads_(1),
+      global_update_frequency_(0.5),
+      status_(NOT_SOLVED),
+      residual_arc_capacity_(),
+      num_active_(0),
+      num_next_active_(0),
+      round_(0),
+      root_(sink),
+      excluded_(source),
+      command_(STOP),
+      num_workers_(1),
+      next_push_chunk_(0),
+      next_relabel_chunk_(0),
+      num_rounds_(0),
+      num_global_updates_(0) {
+  DCHECK(graph->IsNodeValid(source));
+  DCHECK(graph->IsNodeValid(sink));
+  const NodeIndex num_nodes = graph_->num_nodes();
+  const ArcIndex num_arcs = graph_->num_arcs();
+  if (num_arcs > 0) {
+    residual_arc_capacity_.Reserve(-num_arcs, num_arcs - 1);
+    residual_arc_capacity_.SetAll(0);
+  }
+  node_excess_.reset(new std::atomic<FlowQuantity>[num_nodes]);
+  node_height_.reset(new std::atomic<NodeIndex>[num_nodes]);
+  node_round_.reset(new std::atomic<int>[num_nodes]);
+  for (NodeIndex node = 0; node < num_nodes; ++node) {
+    node_excess_[node] = 0;
+    node_height_[node] = 0;
+    node_round_[node] = -1;
+  }
+  active_nodes_.resize(num_nodes);
+  next_active_nodes_.resize(num_nodes);
+  bfs_queue_[0].resize(num_nodes);
+  bfs_queue_[1].resize(num_nodes);
+}
+
+template <typename Graph>
+void ParallelMaxFlow<Graph>::SetArcCapacity(ArcIndex arc,
+                                            FlowQuantity new_capacity) {
+  DCHECK_LE(0, new_capacity);
+  DCHECK(graph_->IsArcValid(arc));
+  DCHECK_GE(arc, 0);
+  residual_arc_capacity_.Set(arc, new_capacity);
+  residual_arc_capacity_.Set(Opposite(arc), 0);
+  status_ = NOT_SOLVED;
+}
+
+template <typename Graph>
+bool ParallelMaxFlow<Graph>::CheckInputConsistency() const {
+  for (ArcIndex arc = 0; arc < graph_->num_arcs(); ++arc) {
+    if (residual_arc_capacity_[arc] < 0) return false;
+  }
+  return true;
+}
+
+template <typename Graph>
+bool ParallelMaxFlow<Graph>::Solve() {
+  status_ = NOT_SOLVED;
+  if (!CheckInputConsistency()) {
+    status_ = BAD_INPUT;
+    return false;
+  }
+  num_rounds_ = 0;
+  num_global_updates_ = 0;
+  round_ = 0;
+  thread_data_.assign(num_threads_, ThreadData());
+  barrier_.reset(new ReusableBarrier(num_threads_));
+  std::vector<std::thread> threads;
+  for (int thread = 1; thread < num_threads_; ++thread) {
+    threads.push_back(std::thread(&ParallelMaxFlow::WorkerLoop, this, thread));
+  }
+  RunCommand(INITIALIZE, true);
+  if (source_ != sink_) {
+    SaturateOutgoingArcsFromSource();
+    RunPhase(sink_, source_);
+    RunPhase(source_, sink_);
+  }
+  RunCommand(STOP, true);
+  for (int i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+  barrier_.reset();
+  VLOG(1) << "ParallelMaxFlow: " << num_rounds_ << " rounds, "
+          << num_global_updates_ << " global updates.";
+
+  for (NodeIndex node = 0; node < graph_->num_nodes(); ++node) {
+    if (node != source_ && node != sink_ && node_excess_[node] != 0) {
+      LOG(DFATAL) << "node_excess_[" << node << "] = " << node_excess_[node]
+                  << " != 0";
+      status_ = BAD_RESULT;
+      return false;
+    }
+  }
+  DCHECK_EQ(node_excess_[sink_], -node_excess_[source_]);
+  status_ = OPTIMAL;
+  if (GetOptimalFlow() == std::numeric_limits<FlowQuantity>::max()) {
+    // The flow may have been capped, see SaturateOutgoingArcsFromSource().
+    std::vector<NodeIndex> reachable;
+    ComputeReachableNodes(source_, false, &reachable);
+    if (std::find(reachable.begin(), reachable.end(), sink_) !=
+        reachable.end()) {
+      status_ = INT_OVERFLOW;
+    }
+  }
+  return true;
+}
+
+template <typename Graph>
+void ParallelMaxFlow<Graph>::SaturateOutgoingArcsFromSource() {
+  // The flow out of the source is capped so that no excess can overflow.
+  const FlowQuantity kMaxFlow = std::numeric_limits<FlowQuantity>::max();
+  FlowQuantity total_flow = 0;
+  for (const ArcIndex arc : graph_->OutgoingArcs(source_)) {
+    const NodeIndex head = graph_->Head(arc);
+    if (head == source_) continue;
+    const FlowQuantity flow =
+        std::min(residual_arc_capacity_[arc], kMaxFlow - total_flow);
+    if (flow == 0) continue;
+    residual_arc_capacity_[arc] -= flow;
+    residual_arc_capacity_[Opposite(arc)] += flow;
+    node_excess_[head] += flow;
+    total_flow += flow;
+  }
+  node_excess_[source_] = -total_flow;
+}
+
+template <typename Graph>
+void ParallelMaxFlow<Graph>::RunPhase(NodeIndex root, NodeIndex excluded) {
+  root_ = root;
+  excluded_ = excluded;
+  RunCommand(GLOBAL_UPDATE, true);
+  const NodeIndex num_nodes = graph_->num_nodes();
+  num_active_ = 0;
+  for (NodeIndex node = 0; node < num_nodes; ++node) {
+    if (node != source_ && node != sink_ && node_excess_[node] > 0) {
+      active_nodes_[num_active_++] = node;
+    }
+  }
+  const double max_work =
+      global_update_frequency_ * (num_nodes + graph_->num_arcs());
+  int64 work = 0;
+  while (num_active_ > 0) {
+    if (work > max_work) {
+      RunCommand(GLOBAL_UPDATE, true);
+      work = 0;
+    }
+    ++round_;
+    RunCommand(ROUND,
+               num_active_ >= kMinActiveNodesPerThread * num_threads_);
+    for (int thread = 0; thread < num_threads_; ++thread) {
+      work += thread_data_[thread].work;
+      thread_data_[thread].work = 0;
+    }
+    active_nodes_.swap(next_active_nodes_);
+    num_active_ = num_next_active_;
+    ++num_rounds_;
+  }
+}
+
+template <typename Graph>
+void ParallelMaxFlow<Graph>::RunCommand(Command command,
+                                        bool use_all_threads) {
+  num_workers_ = use_all_threads ? num_threads_ : 1;
+  next_push_chunk_ = 0;
+  next_relabel_chunk_ = 0;
+  command_ = command;
+  // The other threads are waiting for the next command.
+  if (num_workers_ > 1) barrier_->Wait();
+  if (command == STOP) return;
+  Execute(command, 0);
+  // Waits for the other threads to finish the command.
+  if (num_workers_ > 1) barrier_->Wait();
+}
+
+template <typename Graph>
+void ParallelMaxFlow<Graph>::WorkerLoop(int thread) {
+  for (;;) {
+    barrier_->Wait();
+    if (command_ == STOP) return;
+    Execute(command_, thread);
+    barrier_->Wait();
+  }
+}
+
+template <typename Graph>
+void ParallelMaxFlow<Graph>::Execute(Command command, int thread) {
+  switch (command) {
+    case INITIALIZE:
+      Initialize(thread);
+      break;
+    case GLOBAL_UPDATE:
+      GlobalUpdate(thread);
+      break;
+    case ROUND:
+      Round(thread);
+      break;
+    case STOP:
+      break;
+  }
+}
+
+template <typename Graph>
+void ParallelMaxFlow<Graph>::Synchronize() {
+  if (num_workers_ > 1) barrier_->Wait();
+}
+
+template <typename Graph>
+void ParallelMaxFlow<Graph>::GetStaticRange(int thread, int64 size,
+                                            int64* begin, int64* end) const {
+  *begin = size * thread / num_workers_;
+  *end = size * (thread + 1) / num_workers_;
+}
+
+template <typename Graph>
+int ParallelMaxFlow<Graph>::GatherNodes(int thread,
+                                        std::vector<NodeIndex>* output) {
+  int offset = 0;
+  int total = 0;
+  for (int t = 0; t < num_workers_; ++t) {
+    const int size = thread_data_[t].nodes.size();
+    if (t < thread) offset += size;
+    total += size;
+  }
+  const std::vector<NodeIndex>& nodes = thread_data_[thread].nodes;
+  std::copy(nodes.begin(), nodes.end(), output->begin() + offset);
+  return total;
+}
+
+template <typename Graph>
+void ParallelMaxFlow<Graph>::Initialize(int thread) {
+  // Clears the flow of a previous Solve().
+  int64 begin, end;
+  GetStaticRange(thread, graph_->num_arcs(), &begin, &end);
+  for (ArcIndex arc = begin; arc < end; ++arc) {
+    const ArcIndex opposite = Opposite(arc);
+    residual_arc_capacity_[arc] += residual_arc_capacity_[opposite];
+    residual_arc_capacity_[opposite] = 0;
+  }
+  GetStaticRange(thread, graph_->num_nodes(), &begin, &end);
+  for (NodeIndex node = begin; node < end; ++node) {
+    node_excess_[node].store(0, std::memory_order_relaxed);
+    node_height_[node].store(0, std::memory_order_relaxed);
+    node_round_[node].store(-1, std::memory_order_relaxed);
+  }
+}
+
+template <typename Graph>
+void ParallelMaxFlow<Graph>::GlobalUpdate(int thread) {
+  // The nodes that cannot reach root_ keep the height num_nodes, which makes
+  // them inactive for the rest of the phase.
+  const NodeIndex num_nodes = graph_->num_nodes();
+  int64 begin, end;
+  GetStaticRange(thread, num_nodes, &begin, &end);
+  for (NodeIndex node = begin; node < end; ++node) {
+    node_height_[node].store(node == root_ ? 0 : num_nodes,
+                             std::memory_order_relaxed);
+  }
+  if (thread == 0) bfs_queue_[0][0] = root_;
+  std::vector<NodeIndex>* const next_level = &thread_data_[thread].nodes;
+  int size = 1;
+  Synchronize();
+  for (NodeIndex level = 0; size > 0; ++level) {
+    const std::vector<NodeIndex>& queue = bfs_queue_[level & 1];
+    next_level->clear();
+    GetStaticRange(thread, size, &begin, &end);
+    for (int64 i = begin; i < end; ++i) {
+      const NodeIndex node = queue[i];
+      for (const ArcIndex arc : graph_->IncidentArcs(node)) {
+        const NodeIndex head = graph_->Head(arc);
+        if (head == excluded_ || residual_arc_capacity_[Opposite(arc)] == 0) {
+          continue;
+        }
+        NodeIndex expected = num_nodes;
+        if (node_height_[head].load(std::memory_order_relaxed) == expected &&
+            node_height_[head].compare_exchange_strong(
+                expected, level + 1, std::memory_order_relaxed)) {
+          next_level->push_back(head);
+        }
+      }
+    }
+    Synchronize();
+    size = GatherNodes(thread, &bfs_queue_[(level + 1) & 1]);
+    Synchronize();
+  }
+  if (thread == 0) ++num_global_updates_;
+}
+
+template <typename Graph>
+void ParallelMaxFlow<Graph>::Round(int thread) {
+  thread_data_[thread].nodes.clear();
+  PushStep(thread);
+  Synchronize();
+  RelabelStep(thread);
+  Synchronize();
+  const int num_next_active = GatherNodes(thread, &next_active_nodes_);
+  if (thread == 0) num_next_active_ = num_next_active;
+}
+
+template <typename Graph>
+void ParallelMaxFlow<Graph>::PushStep(int thread) {
+  const NodeIndex num_nodes = graph_->num_nodes();
+  std::vector<NodeIndex>* const next_active = &thread_data_[thread].nodes;
+  for (;;) {
+    const int begin = next_push_chunk_.fetch_add(kChunkSize);
+    if (begin >= num_active_) break;
+    const int end = std::min(begin + kChunkSize, num_active_);
+    for (int i = begin; i < end; ++i) {
+      const NodeIndex node = active_nodes_[i];
+      const NodeIndex height =
+          node_height_[node].load(std::memory_order_relaxed);
+      if (height >= num_nodes) continue;
+      FlowQuantity excess = node_excess_[node].load(std::memory_order_relaxed);
+      if (excess <= 0) continue;
+      FlowQuantity total_flow = 0;
+      for (const ArcIndex arc : graph_->IncidentArcs(node)) {
+        const NodeIndex head = graph_->Head(arc);
+        // The height must be tested first: if it is not height - 1, another
+        // thread may be pushing flow on the opposite arc.
+        if (node_height_[head].load(std::memory_order_relaxed) != height - 1) {
+          continue;
+        }
+        const FlowQuantity residual = residual_arc_capacity_[arc];
+        if (residual == 0) continue;
+        const FlowQuantity flow = std::min(excess, residual);
+        residual_arc_capacity_[arc] -= flow;
+        residual_arc_capacity_[Opposite(arc)] += flow;
+        node_excess_[head].fetch_add(flow, std::memory_order_relaxed);
+        if (head != source_ && head != sink_ &&
+            node_round_[head].exchange(round_, std::memory_order_relaxed) !=
+                round_) {
+          next_active->push_back(head);
+        }
+        total_flow += flow;
+        excess -= flow;
+        if (excess == 0) break;
+      }
+      if (total_flow > 0) {
+        node_excess_[node].fetch_sub(total_flow, std::memory_order_relaxed);
+      }
+    }
+  }
+}
+
+template <typename Graph>
+void ParallelMaxFlow<Graph>::RelabelStep(int thread) {
+  const NodeIndex num_nodes = graph_->num_nodes();
+  std::vector<NodeIndex>* const next_active = &thread_data_[thread].nodes;
+  int64 work = 0;
+  for (;;) {
+    const int begin = next_relabel_chunk_.fetch_add(kChunkSize);
+    if (begin >= num_active_) break;
+    const int end = std::min(begin + kChunkSize, num_active_);
+    for (int i = begin; i < end; ++i) {
+      const NodeIndex node = active_nodes_[i];
+      const NodeIndex height =
+          node_height_[node].load(std::memory_order_relaxed);
+      if (height >= num_nodes ||
+          node_excess_[node].load(std::memory_order_relaxed) <= 0) {
+        continue;
+      }
+      // The node may still have admissible arcs if it received some excess
+      // during the push step, in which case its height does not change.
+      NodeIndex min_height = num_nodes;
+      for (const ArcIndex arc : graph_->IncidentArcs(node)) {
+        if (residual_arc_capacity_[arc] > 0) {
+          min_height = std::min(
+              min_height, node_height_[graph_->Head(arc)].load(
+                              std::memory_order_relaxed));
+        }
+        ++work;
+      }
+      work += kRelabelWork;
+      const NodeIndex new_height =
+          std::max(height, std::min<NodeIndex>(num_nodes, min_height + 1));
+      if (new_height != height) {
+        node_height_[node].store(new_height, std::memory_order_relaxed);
+      }
+      if (new_height < num_nodes &&
+          node_round_[node].exchange(round_, std::memory_order_relaxed) !=
+              round_) {
+        next_active->push_back(node);
+      }
+    }
+  }
+  thread_data_[thread].work += work;
+}
+
+template <typename Graph>
+void ParallelMaxFlow<Graph>::ComputeReachableNodes(
+    NodeIndex start, bool reverse, std::vector<NodeIndex>* result) const {
+  const NodeIndex num_nodes = graph_->num_nodes();
+  std::vector<bool> is_reached(num_nodes, false);
+  result->clear();
+  result->push_back(start);
+  is_reached[start] = true;
+  for (int i = 0; i < result->size(); ++i) {
+    const NodeIndex node = (*result)[i];
+    for (const ArcIndex arc : graph_->IncidentArcs(node)) {
+      const NodeIndex head = graph_->Head(arc);
+      if (is_reached[head]) continue;
+      if (residual_arc_capacity_[reverse ? Opposite(arc) : arc] > 0) {
+        is_reached[head] = true;
+        result->push_back(head);
+      }
+    }
+  }
+}
+
+template <typename Graph>
+void ParallelMaxFlow<Graph>::GetSourceSideMinCut(
+    std::vector<NodeIndex>* result) {
+  ComputeReachableNodes(source_, false, result);
+}
+
+template <typename Graph>
+void ParallelMaxFlow<Graph>::GetSinkSideMinCut(std::vector<NodeIndex>* result) {
+  ComputeReachableNodes(sink_, true, result);
+}
+
+// Explicit instantiations that can be used by a client.
+template class ParallelMaxFlow<ReverseArcStaticGraph<> >;
+
+}  // namespace operations_research
@@ -0,0 +1,236 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A multi-threaded push-relabel algorithm for the max flow problem, meant for
+// the very large graphs (10^7 nodes, 10^8 arcs) where the sequential
+// GenericMaxFlow of ./max_flow.h is too slow. See max_flow.h for the
+// definitions (preflow, excess, height, admissible arc, ...).
+//
+// The algorithm is the synchronous variant described in:
+// N. Baumstark, G. Blelloch and J. Shun, "Efficient Implementation of a
+// Synchronous Parallel Push-Relabel Algorithm", ESA 2015, LNCS 9294:106-117.
+// http://arxiv.org/abs/1507.01926
+//
+// It works by rounds. In each round, all the active nodes are processed in
+// parallel:
+// - During the push step, each active node pushes its excess along its
+//   admissible arcs. The heights do not change during this step, and an arc
+//   (v, w) and its opposite cannot both be admissible, so each residual
+//   capacity is written by at most one thread. The excesses are the only
+//   shared counters and are updated atomically.
+// - During the relabel step, each node that still has some excess is relabeled
+//   to 1 + the minimum height of its residual neighbors (or kept at its height
+//   if this is larger). Since heights only increase, reading the height of a
+//   neighbor that is being relabeled concurrently keeps the labeling valid.
+// The active nodes of the next round are collected in per-thread lists.
+//
+// The heights are periodically recomputed exactly by a global update, which is
+// a level-synchronous parallel breadth-first search in the residual graph.
+// Like GenericMaxFlow, the algorithm has two phases: the first one computes a
+// maximum preflow (and thus a minimum cut), the second one returns the
+// remaining excesses to the source to get a flow.
+//
+// The rounds with few active nodes (typically at the end of each phase) are
+// run by the calling thread alone, to avoid paying for the synchronization of
+// all the threads.
+//
+// Example usage:
+//   ReverseArcStaticGraph<> graph(num_nodes, num_arcs);
+//   ... add the arcs, call graph.Build(&permutation) ...
+//   ParallelMaxFlow<ReverseArcStaticGraph<> > max_flow(&graph, source, sink);
+//   for (...) max_flow.SetArcCapacity(arc, capacity);
+//   max_flow.set_num_threads(8);
+//   if (max_flow.Solve() && max_flow.status() == ParallelMaxFlow<...>::OPTIMAL)
+//     ... use max_flow.GetOptimalFlow() and max_flow.Flow(arc) ...
+//
+// See the end of parallel_max_flow.cc for the graph types this class is
+// compiled for.
+
+#ifndef OR_TOOLS_GRAPH_PARALLEL_MAX_FLOW_H_
+#define OR_TOOLS_GRAPH_PARALLEL_MAX_FLOW_H_
+
+#include <atomic>
+#include "base/unique_ptr.h"
+#include <vector>
+
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/synchronization.h"
+#include "graph/ebert_graph.h"
+#include "graph/graph.h"
+#include "graph/max_flow.h"
+#include "util/zvector.h"
+
+namespace operations_research {
+
+template <typename Graph>
+class ParallelMaxFlow : public MaxFlowStatusClass {
+ public:
+  typedef typename Graph::NodeIndex NodeIndex;
+  typedef typename Graph::ArcIndex ArcIndex;
+
+  // The graph must be fully built and must not change while this object is
+  // in use. source and sink must be valid nodes of the graph.
+  ParallelMaxFlow(const Graph* graph, NodeIndex source, NodeIndex sink);
+
+  const Graph* graph() const { return graph_; }
+
+  // Returns the status of the last call to Solve(). NOT_SOLVED is returned if
+  // Solve() has never been called or if the capacities were modified since.
+  Status status() const { return status_; }
+
+  NodeIndex GetSourceNodeIndex() const { return source_; }
+  NodeIndex GetSinkNodeIndex() const { return sink_; }
+
+  // Sets the number of threads used by Solve(), including the calling thread.
+  // Defaults to 1.
+  void set_num_threads(int num_threads) {
+    CHECK_GE(num_threads, 1);
+    num_threads_ = num_threads;
+  }
+
+  // A global update is done each time the relabel steps have scanned more than
+  // frequency * (num_nodes + num_arcs) arcs since the last one. Defaults to
+  // 0.5, smaller values trade more global updates for fewer rounds.
+  void set_global_update_frequency(double frequency) {
+    global_update_frequency_ = frequency;
+  }
+
+  // Sets the capacity of a direct arc. This resets the flow on this arc.
+  void SetArcCapacity(ArcIndex arc, FlowQuantity new_capacity);
+
+  // Computes a maximum flow. Returns false if the input was invalid or if the
+  // result failed the final checks, see status().
+  bool Solve();
+
+  // Returns the total flow found by the algorithm.
+  FlowQuantity GetOptimalFlow() const { return node_excess_[sink_]; }
+
+  // Returns the flow on arc; the flow on a reverse arc is the opposite of the
+  // flow on its direct arc.
+  FlowQuantity Flow(ArcIndex arc) const {
+    if (arc >= 0) return residual_arc_capacity_[Opposite(arc)];
+    return -residual_arc_capacity_[arc];
+  }
+
+  // Returns the capacity of arc, 0 for a reverse arc.
+  FlowQuantity Capacity(ArcIndex arc) const {
+    if (arc < 0) return 0;
+    return residual_arc_capacity_[arc] + residual_arc_capacity_[Opposite(arc)];
+  }
+
+  // Same as the GenericMaxFlow functions with the same names.
+  void GetSourceSideMinCut(std::vector<NodeIndex>* result);
+  void GetSinkSideMinCut(std::vector<NodeIndex>* result);
+
+  // Returns the number of rounds and global updates of the last Solve().
+  int64 num_rounds() const { return num_rounds_; }
+  int64 num_global_updates() const { return num_global_updates_; }
+
+ private:
+  // The unit of work given to all the threads by the calling thread.
+  enum Command { INITIALIZE, GLOBAL_UPDATE, ROUND, STOP };
+
+  // Data owned by each thread. It is padded to avoid false sharing between
+  // the threads.
+  struct ThreadData {
+    ThreadData() : work(0) {}
+    std::vector<NodeIndex> nodes;
+    int64 work;
+    char padding[64];
+  };
+
+  ArcIndex Opposite(ArcIndex arc) const { return graph_->OppositeArc(arc); }
+
+  // Functions run by the calling thread.
+  bool CheckInputConsistency() const;
+  void RunCommand(Command command, bool use_all_threads);
+  void SaturateOutgoingArcsFromSource();
+  void RunPhase(NodeIndex root, NodeIndex excluded);
+  void ComputeReachableNodes(NodeIndex start, bool reverse,
+                             std::vector<NodeIndex>* result) const;
+
+  // Functions run by all the threads taking part in a command.
+  void WorkerLoop(int thread);
+  void Execute(Command command, int thread);
+  void Synchronize();
+  void Initialize(int thread);
+  void GlobalUpdate(int thread);
+  void Round(int thread);
+  void PushStep(int thread);
+  void RelabelStep(int thread);
+
+  // Copies the nodes collected by each thread to output, and returns their
+  // total number. Must be called by all the threads after a Synchronize().
+  int GatherNodes(int thread, std::vector<NodeIndex>* output);
+
+  // Returns the range [*begin, *end) of [0, size) statically assigned to
+  // thread.
+  void GetStaticRange(int thread, int64 size, int64* begin, int64* end) const;
+
+  const Graph* const graph_;
+  const NodeIndex source_;
+  const NodeIndex sink_;
+  int num_threads_;
+  double global_update_frequency_;
+  Status status_;
+
+  // Same semantic as in GenericMaxFlow: residual_arc_capacity_[arc] is the
+  // capacity minus the flow of a direct arc, and the flow on its opposite for
+  // a reverse arc.
+  ZVector<FlowQuantity> residual_arc_capacity_;
+
+  // The per node state, shared by all the threads.
+  std::unique_ptr<std::atomic<FlowQuantity>[]> node_excess_;
+  std::unique_ptr<std::atomic<NodeIndex>[]> node_height_;
+  // The last round in which a node was added to the active nodes of the next
+  // round, this avoids duplicates.
+  std::unique_ptr<std::atomic<int>[]> node_round_;
+
+  // The active nodes of the current round are active_nodes_[0, num_active_).
+  // The lists are allocated once with num_nodes elements.
+  std::vector<NodeIndex> active_nodes_;
+  std::vector<NodeIndex> next_active_nodes_;
+  int num_active_;
+  int num_next_active_;
+  int round_;
+
+  // Current phase: the heights are the distances to root_ in the residual
+  // graph, and excluded_ is never a valid push target.
+  NodeIndex root_;
+  NodeIndex excluded_;
+
+  // Synchronization between the threads. The other threads wait on barrier_
+  // for the next command, and the commands themselves use it between their
+  // steps when more than one thread takes part in them.
+  Command command_;
+  int num_workers_;
+  std::unique_ptr<ReusableBarrier> barrier_;
+  // The next chunk of active nodes to process in the push and relabel steps.
+  std::atomic<int> next_push_chunk_;
+  std::atomic<int> next_relabel_chunk_;
+  std::vector<ThreadData> thread_data_;
+
+  // The breadth-first search queues of the global update, by level parity.
+  std::vector<NodeIndex> bfs_queue_[2];
+
+  int64 num_rounds_;
+  int64 num_global_updates_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelMaxFlow);
+};
+
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_GRAPH_PARALLEL_MAX_FLOW_H_
@@ -0,0 +1,476 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Shortest path searches on the graph classes of ./graph.h, with the arc
+// lengths stored in an array indexed by arc, as is usual for these graphs.
+//
+// Unlike the functions of ./shortestpaths.h, which probe a distance callback
+// for every pair of nodes and are thus O(num_nodes^2), these searches only look
+// at the arcs that are actually present and run in
+// O((num_arcs + num_nodes) * log(num_nodes)) in the worst case. They only touch
+// the part of the graph they explore.
+//
+// Provided classes:
+//   - DijkstraSearch<>: one-to-all, bounded, point-to-point and A* searches.
+//   - BidirectionalDijkstra<>: point-to-point search growing two balls, one
+//     from the source on the forward graph and one from the target on the
+//     reverse graph.
+//
+// All the searches keep their state in the object itself, which thus acts as a
+// reusable workspace: once the vectors have been allocated by the first search,
+// the following searches do not allocate memory, and their setup cost is
+// proportional to the number of nodes touched by the previous search, not to
+// the size of the graph. The objects are not thread-safe, but several of them
+// can share the same const graph and arc lengths, so the usual pattern for
+// running many queries in parallel is to create one search object per thread.
+//
+// Example:
+//   typedef StaticGraph<> Graph;
+//   Graph graph;
+//   std::vector<int64> lengths;
+//   ... fill the graph and the lengths, Build() and Permute() ...
+//   DijkstraSearch<Graph> search(&graph, &lengths);
+//   for (...) {
+//     const int64 distance = search.RunToTarget(source, target);
+//     if (distance != DijkstraSearch<Graph>::kInfinity) {
+//       search.NodePathTo(target, &path);
+//     }
+//   }
+//
+// Keywords: directed graph, shortest path, Dijkstra, bidirectional, A*.
+
+#ifndef OR_TOOLS_GRAPH_SHORTEST_PATH_SEARCH_H_
+#define OR_TOOLS_GRAPH_SHORTEST_PATH_SEARCH_H_
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "graph/graph.h"
+#include "util/dary_heap.h"
+
+namespace operations_research {
+
+// A heuristic that always returns zero, under which A* is simply Dijkstra.
+template <typename NodeIndex, typename DistanceType>
+struct ZeroHeuristic {
+  DistanceType operator()(NodeIndex node) const { return 0; }
+};
+
+// Dijkstra's algorithm on a graph with nonnegative arc lengths.
+//
+// The arc lengths must be given as a vector indexed by the (forward) arcs of
+// the graph. Any graph class of ./graph.h can be used, but StaticGraph<> and
+// ReverseArcStaticGraph<> are the fastest ones since their outgoing arcs are
+// stored contiguously. Neither the graph nor the lengths are owned and they
+// must outlive the search object.
+//
+// The sum of the lengths along any explored path must not overflow
+// DistanceType. This is not checked.
+template <class Graph, typename DistanceType = int64>
+class DijkstraSearch {
+ public:
+  typedef typename Graph::NodeIndex NodeIndex;
+  typedef typename Graph::ArcIndex ArcIndex;
+
+  // The distance of the nodes that were not reached by the last search.
+  static const DistanceType kInfinity;
+
+  DijkstraSearch(const Graph* graph,
+                 const std::vector<DistanceType>* arc_lengths);
+
+  // Computes the distance from the source to all the nodes whose distance is
+  // at most distance_limit. The other nodes may still have a tentative
+  // distance, see IsSettled().
+  void RunFromSource(NodeIndex source, DistanceType distance_limit);
+  void RunFromSource(NodeIndex source) { RunFromSource(source, kInfinity); }
+
+  // Computes the distance from source to target, stopping as soon as the
+  // target is settled. Returns kInfinity if target is not reachable.
+  DistanceType RunToTarget(NodeIndex source, NodeIndex target);
+
+  // Same as RunToTarget() but uses the A* algorithm: nodes are explored in
+  // increasing order of distance(source, node) + heuristic(node), where
+  // heuristic is a functor NodeIndex -> DistanceType. The heuristic must be
+  // consistent, i.e. heuristic(tail) <= length(arc) + heuristic(head) for all
+  // arcs and heuristic(target) == 0. In that case, the result is exact and
+  // usually much fewer nodes are explored than with plain Dijkstra. A typical
+  // heuristic for road networks is the straight-line distance to the target
+  // divided by the maximum speed.
+  template <class Heuristic>
+  DistanceType RunAStar(NodeIndex source, NodeIndex target,
+                        const Heuristic& heuristic);
+
+  // Accessors to the result of the last search.
+  //
+  // A node is "settled" if its exact distance from the source is known. A node
+  // is "reached" if an upper bound on its distance is known (it is in the
+  // search frontier or it is settled).
+  bool IsReached(NodeIndex node) const { return distance_[node] != kInfinity; }
+  bool IsSettled(NodeIndex node) const {
+    return IsReached(node) && !heap_.Contains(node);
+  }
+  // Returns the (tentative if the node is reached but not settled) distance of
+  // the given node, or kInfinity if it is not reached.
+  DistanceType Distance(NodeIndex node) const { return distance_[node]; }
+  // Returns the last arc of the shortest path to the given reached node, or
+  // Graph::kNilArc if it is the source.
+  ArcIndex ParentArc(NodeIndex node) const {
+    DCHECK(IsReached(node));
+    return parent_arc_[node];
+  }
+  // The nodes settled by the last search, in the order they were settled,
+  // thus by nondecreasing distance for Dijkstra.
+  const std::vector<NodeIndex>& settled_nodes() const { return settled_; }
+
+  // Fills the arcs or the nodes of the path from the source to the given
+  // reached node. The node path includes both the source and the node.
+  void ArcPathTo(NodeIndex node, std::vector<ArcIndex>* arcs) const;
+  void NodePathTo(NodeIndex node, std::vector<NodeIndex>* nodes) const;
+
+  // Advanced usage: step-by-step interface, used by BidirectionalDijkstra.
+  //
+  // Init() resets the search and adds the source to the frontier. Then each
+  // call to SettleNextNode() settles the closest node of the frontier, relaxes
+  // its outgoing arcs and returns it. NextDistance() is the distance of the
+  // node that SettleNextNode() would return.
+  void Init(NodeIndex source);
+  bool FrontierIsEmpty() const { return heap_.IsEmpty(); }
+  DistanceType NextDistance() const { return heap_.TopPriority(); }
+  NodeIndex SettleNextNode() {
+    return SettleNextNode(ZeroHeuristic<NodeIndex, DistanceType>());
+  }
+
+  const Graph& graph() const { return *graph_; }
+
+ private:
+  template <class Heuristic>
+  NodeIndex SettleNextNode(const Heuristic& heuristic);
+
+  const Graph* const graph_;
+  const std::vector<DistanceType>* const arc_lengths_;
+
+  std::vector<DistanceType> distance_;
+  std::vector<ArcIndex> parent_arc_;
+  // We store the parent node so that path reconstruction never needs
+  // Graph::Tail(), which is lazily computed (thus not thread-safe) on
+  // StaticGraph<>.
+  std::vector<NodeIndex> parent_node_;
+  // All the nodes whose distance_ is not kInfinity, to reset the search in
+  // O(number of touched nodes).
+  std::vector<NodeIndex> reached_;
+  std::vector<NodeIndex> settled_;
+  DaryHeap<DistanceType, NodeIndex> heap_;
+
+  DISALLOW_COPY_AND_ASSIGN(DijkstraSearch);
+};
+
+// Bidirectional Dijkstra: alternately grows a ball around the source in the
+// forward graph and around the target in the backward graph, and stops when
+// the two balls are guaranteed to contain a shortest path. On road-like graphs
+// it explores roughly half of the nodes explored by a unidirectional search.
+//
+// The backward graph must be the reverse of the forward graph with the same
+// node indices: for each arc tail->head of length l in the forward graph there
+// must be an arc head->tail of length l in the backward graph (this is what
+// BuildReverseGraph() below returns). The arc indices of the two graphs do not
+// need to correspond.
+//
+// Note that the stopping criterion relies on both searches settling the nodes
+// by increasing distance in the whole graph, so this class cannot be used on
+// the upward and downward graphs of a contraction hierarchy; see
+// ./contraction_hierarchy.h instead.
+template <class Graph, typename DistanceType = int64>
+class BidirectionalDijkstra {
+ public:
+  typedef typename Graph::NodeIndex NodeIndex;
+  typedef typename Graph::ArcIndex ArcIndex;
+
+  static const DistanceType kInfinity;
+
+  BidirectionalDijkstra(const Graph* forward_graph,
+                        const std::vector<DistanceType>* forward_arc_lengths,
+                        const Graph* backward_graph,
+                        const std::vector<DistanceType>* backward_arc_lengths);
+
+  // Returns the distance from source to target, or kInfinity if target is
+  // not reachable.
+  DistanceType Run(NodeIndex source, NodeIndex target);
+
+  // Fills the nodes of the shortest path found by the last Run(), from source
+  // to target (both included). The path is empty if the target was not
+  // reachable.
+  void NodePath(std::vector<NodeIndex>* nodes) const;
+
+  // The node on the shortest path where the two searches met, or
+  // Graph::kNilNode if target was not reachable.
+  NodeIndex meeting_node() const { return meeting_node_; }
+
+  const DijkstraSearch<Graph, DistanceType>& forward_search() const {
+    return forward_;
+  }
+  const DijkstraSearch<Graph, DistanceType>& backward_search() const {
+    return backward_;
+  }
+
+ private:
+  // Settles one node of the given search and updates the best path found so
+  // far using the distances of the other search.
+  void Step(DijkstraSearch<Graph, DistanceType>* search,
+            const DijkstraSearch<Graph, DistanceType>& other);
+
+  DijkstraSearch<Graph, DistanceType> forward_;
+  DijkstraSearch<Graph, DistanceType> backward_;
+  DistanceType best_distance_;
+  NodeIndex meeting_node_;
+
+  DISALLOW_COPY_AND_ASSIGN(BidirectionalDijkstra);
+};
+
+// Returns a new graph with all the arcs of the given graph reversed, and fills
+// reverse_arc_lengths accordingly. The caller takes ownership of the returned
+// graph. This is meant to build the backward graph of a BidirectionalDijkstra
+// when the graph type does not store reverse arcs.
+template <class Graph, typename DistanceType>
+Graph* BuildReverseGraph(const Graph& graph,
+                         const std::vector<DistanceType>& arc_lengths,
+                         std::vector<DistanceType>* reverse_arc_lengths);
+
+// Implementation of the templated methods.
+
+template <class Graph, typename DistanceType>
+const DistanceType DijkstraSearch<Graph, DistanceType>::kInfinity =
+    std::numeric_limits<DistanceType>::max();
+
+template <class Graph, typename DistanceType>
+DijkstraSearch<Graph, DistanceType>::DijkstraSearch(
+    const Graph* graph, const std::vector<DistanceType>* arc_lengths)
+    : graph_(graph),
+      arc_lengths_(arc_lengths),
+      distance_(graph->num_nodes(), kInfinity),
+      parent_arc_(graph->num_nodes(), Graph::kNilArc),
+      parent_node_(graph->num_nodes(), Graph::kNilNode),
+      heap_(graph->num_nodes()) {
+  DCHECK_GE(arc_lengths->size(), graph->num_arcs());
+}
+
+template <class Graph, typename DistanceType>
+void DijkstraSearch<Graph, DistanceType>::Init(NodeIndex source) {
+  DCHECK(graph_->IsNodeValid(source));
+  for (const NodeIndex node : reached_) {
+    distance_[node] = kInfinity;
+  }
+  reached_.clear();
+  settled_.clear();
+  heap_.Clear();
+  distance_[source] = 0;
+  parent_arc_[source] = Graph::kNilArc;
+  parent_node_[source] = Graph::kNilNode;
+  reached_.push_back(source);
+  heap_.Push(source, 0);
+}
+
+template <class Graph, typename DistanceType>
+template <class Heuristic>
+typename Graph::NodeIndex DijkstraSearch<Graph, DistanceType>::SettleNextNode(
+    const Heuristic& heuristic) {
+  const NodeIndex node = heap_.Pop();
+  settled_.push_back(node);
+  const DistanceType node_distance = distance_[node];
+  for (const ArcIndex arc : graph_->OutgoingArcs(node)) {
+    const NodeIndex head = graph_->Head(arc);
+    const DistanceType length = (*arc_lengths_)[arc];
+    DCHECK_GE(length, 0);
+    const DistanceType head_distance = node_distance + length;
+    if (head_distance >= distance_[head]) continue;
+    // Note that with a consistent heuristic, a settled node can never be
+    // improved, so head is either unreached or in the heap here.
+    if (distance_[head] == kInfinity) {
+      reached_.push_back(head);
+      distance_[head] = head_distance;
+      heap_.Push(head, head_distance + heuristic(head));
+    } else {
+      DCHECK(heap_.Contains(head));
+      distance_[head] = head_distance;
+      heap_.DecreasePriority(head, head_distance + heuristic(head));
+    }
+    parent_arc_[head] = arc;
+    parent_node_[head] = node;
+  }
+  return node;
+}
+
+template <class Graph, typename DistanceType>
+void DijkstraSearch<Graph, DistanceType>::RunFromSource(
+    NodeIndex source, DistanceType distance_limit) {
+  Init(source);
+  while (!heap_.IsEmpty() && heap_.TopPriority() <= distance_limit) {
+    SettleNextNode();
+  }
+}
+
+template <class Graph, typename DistanceType>
+DistanceType DijkstraSearch<Graph, DistanceType>::RunToTarget(
+    NodeIndex source, NodeIndex target) {
+  return RunAStar(source, target, ZeroHeuristic<NodeIndex, DistanceType>());
+}
+
+template <class Graph, typename DistanceType>
+template <class Heuristic>
+DistanceType DijkstraSearch<Graph, DistanceType>::RunAStar(
+    NodeIndex source, NodeIndex target, const Heuristic& heuristic) {
+  DCHECK(graph_->IsNodeValid(target));
+  Init(source);
+  while (!heap_.IsEmpty()) {
+    if (SettleNextNode(heuristic) == target) return distance_[target];
+  }
+  return kInfinity;
+}
+
+template <class Graph, typename DistanceType>
+void DijkstraSearch<Graph, DistanceType>::ArcPathTo(
+    NodeIndex node, std::vector<ArcIndex>* arcs) const {
+  DCHECK(IsReached(node));
+  arcs->clear();
+  for (; parent_node_[node] != Graph::kNilNode; node = parent_node_[node]) {
+    arcs->push_back(parent_arc_[node]);
+  }
+  std::reverse(arcs->begin(), arcs->end());
+}
+
+template <class Graph, typename DistanceType>
+void DijkstraSearch<Graph, DistanceType>::NodePathTo(
+    NodeIndex node, std::vector<NodeIndex>* nodes) const {
+  DCHECK(IsReached(node));
+  nodes->clear();
+  for (; node != Graph::kNilNode; node = parent_node_[node]) {
+    nodes->push_back(node);
+  }
+  std::reverse(nodes->begin(), nodes->end());
+}
+
+template <class Graph, typename DistanceType>
+const DistanceType BidirectionalDijkstra<Graph, DistanceType>::kInfinity =
+    std::numeric_limits<DistanceType>::max();
+
+template <class Graph, typename DistanceType>
+BidirectionalDijkstra<Graph, DistanceType>::BidirectionalDijkstra(
+    const Graph* forward_graph,
+    const std::vector<DistanceType>* forward_arc_lengths,
+    const Graph* backward_graph,
+    const std::vector<DistanceType>* backward_arc_lengths)
+    : forward_(forward_graph, forward_arc_lengths),
+      backward_(backward_graph, backward_arc_lengths),
+      best_distance_(kInfinity),
+      meeting_node_(Graph::kNilNode) {
+  DCHECK_EQ(forward_graph->num_nodes(), backward_graph->num_nodes());
+}
+
+template <class Graph, typename DistanceType>
+void BidirectionalDijkstra<Graph, DistanceType>::Step(
+    DijkstraSearch<Graph, DistanceType>* search,
+    const DijkstraSearch<Graph, DistanceType>& other) {
+  const NodeIndex node = search->SettleNextNode();
+  // A path through node or through one of its heads (whose distance was just
+  // relaxed) may be better than the best one known so far.
+  if (other.IsReached(node) &&
+      search->Distance(node) + other.Distance(node) < best_distance_) {
+    best_distance_ = search->Distance(node) + other.Distance(node);
+    meeting_node_ = node;
+  }
+  const Graph& graph = search->graph();
+  for (const ArcIndex arc : graph.OutgoingArcs(node)) {
+    const NodeIndex head = graph.Head(arc);
+    if (!other.IsReached(head)) continue;
+    const DistanceType distance = search->Distance(head) + other.Distance(head);
+    if (distance < best_distance_) {
+      best_distance_ = distance;
+      meeting_node_ = head;
+    }
+  }
+}
+
+template <class Graph, typename DistanceType>
+DistanceType BidirectionalDijkstra<Graph, DistanceType>::Run(NodeIndex source,
+                                                             NodeIndex target) {
+  forward_.Init(source);
+  backward_.Init(target);
+  best_distance_ = kInfinity;
+  meeting_node_ = Graph::kNilNode;
+  if (source == target) {
+    best_distance_ = 0;
+    meeting_node_ = source;
+    return 0;
+  }
+  // Each search settles nodes by nondecreasing distance, so once the sum of
+  // the two frontier distances is at least the best distance found, no
+  // shorter path can be found. If one frontier becomes empty, that search has
+  // settled all the nodes it can reach, and in particular the meeting node of
+  // any shortest path.
+  while (!forward_.FrontierIsEmpty() && !backward_.FrontierIsEmpty()) {
+    const DistanceType forward_radius = forward_.NextDistance();
+    const DistanceType backward_radius = backward_.NextDistance();
+    if (best_distance_ != kInfinity &&
+        forward_radius + backward_radius >= best_distance_) {
+      break;
+    }
+    if (forward_radius <= backward_radius) {
+      Step(&forward_, backward_);
+    } else {
+      Step(&backward_, forward_);
+    }
+  }
+  return best_distance_;
+}
+
+template <class Graph, typename DistanceType>
+void BidirectionalDijkstra<Graph, DistanceType>::NodePath(
+    std::vector<NodeIndex>* nodes) const {
+  nodes->clear();
+  if (meeting_node_ == Graph::kNilNode) return;
+  forward_.NodePathTo(meeting_node_, nodes);
+  std::vector<NodeIndex> backward_path;
+  backward_.NodePathTo(meeting_node_, &backward_path);
+  // backward_path goes from target to meeting_node_.
+  for (int i = static_cast<int>(backward_path.size()) - 2; i >= 0; --i) {
+    nodes->push_back(backward_path[i]);
+  }
+}
+
+template <class Graph, typename DistanceType>
+Graph* BuildReverseGraph(const Graph& graph,
+                         const std::vector<DistanceType>& arc_lengths,
+                         std::vector<DistanceType>* reverse_arc_lengths) {
+  typedef typename Graph::NodeIndex NodeIndex;
+  typedef typename Graph::ArcIndex ArcIndex;
+  Graph* const reverse_graph = new Graph(graph.num_nodes(), graph.num_arcs());
+  reverse_arc_lengths->clear();
+  reverse_arc_lengths->reserve(graph.num_arcs());
+  for (const NodeIndex node : graph.AllNodes()) {
+    for (const ArcIndex arc : graph.OutgoingArcs(node)) {
+      reverse_graph->AddArc(graph.Head(arc), node);
+      reverse_arc_lengths->push_back(arc_lengths[arc]);
+    }
+  }
+  std::vector<ArcIndex> permutation;
+  reverse_graph->Build(&permutation);
+  Permute(permutation, reverse_arc_lengths);
+  return reverse_graph;
+}
+
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_GRAPH_SHORTEST_PATH_SEARCH_H_
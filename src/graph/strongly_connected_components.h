@@ -0,0 +1,215 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Strongly connected components of a directed graph, computed by a
+// non-recursive version of the algorithm of Tarjan, in O(n + m) time and
+// O(n) memory (n nodes, m arcs). It does not use the call stack, so it works
+// on graphs with very long paths.
+//
+// The graph can be any class where graph[node] returns an iterable over the
+// heads of the arcs leaving node, for instance all the graph classes of
+// graph.h, or a std::vector<std::vector<int> > adjacency list. graph[node] is
+// called exactly once for each node, so the adjacency can also be computed on
+// the fly (see PropagationGraph in sat/simplification.cc).
+//
+// The components are output in reverse topological order: if there is an arc
+// from a node of component i to a node of component j, then j <= i.
+//
+// Reference: R. Tarjan, "Depth-first search and linear graph algorithms",
+// SIAM Journal on Computing 1 (2): 146-160, 1972.
+//
+// Example usage:
+//   std::vector<std::vector<int> > components;
+//   FindStronglyConnectedComponents(graph.num_nodes(), graph, &components);
+//
+// Or, to reuse the memory between calls and get the component of each node:
+//   StronglyConnectedComponentsFinder<int32, StaticGraph<> > finder;
+//   std::vector<int32> component_of_node;
+//   const int32 num_components =
+//       finder.ComputeComponentOfNodes(graph.num_nodes(), graph,
+//                                      &component_of_node);
+//
+// Keywords: graph, strongly connected components, Tarjan.
+
+#ifndef OR_TOOLS_GRAPH_STRONGLY_CONNECTED_COMPONENTS_H_
+#define OR_TOOLS_GRAPH_STRONGLY_CONNECTED_COMPONENTS_H_
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/macros.h"
+
+namespace operations_research {
+
+template <typename NodeIndex, typename Graph>
+class StronglyConnectedComponentsFinder {
+ public:
+  StronglyConnectedComponentsFinder() {}
+
+  // Appends the strongly connected components of the graph to *components,
+  // each as a vector of nodes.
+  void FindStronglyConnectedComponents(
+      NodeIndex num_nodes, const Graph& graph,
+      std::vector<std::vector<NodeIndex> >* components) {
+    VectorOutput output(components);
+    Run(num_nodes, graph, &output);
+  }
+
+  // Fills component_of_node[node] with the index of the component of node,
+  // in the order defined above, and returns the number of components. This
+  // does not allocate memory per component.
+  NodeIndex ComputeComponentOfNodes(NodeIndex num_nodes, const Graph& graph,
+                                    std::vector<NodeIndex>* component_of_node) {
+    component_of_node->resize(num_nodes);
+    IndexOutput output(component_of_node);
+    Run(num_nodes, graph, &output);
+    return output.num_components;
+  }
+
+ private:
+  // The index of the nodes whose component is known.
+  static const NodeIndex kSettledIndex;
+
+  struct VectorOutput {
+    explicit VectorOutput(std::vector<std::vector<NodeIndex> >* components)
+        : components(components) {}
+    void AddComponent(const NodeIndex* begin, const NodeIndex* end) {
+      components->push_back(std::vector<NodeIndex>(begin, end));
+    }
+    std::vector<std::vector<NodeIndex> >* const components;
+  };
+
+  struct IndexOutput {
+    explicit IndexOutput(std::vector<NodeIndex>* component_of_node)
+        : component_of_node(component_of_node), num_components(0) {}
+    void AddComponent(const NodeIndex* begin, const NodeIndex* end) {
+      for (const NodeIndex* node = begin; node != end; ++node) {
+        (*component_of_node)[*node] = num_components;
+      }
+      ++num_components;
+    }
+    std::vector<NodeIndex>* const component_of_node;
+    NodeIndex num_components;
+  };
+
+  template <typename Output>
+  void Run(NodeIndex num_nodes, const Graph& graph, Output* output);
+
+  // The nodes whose component is not known yet, in the order of the depth
+  // first search (the stack of Tarjan's algorithm).
+  std::vector<NodeIndex> scc_stack_;
+
+  // The 1-based positions in scc_stack_ of the first node of each potential
+  // component. They are increasing, and the last one is the start of the
+  // component of the node being explored.
+  std::vector<NodeIndex> scc_start_index_;
+
+  // For each node, 0 if it was not visited yet, kSettledIndex if its
+  // component is known, and its 1-based position in scc_stack_ otherwise.
+  std::vector<NodeIndex> node_index_;
+
+  // The depth first search stack. A node is pushed once when it is discovered
+  // from each of its predecessors, and its arcs are scanned the first time it
+  // is at the top. It is finished the next time it is at the top, once all
+  // the nodes pushed after it are popped.
+  std::vector<NodeIndex> node_to_process_;
+
+  DISALLOW_COPY_AND_ASSIGN(StronglyConnectedComponentsFinder);
+};
+
+// Simple wrapper function for most usage.
+template <typename NodeIndex, typename Graph>
+void FindStronglyConnectedComponents(
+    NodeIndex num_nodes, const Graph& graph,
+    std::vector<std::vector<NodeIndex> >* components) {
+  StronglyConnectedComponentsFinder<NodeIndex, Graph> finder;
+  finder.FindStronglyConnectedComponents(num_nodes, graph, components);
+}
+
+template <typename NodeIndex, typename Graph>
+const NodeIndex
+    StronglyConnectedComponentsFinder<NodeIndex, Graph>::kSettledIndex =
+        std::numeric_limits<NodeIndex>::max();
+
+template <typename NodeIndex, typename Graph>
+template <typename Output>
+void StronglyConnectedComponentsFinder<NodeIndex, Graph>::Run(
+    NodeIndex num_nodes, const Graph& graph, Output* output) {
+  scc_stack_.clear();
+  scc_start_index_.clear();
+  node_index_.assign(num_nodes, 0);
+  node_to_process_.clear();
+
+  // Always equal to scc_start_index_.back(), or 0 if it is empty.
+  NodeIndex current_scc_start = 0;
+  for (NodeIndex base_node = 0; base_node < num_nodes; ++base_node) {
+    if (node_index_[base_node] != 0) continue;
+    DCHECK(node_to_process_.empty());
+    node_to_process_.push_back(base_node);
+    while (!node_to_process_.empty()) {
+      const NodeIndex node = node_to_process_.back();
+      const NodeIndex index = node_index_[node];
+      if (index == 0) {
+        // First visit of node: push it on the SCC stack, and its unvisited
+        // successors on the DFS stack.
+        scc_stack_.push_back(node);
+        current_scc_start = scc_stack_.size();
+        node_index_[node] = current_scc_start;
+        scc_start_index_.push_back(current_scc_start);
+        NodeIndex min_head_index = kSettledIndex;
+        for (const NodeIndex head : graph[node]) {
+          DCHECK_GE(head, 0);
+          DCHECK_LT(head, num_nodes);
+          const NodeIndex head_index = node_index_[head];
+          if (head_index == 0) {
+            node_to_process_.push_back(head);
+          } else {
+            min_head_index = std::min(min_head_index, head_index);
+          }
+        }
+        // The arcs to nodes on the SCC stack merge all the potential
+        // components after them into one. The arcs to settled nodes
+        // (kSettledIndex) do nothing. scc_start_index_ cannot become empty,
+        // since its first element is 1 and min_head_index >= 1.
+        while (current_scc_start > min_head_index) {
+          scc_start_index_.pop_back();
+          current_scc_start = scc_start_index_.back();
+        }
+      } else {
+        node_to_process_.pop_back();
+        // node and all the nodes explored from it are finished. If it is the
+        // first node of the last potential component, this component is
+        // strongly connected. The other arcs leading to node are forward
+        // arcs of the search, which do not matter.
+        if (current_scc_start == index) {
+          const NodeIndex begin = current_scc_start - 1;
+          output->AddComponent(scc_stack_.data() + begin,
+                               scc_stack_.data() + scc_stack_.size());
+          for (NodeIndex i = begin; i < scc_stack_.size(); ++i) {
+            node_index_[scc_stack_[i]] = kSettledIndex;
+          }
+          scc_stack_.resize(begin);
+          scc_start_index_.pop_back();
+          current_scc_start =
+              scc_start_index_.empty() ? 0 : scc_start_index_.back();
+        }
+      }
+    }
+  }
+}
+
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_GRAPH_STRONGLY_CONNECTED_COMPONENTS_H_
@@ -140,6 +140,7 @@
 #include <string>
 #include <vector>
 
+#include "base/flat_hash_map.h"
 #include "base/integral_types.h"
 #include "base/logging.h"
 #include "base/timer.h"
@@ -592,14 +593,10 @@ class MPSolver {
 // The data structure used to store the coefficients of the contraints and of
 // the objective. Also define a type to facilitate iteration over them with:
 //  for (CoeffEntry entry : coefficients_) { ... }
-class CoeffMap : public hash_map<const MPVariable*, double> {
+class CoeffMap : public FlatHashMap<const MPVariable*, double> {
  public:
   explicit CoeffMap(int num_buckets)
-#if !defined(_MSC_VER)  // Visual C++ doesn't support this constructor
-      : hash_map<const MPVariable*, double>(num_buckets)
-#endif  // _MSC_VER
-  {
-  }
+      : FlatHashMap<const MPVariable*, double>(num_buckets) {}
 };
 #endif  // SWIG
 
@@ -172,7 +172,7 @@ RowIndex LinearProgram::CreateNewConstraint() {
 }
 
 ColIndex LinearProgram::FindOrCreateVariable(const std::string& variable_id) {
-  const hash_map<std::string, ColIndex>::iterator it =
+  const FlatHashMap<std::string, ColIndex>::iterator it =
       variable_table_.find(variable_id);
   if (it != variable_table_.end()) {
     return it->second;
@@ -185,7 +185,7 @@ ColIndex LinearProgram::FindOrCreateVariable(const std::string& variable_id) {
 }
 
 RowIndex LinearProgram::FindOrCreateConstraint(const std::string& constraint_id) {
-  const hash_map<std::string, RowIndex>::iterator it =
+  const FlatHashMap<std::string, RowIndex>::iterator it =
       constraint_table_.find(constraint_id);
   if (it != constraint_table_.end()) {
     return it->second;
@@ -738,17 +738,16 @@ void LinearProgram::DeleteColumns(const DenseBooleanRow& columns_to_delete) {
   variable_names_.resize(new_index, "");
 
   // Remove the id of the deleted columns and adjust the index of the other.
-  hash_map<std::string, ColIndex>::iterator it = variable_table_.begin();
-  while (it != variable_table_.end()) {
-    const ColIndex col = it->second;
+  // The table is rebuilt, since erasing from a FlatHashMap invalidates its
+  // iterators.
+  FlatHashMap<std::string, ColIndex> variable_table(variable_table_.size());
+  for (const auto& entry : variable_table_) {
+    const ColIndex col = entry.second;
     if (col >= columns_to_delete.size() || !columns_to_delete[col]) {
-      it->second = permutation[col];
-      ++it;
-    } else {
-      // This safely deletes the entry and moves the iterator one step ahead.
-      variable_table_.erase(it++);
+      variable_table[entry.first] = permutation[col];
     }
   }
+  variable_table_.swap(variable_table);
 
   // Eventually update transpose_matrix_.
   if (transpose_matrix_is_consistent_) {
@@ -796,17 +795,16 @@ void LinearProgram::DeleteRows(const DenseBooleanColumn& row_to_delete) {
   matrix_.DeleteRows(new_index, permutation);
 
   // Remove the id of the deleted rows and adjust the index of the other.
-  hash_map<std::string, RowIndex>::iterator it = constraint_table_.begin();
-  while (it != constraint_table_.end()) {
-    const RowIndex row = it->second;
+  // The table is rebuilt, since erasing from a FlatHashMap invalidates its
+  // iterators.
+  FlatHashMap<std::string, RowIndex> constraint_table(constraint_table_.size());
+  for (const auto& entry : constraint_table_) {
+    const RowIndex row = entry.second;
     if (permutation[row] != kInvalidRow) {
-      it->second = permutation[row];
-      ++it;
-    } else {
-      // This safely deletes the entry and moves the iterator one step ahead.
-      constraint_table_.erase(it++);
+      constraint_table[entry.first] = permutation[row];
     }
   }
+  constraint_table_.swap(constraint_table);
 
   // Eventually update transpose_matrix_.
   if (transpose_matrix_is_consistent_) {
@@ -29,6 +29,7 @@
 #include <string>  // for std::string
 #include <vector>  // for vector
 
+#include "base/flat_hash_map.h"
 #include "base/logging.h"  // for CHECK*
 #include "base/macros.h"   // for DISALLOW_COPY_AND_ASSIGN, NULL
 #include "base/int_type.h"
@@ -407,10 +408,10 @@ class LinearProgram {
   mutable std::vector<ColIndex> non_binary_variables_list_;
 
   // Map used to find the index of a variable based on its id.
-  hash_map<std::string, ColIndex> variable_table_;
+  FlatHashMap<std::string, ColIndex> variable_table_;
 
   // Map used to find the index of a constraint based on its id.
-  hash_map<std::string, RowIndex> constraint_table_;
+  FlatHashMap<std::string, RowIndex> constraint_table_;
 
   // Offset of the objective, i.e. value of the objective when all variables
   // are set to zero.
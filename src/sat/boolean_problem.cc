@@ -584,7 +584,7 @@ void MakeAllLiteralsPositive(LinearBooleanProblem* problem) {
 }
 
 void FindLinearBooleanProblemSymmetries(
-    const LinearBooleanProblem& problem,
+    const LinearBooleanProblem& problem, TimeLimit* time_limit,
     std::vector<std::unique_ptr<SparsePermutation>>* generators) {
   typedef GraphSymmetryFinder::Graph Graph;
   std::vector<int> equivalence_classes;
@@ -618,10 +618,14 @@ void FindLinearBooleanProblemSymmetries(
   GraphSymmetryFinder symmetry_finder(*graph.get(),
                                       /*graph_is_undirected=*/true);
   std::vector<int> factorized_automorphism_group_size;
-  // TODO(user): inject the appropriate time limit here.
-  CHECK_OK(symmetry_finder.FindSymmetries(
-      /*time_limit_seconds=*/std::numeric_limits<double>::infinity(),
-      &equivalence_classes, generators, &factorized_automorphism_group_size));
+  const util::Status status = symmetry_finder.FindSymmetries(
+      time_limit, &equivalence_classes, generators,
+      &factorized_automorphism_group_size);
+  if (!status.ok()) {
+    // The generators found so far are still valid symmetries.
+    LOG(INFO) << "Symmetry detection stopped (" << status.ToString() << "), "
+              << generators->size() << " generators found.";
+  }
 
   // Remove from the permutations the part not concerning the literals.
   // Note that some permutation may becomes empty, which means that we had
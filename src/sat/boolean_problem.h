@@ -19,6 +19,7 @@
 #include "sat/simplification.h"
 #include "algorithms/sparse_permutation.h"
 #include "base/status.h"
+#include "util/time_limit.h"
 
 namespace operations_research {
 namespace sat {
@@ -104,8 +105,11 @@ void MakeAllLiteralsPositive(LinearBooleanProblem* problem);
 // generator is a permutation of the integer range [0, 2n) where n is the number
 // of variables of the problem. They are permutations of the (index
 // representation of the) problem literals.
+//
+// The search stops when the time limit is reached, in which case only some of
+// the generators are returned.
 void FindLinearBooleanProblemSymmetries(
-    const LinearBooleanProblem& problem,
+    const LinearBooleanProblem& problem, TimeLimit* time_limit,
     std::vector<std::unique_ptr<SparsePermutation>>* generators);
 
 // Maps all the literals of the problem. Note that this converts the cost of a
@@ -13,9 +13,15 @@
 
 #include "sat/lp_utils.h"
 
+#include <map>
+
 #include "glop/lp_solver.h"
 #include "lp_data/lp_print_utils.h"
 #include "sat/boolean_problem.h"
+#include "algorithms/dynamic_partition.h"
+#include "algorithms/find_graph_symmetries.h"
+#include "base/map_util.h"
+#include "graph/graph.h"
 #include "util/fp_utils.h"
 
 namespace operations_research {
@@ -334,5 +340,235 @@ bool SolveLpAndUseIntegerVariableToStartLNS(const glop::LinearProgram& lp,
   return true;
 }
 
+namespace {
+// Generates the equivalence class numbers of the nodes of the graph of
+// FindLinearProgramSymmetries(). Two nodes are in the same class if and only if
+// they have the same type and the same key.
+class IdGenerator {
+ public:
+  IdGenerator() {}
+
+  // If the pair (type, key) was never seen before, then generate a new id,
+  // otherwise return the previously generated id.
+  int GetId(int type, const std::vector<Fractional>& key) {
+    const std::pair<int, std::vector<Fractional>> type_and_key(type, key);
+    return LookupOrInsert(&id_map_, type_and_key, id_map_.size());
+  }
+
+ private:
+  std::map<std::pair<int, std::vector<Fractional>>, int> id_map_;
+};
+}  // namespace
+
+void FindLinearProgramSymmetries(
+    const glop::LinearProgram& lp, TimeLimit* time_limit,
+    std::vector<std::unique_ptr<SparsePermutation>>* generators) {
+  typedef GraphSymmetryFinder::Graph Graph;
+  const int num_variables = lp.num_variables().value();
+  const int num_constraints = lp.num_constraints().value();
+
+  // The nodes [0, num_variables) are the variables, and the next
+  // num_constraints nodes are the constraints. Then, each coefficient value
+  // c != 1.0 of a constraint has its own node, connected to the constraint and
+  // to its variables with the coefficient c. The variables with a coefficient
+  // of 1.0 are directly connected to the constraint.
+  enum NodeType { VARIABLE_NODE, CONSTRAINT_NODE, CONSTRAINT_COEFFICIENT_NODE };
+  IdGenerator id_generator;
+  std::vector<int> equivalence_classes;
+  for (ColIndex col(0); col < lp.num_variables(); ++col) {
+    const Fractional is_integer = lp.is_variable_integer()[col] ? 1.0 : 0.0;
+    equivalence_classes.push_back(id_generator.GetId(
+        NodeType::VARIABLE_NODE,
+        {lp.variable_lower_bounds()[col], lp.variable_upper_bounds()[col],
+         lp.GetObjectiveCoefficientForMinimizationVersion(col), is_integer}));
+  }
+  for (RowIndex row(0); row < lp.num_constraints(); ++row) {
+    equivalence_classes.push_back(id_generator.GetId(
+        NodeType::CONSTRAINT_NODE, {lp.constraint_lower_bounds()[row],
+                                    lp.constraint_upper_bounds()[row]}));
+  }
+  std::unique_ptr<Graph> graph(new Graph());
+  std::map<std::pair<int, Fractional>, int> coefficient_node;
+  for (ColIndex col(0); col < lp.num_variables(); ++col) {
+    const int variable_node = col.value();
+    for (const glop::SparseColumn::Entry e : lp.GetSparseColumn(col)) {
+      if (e.coefficient() == 0.0) continue;
+      const int constraint_node = num_variables + e.row().value();
+      int node = constraint_node;
+      if (e.coefficient() != 1.0) {
+        const std::pair<int, Fractional> key(constraint_node, e.coefficient());
+        node = LookupOrInsert(&coefficient_node, key,
+                              static_cast<int>(equivalence_classes.size()));
+        if (node == equivalence_classes.size()) {
+          equivalence_classes.push_back(
+              id_generator.GetId(NodeType::CONSTRAINT_COEFFICIENT_NODE,
+                                 {e.coefficient()}));
+          graph->AddArc(constraint_node, node);
+          graph->AddArc(node, constraint_node);
+        }
+      }
+      graph->AddArc(variable_node, node);
+      graph->AddArc(node, variable_node);
+    }
+  }
+  // Make sure that the isolated nodes exist.
+  if (!equivalence_classes.empty()) {
+    graph->AddNode(equivalence_classes.size() - 1);
+  }
+  graph->Build();
+  DCHECK_EQ(graph->num_nodes(), equivalence_classes.size());
+  VLOG(1) << "Symmetry graph of the linear program has " << graph->num_nodes()
+          << " nodes and " << graph->num_arcs() / 2 << " edges.";
+
+  GraphSymmetryFinder symmetry_finder(*graph, /*graph_is_undirected=*/true);
+  std::vector<int> factorized_automorphism_group_size;
+  const util::Status status = symmetry_finder.FindSymmetries(
+      time_limit, &equivalence_classes, generators,
+      &factorized_automorphism_group_size);
+  if (!status.ok()) {
+    // The generators found so far are still valid symmetries.
+    VLOG(1) << "Symmetry detection stopped (" << status.ToString() << "), "
+            << generators->size() << " generators found.";
+  }
+
+  // Restrict the permutations to the variables. A cycle contains nodes of the
+  // same class, so it only contains variables or no variable at all. The
+  // permutations that only permute the constraints (i.e. duplicate
+  // constraints) are removed.
+  int num_generators = 0;
+  for (int i = 0; i < generators->size(); ++i) {
+    SparsePermutation* permutation = (*generators)[i].get();
+    std::vector<int> to_delete;
+    for (int j = 0; j < permutation->NumCycles(); ++j) {
+      if (*(permutation->Cycle(j).begin()) >= num_variables) {
+        to_delete.push_back(j);
+      }
+    }
+    permutation->RemoveCycles(to_delete);
+    if (!permutation->Support().empty()) {
+      std::unique_ptr<SparsePermutation> restricted(
+          new SparsePermutation(num_variables));
+      for (int j = 0; j < permutation->NumCycles(); ++j) {
+        for (const int node : permutation->Cycle(j)) {
+          restricted->AddToCurrentCycle(node);
+        }
+        restricted->CloseCurrentCycle();
+      }
+      (*generators)[num_generators] = std::move(restricted);
+      ++num_generators;
+    }
+  }
+  generators->resize(num_generators);
+  VLOG(1) << "Linear program symmetries: " << num_generators << " generators"
+          << " on " << num_variables << " variables and " << num_constraints
+          << " constraints.";
+}
+
+int AddSymmetryBreakingConstraints(
+    const std::vector<std::unique_ptr<SparsePermutation>>& generators,
+    glop::LinearProgram* lp) {
+  const int num_variables = lp->num_variables().value();
+  std::vector<const SparsePermutation*> group_generators;
+  for (const std::unique_ptr<SparsePermutation>& permutation : generators) {
+    CHECK_EQ(num_variables, permutation->Size());
+    group_generators.push_back(permutation.get());
+  }
+  int num_constraints_added = 0;
+  MergingPartition orbits;
+  std::vector<int> orbit_of_variable;
+  std::vector<bool> in_previous_orbit(num_variables, false);
+  while (!group_generators.empty()) {
+    // The orbits of the current group. The representative is the first moved
+    // variable that is not in a previous orbit: the constraints of the other
+    // variables of these orbits are mostly redundant.
+    orbits.Reset(num_variables);
+    int representative = num_variables;
+    int fallback_representative = num_variables;
+    for (const SparsePermutation* permutation : group_generators) {
+      for (int c = 0; c < permutation->NumCycles(); ++c) {
+        const int first = *permutation->Cycle(c).begin();
+        for (const int var : permutation->Cycle(c)) {
+          orbits.MergePartsOf(first, var);
+          fallback_representative = std::min(fallback_representative, var);
+          if (!in_previous_orbit[var]) {
+            representative = std::min(representative, var);
+          }
+        }
+      }
+    }
+    if (representative == num_variables) {
+      representative = fallback_representative;
+    }
+    orbits.FillEquivalenceClasses(&orbit_of_variable);
+
+    // x_representative >= x_var for all the other variables of its orbit.
+    const int orbit = orbit_of_variable[representative];
+    for (int var = 0; var < num_variables; ++var) {
+      if (orbit_of_variable[var] != orbit) continue;
+      in_previous_orbit[var] = true;
+      if (var == representative) continue;
+      const RowIndex row = lp->CreateNewConstraint();
+      lp->SetCoefficient(row, ColIndex(representative), 1.0);
+      lp->SetCoefficient(row, ColIndex(var), -1.0);
+      lp->SetConstraintBounds(row, 0.0, kInfinity);
+      ++num_constraints_added;
+    }
+
+    // Only keep the generators that fix the representative.
+    int num_kept = 0;
+    for (const SparsePermutation* permutation : group_generators) {
+      const std::vector<int>& support = permutation->Support();
+      if (std::find(support.begin(), support.end(), representative) ==
+          support.end()) {
+        group_generators[num_kept++] = permutation;
+      }
+    }
+    group_generators.resize(num_kept);
+  }
+  VLOG(1) << num_constraints_added << " symmetry breaking constraints added.";
+  return num_constraints_added;
+}
+
+void ComputeOrbitalFixings(
+    int num_variables,
+    const std::vector<std::unique_ptr<SparsePermutation>>& generators,
+    const std::vector<int>& branched_to_one,
+    const std::vector<int>& branched_to_zero, std::vector<int>* fixed_to_zero) {
+  fixed_to_zero->clear();
+  if (branched_to_zero.empty()) return;
+  std::vector<bool> is_one(num_variables, false);
+  for (const int var : branched_to_one) is_one[var] = true;
+  MergingPartition orbits;
+  orbits.Reset(num_variables);
+  for (const std::unique_ptr<SparsePermutation>& permutation : generators) {
+    CHECK_EQ(num_variables, permutation->Size());
+    bool fixes_ones = true;
+    for (const int var : permutation->Support()) {
+      if (is_one[var]) {
+        fixes_ones = false;
+        break;
+      }
+    }
+    if (!fixes_ones) continue;
+    for (int c = 0; c < permutation->NumCycles(); ++c) {
+      const int first = *permutation->Cycle(c).begin();
+      for (const int var : permutation->Cycle(c)) {
+        orbits.MergePartsOf(first, var);
+      }
+    }
+  }
+  std::vector<bool> is_zero(num_variables, false);
+  std::vector<bool> orbit_has_zero(num_variables, false);
+  for (const int var : branched_to_zero) {
+    is_zero[var] = true;
+    orbit_has_zero[orbits.GetRootAndCompressPath(var)] = true;
+  }
+  for (int var = 0; var < num_variables; ++var) {
+    if (!is_zero[var] && orbit_has_zero[orbits.GetRootAndCompressPath(var)]) {
+      fixed_to_zero->push_back(var);
+    }
+  }
+}
+
 }  // namespace sat
 }  // namespace operations_research
@@ -16,10 +16,15 @@
 #ifndef OR_TOOLS_SAT_LP_UTILS_H_
 #define OR_TOOLS_SAT_LP_UTILS_H_
 
+#include <memory>
+#include <vector>
+
 #include "sat/boolean_problem.pb.h"
 #include "linear_solver/linear_solver2.pb.h"
 #include "lp_data/lp_data.h"
 #include "sat/sat_solver.h"
+#include "algorithms/sparse_permutation.h"
+#include "util/time_limit.h"
 
 namespace operations_research {
 namespace sat {
@@ -54,6 +59,60 @@ bool SolveLpAndUseSolutionForSatAssignmentPreference(
 bool SolveLpAndUseIntegerVariableToStartLNS(const glop::LinearProgram& lp,
                                             LinearBooleanProblem* problem);
 
+// Returns a list of generators of the symmetry group of the given linear
+// program, possibly with integer variables. Each generator is a permutation of
+// the integer range [0, num_variables) that maps the variables onto variables
+// with the same bounds, integrality and objective coefficient, and the
+// constraints onto constraints with the same bounds and coefficients. An
+// MPModelProto can be converted with MPModelProtoToLinearProgram() first.
+//
+// The symmetries are found with GraphSymmetryFinder on a colored graph with
+// one node per variable, one per constraint, and one per distinct coefficient
+// different from 1.0 of each constraint. The search stops when the time limit
+// is reached, in which case only some of the generators are returned.
+void FindLinearProgramSymmetries(
+    const glop::LinearProgram& lp, TimeLimit* time_limit,
+    std::vector<std::unique_ptr<SparsePermutation>>* generators);
+
+// Adds to the linear program constraints x_r >= x_j that remove some of its
+// symmetric solutions but keep at least one optimal solution. The generators
+// must be symmetries of lp, e.g. as returned by FindLinearProgramSymmetries().
+// Returns the number of constraints added.
+//
+// The representatives r_1, r_2, ... form a chain: r_1 is a variable of a
+// non-trivial orbit O_1 of the group G_1 generated by all the generators, and
+// r_k a variable of a non-trivial orbit O_k of the group G_k generated by the
+// generators that fix r_1, ..., r_{k-1}, preferably not in O_1, ..., O_{k-1}.
+// The constraints are x_{r_k} >= x_j for all j in O_k. For any solution, an
+// element of G_1 maps it to a solution satisfying the constraints of O_1, then
+// an element of G_2, which fixes r_1 and permutes O_1, to one that also
+// satisfies those of O_2, and so on. On problems with identical machines, this forces the first job
+// on the first machine, the second job on one of the first two machines, etc.
+int AddSymmetryBreakingConstraints(
+    const std::vector<std::unique_ptr<SparsePermutation>>& generators,
+    glop::LinearProgram* lp);
+
+// Orbital fixing, for a tree search that branches on binary variables, see
+// F. Margot, "Small covering designs by branch-and-cut", Mathematical
+// Programming 94: 207-220, 2003, and J. Ostrowski, J. Linderoth, F. Rossi,
+// S. Smriglio, "Orbital branching", Mathematical Programming 126: 147-178,
+// 2011.
+//
+// At a node of the search, given the variables set to one and to zero by the
+// branching decisions leading to it, fills fixed_to_zero with the other
+// variables that can be set to zero at this node and in its subtree: those in
+// the orbit of a variable set to zero, under the group generated by the
+// generators that fix all the variables set to one (a subgroup of their
+// stabilizer, so some fixings may be missed). The generators must be
+// symmetries of the problem searched, without the constraints added by
+// AddSymmetryBreakingConstraints(), and the variables fixed by other means
+// (e.g. reduced costs) must not be in branched_to_zero.
+void ComputeOrbitalFixings(
+    int num_variables,
+    const std::vector<std::unique_ptr<SparsePermutation>>& generators,
+    const std::vector<int>& branched_to_one,
+    const std::vector<int>& branched_to_zero, std::vector<int>* fixed_to_zero);
+
 }  // namespace sat
 }  // namespace operations_research
 
@@ -23,6 +23,7 @@
 #include "base/sysinfo.h"
 #include "base/join.h"
 #include "util/saturated_arithmetic.h"
+#include "util/stats_registry.h"
 #include "base/stl_util.h"
 
 namespace operations_research {
@@ -899,6 +900,16 @@ SatSolver::Status SatSolver::ResetAndSolveWithGivenAssumptions(
 }
 
 SatSolver::Status SatSolver::StatusWithLog(Status status) {
+  static StatsCounter* const solves = StatsRegistry::Global()->GetCounter(
+      "sat_solves_total", "Number of calls to SatSolver::Solve().");
+  static StatsCounter* const conflicts = StatsRegistry::Global()->GetCounter(
+      "sat_conflicts_total", "Number of conflicts of the SAT solver.");
+  static StatsCounter* const decisions = StatsRegistry::Global()->GetCounter(
+      "sat_decisions_total", "Number of decisions of the SAT solver.");
+  solves->Increment();
+  conflicts->Add(counters_.num_failures - exported_counters_.num_failures);
+  decisions->Add(counters_.num_branches - exported_counters_.num_branches);
+  exported_counters_ = counters_;
   if (parameters_.log_search_progress()) {
     LOG(INFO) << RunningStatisticsString();
     LOG(INFO) << StatusString(status);
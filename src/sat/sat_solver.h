@@ -714,6 +714,10 @@ class SatSolver {
   };
   Counters counters_;
 
+  // The values of counters_ at the last export to the StatsRegistry, so that
+  // each solve only exports its own conflicts and decisions.
+  Counters exported_counters_;
+
   // Solver information.
   WallTimer timer_;
 
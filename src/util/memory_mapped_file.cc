@@ -0,0 +1,100 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/memory_mapped_file.h"
+
+#include <stdio.h>
+#if !defined(_MSC_VER)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "base/join.h"
+#include "base/logging.h"
+
+namespace operations_research {
+
+MemoryMappedFile::MemoryMappedFile()
+    : data_(nullptr), size_(0), mapped_(false) {}
+
+MemoryMappedFile::~MemoryMappedFile() { Close(); }
+
+void MemoryMappedFile::Close() {
+#if !defined(_MSC_VER)
+  if (mapped_ && size_ > 0) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+#endif
+  data_ = nullptr;
+  size_ = 0;
+  mapped_ = false;
+  std::vector<uint64>().swap(buffer_);
+}
+
+#if !defined(_MSC_VER)
+util::Status MemoryMappedFile::Open(const std::string& filename) {
+  Close();
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        StrCat("Could not open file '", filename, "'"));
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    close(fd);
+    return util::Status(util::error::INTERNAL,
+                        StrCat("Could not stat file '", filename, "'"));
+  }
+  size_ = file_stat.st_size;
+  if (size_ > 0) {
+    void* const address = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+      close(fd);
+      size_ = 0;
+      return util::Status(util::error::INTERNAL,
+                          StrCat("Could not mmap file '", filename, "'"));
+    }
+    data_ = static_cast<const char*>(address);
+    mapped_ = true;
+  }
+  // The mapping stays valid after the file descriptor is closed.
+  close(fd);
+  return util::Status::OK;
+}
+#else   // _MSC_VER
+util::Status MemoryMappedFile::Open(const std::string& filename) {
+  Close();
+  FILE* const f = fopen(filename.c_str(), "rb");
+  if (f == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        StrCat("Could not open file '", filename, "'"));
+  }
+  fseek(f, 0, SEEK_END);
+  size_ = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  buffer_.resize((size_ + sizeof(uint64) - 1) / sizeof(uint64));
+  if (size_ > 0 && fread(buffer_.data(), 1, size_, f) != size_) {
+    fclose(f);
+    Close();
+    return util::Status(util::error::INTERNAL,
+                        StrCat("Could not read file '", filename, "'"));
+  }
+  fclose(f);
+  data_ = reinterpret_cast<const char*>(buffer_.data());
+  return util::Status::OK;
+}
+#endif  // _MSC_VER
+
+}  // namespace operations_research
@@ -0,0 +1,63 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OR_TOOLS_UTIL_MEMORY_MAPPED_FILE_H_
+#define OR_TOOLS_UTIL_MEMORY_MAPPED_FILE_H_
+
+#include <string>
+#include <vector>
+
+#include "base/integral_types.h"
+#include "base/macros.h"
+#include "base/status.h"
+
+namespace operations_research {
+
+// A read-only view of the whole content of a file.
+//
+// On POSIX systems the file is mapped in memory with mmap(), so opening it is
+// O(1), the pages are only read from disk when they are first accessed, and
+// several processes mapping the same file share the same physical memory. On
+// other systems, the file is simply read into a buffer.
+//
+// The data is aligned on a page boundary (or at least on 8 bytes when read
+// into a buffer), so binary formats made of aligned arrays can be accessed in
+// place.
+class MemoryMappedFile {
+ public:
+  MemoryMappedFile();
+  ~MemoryMappedFile();
+
+  // Maps the given file. The previous mapping, if any, is released first.
+  util::Status Open(const std::string& filename);
+
+  // Releases the mapping. The data must not be used afterwards.
+  void Close();
+
+  const char* data() const { return data_; }
+  int64 size() const { return size_; }
+  bool is_mapped() const { return mapped_; }
+
+ private:
+  const char* data_;
+  int64 size_;
+  // True if data_ was obtained with mmap(), false if it points to buffer_.
+  bool mapped_;
+  std::vector<uint64> buffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryMappedFile);
+};
+
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_UTIL_MEMORY_MAPPED_FILE_H_
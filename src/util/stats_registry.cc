@@ -0,0 +1,302 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/stats_registry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <thread>  // NOLINT
+
+#include "base/file.h"
+#include "base/logging.h"
+#include "base/stringprintf.h"
+
+namespace operations_research {
+
+int CurrentStatsShard() {
+  // The ids of the threads are often aligned addresses: the hash is mixed
+  // before taking its high bits.
+  const uint64 hash =
+      static_cast<uint64>(std::hash<std::thread::id>()(
+          std::this_thread::get_id())) *
+      GG_ULONGLONG(0x9E3779B97F4A7C15);
+  return static_cast<int>((hash >> 32) % kNumStatsShards);
+}
+
+namespace {
+// Prints a finite double with 15 significant digits if this is enough to read
+// it back exactly (e.g. 0.1), and with 17 otherwise.
+std::string ExactDouble(double value) {
+  const std::string short_string = StringPrintf("%.15g", value);
+  if (strtod(short_string.c_str(), NULL) == value) return short_string;
+  return StringPrintf("%.17g", value);
+}
+
+// The non-finite values are printed as in the Prometheus text format.
+std::string PrometheusDouble(double value) {
+  if (std::isnan(value)) return "NaN";
+  if (std::isinf(value)) return value > 0 ? "+Inf" : "-Inf";
+  return ExactDouble(value);
+}
+
+// JSON has no representation of the non-finite values.
+std::string JsonDouble(double value) {
+  if (std::isnan(value) || std::isinf(value)) return "null";
+  return ExactDouble(value);
+}
+
+// Escapes the backslashes and the newlines of a help string, as required by
+// the Prometheus text format.
+std::string EscapeHelp(const std::string& help) {
+  std::string escaped;
+  for (const char c : help) {
+    if (c == '\\') {
+      escaped += "\\\\";
+    } else if (c == '\n') {
+      escaped += "\\n";
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+bool IsValidStatName(const std::string& name) {
+  if (name.empty()) return false;
+  for (int i = 0; i < name.size(); ++i) {
+    const char c = name[i];
+    const bool is_letter =
+        (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' ||
+        c == ':';
+    if (!is_letter && (i == 0 || c < '0' || c > '9')) return false;
+  }
+  return true;
+}
+
+void AppendHeader(const std::string& name, const std::string& help,
+                  const char* type, std::string* out) {
+  StringAppendF(out, "# HELP %s %s\n", name.c_str(), EscapeHelp(help).c_str());
+  StringAppendF(out, "# TYPE %s %s\n", name.c_str(), type);
+}
+}  // namespace
+
+int64 StatsCounter::Value() const {
+  int64 sum = 0;
+  for (int i = 0; i < kNumStatsShards; ++i) {
+    sum += shards_[i].value.load(std::memory_order_relaxed);
+  }
+  return sum;
+}
+
+std::vector<double> StatsHistogram::ExponentialBuckets(double start,
+                                                       double factor,
+                                                       int count) {
+  CHECK_GT(start, 0.0);
+  CHECK_GT(factor, 1.0);
+  CHECK_GE(count, 1);
+  std::vector<double> upper_bounds(count);
+  upper_bounds[0] = start;
+  for (int i = 1; i < count; ++i) {
+    upper_bounds[i] = upper_bounds[i - 1] * factor;
+  }
+  return upper_bounds;
+}
+
+StatsHistogram::StatsHistogram(const std::string& name, const std::string& help,
+                               const std::vector<double>& upper_bounds)
+    : name_(name), help_(help), upper_bounds_(upper_bounds) {
+  for (int i = 1; i < upper_bounds_.size(); ++i) {
+    CHECK_LT(upper_bounds_[i - 1], upper_bounds_[i]) << name;
+  }
+  for (int s = 0; s < kNumStatsShards; ++s) {
+    shards_[s].counts.reset(
+        new std::atomic<int64>[upper_bounds_.size() + 1]);
+    for (int i = 0; i <= upper_bounds_.size(); ++i) {
+      shards_[s].counts[i].store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+void StatsHistogram::Record(double value) {
+  const int bucket =
+      std::lower_bound(upper_bounds_.begin(), upper_bounds_.end(), value) -
+      upper_bounds_.begin();
+  Shard* const shard = &shards_[CurrentStatsShard()];
+  shard->counts[bucket].fetch_add(1, std::memory_order_relaxed);
+  // There is no fetch_add() for the atomic doubles.
+  double sum = shard->sum.load(std::memory_order_relaxed);
+  while (!shard->sum.compare_exchange_weak(sum, sum + value,
+                                           std::memory_order_relaxed)) {
+  }
+}
+
+StatsHistogram::Snapshot StatsHistogram::GetSnapshot() const {
+  Snapshot snapshot;
+  snapshot.counts.assign(upper_bounds_.size() + 1, 0);
+  snapshot.count = 0;
+  snapshot.sum = 0.0;
+  for (int s = 0; s < kNumStatsShards; ++s) {
+    for (int i = 0; i <= upper_bounds_.size(); ++i) {
+      const int64 count = shards_[s].counts[i].load(std::memory_order_relaxed);
+      snapshot.counts[i] += count;
+      snapshot.count += count;
+    }
+    snapshot.sum += shards_[s].sum.load(std::memory_order_relaxed);
+  }
+  return snapshot;
+}
+
+StatsRegistry* StatsRegistry::Global() {
+  static StatsRegistry* const registry = new StatsRegistry();
+  return registry;
+}
+
+void StatsRegistry::CheckNewName(const std::string& name) const {
+  CHECK(IsValidStatName(name)) << "Invalid statistic name: '" << name << "'";
+  CHECK(counters_.find(name) == counters_.end() &&
+        gauges_.find(name) == gauges_.end() &&
+        histograms_.find(name) == histograms_.end())
+      << "The statistic " << name << " already exists with another kind.";
+}
+
+StatsCounter* StatsRegistry::GetCounter(const std::string& name,
+                                        const std::string& help) {
+  std::unique_lock<std::mutex> mutex_lock(mutex_);
+  const auto it = counters_.find(name);
+  if (it != counters_.end()) return it->second.get();
+  CheckNewName(name);
+  StatsCounter* const counter = new StatsCounter(name, help);
+  counters_[name].reset(counter);
+  return counter;
+}
+
+StatsGauge* StatsRegistry::GetGauge(const std::string& name,
+                                    const std::string& help) {
+  std::unique_lock<std::mutex> mutex_lock(mutex_);
+  const auto it = gauges_.find(name);
+  if (it != gauges_.end()) return it->second.get();
+  CheckNewName(name);
+  StatsGauge* const gauge = new StatsGauge(name, help);
+  gauges_[name].reset(gauge);
+  return gauge;
+}
+
+StatsHistogram* StatsRegistry::GetHistogram(
+    const std::string& name, const std::string& help,
+    const std::vector<double>& upper_bounds) {
+  std::unique_lock<std::mutex> mutex_lock(mutex_);
+  const auto it = histograms_.find(name);
+  if (it != histograms_.end()) {
+    CHECK(it->second->upper_bounds() == upper_bounds)
+        << "The histogram " << name << " already exists with other buckets.";
+    return it->second.get();
+  }
+  CheckNewName(name);
+  StatsHistogram* const histogram =
+      new StatsHistogram(name, help, upper_bounds);
+  histograms_[name].reset(histogram);
+  return histogram;
+}
+
+std::string StatsRegistry::Export(ExportFormat format) const {
+  std::unique_lock<std::mutex> mutex_lock(mutex_);
+  return format == JSON ? ExportAsJson() : ExportAsPrometheusText();
+}
+
+util::Status StatsRegistry::ExportToFile(const std::string& filename,
+                                         ExportFormat format) const {
+  return file::SetContents(filename, Export(format), file::Defaults());
+}
+
+void StatsRegistry::ExportToCallback(
+    ExportFormat format, Callback1<const std::string&>* const callback) const {
+  CHECK(callback != nullptr);
+  callback->Run(Export(format));
+}
+
+std::string StatsRegistry::ExportAsJson() const {
+  std::string out = "{\n  \"counters\": {";
+  const char* separator = "\n";
+  for (const auto& entry : counters_) {
+    StringAppendF(&out, "%s    \"%s\": %lld", separator, entry.first.c_str(),
+                  static_cast<long long>(entry.second->Value()));  // NOLINT
+    separator = ",\n";
+  }
+  out += "\n  },\n  \"gauges\": {";
+  separator = "\n";
+  for (const auto& entry : gauges_) {
+    StringAppendF(&out, "%s    \"%s\": %s", separator, entry.first.c_str(),
+                  JsonDouble(entry.second->Value()).c_str());
+    separator = ",\n";
+  }
+  out += "\n  },\n  \"histograms\": {";
+  separator = "\n";
+  for (const auto& entry : histograms_) {
+    const StatsHistogram& histogram = *entry.second;
+    const StatsHistogram::Snapshot snapshot = histogram.GetSnapshot();
+    StringAppendF(&out, "%s    \"%s\": {\"count\": %lld, \"sum\": %s, "
+                        "\"buckets\": [",
+                  separator, entry.first.c_str(),
+                  static_cast<long long>(snapshot.count),  // NOLINT
+                  JsonDouble(snapshot.sum).c_str());
+    int64 cumulative_count = 0;
+    for (int i = 0; i < histogram.upper_bounds().size(); ++i) {
+      cumulative_count += snapshot.counts[i];
+      StringAppendF(&out, "%s{\"le\": %s, \"count\": %lld}", i > 0 ? ", " : "",
+                    JsonDouble(histogram.upper_bounds()[i]).c_str(),
+                    static_cast<long long>(cumulative_count));  // NOLINT
+    }
+    out += "]}";
+    separator = ",\n";
+  }
+  out += "\n  }\n}\n";
+  return out;
+}
+
+std::string StatsRegistry::ExportAsPrometheusText() const {
+  std::string out;
+  for (const auto& entry : counters_) {
+    AppendHeader(entry.first, entry.second->help(), "counter", &out);
+    StringAppendF(&out, "%s %lld\n", entry.first.c_str(),
+                  static_cast<long long>(entry.second->Value()));  // NOLINT
+  }
+  for (const auto& entry : gauges_) {
+    AppendHeader(entry.first, entry.second->help(), "gauge", &out);
+    StringAppendF(&out, "%s %s\n", entry.first.c_str(),
+                  PrometheusDouble(entry.second->Value()).c_str());
+  }
+  for (const auto& entry : histograms_) {
+    const StatsHistogram& histogram = *entry.second;
+    const StatsHistogram::Snapshot snapshot = histogram.GetSnapshot();
+    const char* const name = entry.first.c_str();
+    AppendHeader(entry.first, histogram.help(), "histogram", &out);
+    int64 cumulative_count = 0;
+    for (int i = 0; i < histogram.upper_bounds().size(); ++i) {
+      cumulative_count += snapshot.counts[i];
+      StringAppendF(&out, "%s_bucket{le=\"%s\"} %lld\n", name,
+                    PrometheusDouble(histogram.upper_bounds()[i]).c_str(),
+                    static_cast<long long>(cumulative_count));  // NOLINT
+    }
+    StringAppendF(&out, "%s_bucket{le=\"+Inf\"} %lld\n", name,
+                  static_cast<long long>(snapshot.count));  // NOLINT
+    StringAppendF(&out, "%s_sum %s\n", name,
+                  PrometheusDouble(snapshot.sum).c_str());
+    StringAppendF(&out, "%s_count %lld\n", name,
+                  static_cast<long long>(snapshot.count));  // NOLINT
+  }
+  return out;
+}
+
+}  // namespace operations_research
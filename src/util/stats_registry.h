@@ -0,0 +1,229 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A process-wide registry of statistics, meant to be scraped by monitoring
+// systems, e.g. from a long-running service that calls the solvers. Contrary
+// to the StatsGroup of util/stats.h, which are per object and printed for
+// humans, the statistics of the registry are global, thread-safe, and
+// exported in JSON or in the Prometheus text format.
+//
+// There are three kinds of statistics:
+// - StatsCounter: an int64 that only increases, e.g. a number of solves.
+// - StatsGauge: a double that can be set to any value, e.g. a memory usage.
+// - StatsHistogram: the distribution of a double over fixed buckets, e.g. the
+//   solve times.
+//
+// The counters and histograms are sharded: each thread updates a shard
+// selected by its id, on its own cache line, with relaxed atomic operations.
+// The shards are only summed when the statistics are exported, so that the
+// updates are cheap and scale with the number of threads.
+//
+// The statistics are created and owned by the registry, and are never
+// deleted. Looking them up by name takes a mutex, and a histogram lookup
+// builds its buckets: look each statistic up once, e.g. in a function-local
+// static, and keep the returned pointer. The names must follow the
+// Prometheus conventions: [a-zA-Z_:][a-zA-Z0-9_:]*, with a "_total" suffix
+// for the counters and a unit suffix (e.g. "_seconds") where it makes sense.
+//
+// Example usage:
+//   static StatsCounter* const conflicts = StatsRegistry::Global()->GetCounter(
+//       "sat_conflicts_total", "Number of conflicts of the SAT solver.");
+//   static StatsHistogram* const solve_time =
+//       StatsRegistry::Global()->GetHistogram(
+//           "glop_solve_time_seconds", "Time of the LP solves.",
+//           StatsHistogram::ExponentialBuckets(1e-3, 10, 7));
+//   conflicts->Add(num_conflicts);
+//   solve_time->Record(time_in_seconds);
+//   ...
+//   const util::Status status = StatsRegistry::Global()->ExportToFile(
+//       "/tmp/stats.prom", StatsRegistry::PROMETHEUS_TEXT);
+//   if (!status.ok()) LOG(ERROR) << status.ToString();
+
+#ifndef OR_TOOLS_UTIL_STATS_REGISTRY_H_
+#define OR_TOOLS_UTIL_STATS_REGISTRY_H_
+
+#include <atomic>
+#include <map>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/integral_types.h"
+#include "base/macros.h"
+#include "base/status.h"
+#include "base/unique_ptr.h"
+
+namespace operations_research {
+
+// The number of shards of the counters and histograms. Threads whose ids fall
+// in the same shard share its atomic variables.
+static const int kNumStatsShards = 16;
+
+// Returns the shard of the calling thread, in [0, kNumStatsShards).
+int CurrentStatsShard();
+
+class StatsCounter {
+ public:
+  // Adds value, which must be non-negative, to the counter.
+  void Add(int64 value) {
+    shards_[CurrentStatsShard()].value.fetch_add(value,
+                                                 std::memory_order_relaxed);
+  }
+  void Increment() { Add(1); }
+
+  // Returns the sum of the shards.
+  int64 Value() const;
+
+  const std::string& name() const { return name_; }
+  const std::string& help() const { return help_; }
+
+ private:
+  friend class StatsRegistry;
+  // An atomic alone on its cache line, to avoid false sharing.
+  struct Shard {
+    Shard() : value(0) {}
+    std::atomic<int64> value;
+    char padding[64 - sizeof(std::atomic<int64>)];
+  };
+
+  StatsCounter(const std::string& name, const std::string& help)
+      : name_(name), help_(help) {}
+
+  const std::string name_;
+  const std::string help_;
+  Shard shards_[kNumStatsShards];
+
+  DISALLOW_COPY_AND_ASSIGN(StatsCounter);
+};
+
+class StatsGauge {
+ public:
+  void Set(double value) { value_.store(value, std::memory_order_relaxed); }
+  double Value() const { return value_.load(std::memory_order_relaxed); }
+
+  const std::string& name() const { return name_; }
+  const std::string& help() const { return help_; }
+
+ private:
+  friend class StatsRegistry;
+  StatsGauge(const std::string& name, const std::string& help)
+      : name_(name), help_(help), value_(0.0) {}
+
+  const std::string name_;
+  const std::string help_;
+  std::atomic<double> value_;
+
+  DISALLOW_COPY_AND_ASSIGN(StatsGauge);
+};
+
+class StatsHistogram {
+ public:
+  // Returns the upper bounds start, start * factor, ...,
+  // start * factor^(count - 1).
+  static std::vector<double> ExponentialBuckets(double start, double factor,
+                                                int count);
+
+  // Adds a value to the bucket of the first upper bound that is greater than
+  // or equal to it, or to the last bucket (of upper bound +infinity).
+  void Record(double value);
+
+  // The aggregated content of the shards. counts[i] is the number of values
+  // in the bucket i, i.e. in (upper_bounds[i - 1], upper_bounds[i]], and
+  // counts.back() the number of values greater than all the upper bounds.
+  struct Snapshot {
+    std::vector<int64> counts;
+    int64 count;
+    double sum;
+  };
+  Snapshot GetSnapshot() const;
+
+  const std::string& name() const { return name_; }
+  const std::string& help() const { return help_; }
+  const std::vector<double>& upper_bounds() const { return upper_bounds_; }
+
+ private:
+  friend class StatsRegistry;
+  struct Shard {
+    Shard() : sum(0.0) {}
+    std::unique_ptr<std::atomic<int64>[]> counts;
+    std::atomic<double> sum;
+    char padding[64 - sizeof(std::atomic<double>)];
+  };
+
+  StatsHistogram(const std::string& name, const std::string& help,
+                 const std::vector<double>& upper_bounds);
+
+  const std::string name_;
+  const std::string help_;
+  const std::vector<double> upper_bounds_;
+  Shard shards_[kNumStatsShards];
+
+  DISALLOW_COPY_AND_ASSIGN(StatsHistogram);
+};
+
+class StatsRegistry {
+ public:
+  enum ExportFormat { JSON, PROMETHEUS_TEXT };
+
+  // The registry of the process.
+  static StatsRegistry* Global();
+
+  StatsRegistry() {}
+
+  // Returns the statistic with the given name, and creates it the first time.
+  // It is a fatal error to use the same name for two different kinds of
+  // statistics, or for two histograms with different buckets. The help is
+  // only used when the statistic is created.
+  StatsCounter* GetCounter(const std::string& name, const std::string& help);
+  StatsGauge* GetGauge(const std::string& name, const std::string& help);
+  StatsHistogram* GetHistogram(const std::string& name, const std::string& help,
+                               const std::vector<double>& upper_bounds);
+
+  // Returns a snapshot of all the statistics, sorted by name, in the given
+  // format. In JSON, the snapshot is an object with the members "counters",
+  // "gauges" and "histograms", each mapping the names of the statistics to
+  // their values; the value of a histogram is an object with its "count", its
+  // "sum", and its "buckets", a list of {"le": upper bound, "count":
+  // cumulative count} as in Prometheus. The non-finite values are exported
+  // as null.
+  std::string Export(ExportFormat format) const;
+
+  // Writes the snapshot to a file, replacing its content.
+  util::Status ExportToFile(const std::string& filename,
+                            ExportFormat format) const;
+
+  // Passes the snapshot to the callback. A self-deleting callback is deleted
+  // by this call, a permanent one is still owned by the caller.
+  void ExportToCallback(ExportFormat format,
+                        Callback1<const std::string&>* const callback) const;
+
+ private:
+  // Checks that the name is valid and not used by another kind of statistic.
+  // The caller must hold mutex_.
+  void CheckNewName(const std::string& name) const;
+
+  std::string ExportAsJson() const;
+  std::string ExportAsPrometheusText() const;
+
+  mutable std::mutex mutex_;
+  std::map<std::string, std::unique_ptr<StatsCounter> > counters_;
+  std::map<std::string, std::unique_ptr<StatsGauge> > gauges_;
+  std::map<std::string, std::unique_ptr<StatsHistogram> > histograms_;
+
+  DISALLOW_COPY_AND_ASSIGN(StatsRegistry);
+};
+
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_UTIL_STATS_REGISTRY_H_